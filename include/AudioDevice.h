@@ -79,6 +79,12 @@ public:
 
 	void processNextBuffer();
 
+	// write a buffer rendered by the mixer at its processing rate,
+	// for devices which don't fetch their data via getNextBuffer()
+	void processBuffer( const surroundSampleFrame * _ab,
+					const fpp_t _frames,
+					const float _master_gain );
+
 	virtual void startProcessing()
 	{
 		m_inProcess = true;
@@ -99,11 +99,6 @@ private:
 			{
 				break;
 			}
-			if( mixer()->hasFifoWriter() )
-			{
-				delete[] b;
-			}
-
 			const int microseconds = static_cast<int>( mixer()->framesPerPeriod() * 1000000.0f / mixer()->processingSampleRate() - timer.elapsed() );
 			if( microseconds > 0 )
 			{
@@ -35,6 +35,7 @@
 class AudioFileDevice : public AudioDevice
 {
 public:
+	// an empty file name makes the device discard its output
 	AudioFileDevice(OutputSettings const & outputSettings,
 			const ch_cnt_t _channels, const QString & _file,
 			Mixer* mixer );
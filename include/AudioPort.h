@@ -32,8 +32,10 @@
 
 #include "MemoryManager.h"
 #include "PlayHandle.h"
+#include "PlayHandleArray.h"
 
 class EffectChain;
+class FxChannel;
 class FloatModel;
 class BoolModel;
 
@@ -105,6 +107,10 @@ public:
 	{
 		return true;
 	}
+	virtual ProfilingTarget profilingTarget() const
+	{
+		return { this, m_name, "Effects" };
+	}
 
 	void addPlayHandle( PlayHandle * handle );
 	void removePlayHandle( PlayHandle * handle );
@@ -117,18 +123,22 @@ private:
 
 	bool m_extOutputEnabled;
 	fx_ch_t m_nextFxChannel;
+	// FX channel waiting for our output in the current period, set up by
+	// FxMixer::processChannels()
+	FxChannel * m_pendingFxChannel;
 
 	QString m_name;
 
 	std::unique_ptr<EffectChain> m_effects;
 
-	PlayHandleList m_playHandles;
+	PlayHandleArray m_playHandles;
 	QMutex m_playHandleLock;
 
 	FloatModel * m_volumeModel;
 	FloatModel * m_panningModel;
 	BoolModel * m_mutedModel;
 
+	friend class FxMixer;
 	friend class Mixer;
 	friend class MixerWorkerThread;
 
@@ -34,6 +34,9 @@
 #include "ValueBuffer.h"
 #include "MemoryManager.h"
 
+#include <atomic>
+#include <vector>
+
 // simple way to map a property of a view to a model
 #define mapPropertyFromModelPtr(type,getfunc,setfunc,modelname)	\
 		public:													\
@@ -124,8 +127,17 @@ public:
 
 	//! @brief Function that returns sample-exact data as a ValueBuffer
 	//! @return pointer to model's valueBuffer when s.ex.data exists, NULL otherwise
+	//!
+	//! Doesn't lock once updateValueBuffers() ran for the current period
 	ValueBuffer * valueBuffer();
 
+	//! @brief Computes the ValueBuffers of all models which are connected to
+	//! a controller, linked or changed since the last period
+	//!
+	//! Called by the mixer before any job of the period runs, afterwards
+	//! the buffers are read-only until the period counter advances.
+	static void updateValueBuffers();
+
 	template<class T>
 	T initValue() const
 	{
@@ -163,6 +175,10 @@ public:
 	void setInitValue( const float value );
 
 	void setAutomatedValue( const float value );
+	//! @brief Sets sample-exact automation data for the current period
+	//! @param values one value per frame, unscaled like the ones passed to setAutomatedValue()
+	//! @return false if the model is driven by a controller or linked models and can't take the data
+	bool setAutomatedValueBuffer( const float * values );
 	void setValue( const float value );
 
 	void incValue( int steps )
@@ -285,6 +301,15 @@ protected:
 private:
 	static bool mustQuoteName(const QString &name);
 
+	class ValueBufferJob;
+
+	// fills m_valueBuffer unless it's up to date, m_valueBufferMutex has to
+	// be locked
+	void updateValueBuffer();
+
+	// registers the model for updateValueBuffers()
+	void markActive();
+
 	virtual void saveSettings( QDomDocument& doc, QDomElement& element )
 	{
 		saveSettings( doc, element, "value" );
@@ -334,7 +359,9 @@ private:
 
 
 	ValueBuffer m_valueBuffer;
-	long m_lastUpdatedPeriod;
+	// published last, so readers seeing the current period can use
+	// m_valueBuffer and m_hasSampleExactData without locking
+	std::atomic<long> m_lastUpdatedPeriod;
 	static long s_periodCounter;
 
 	bool m_hasSampleExactData;
@@ -342,6 +369,12 @@ private:
 	// prevent several threads from attempting to write the same vb at the same time
 	QMutex m_valueBufferMutex;
 
+	// models updateValueBuffers() has to look at, m_active tells whether
+	// a model is part of s_activeModels
+	std::atomic_bool m_active;
+	static std::vector<AutomatableModel *> s_activeModels;
+	static QMutex s_activeModelsMutex;
+
 signals:
 	void initValueChanged( float val );
 	void destroyed( jo_id_t id );
@@ -30,6 +30,8 @@
 #include <QtCore/QMap>
 #include <QtCore/QPointer>
 
+#include <limits>
+
 #include "Track.h"
 
 
@@ -136,6 +138,8 @@ public:
 
 	float valueAt( const MidiTime & _time ) const;
 	float *valuesAfter( const MidiTime & _time ) const;
+	void valuesAt( float time, float step, float * values, int count,
+			float maxTime = std::numeric_limits<float>::max() ) const;
 
 	const QString name() const;
 
@@ -0,0 +1,140 @@
+/*
+ * AutomationTimeline.h - precompiled automation lookup for song playback
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AUTOMATION_TIMELINE_H
+#define AUTOMATION_TIMELINE_H
+
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+
+#include <atomic>
+#include <vector>
+
+#include "AutomatableModel.h"
+#include "MidiTime.h"
+
+class AutomationPattern;
+class Track;
+class TrackContainer;
+class TrackContentObject;
+
+
+/*! \brief Precompiled automation of a track container
+ *
+ *  Collects all automation patterns of a track container (including the ones
+ *  played through BB tracks) into one list sorted by start position, the
+ *  same order TrackContainer::automatedValuesAt() evaluates them in. While
+ *  playing, a cursor advances through that list and keeps the segments
+ *  which already started per model, so computing the values of a tick does
+ *  not have to search the song anymore.
+ *
+ *  The timeline is recompiled whenever invalidate() got called since the
+ *  last compilation, i.e. when patterns, tracks or their positions changed.
+ *  Mute states, automation points and lengths are evaluated live.
+ */
+class LMMS_EXPORT AutomationTimeline
+{
+public:
+	struct Value
+	{
+		AutomatableModel * model;
+		float value;
+	} ;
+	typedef std::vector<Value> ValueVector;
+
+	AutomationTimeline( TrackContainer * container, Track * globalTrack = NULL );
+
+	//! Mark all timelines as outdated
+	static void invalidate();
+
+	//! Returns the automated values at given position. The result stays
+	//! valid until the next call.
+	const ValueVector & valuesAt( MidiTime time );
+
+	//! Renders the automation curves of the current period into the
+	//! value buffers of the automated models, so they change sample by
+	//! sample instead of stepping at tick boundaries. The curves are split
+	//! where patterns start and where playback loops. Models which can't be
+	//! rendered for the whole period keep their per-tick values.
+	//! @param position position of the period's first frame in ticks
+	//! @param ticksPerFrame playback speed
+	//! @param loopBegin, loopEnd playback jumps back to loopBegin once it
+	//! reaches loopEnd, no looping if loopEnd isn't behind loopBegin
+	void renderValueBuffers( float position, float ticksPerFrame,
+					float loopBegin = 0, float loopEnd = 0 );
+
+	//! Returns all patterns on automation tracks of the container which
+	//! started at or before the position last passed to valuesAt()
+	const QVector<AutomationPattern *> & startedPatterns() const
+	{
+		return m_startedPatterns;
+	}
+
+private:
+	struct Segment
+	{
+		MidiTime start;
+		Track * track;
+		AutomationPattern * pattern;
+		// set if the pattern is played through a BB track
+		TrackContentObject * bbTCO;
+		int bbIndex;
+		// whether the pattern is on one of the container's automation tracks
+		bool recordable;
+		QVector<int> models;
+	} ;
+
+	void compile();
+	void rewind();
+	void seek( MidiTime time );
+	void renderSpan( float position, float ticksPerFrame, int offset, int frames );
+	bool isRecorded( int model ) const;
+	bool valueOf( const Segment & segment, MidiTime time, float & value ) const;
+
+	TrackContainer * m_container;
+	Track * m_globalTrack;
+
+	unsigned int m_revision;
+	QVector<Segment> m_segments;
+	QVector<QPointer<AutomatableModel> > m_models;
+
+	// cursor state
+	MidiTime m_cursorTime;
+	int m_nextSegment;
+	// indices of started segments per model, latest last
+	std::vector<std::vector<int> > m_startedSegments;
+	std::vector<int> m_activeModels;
+	QVector<AutomationPattern *> m_startedPatterns;
+
+	ValueVector m_values;
+	// render state per model, frames rendered so far are -1 if the
+	// model keeps its per-tick values this period
+	std::vector<std::vector<float> > m_renderBuffers;
+	std::vector<int> m_renderedFrames;
+	std::vector<int> m_renderedModels;
+
+	static std::atomic_uint s_revision;
+
+} ;
+
+
+#endif
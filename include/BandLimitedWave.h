@@ -61,6 +61,10 @@ public:
 		else
 		{	return m_data3[ TLENS[ table ] + ph ]; }
 	}
+	inline const sample_t * table( int table ) const
+	{
+		return ( table % 2 == 0 ? m_data : m_data3 ) + TLENS[ table ];
+	}
 	inline void setSampleAt( int table, int ph, sample_t sample )
 	{
 		if( table % 2 == 0 )
@@ -118,6 +122,16 @@ public:
 		return 1.0f / pd;
 	}
 
+	/*! \brief This method returns the index of the mipmap table holding all harmonics below the Nyquist
+	 *  frequency for oscillations of the given wavelength. TLENS holds the length of the table.
+	 */
+	static inline int tableIndex( float _wavelen )
+	{
+		int t = 0;
+		while( t < MAXTBL && _wavelen >= TLENS[t+1] ) { t++; }
+		return t;
+	}
+
 	/*! \brief This method provides interpolated samples of bandlimited waveforms.
 	 *  \param _ph The phase of the sample.
 	 *  \param _wavelen The wavelength (length of one cycle, ie. the inverse of frequency) of the wanted oscillation, measured in sample frames
@@ -126,8 +140,7 @@ public:
 	static inline sample_t oscillate( float _ph, float _wavelen, Waveforms _wave )
 	{
 		// get the next higher tlen
-		int t = 0;
-		while( t < MAXTBL && _wavelen >= TLENS[t+1] ) { t++; }
+		const int t = tableIndex( _wavelen );
 
 		int tlen = TLENS[t];
 		const float ph = fraction( _ph );
@@ -262,18 +262,27 @@ public:
 
 	inline void setFilterType( const int _idx )
 	{
-		m_doubleFilter = _idx == DoubleLowPass || _idx == DoubleMoog;
+		const bool doubleFilter = _idx == DoubleLowPass || _idx == DoubleMoog;
+		// Double lowpass mode, backwards-compat for the goofy
+		// Add-NumFilters to signify doubleFilter stuff
+		const FilterTypes type = !doubleFilter
+			? static_cast<FilterTypes>( _idx )
+			: _idx == DoubleLowPass
+				? LowPass
+				: Moog;
+		if( doubleFilter != m_doubleFilter || type != m_type )
+		{
+			// don't interpolate from coefficients of another filter
+			m_coeffsValid = false;
+		}
+
+		m_doubleFilter = doubleFilter;
+		m_type = type;
 		if( !m_doubleFilter )
 		{
-			m_type = static_cast<FilterTypes>( _idx );
 			return;
 		}
 
-		// Double lowpass mode, backwards-compat for the goofy
-		// Add-NumFilters to signify doubleFilter stuff
-		m_type = _idx == DoubleLowPass 
-			? LowPass
-			: Moog;
 		if( m_subFilter == NULL )
 		{
 			m_subFilter = new BasicFilters<CHANNELS>(
@@ -284,11 +293,15 @@ public:
 	}
 
 	inline BasicFilters( const sample_rate_t _sample_rate ) :
+		m_type( LowPass ),
 		m_doubleFilter( false ),
+		m_coeffsValid( false ),
 		m_sampleRate( (float) _sample_rate ),
 		m_sampleRatio( 1.0f / m_sampleRate ),
 		m_subFilter( NULL )
 	{
+		const float zero[NumCoeffs] = { };
+		loadCoeffs( zero );
 		clearHistory();
 	}
 
@@ -330,8 +343,414 @@ public:
 
 	inline sample_t update( sample_t _in0, ch_cnt_t _chnl )
 	{
-		sample_t out;
 		switch( m_type )
+		{
+			case Moog: return updateKernel<Moog>( _in0, _chnl );
+			case Tripole: return updateKernel<Tripole>( _in0, _chnl );
+			case Lowpass_SV: return updateKernel<Lowpass_SV>( _in0, _chnl );
+			case Bandpass_SV: return updateKernel<Bandpass_SV>( _in0, _chnl );
+			case Highpass_SV: return updateKernel<Highpass_SV>( _in0, _chnl );
+			case Notch_SV: return updateKernel<Notch_SV>( _in0, _chnl );
+			case Lowpass_RC12: return updateKernel<Lowpass_RC12>( _in0, _chnl );
+			case Bandpass_RC12: return updateKernel<Bandpass_RC12>( _in0, _chnl );
+			case Highpass_RC12: return updateKernel<Highpass_RC12>( _in0, _chnl );
+			case Lowpass_RC24: return updateKernel<Lowpass_RC24>( _in0, _chnl );
+			case Bandpass_RC24: return updateKernel<Bandpass_RC24>( _in0, _chnl );
+			case Highpass_RC24: return updateKernel<Highpass_RC24>( _in0, _chnl );
+			case Formantfilter: return updateKernel<Formantfilter>( _in0, _chnl );
+			case FastFormant: return updateKernel<FastFormant>( _in0, _chnl );
+			// all biquads share the same kernel
+			default: return updateKernel<LowPass>( _in0, _chnl );
+		}
+	}
+
+
+	// number of frames coefficients are interpolated over by the
+	// modulated processBuffer()
+	static const fpp_t CoeffInterval = 16;
+
+	//! Filters all frames of buf with the current coefficients
+	inline void processBuffer( sampleFrame * _buf, const fpp_t _frames )
+	{
+		processFrames<false>( _buf, _frames, NULL );
+	}
+
+	//! Filters all frames of buf while cutoff frequency and Q follow the
+	//! values in _freqs and _qs, which are advanced by _freqInc and _qInc
+	//! per frame. Coefficients are calculated every CoeffInterval frames
+	//! and linearly interpolated in between.
+	inline void processBuffer( sampleFrame * _buf, const fpp_t _frames,
+					const float * _freqs, int _freqInc,
+					const float * _qs, int _qInc )
+	{
+		float from[NumCoeffs];
+		float to[NumCoeffs];
+		float step[NumCoeffs];
+		for( fpp_t f = 0; f < _frames; f += CoeffInterval )
+		{
+			const fpp_t frames = qMin<fpp_t>( fpp_t( CoeffInterval ), _frames - f );
+			const fpp_t last = f + frames - 1;
+
+			const bool interpolate = m_coeffsValid;
+			saveCoeffs( from );
+			calcFilterCoeffs( _freqs[last * _freqInc], _qs[last * _qInc] );
+			if( !interpolate )
+			{
+				// nothing to start from yet
+				processFrames<false>( _buf + f, frames, NULL );
+				continue;
+			}
+
+			saveCoeffs( to );
+			for( int i = 0; i < NumCoeffs; ++i )
+			{
+				step[i] = ( to[i] - from[i] ) / frames;
+			}
+			loadCoeffs( from );
+			processFrames<true>( _buf + f, frames, step );
+			// don't let rounding errors accumulate
+			loadCoeffs( to );
+		}
+	}
+
+
+	inline void calcFilterCoeffs( float _freq, float _q )
+	{
+		m_coeffsValid = true;
+
+		// temp coef vars
+		_q = qMax( _q, minQ() );
+
+		if( m_type == Lowpass_RC12  ||
+			m_type == Bandpass_RC12 ||
+			m_type == Highpass_RC12 ||
+			m_type == Lowpass_RC24 ||
+			m_type == Bandpass_RC24 ||
+			m_type == Highpass_RC24 )
+		{
+			_freq = qBound( 50.0f, _freq, 20000.0f );
+			const float sr = m_sampleRatio * 0.25f;
+			const float f = 1.0f / ( _freq * F_2PI );
+			
+			m_rca = 1.0f - sr / ( f + sr );
+			m_rcb = 1.0f - m_rca;
+			m_rcc = f / ( f + sr );
+
+			// Stretch Q/resonance, as self-oscillation reliably starts at a q of ~2.5 - ~2.6
+			m_rcq = _q * 0.25f;
+			return;
+		}
+
+		if( m_type == Formantfilter ||
+			m_type == FastFormant )
+		{
+			_freq = qBound( minFreq(), _freq, 20000.0f ); // limit freq and q for not getting bad noise out of the filter...
+
+			// formats for a, e, i, o, u, a
+			static const float _f[6][2] = { { 1000, 1400 }, { 500, 2300 },
+							{ 320, 3200 },
+							{ 500, 1000 },
+							{ 320, 800 },
+							{ 1000, 1400 } };
+			static const float freqRatio = 4.0f / 14000.0f;
+
+			// Stretch Q/resonance
+			m_vfq = _q * 0.25f;
+
+			// frequency in lmms ranges from 1Hz to 14000Hz
+			const float vowelf = _freq * freqRatio;
+			const int vowel = static_cast<int>( vowelf );
+			const float fract = vowelf - vowel;
+
+			// interpolate between formant frequencies
+			const float f0 = 1.0f / ( linearInterpolate( _f[vowel+0][0], _f[vowel+1][0], fract ) * F_2PI );
+			const float f1 = 1.0f / ( linearInterpolate( _f[vowel+0][1], _f[vowel+1][1], fract ) * F_2PI );
+
+			// samplerate coeff: depends on oversampling
+			const float sr = m_type == FastFormant ? m_sampleRatio : m_sampleRatio * 0.25f;
+
+			m_vfa[0] = 1.0f - sr / ( f0 + sr );
+			m_vfb[0] = 1.0f - m_vfa[0];
+			m_vfc[0] = f0 /	( f0 + sr );
+			m_vfa[1] = 1.0f - sr / ( f1 + sr );
+			m_vfb[1] = 1.0f - m_vfa[1];
+			m_vfc[1] = f1 /	( f1 + sr );
+			return;
+		}
+
+		if( m_type == Moog ||
+			m_type == DoubleMoog )
+		{
+			// [ 0 - 0.5 ]
+			const float f = qBound( minFreq(), _freq, 20000.0f ) * m_sampleRatio;
+			// (Empirical tunning)
+			m_p = ( 3.6f - 3.2f * f ) * f;
+			m_k = 2.0f * m_p - 1;
+			m_r = _q * powf( F_E, ( 1 - m_p ) * 1.386249f );
+
+			if( m_doubleFilter )
+			{
+				m_subFilter->m_r = m_r;
+				m_subFilter->m_p = m_p;
+				m_subFilter->m_k = m_k;
+			}
+			return;
+		}
+		
+		if( m_type == Tripole )
+		{
+			const float f = qBound( 20.0f, _freq, 20000.0f ) * m_sampleRatio * 0.25f;
+			
+			m_p = ( 3.6f - 3.2f * f ) * f;
+			m_k = 2.0f * m_p - 1.0f;
+			m_r = _q * 0.1f * powf( F_E, ( 1 - m_p ) * 1.386249f );
+			
+			return;
+		}
+
+		if( m_type == Lowpass_SV || 
+			m_type == Bandpass_SV ||
+			m_type == Highpass_SV ||
+			m_type == Notch_SV )
+		{
+			const float f = sinf( qMax( minFreq(), _freq ) * m_sampleRatio * F_PI );
+			m_svf1 = qMin( f, 0.825f );
+			m_svf2 = qMin( f * 2.0f, 0.825f );
+			m_svq = qMax( 0.0001f, 2.0f - ( _q * 0.1995f ) );
+			return;
+		}
+
+		// other filters
+		_freq = qBound( minFreq(), _freq, 20000.0f );
+		const float omega = F_2PI * _freq * m_sampleRatio;
+		const float tsin = sinf( omega ) * 0.5f;
+		const float tcos = cosf( omega );
+
+		const float alpha = tsin / _q;
+
+		const float a0 = 1.0f / ( 1.0f + alpha );
+
+		const float a1 = -2.0f * tcos * a0;
+		const float a2 = ( 1.0f - alpha ) * a0;
+
+		switch( m_type )
+		{
+			case LowPass:
+			{
+				const float b1 = ( 1.0f - tcos ) * a0;
+				const float b0 = b1 * 0.5f;
+				m_biQuad.setCoeffs( a1, a2, b0, b1, b0 );
+				break;
+			}
+			case HiPass:
+			{
+				const float b1 = ( -1.0f - tcos ) * a0;
+				const float b0 = b1 * -0.5f;
+				m_biQuad.setCoeffs( a1, a2, b0, b1, b0 );
+				break;
+			}
+			case BandPass_CSG:
+			{
+				const float b0 = tsin * a0;
+				m_biQuad.setCoeffs( a1, a2, b0, 0.0f, -b0 );
+				break;
+			}
+			case BandPass_CZPG:
+			{
+				const float b0 = alpha * a0;
+				m_biQuad.setCoeffs( a1, a2, b0, 0.0f, -b0 );
+				break;
+			}
+			case Notch:
+			{
+				m_biQuad.setCoeffs( a1, a2, a0, a1, a0 );
+				break;
+			}
+			case AllPass:
+			{
+				m_biQuad.setCoeffs( a1, a2, a2, a1, 1.0f );
+				break;
+			}
+			default:
+				break;
+		}
+
+		if( m_doubleFilter )
+		{
+			m_subFilter->m_biQuad.setCoeffs( m_biQuad.m_a1, m_biQuad.m_a2, m_biQuad.m_b0, m_biQuad.m_b1, m_biQuad.m_b2 );
+		}
+	}
+
+
+private:
+	// indices of all coefficients in arrays used for interpolating them
+	enum Coeffs
+	{
+		BiQuadA1, BiQuadA2, BiQuadB0, BiQuadB1, BiQuadB2,
+		MoogR, MoogP, MoogK,
+		RcA, RcB, RcC, RcQ,
+		VfA0, VfA1, VfB0, VfB1, VfC0, VfC1, VfQ,
+		SvF1, SvF2, SvQ,
+		NumCoeffs
+	} ;
+
+	inline void saveCoeffs( float * _c ) const
+	{
+		_c[BiQuadA1] = m_biQuad.m_a1;
+		_c[BiQuadA2] = m_biQuad.m_a2;
+		_c[BiQuadB0] = m_biQuad.m_b0;
+		_c[BiQuadB1] = m_biQuad.m_b1;
+		_c[BiQuadB2] = m_biQuad.m_b2;
+		_c[MoogR] = m_r;
+		_c[MoogP] = m_p;
+		_c[MoogK] = m_k;
+		_c[RcA] = m_rca;
+		_c[RcB] = m_rcb;
+		_c[RcC] = m_rcc;
+		_c[RcQ] = m_rcq;
+		_c[VfA0] = m_vfa[0];
+		_c[VfA1] = m_vfa[1];
+		_c[VfB0] = m_vfb[0];
+		_c[VfB1] = m_vfb[1];
+		_c[VfC0] = m_vfc[0];
+		_c[VfC1] = m_vfc[1];
+		_c[VfQ] = m_vfq;
+		_c[SvF1] = m_svf1;
+		_c[SvF2] = m_svf2;
+		_c[SvQ] = m_svq;
+	}
+
+	inline void loadCoeffs( const float * _c )
+	{
+		m_biQuad.setCoeffs( _c[BiQuadA1], _c[BiQuadA2],
+				_c[BiQuadB0], _c[BiQuadB1], _c[BiQuadB2] );
+		m_r = _c[MoogR];
+		m_p = _c[MoogP];
+		m_k = _c[MoogK];
+		m_rca = _c[RcA];
+		m_rcb = _c[RcB];
+		m_rcc = _c[RcC];
+		m_rcq = _c[RcQ];
+		m_vfa[0] = _c[VfA0];
+		m_vfa[1] = _c[VfA1];
+		m_vfb[0] = _c[VfB0];
+		m_vfb[1] = _c[VfB1];
+		m_vfc[0] = _c[VfC0];
+		m_vfc[1] = _c[VfC1];
+		m_vfq = _c[VfQ];
+		m_svf1 = _c[SvF1];
+		m_svf2 = _c[SvF2];
+		m_svq = _c[SvQ];
+		if( m_doubleFilter )
+		{
+			m_subFilter->loadCoeffs( _c );
+		}
+	}
+
+	// advances only the coefficients the kernel of given type uses
+	template<FilterTypes TYPE>
+	inline void stepCoeffs( const float * _step )
+	{
+		switch( TYPE )
+		{
+			case Moog:
+			case Tripole:
+				m_r += _step[MoogR];
+				m_p += _step[MoogP];
+				m_k += _step[MoogK];
+				break;
+			case Lowpass_SV:
+			case Bandpass_SV:
+			case Highpass_SV:
+			case Notch_SV:
+				m_svf1 += _step[SvF1];
+				m_svf2 += _step[SvF2];
+				m_svq += _step[SvQ];
+				break;
+			case Lowpass_RC12:
+			case Bandpass_RC12:
+			case Highpass_RC12:
+			case Lowpass_RC24:
+			case Bandpass_RC24:
+			case Highpass_RC24:
+				m_rca += _step[RcA];
+				m_rcb += _step[RcB];
+				m_rcc += _step[RcC];
+				m_rcq += _step[RcQ];
+				break;
+			case Formantfilter:
+			case FastFormant:
+				m_vfa[0] += _step[VfA0];
+				m_vfa[1] += _step[VfA1];
+				m_vfb[0] += _step[VfB0];
+				m_vfb[1] += _step[VfB1];
+				m_vfc[0] += _step[VfC0];
+				m_vfc[1] += _step[VfC1];
+				m_vfq += _step[VfQ];
+				break;
+			default:
+				m_biQuad.m_a1 += _step[BiQuadA1];
+				m_biQuad.m_a2 += _step[BiQuadA2];
+				m_biQuad.m_b0 += _step[BiQuadB0];
+				m_biQuad.m_b1 += _step[BiQuadB1];
+				m_biQuad.m_b2 += _step[BiQuadB2];
+				break;
+		}
+		if( m_doubleFilter )
+		{
+			m_subFilter->template stepCoeffs<TYPE>( _step );
+		}
+	}
+
+	// filters a stereo block, stepping the coefficients by _step per
+	// frame if STEP is set
+	template<FilterTypes TYPE, bool STEP>
+	inline void processKernel( sampleFrame * _buf, const fpp_t _frames,
+							const float * _step )
+	{
+		static_assert( CHANNELS == DEFAULT_CHANNELS,
+				"block processing requires stereo filters" );
+		for( fpp_t f = 0; f < _frames; ++f )
+		{
+			if( STEP )
+			{
+				stepCoeffs<TYPE>( _step );
+			}
+			_buf[f][0] = updateKernel<TYPE>( _buf[f][0], 0 );
+			_buf[f][1] = updateKernel<TYPE>( _buf[f][1], 1 );
+		}
+	}
+
+	template<bool STEP>
+	inline void processFrames( sampleFrame * _buf, const fpp_t _frames,
+							const float * _step )
+	{
+		switch( m_type )
+		{
+			case Moog: processKernel<Moog, STEP>( _buf, _frames, _step ); break;
+			case Tripole: processKernel<Tripole, STEP>( _buf, _frames, _step ); break;
+			case Lowpass_SV: processKernel<Lowpass_SV, STEP>( _buf, _frames, _step ); break;
+			case Bandpass_SV: processKernel<Bandpass_SV, STEP>( _buf, _frames, _step ); break;
+			case Highpass_SV: processKernel<Highpass_SV, STEP>( _buf, _frames, _step ); break;
+			case Notch_SV: processKernel<Notch_SV, STEP>( _buf, _frames, _step ); break;
+			case Lowpass_RC12: processKernel<Lowpass_RC12, STEP>( _buf, _frames, _step ); break;
+			case Bandpass_RC12: processKernel<Bandpass_RC12, STEP>( _buf, _frames, _step ); break;
+			case Highpass_RC12: processKernel<Highpass_RC12, STEP>( _buf, _frames, _step ); break;
+			case Lowpass_RC24: processKernel<Lowpass_RC24, STEP>( _buf, _frames, _step ); break;
+			case Bandpass_RC24: processKernel<Bandpass_RC24, STEP>( _buf, _frames, _step ); break;
+			case Highpass_RC24: processKernel<Highpass_RC24, STEP>( _buf, _frames, _step ); break;
+			case Formantfilter: processKernel<Formantfilter, STEP>( _buf, _frames, _step ); break;
+			case FastFormant: processKernel<FastFormant, STEP>( _buf, _frames, _step ); break;
+			default: processKernel<LowPass, STEP>( _buf, _frames, _step ); break;
+		}
+	}
+
+	// the filter for one type, the switch gets resolved at compile time
+	template<FilterTypes TYPE>
+	inline sample_t updateKernel( sample_t _in0, ch_cnt_t _chnl )
+	{
+		sample_t out;
+		switch( TYPE )
 		{
 			case Moog:
 			{
@@ -420,7 +839,7 @@ public:
 				}
 
 				/* mix filter output into output buffer */
-				return m_type == Lowpass_SV 
+				return TYPE == Lowpass_SV 
 					? m_delay4[_chnl]
 					: m_delay3[_chnl];
 			}
@@ -507,7 +926,7 @@ public:
 					m_rchp0[_chnl] = hp;
 					m_rcbp0[_chnl] = bp;
 				}
-				return m_type == Highpass_RC12 ? hp : bp;
+				return TYPE == Highpass_RC12 ? hp : bp;
 			}
 
 			case Lowpass_RC24:
@@ -574,7 +993,7 @@ public:
 					m_rcbp0[_chnl] = bp;
 
 					// second stage gets the output of the first stage as input...
-					in = m_type == Highpass_RC24
+					in = TYPE == Highpass_RC24
 						? hp + m_rcbp1[_chnl] * m_rcq
 						: bp + m_rcbp1[_chnl] * m_rcq;
 
@@ -590,7 +1009,7 @@ public:
 					m_rchp1[_chnl] = hp;
 					m_rcbp1[_chnl] = bp;
 				}
-				return m_type == Highpass_RC24 ? hp : bp;
+				return TYPE == Highpass_RC24 ? hp : bp;
 			}
 
 			case Formantfilter:
@@ -600,7 +1019,7 @@ public:
 				sample_t hp, bp, in;
 
 				out = 0;
-				const int os = m_type == FastFormant ? 1 : 4; // no oversampling for fast formant
+				const int os = TYPE == FastFormant ? 1 : 4; // no oversampling for fast formant
 				for( int o = 0; o < os; ++o )
 				{
 					// first formant
@@ -687,7 +1106,7 @@ public:
 
 					out += bp;
 				}
-            	return m_type == FastFormant ? out * 2.0f : out * 0.5f;
+            	return TYPE == FastFormant ? out * 2.0f : out * 0.5f;
 			}
 
 			default:
@@ -697,7 +1116,7 @@ public:
 
 		if( m_doubleFilter )
 		{
-			return m_subFilter->update( out, _chnl );
+			return m_subFilter->template updateKernel<TYPE>( out, _chnl );
 		}
 
 		// Clipper band limited sigmoid
@@ -705,173 +1124,7 @@ public:
 	}
 
 
-	inline void calcFilterCoeffs( float _freq, float _q )
-	{
-		// temp coef vars
-		_q = qMax( _q, minQ() );
-
-		if( m_type == Lowpass_RC12  ||
-			m_type == Bandpass_RC12 ||
-			m_type == Highpass_RC12 ||
-			m_type == Lowpass_RC24 ||
-			m_type == Bandpass_RC24 ||
-			m_type == Highpass_RC24 )
-		{
-			_freq = qBound( 50.0f, _freq, 20000.0f );
-			const float sr = m_sampleRatio * 0.25f;
-			const float f = 1.0f / ( _freq * F_2PI );
-			
-			m_rca = 1.0f - sr / ( f + sr );
-			m_rcb = 1.0f - m_rca;
-			m_rcc = f / ( f + sr );
-
-			// Stretch Q/resonance, as self-oscillation reliably starts at a q of ~2.5 - ~2.6
-			m_rcq = _q * 0.25f;
-			return;
-		}
-
-		if( m_type == Formantfilter ||
-			m_type == FastFormant )
-		{
-			_freq = qBound( minFreq(), _freq, 20000.0f ); // limit freq and q for not getting bad noise out of the filter...
-
-			// formats for a, e, i, o, u, a
-			static const float _f[6][2] = { { 1000, 1400 }, { 500, 2300 },
-							{ 320, 3200 },
-							{ 500, 1000 },
-							{ 320, 800 },
-							{ 1000, 1400 } };
-			static const float freqRatio = 4.0f / 14000.0f;
-
-			// Stretch Q/resonance
-			m_vfq = _q * 0.25f;
-
-			// frequency in lmms ranges from 1Hz to 14000Hz
-			const float vowelf = _freq * freqRatio;
-			const int vowel = static_cast<int>( vowelf );
-			const float fract = vowelf - vowel;
-
-			// interpolate between formant frequencies
-			const float f0 = 1.0f / ( linearInterpolate( _f[vowel+0][0], _f[vowel+1][0], fract ) * F_2PI );
-			const float f1 = 1.0f / ( linearInterpolate( _f[vowel+0][1], _f[vowel+1][1], fract ) * F_2PI );
-
-			// samplerate coeff: depends on oversampling
-			const float sr = m_type == FastFormant ? m_sampleRatio : m_sampleRatio * 0.25f;
-
-			m_vfa[0] = 1.0f - sr / ( f0 + sr );
-			m_vfb[0] = 1.0f - m_vfa[0];
-			m_vfc[0] = f0 /	( f0 + sr );
-			m_vfa[1] = 1.0f - sr / ( f1 + sr );
-			m_vfb[1] = 1.0f - m_vfa[1];
-			m_vfc[1] = f1 /	( f1 + sr );
-			return;
-		}
-
-		if( m_type == Moog ||
-			m_type == DoubleMoog )
-		{
-			// [ 0 - 0.5 ]
-			const float f = qBound( minFreq(), _freq, 20000.0f ) * m_sampleRatio;
-			// (Empirical tunning)
-			m_p = ( 3.6f - 3.2f * f ) * f;
-			m_k = 2.0f * m_p - 1;
-			m_r = _q * powf( F_E, ( 1 - m_p ) * 1.386249f );
-
-			if( m_doubleFilter )
-			{
-				m_subFilter->m_r = m_r;
-				m_subFilter->m_p = m_p;
-				m_subFilter->m_k = m_k;
-			}
-			return;
-		}
-		
-		if( m_type == Tripole )
-		{
-			const float f = qBound( 20.0f, _freq, 20000.0f ) * m_sampleRatio * 0.25f;
-			
-			m_p = ( 3.6f - 3.2f * f ) * f;
-			m_k = 2.0f * m_p - 1.0f;
-			m_r = _q * 0.1f * powf( F_E, ( 1 - m_p ) * 1.386249f );
-			
-			return;
-		}
-
-		if( m_type == Lowpass_SV || 
-			m_type == Bandpass_SV ||
-			m_type == Highpass_SV ||
-			m_type == Notch_SV )
-		{
-			const float f = sinf( qMax( minFreq(), _freq ) * m_sampleRatio * F_PI );
-			m_svf1 = qMin( f, 0.825f );
-			m_svf2 = qMin( f * 2.0f, 0.825f );
-			m_svq = qMax( 0.0001f, 2.0f - ( _q * 0.1995f ) );
-			return;
-		}
-
-		// other filters
-		_freq = qBound( minFreq(), _freq, 20000.0f );
-		const float omega = F_2PI * _freq * m_sampleRatio;
-		const float tsin = sinf( omega ) * 0.5f;
-		const float tcos = cosf( omega );
-
-		const float alpha = tsin / _q;
-
-		const float a0 = 1.0f / ( 1.0f + alpha );
-
-		const float a1 = -2.0f * tcos * a0;
-		const float a2 = ( 1.0f - alpha ) * a0;
-
-		switch( m_type )
-		{
-			case LowPass:
-			{
-				const float b1 = ( 1.0f - tcos ) * a0;
-				const float b0 = b1 * 0.5f;
-				m_biQuad.setCoeffs( a1, a2, b0, b1, b0 );
-				break;
-			}
-			case HiPass:
-			{
-				const float b1 = ( -1.0f - tcos ) * a0;
-				const float b0 = b1 * -0.5f;
-				m_biQuad.setCoeffs( a1, a2, b0, b1, b0 );
-				break;
-			}
-			case BandPass_CSG:
-			{
-				const float b0 = tsin * a0;
-				m_biQuad.setCoeffs( a1, a2, b0, 0.0f, -b0 );
-				break;
-			}
-			case BandPass_CZPG:
-			{
-				const float b0 = alpha * a0;
-				m_biQuad.setCoeffs( a1, a2, b0, 0.0f, -b0 );
-				break;
-			}
-			case Notch:
-			{
-				m_biQuad.setCoeffs( a1, a2, a0, a1, a0 );
-				break;
-			}
-			case AllPass:
-			{
-				m_biQuad.setCoeffs( a1, a2, a2, a1, 1.0f );
-				break;
-			}
-			default:
-				break;
-		}
-
-		if( m_doubleFilter )
-		{
-			m_subFilter->m_biQuad.setCoeffs( m_biQuad.m_a1, m_biQuad.m_a2, m_biQuad.m_b0, m_biQuad.m_b1, m_biQuad.m_b2 );
-		}
-	}
-
 
-private:
 	// biquad filter
 	BiQuad<CHANNELS> m_biQuad;
 
@@ -906,6 +1159,8 @@ private:
 
 	FilterTypes m_type;
 	bool m_doubleFilter;
+	// false until coefficients for the current type got calculated
+	bool m_coeffsValid;
 
 	float m_sampleRate;
 	float m_sampleRatio;
@@ -28,12 +28,23 @@
 
 #include "lmms_export.h"
 #include "lmms_basics.h"
+#include "PlanarBuffer.h"
 
+/*! \brief Pool of period-sized audio buffers
+ *
+ *  Buffers are aligned to 64 bytes and put back on a free list when released,
+ *  so acquiring a buffer while playing doesn't hit the allocator. Interleaved
+ *  and planar buffers come from the same pool.
+ */
 class LMMS_EXPORT BufferManager
 {
 public:
+	//! Has to be called before the first buffer is acquired. Buffers
+	//! acquired before are still valid, their memory is freed once all of
+	//! them got released.
 	static void init( fpp_t framesPerPeriod );
 	static sampleFrame * acquire();
+	static PlanarBuffer acquirePlanar();
 	// audio-buffer-mgm
 	static void clear( sampleFrame * ab, const f_cnt_t frames,
 						const f_cnt_t offset = 0 );
@@ -42,6 +53,7 @@ public:
 						const f_cnt_t offset = 0 );
 #endif
 	static void release( sampleFrame * buf );
+	static void release( const PlanarBuffer & buf );
 };
 
 #endif
@@ -32,6 +32,7 @@
 #include "lmms_export.h"
 #include "MemoryManager.h"
 
+class QIODevice;
 class QTextStream;
 
 class LMMS_EXPORT DataFile : public QDomDocument
@@ -114,6 +115,21 @@ private:
 
 	void loadData( const QByteArray & _data, const QString & _sourceFile );
 
+	//! Returns true for the output of qCompress(), i.e. mmpz files
+	static bool isCompressed( const QByteArray & data );
+	//! Builds the document from XML or compressed XML, whichever of both
+	//! the data turns out to be. Returns false and sets error if neither.
+	bool parse( QIODevice & device, QString & error );
+	bool parseCompressed( QIODevice & device, QString & error );
+	//! Appends everything a QXmlStreamReader delivers to the document
+	bool parseXml( QIODevice & device, QString & error );
+	void reportError( const QString & error, const QString & sourceFile );
+	//! Tells about projects created with other LMMS versions, returns
+	//! whether the document needs to be upgraded
+	bool checkVersion( const QString & creatorVersion,
+					const QString & sourceFile ) const;
+	void findHeadAndContent();
+
 
 	struct LMMS_EXPORT typeDescStruct
 	{
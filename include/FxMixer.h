@@ -28,10 +28,13 @@
 #include "Model.h"
 #include "EffectChain.h"
 #include "JournallingObject.h"
+#include "PlanarBuffer.h"
 #include "ThreadableJob.h"
 
 #include <atomic>
+#include <vector>
 
+class AudioPort;
 class FxRoute;
 typedef QVector<FxRoute *> FxRouteVector;
 
@@ -51,14 +54,16 @@ class FxChannel : public ThreadableJob
 		float m_peakLeft;
 		float m_peakRight;
 		sampleFrame * m_buffer;
+		// the sends get summed up in planar layout, where the mixing loops
+		// vectorize without shuffling channels. Holds the sum while the
+		// channel gets processed and m_buffer for the receivers afterwards.
+		PlanarBuffer m_planarBuffer;
 		bool m_muteBeforeSolo;
 		BoolModel m_muteModel;
 		BoolModel m_soloModel;
 		FloatModel m_volumeModel;
 		QString m_name;
-		QMutex m_lock;
 		int m_channelIndex; // what channel index are we
-		bool m_queued; // are we queued up for rendering yet?
 		bool m_muted; // are we muted? updated per period so we don't have to call m_muteModel.value() twice
 
 		// pointers to other channels that this one sends to
@@ -68,13 +73,29 @@ class FxChannel : public ThreadableJob
 		FxRouteVector m_receives;
 
 		virtual bool requiresProcessing() const { return true; }
+		virtual ProfilingTarget profilingTarget() const;
 		void unmuteForSolo();
 
-	
-		std::atomic_int m_dependenciesMet;
-		void incrementDeps();
+
+		// number of senders and audio ports which still have to deliver
+		// their output in the current period before we can be processed
+		std::atomic_int m_pendingDependencies;
+		void resolveDependency();
 		void processed();
-		
+
+		// audio ports are summed up by every worker on its own, so
+		// they never wait for each other, and merged into m_buffer
+		// right before the channel gets processed
+		struct PartialSum
+		{
+			sampleFrame * buffer;
+			// set once the worker mixed anything in this period
+			bool used;
+		} ;
+		std::vector<PartialSum> m_partialSums;
+		void resizePartialSums( int workers );
+		void mixPartialSums();
+
 	private:
 		virtual void doProcessing();
 };
@@ -131,6 +152,10 @@ public:
 	void mixToChannel( const sampleFrame * _buf, fx_ch_t _ch );
 
 	void prepareMasterMix();
+	// process the effects of all audio ports and all FX channels in a
+	// single job round - every channel gets processed as soon as all of
+	// its inputs are complete
+	void processChannels( const QVector<AudioPort *> & _ports );
 	void masterMix( sampleFrame * _buf );
 
 	virtual void saveSettings( QDomDocument & _doc, QDomElement & _parent );
@@ -203,6 +228,15 @@ private:
 	// make sure we have at least num channels
 	void allocateChannelsTo(int num);
 
+	// compile the routing graph into m_graphOrder, called by the mixer
+	// thread whenever routing changed since the last period
+	void rebuildGraph();
+
+	// all channels in topological order, i.e. every channel comes
+	// after all channels sending to it
+	QVector<FxChannel *> m_graphOrder;
+	std::atomic_bool m_graphDirty;
+
 	int m_lastSoloed;
 
 } ;
@@ -28,14 +28,24 @@
 #include <atomic>
 #include <stddef.h>
 
-class LocklessAllocator
+#include "lmms_export.h"
+
+class LMMS_EXPORT LocklessAllocator
 {
 public:
 	LocklessAllocator( size_t nmemb, size_t size );
 	virtual ~LocklessAllocator();
 	void * alloc();
+	// like alloc(), but doesn't complain when there's no free space left
+	void * tryAlloc();
 	void free( void * ptr );
 
+	bool contains( const void * ptr ) const
+	{
+		return (const char *)ptr >= m_pool &&
+			(const char *)ptr < m_pool + m_capacity * m_elementSize;
+	}
+
 
 private:
 	char * m_pool;
@@ -71,6 +81,13 @@ public:
 		return (T *)LocklessAllocator::alloc();
 	}
 
+	T * tryAlloc()
+	{
+		return (T *)LocklessAllocator::tryAlloc();
+	}
+
+	using LocklessAllocator::contains;
+
 	void free( T * ptr )
 	{
 		LocklessAllocator::free( ptr );
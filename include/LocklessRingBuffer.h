@@ -0,0 +1,103 @@
+/*
+ * LocklessRingBuffer.h - fixed-size ring buffer for one reader and one writer
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LOCKLESS_RING_BUFFER_H
+#define LOCKLESS_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*! \brief Ring of preallocated slots passed from one writer thread to one
+ *  reader thread without locking
+ *
+ *  Slots are filled and read in place, so elements holding containers keep
+ *  their capacity and nothing gets allocated once the ring has warmed up.
+ *  The writer never blocks, it just gets no slot while the ring is full.
+ */
+template<typename T>
+class LocklessRingBuffer
+{
+public:
+	LocklessRingBuffer( size_t capacity ) :
+		m_slots( capacity + 1 ),
+		m_read( 0 ),
+		m_write( 0 )
+	{
+	}
+
+	//! Returns the slot to fill next or NULL if the ring is full
+	T * beginWrite()
+	{
+		const size_t write = m_write.load( std::memory_order_relaxed );
+		if( next( write ) == m_read.load( std::memory_order_acquire ) )
+		{
+			return NULL;
+		}
+		return &m_slots[write];
+	}
+
+	//! Makes the slot returned by beginWrite() available to the reader
+	void endWrite()
+	{
+		const size_t write = m_write.load( std::memory_order_relaxed );
+		m_write.store( next( write ), std::memory_order_release );
+	}
+
+	//! Returns the oldest filled slot or NULL if the ring is empty
+	T * beginRead()
+	{
+		const size_t read = m_read.load( std::memory_order_relaxed );
+		if( read == m_write.load( std::memory_order_acquire ) )
+		{
+			return NULL;
+		}
+		return &m_slots[read];
+	}
+
+	//! Hands the slot returned by beginRead() back to the writer
+	void endRead()
+	{
+		const size_t read = m_read.load( std::memory_order_relaxed );
+		m_read.store( next( read ), std::memory_order_release );
+	}
+
+private:
+	size_t next( size_t index ) const
+	{
+		return index + 1 < m_slots.size() ? index + 1 : 0;
+	}
+
+	std::vector<T> m_slots;
+	// keep reader and writer positions on separate cache lines. Padding
+	// instead of alignas(), over-aligned types can't be allocated with
+	// plain new before C++17.
+	char m_pad0[64];
+	std::atomic<size_t> m_read;
+	char m_pad1[64 - sizeof( std::atomic<size_t> )];
+	std::atomic<size_t> m_write;
+	char m_pad2[64 - sizeof( std::atomic<size_t> )];
+
+} ;
+
+
+#endif
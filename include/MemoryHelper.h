@@ -32,6 +32,7 @@ class MemoryHelper {
 public:
 
 	static void* alignedMalloc( size_t );
+	static void* alignedMalloc( size_t, size_t alignment );
 
 	static void alignedFree( void* );
 
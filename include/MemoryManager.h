@@ -43,6 +43,11 @@ public:
 
 	static void * alloc( size_t size );
 	static void free( void * ptr );
+
+	//! While enabled, alloc() calls are counted - used for checking that
+	//! rendering doesn't allocate
+	static void setCountingAllocations( bool enabled );
+	static long long allocationCount();
 };
 
 template<typename T>
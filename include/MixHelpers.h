@@ -27,6 +27,7 @@
 
 #include "lmms_basics.h"
 
+class PlanarBuffer;
 class ValueBuffer;
 namespace MixHelpers
 {
@@ -69,6 +70,43 @@ void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float c
 /*! \brief Multiply dst by coeffDst and add samples from srcLeft/srcRight multiplied by coeffSrc */
 void multiplyAndAddMultipliedJoined( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames );
 
+
+/*! \brief Planar version of isSilent() */
+bool isSilent( const PlanarBuffer& src, int frames );
+
+/*! \brief Add samples from planar src to planar dst */
+void add( const PlanarBuffer& dst, const PlanarBuffer& src, int frames );
+
+/*! \brief Add samples from planar src multiplied by coeffSrc to planar dst */
+void addMultiplied( const PlanarBuffer& dst, const PlanarBuffer& src, float coeffSrc, int frames );
+
+/*! \brief Planar version of addSanitizedMultiplied() */
+void addSanitizedMultiplied( const PlanarBuffer& dst, const PlanarBuffer& src, float coeffSrc, int frames );
+
+/*! \brief Planar version of addSanitizedMultipliedByBuffer() */
+void addSanitizedMultipliedByBuffer( const PlanarBuffer& dst, const PlanarBuffer& src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames );
+
+/*! \brief Planar version of addSanitizedMultipliedByBuffers() */
+void addSanitizedMultipliedByBuffers( const PlanarBuffer& dst, const PlanarBuffer& src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames );
+
+/*! \brief Instruction sets the interleaved functions above have implementations for */
+enum class InstructionSet
+{
+	Generic,
+	SSE2,
+	AVX2,
+	AVX512
+} ;
+
+/*! \brief Returns the instruction set currently in use - the best one supported by the CPU unless changed */
+InstructionSet instructionSet();
+
+/*! \brief Returns whether this build and the CPU support given instruction set */
+bool isSupported( InstructionSet set );
+
+/*! \brief Switch to given instruction set, returns false if it isn't supported - not thread-safe, for testing only */
+bool setInstructionSet( InstructionSet set );
+
 }
 
 #endif
@@ -0,0 +1,278 @@
+/*
+ * MixHelpersKernels.h - instruction set specific implementations of MixHelpers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef MIX_HELPERS_KERNELS_H
+#define MIX_HELPERS_KERNELS_H
+
+#include "lmms_basics.h"
+
+namespace MixHelpers
+{
+
+/*! \brief Table of MixHelpers implementations for one instruction set
+ *
+ *  MixHelpers.cpp picks one of these at startup. Value buffers are passed as
+ *  plain arrays here.
+ */
+struct Kernels
+{
+	bool (*isSilent)( const sampleFrame* src, int frames );
+	bool (*sanitize)( sampleFrame* src, int frames );
+	void (*add)( sampleFrame* dst, const sampleFrame* src, int frames );
+	void (*addMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames );
+	void (*addMultipliedByBuffer)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames );
+	void (*addMultipliedByBuffers)( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames );
+	void (*addSanitizedMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames );
+	void (*addSanitizedMultipliedByBuffer)( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames );
+	void (*addSanitizedMultipliedByBuffers)( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames );
+	void (*addMultipliedStereo)( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames );
+	void (*multiplyAndAddMultiplied)( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames );
+	void (*multiplyAndAddMultipliedJoined)( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames );
+} ;
+
+extern const Kernels genericKernels;
+extern const Kernels sse2Kernels;
+extern const Kernels avx2Kernels;
+extern const Kernels avx512Kernels;
+
+
+
+/*! \brief Kernels built on a vector type
+ *
+ *  V wraps the intrinsics of one instruction set and is only instantiated in
+ *  a translation unit compiled for it. All operations are done in the same
+ *  order as in the generic implementation so results are bit-exact. Frames
+ *  left over at the end are passed to the generic kernels.
+ *
+ *  V has to provide:
+ *    Type, Size (floats per vector), load(), store(), set1(), add(), mul(),
+ *    min(), max(), abs(),
+ *    keepFinite( x, y ) - y where x is finite, 0 elsewhere,
+ *    anyGreaterEqual( a, b ), anyNonFinite( x ),
+ *    dupPairs( c, lo, hi ) - Size values of c, each one doubled,
+ *    interleave( l, r, lo, hi ) - Size values of l and r, interleaved
+ */
+template<class V>
+struct VectorKernels
+{
+	typedef typename V::Type Vec;
+
+	// frames per vector
+	static const int Step = V::Size / 2;
+
+	static bool isSilent( const sampleFrame* src, int frames )
+	{
+		const Vec threshold = V::set1( 0.0000001f );
+		int f = 0;
+		for( ; f + Step <= frames; f += Step )
+		{
+			if( V::anyGreaterEqual( V::abs( V::load( src[f] ) ), threshold ) )
+			{
+				return false;
+			}
+		}
+		return genericKernels.isSilent( src + f, frames - f );
+	}
+
+	static bool sanitize( sampleFrame* src, int frames )
+	{
+		const Vec lower = V::set1( -4.0f );
+		const Vec upper = V::set1( 4.0f );
+		bool found = false;
+		int f = 0;
+		for( ; f + Step <= frames; f += Step )
+		{
+			const Vec x = V::load( src[f] );
+			found |= V::anyNonFinite( x );
+			V::store( src[f], V::keepFinite( x, V::max( V::min( x, upper ), lower ) ) );
+		}
+		return genericKernels.sanitize( src + f, frames - f ) || found;
+	}
+
+	static void add( sampleFrame* dst, const sampleFrame* src, int frames )
+	{
+		int f = 0;
+		for( ; f + Step <= frames; f += Step )
+		{
+			V::store( dst[f], V::add( V::load( dst[f] ), V::load( src[f] ) ) );
+		}
+		genericKernels.add( dst + f, src + f, frames - f );
+	}
+
+	static void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+	{
+		const Vec coeff = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + Step <= frames; f += Step )
+		{
+			V::store( dst[f], V::add( V::load( dst[f] ), V::mul( V::load( src[f] ), coeff ) ) );
+		}
+		genericKernels.addMultiplied( dst + f, src + f, coeffSrc, frames - f );
+	}
+
+	static void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+	{
+		const Vec coeff = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + 2 * Step <= frames; f += 2 * Step )
+		{
+			Vec lo, hi;
+			V::dupPairs( coeffSrcBuf + f, lo, hi );
+			V::store( dst[f], V::add( V::load( dst[f] ),
+						V::mul( V::mul( V::load( src[f] ), coeff ), lo ) ) );
+			V::store( dst[f + Step], V::add( V::load( dst[f + Step] ),
+						V::mul( V::mul( V::load( src[f + Step] ), coeff ), hi ) ) );
+		}
+		genericKernels.addMultipliedByBuffer( dst + f, src + f, coeffSrc, coeffSrcBuf + f, frames - f );
+	}
+
+	static void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+	{
+		int f = 0;
+		for( ; f + 2 * Step <= frames; f += 2 * Step )
+		{
+			Vec lo1, hi1, lo2, hi2;
+			V::dupPairs( coeffSrcBuf1 + f, lo1, hi1 );
+			V::dupPairs( coeffSrcBuf2 + f, lo2, hi2 );
+			V::store( dst[f], V::add( V::load( dst[f] ),
+						V::mul( V::mul( V::load( src[f] ), lo1 ), lo2 ) ) );
+			V::store( dst[f + Step], V::add( V::load( dst[f + Step] ),
+						V::mul( V::mul( V::load( src[f + Step] ), hi1 ), hi2 ) ) );
+		}
+		genericKernels.addMultipliedByBuffers( dst + f, src + f, coeffSrcBuf1 + f, coeffSrcBuf2 + f, frames - f );
+	}
+
+	static void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+	{
+		const Vec coeff = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + Step <= frames; f += Step )
+		{
+			const Vec x = V::load( src[f] );
+			V::store( dst[f], V::add( V::load( dst[f] ), V::keepFinite( x, V::mul( x, coeff ) ) ) );
+		}
+		genericKernels.addSanitizedMultiplied( dst + f, src + f, coeffSrc, frames - f );
+	}
+
+	static void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+	{
+		const Vec coeff = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + 2 * Step <= frames; f += 2 * Step )
+		{
+			Vec lo, hi;
+			V::dupPairs( coeffSrcBuf + f, lo, hi );
+			const Vec x1 = V::load( src[f] );
+			const Vec x2 = V::load( src[f + Step] );
+			V::store( dst[f], V::add( V::load( dst[f] ),
+						V::keepFinite( x1, V::mul( V::mul( x1, coeff ), lo ) ) ) );
+			V::store( dst[f + Step], V::add( V::load( dst[f + Step] ),
+						V::keepFinite( x2, V::mul( V::mul( x2, coeff ), hi ) ) ) );
+		}
+		genericKernels.addSanitizedMultipliedByBuffer( dst + f, src + f, coeffSrc, coeffSrcBuf + f, frames - f );
+	}
+
+	static void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+	{
+		int f = 0;
+		for( ; f + 2 * Step <= frames; f += 2 * Step )
+		{
+			Vec lo1, hi1, lo2, hi2;
+			V::dupPairs( coeffSrcBuf1 + f, lo1, hi1 );
+			V::dupPairs( coeffSrcBuf2 + f, lo2, hi2 );
+			const Vec x1 = V::load( src[f] );
+			const Vec x2 = V::load( src[f + Step] );
+			V::store( dst[f], V::add( V::load( dst[f] ),
+						V::keepFinite( x1, V::mul( V::mul( x1, lo1 ), lo2 ) ) ) );
+			V::store( dst[f + Step], V::add( V::load( dst[f + Step] ),
+						V::keepFinite( x2, V::mul( V::mul( x2, hi1 ), hi2 ) ) ) );
+		}
+		genericKernels.addSanitizedMultipliedByBuffers( dst + f, src + f, coeffSrcBuf1 + f, coeffSrcBuf2 + f, frames - f );
+	}
+
+	static void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
+	{
+		float pair[V::Size];
+		for( int i = 0; i < V::Size; i += 2 )
+		{
+			pair[i] = coeffSrcLeft;
+			pair[i + 1] = coeffSrcRight;
+		}
+		const Vec coeffs = V::load( pair );
+		int f = 0;
+		for( ; f + Step <= frames; f += Step )
+		{
+			V::store( dst[f], V::add( V::load( dst[f] ), V::mul( V::load( src[f] ), coeffs ) ) );
+		}
+		genericKernels.addMultipliedStereo( dst + f, src + f, coeffSrcLeft, coeffSrcRight, frames - f );
+	}
+
+	static void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
+	{
+		const Vec cDst = V::set1( coeffDst );
+		const Vec cSrc = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + Step <= frames; f += Step )
+		{
+			V::store( dst[f], V::add( V::mul( V::load( dst[f] ), cDst ),
+							V::mul( V::load( src[f] ), cSrc ) ) );
+		}
+		genericKernels.multiplyAndAddMultiplied( dst + f, src + f, coeffDst, coeffSrc, frames - f );
+	}
+
+	static void multiplyAndAddMultipliedJoined( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames )
+	{
+		const Vec cDst = V::set1( coeffDst );
+		const Vec cSrc = V::set1( coeffSrc );
+		int f = 0;
+		for( ; f + 2 * Step <= frames; f += 2 * Step )
+		{
+			Vec lo, hi;
+			V::interleave( srcLeft + f, srcRight + f, lo, hi );
+			V::store( dst[f], V::add( V::mul( V::load( dst[f] ), cDst ), V::mul( lo, cSrc ) ) );
+			V::store( dst[f + Step], V::add( V::mul( V::load( dst[f + Step] ), cDst ), V::mul( hi, cSrc ) ) );
+		}
+		genericKernels.multiplyAndAddMultipliedJoined( dst + f, srcLeft + f, srcRight + f, coeffDst, coeffSrc, frames - f );
+	}
+
+	static constexpr Kernels table()
+	{
+		return {
+			isSilent,
+			sanitize,
+			add,
+			addMultiplied,
+			addMultipliedByBuffer,
+			addMultipliedByBuffers,
+			addSanitizedMultiplied,
+			addSanitizedMultipliedByBuffer,
+			addSanitizedMultipliedByBuffers,
+			addMultipliedStereo,
+			multiplyAndAddMultiplied,
+			multiplyAndAddMultipliedJoined
+		};
+	}
+} ;
+
+}
+
+#endif
@@ -31,6 +31,8 @@
 #include <QtCore/QWaitCondition>
 #include <samplerate.h>
 
+#include <atomic>
+
 
 #include "lmms_basics.h"
 #include "LocklessList.h"
@@ -42,6 +44,7 @@
 class AudioDevice;
 class MidiClient;
 class AudioPort;
+class StemExporter;
 
 
 const fpp_t MINIMUM_BUFFER_SIZE = 32;
@@ -61,6 +64,7 @@ const Octaves BaseOctave = DefaultOctave;
 
 
 #include "PlayHandle.h"
+#include "PlayHandleArray.h"
 
 
 class MixerWorkerThread;
@@ -153,6 +157,18 @@ public:
 		}
 	} ;
 
+	//! How periods get from the mixer to the audio device, only used
+	//! while the device is fed through the FIFO writer
+	enum PipelineModes
+	{
+		//! render each period in the device's callback
+		Pipeline_LowLatency,
+		//! render up to lookAhead() periods in advance in an extra
+		//! thread
+		Pipeline_LookAhead
+	} ;
+	static const int MaxLookAhead = 32;
+
 	void initDevices();
 	void clear();
 	void clearNewPlayHandles();
@@ -212,7 +228,7 @@ public:
 
 	void removePlayHandle( PlayHandle* handle );
 
-	inline PlayHandleList& playHandles()
+	inline PlayHandleArray& playHandles()
 	{
 		return m_playHandles;
 	}
@@ -226,6 +242,13 @@ public:
 		return m_framesPerPeriod;
 	}
 
+	// number of periods rendered so far, tells the current period from
+	// the previous ones
+	inline unsigned long periodCounter() const
+	{
+		return m_periodCounter;
+	}
+
 
 	MixerProfiler& profiler()
 	{
@@ -302,11 +325,26 @@ public:
 		return m_inputBufferFrames[ m_inputBufferRead ];
 	}
 
-	inline const surroundSampleFrame * nextBuffer()
+	//! Returns the next period for the audio device, i.e. the one
+	//! rendered last - no matter whether it got rendered ahead or right
+	//! now. The buffer stays valid until the next call.
+	const surroundSampleFrame * nextBuffer();
+
+	inline PipelineModes pipelineMode() const
 	{
-		return hasFifoWriter() ? m_fifo->read() : renderNextBuffer();
+		return static_cast<PipelineModes>( m_pipelineMode.load() );
 	}
 
+	inline int lookAhead() const
+	{
+		return m_lookAhead.load();
+	}
+
+	//! Switches the pipeline while the audio device keeps running. Periods
+	//! which already got rendered ahead are played before switching to
+	//! low latency mode.
+	void setPipelineMode( PipelineModes mode, int lookAhead );
+
 	void changeQuality( const struct qualitySettings & _qs );
 
 	inline bool isMetronomeActive() const { return m_metronomeActive; }
@@ -334,6 +372,8 @@ private:
 		fifoWriter( Mixer * _mixer, fifo * _fifo );
 
 		void finish();
+		// continue rendering after handing over to the audio device
+		void resume();
 
 
 	private:
@@ -341,9 +381,18 @@ private:
 		fifo * m_fifo;
 		volatile bool m_writing;
 
+		QMutex m_parkMutex;
+		QWaitCondition m_parkCondition;
+		bool m_resume;
+
 		virtual void run();
 
+		// returns false if the writer got finished while parking
+		bool park();
+		surroundSampleFrame * nextFreeBuffer();
 		void write( surroundSampleFrame * buffer );
+		void beginWaiting();
+		void endWaiting();
 
 	} ;
 
@@ -359,10 +408,18 @@ private:
 	MidiClient * tryMidiClients();
 
 
+	//! Renders the next period and returns it. The buffer stays untouched
+	//! while the period after it renders.
 	const surroundSampleFrame * renderNextBuffer();
 
 	void clearInternal();
 
+	// queues a handle for removal before the next period, safe to call
+	// from any thread
+	void retirePlayHandle( PlayHandle * handle );
+	void removeRetiredPlayHandles();
+	static void deletePlayHandle( PlayHandle * handle );
+
 	void runChangesInModel();
 
 	bool m_renderOnly;
@@ -370,6 +427,7 @@ private:
 	QVector<AudioPort *> m_audioPorts;
 
 	fpp_t m_framesPerPeriod;
+	unsigned long m_periodCounter;
 
 	sampleFrame * m_inputBuffer[2];
 	f_cnt_t m_inputBufferFrames[2];
@@ -390,10 +448,12 @@ private:
 	int m_numWorkers;
 
 	// playhandle stuff
-	PlayHandleList m_playHandles;
+	PlayHandleArray m_playHandles;
 	// place where new playhandles are added temporarily
 	LocklessList<PlayHandle *> m_newPlayHandles;
-	ConstPlayHandleList m_playHandlesToRemove;
+	// intrusive stack of handles to remove before the next period,
+	// linked through PlayHandle::m_nextRetired
+	std::atomic<PlayHandle *> m_retiredPlayHandles;
 
 
 	struct qualitySettings m_qualitySettings;
@@ -414,9 +474,21 @@ private:
 	// FIFO stuff
 	fifo * m_fifo;
 	fifoWriter * m_fifoWriter;
+	// buffers the reader is done with, refilled by the FIFO writer
+	fifo * m_freeBuffers;
+	// buffer last returned by nextBuffer(), recycled on the next call
+	surroundSampleFrame * m_lastFifoBuffer;
+	// set while the reader renders by itself, only used by the reader
+	bool m_renderingDirectly;
+	std::atomic_int m_pipelineMode;
+	std::atomic_int m_lookAhead;
 
 	MixerProfiler m_profiler;
 
+	// taps track and FX channel outputs while ProjectRenderer exports
+	// stems, only touched by the rendering thread
+	StemExporter * m_stemExporter;
+
 	bool m_metronomeActive;
 
 	bool m_clearSignal;
@@ -27,22 +27,78 @@
 
 #include <QFile>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
 #include "lmms_basics.h"
+#include "LocklessRingBuffer.h"
 #include "MicroTimer.h"
 
+class ThreadableJob;
+
 class MixerProfiler
 {
 public:
-	MixerProfiler();
+	enum Stages
+	{
+		Stage_ValueBuffers,
+		Stage_PlayHandles,
+		Stage_FxChannels,
+		Stage_MasterMix,
+		StageCount
+	} ;
+
+	//! Time spent on the jobs of one owner and category in a period
+	struct JobStats
+	{
+		QString name;
+		const char * category;
+		int jobs;
+		int usecs;
+	} ;
+
+	struct PeriodStats
+	{
+		int periodUsecs;
+		int stageUsecs[StageCount];
+		//! sorted by time, most expensive first
+		std::vector<JobStats> jobs;
+	} ;
+
+	MixerProfiler( int workers );
 	~MixerProfiler();
 
 	void startPeriod()
 	{
 		m_periodTimer.reset();
+		if( jobProfilingEnabled() )
+		{
+			m_periodStart = now();
+			std::fill( m_stageTimes, m_stageTimes + StageCount,
+						StageTimes{ m_periodStart, m_periodStart } );
+		}
 	}
 
 	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod );
 
+	void startStage( Stages stage )
+	{
+		if( jobProfilingEnabled() )
+		{
+			m_stageTimes[stage].start = now();
+		}
+	}
+
+	void finishStage( Stages stage )
+	{
+		if( jobProfilingEnabled() )
+		{
+			m_stageTimes[stage].end = now();
+		}
+	}
+
 	int cpuLoad() const
 	{
 		return m_cpuLoad;
@@ -50,12 +106,86 @@ public:
 
 	void setOutputFile( const QString& outputFile );
 
+	//! Writes all jobs and stages in Chrome's trace event format to the
+	//! given file, which can be viewed in chrome://tracing or Perfetto.
+	//! Enables job profiling as long as the file is open.
+	void setTraceFile( const QString& traceFile );
+
+	//! Timing every job costs a bit, so it's off by default
+	void setJobProfilingEnabled( bool enabled );
+
+	bool jobProfilingEnabled() const
+	{
+		return s_jobProfiler.load( std::memory_order_relaxed ) == this;
+	}
+
+	//! Returns the profiler jobs have to be processed through, NULL if
+	//! job profiling is off
+	static MixerProfiler * jobProfiler()
+	{
+		return s_jobProfiler.load( std::memory_order_acquire );
+	}
+
+	//! Processes and times a job, called by the worker with given index
+	void processJob( ThreadableJob * job, int worker );
+
+	//! Takes the stats of the oldest period recorded while job profiling
+	//! was enabled, returns false if there are none. Must only be called
+	//! by one thread, usually the GUI.
+	bool takePeriodStats( PeriodStats & stats );
+
 
 private:
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	struct JobEvent
+	{
+		const void * owner;
+		QString name;
+		const char * category;
+		TimePoint start;
+		TimePoint end;
+	} ;
+
+	struct WorkerEvents
+	{
+		std::vector<JobEvent> events;
+		// keep neighbouring workers on separate cache lines
+		char padding[64];
+	} ;
+
+	struct StageTimes
+	{
+		TimePoint start;
+		TimePoint end;
+	} ;
+
+	static TimePoint now()
+	{
+		return std::chrono::steady_clock::now();
+	}
+
+	int usecs( TimePoint start, TimePoint end ) const;
+	void collectJobs( int periodElapsed );
+	void writeTraceEvent( const QString& name, const char * category,
+					int thread, TimePoint start, TimePoint end );
+
 	MicroTimer m_periodTimer;
 	int m_cpuLoad;
 	QFile m_outputFile;
 
+	std::vector<WorkerEvents> m_workers;
+	std::vector<JobEvent> m_periodEvents;
+	std::vector<JobStats> m_periodJobs;
+	TimePoint m_periodStart;
+	StageTimes m_stageTimes[StageCount];
+	LocklessRingBuffer<PeriodStats> m_periods;
+
+	QFile m_traceFile;
+	TimePoint m_traceStart;
+
+	static std::atomic<MixerProfiler *> s_jobProfiler;
+
 };
 
 #endif
@@ -25,11 +25,13 @@
 #ifndef MIXER_WORKER_THREAD_H
 #define MIXER_WORKER_THREAD_H
 
+#include <QtCore/QMutex>
 #include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
 
 #include <atomic>
 
-class QWaitCondition;
 class Mixer;
 class ThreadableJob;
 
@@ -38,6 +40,11 @@ class MixerWorkerThread : public QThread
 	Q_OBJECT
 public:
 	// internal representation of the job queue - all functions are thread-safe
+	//
+	// Every worker (including the mixer thread, which is processed inline as
+	// the last worker) owns a deque of jobs. Workers pop from the back of
+	// their own deque and, once it runs dry, steal from the front of the
+	// others. Jobs added from outside a worker are spread round-robin.
 	class JobQueue
 	{
 	public:
@@ -47,15 +54,8 @@ public:
 			Dynamic	// jobs can be added while processing queue
 		} ;
 
-#define JOB_QUEUE_SIZE 8192
-		JobQueue() :
-			m_items(),
-			m_writeIndex( 0 ),
-			m_itemsDone( 0 ),
-			m_opMode( Static )
-		{
-			std::fill(m_items, m_items + JOB_QUEUE_SIZE, nullptr);
-		}
+		JobQueue();
+		~JobQueue();
 
 		void reset( OperationMode _opMode );
 
@@ -64,12 +64,36 @@ public:
 		void run();
 		void wait();
 
+		// registers a new worker deque and returns its index
+		int addWorker();
+
+		int workerCount() const
+		{
+			return m_deques.size();
+		}
+
+		// index of the worker running on the calling thread
+		int currentWorker() const;
+
 	private:
-		std::atomic<ThreadableJob*> m_items[JOB_QUEUE_SIZE];
-		std::atomic_int m_writeIndex;
-		std::atomic_int m_itemsDone;
+		class WorkerDeque;
+
+		ThreadableJob * popOrSteal( int _worker );
+		void jobDone();
+
+		QVector<WorkerDeque *> m_deques;
+		// unsigned, so it wraps around without turning negative
+		std::atomic<unsigned> m_nextDeque;
 		OperationMode m_opMode;
 
+		// keep producer and consumer counters on separate cache lines
+		alignas( 64 ) std::atomic_int m_itemsQueued;
+		alignas( 64 ) std::atomic_int m_itemsDone;
+
+		std::atomic_bool m_waiterParked;
+		QMutex m_waitMutex;
+		QWaitCondition m_waitCond;
+
 	} ;
 
 
@@ -104,14 +128,34 @@ public:
 
 	static void startAndWaitForJobs();
 
+	// number of workers including the mixer thread
+	static int workerCount()
+	{
+		return globalJobQueue.workerCount();
+	}
+
+	// index of the worker processing jobs on the calling thread, all
+	// threads which aren't worker threads share the last index
+	static int currentWorker()
+	{
+		return globalJobQueue.currentWorker();
+	}
+
 
 private:
 	virtual void run();
 
 	static JobQueue globalJobQueue;
-	static QWaitCondition * queueReadyWaitCond;
 	static QList<MixerWorkerThread *> workerThreads;
 
+	// workers sleep on this condition between rounds; a round is started by
+	// bumping s_round so a briefly spinning worker can pick it up without
+	// being woken up at all
+	static QMutex s_roundMutex;
+	static QWaitCondition s_roundCond;
+	static std::atomic_uint s_round;
+
+	int m_index;
 	volatile bool m_quit;
 
 } ;
@@ -26,6 +26,7 @@
 #ifndef NOTE_PLAY_HANDLE_H
 #define NOTE_PLAY_HANDLE_H
 
+#include <cstdint>
 #include <memory>
 
 #include "BasicFilters.h"
@@ -34,7 +35,6 @@
 #include "Track.h"
 #include "MemoryManager.h"
 
-class QReadWriteLock;
 class InstrumentTrack;
 class NotePlayHandle;
 
@@ -329,12 +329,32 @@ private:
 
 
 const int INITIAL_NPH_CACHE = 256;
-const int NPH_CACHE_INCREMENT = 16;
 
+/*! \brief Lock-free pool of NotePlayHandles
+ *
+ *  Each thread caches free handles in two magazines of its own, so acquire()
+ *  and release() don't touch any shared state most of the time. Full and
+ *  empty magazines are exchanged with a global depot, which consists of two
+ *  lock-free stacks. New handles are only allocated when the depot has no
+ *  full magazine left, and released handles are only freed when there's no
+ *  magazine left to put them into.
+ */
 class NotePlayHandleManager
 {
 	MM_OPERATORS
 public:
+	struct Stats
+	{
+		//! acquisitions served by a magazine
+		uint64_t hits;
+		//! acquisitions which had to allocate a new handle
+		uint64_t misses;
+		int inUse;
+		//! maximum of inUse since start
+		int highWaterMark;
+	} ;
+
+	//! Fills the pool with INITIAL_NPH_CACHE handles
 	static void init();
 	static NotePlayHandle * acquire( InstrumentTrack* instrumentTrack,
 					const f_cnt_t offset,
@@ -344,14 +364,17 @@ public:
 					int midiEventChannel = -1,
 					NotePlayHandle::Origin origin = NotePlayHandle::OriginPattern );
 	static void release( NotePlayHandle * nph );
-	static void extend( int i );
 
-private:
-	static NotePlayHandle ** s_available;
-	static QReadWriteLock s_mutex;
-	static std::atomic_int s_availableIndex;
-	static int s_size;
-};
+	//! Takes storage for a handle from the pool, acquire() constructs the
+	//! handle in it. Can be called from any thread.
+	static void * allocate();
+	//! Puts storage taken by allocate() back into the pool of the calling
+	//! thread
+	static void deallocate( void * storage );
+
+	static Stats stats();
+
+} ;
 
 
 #endif
@@ -67,6 +67,8 @@ public:
 	} ;
 
 
+	// the sub-oscillator isn't owned, so oscillators of a voice can be
+	// kept next to each other
 	Oscillator( const IntModel * _wave_shape_model,
 			const IntModel * _mod_algo_model,
 			const float & _freq,
@@ -76,7 +78,6 @@ public:
 			Oscillator * _m_subOsc = NULL );
 	virtual ~Oscillator()
 	{
-		delete m_subOsc;
 	}
 
 
@@ -166,6 +167,11 @@ private:
 	float m_phase;
 	const SampleBuffer * m_userWave;
 
+	// band-limited table for saw, square, triangle and moog saw waves,
+	// chosen per period by the frequency of the oscillator
+	int m_blTable;
+	int m_blTableLength;
+
 
 	void updateNoSub( sampleFrame * _ab, const fpp_t _frames,
 							const ch_cnt_t _chnl );
@@ -207,6 +213,7 @@ private:
 	inline sample_t getSample( const float _sample );
 
 	inline void recalcPhase();
+	inline void selectBLTable( const float _osc_coeff );
 
 } ;
 
@@ -79,6 +79,10 @@ public:
 		return m_notes;
 	}
 
+	// returns the first note at or after given position for playback,
+	// continuing from the previous call as long as playback moves forward
+	NoteVector::ConstIterator seekPlayCursor( const MidiTime & pos );
+
 	Note * addStepNote( int step );
 	void setStep( int step, bool enabled );
 
@@ -135,6 +139,13 @@ private:
 
 	void resizeToFirstTrack();
 
+	// makes the next seekPlayCursor() search from scratch, has to be
+	// called with the track locked whenever m_notes changes
+	void resetPlayCursor()
+	{
+		m_playCursor = -1;
+	}
+
 	InstrumentTrack * m_instrumentTrack;
 
 	PatternTypes m_patternType;
@@ -143,6 +154,10 @@ private:
 	NoteVector m_notes;
 	int m_steps;
 
+	// index of the first note at or after m_playCursorPos
+	int m_playCursor;
+	MidiTime m_playCursorPos;
+
 	Pattern * adjacentPatternByOffset(int offset) const;
 
 	friend class PatternView;
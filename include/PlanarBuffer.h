@@ -0,0 +1,115 @@
+/*
+ * PlanarBuffer.h - stereo buffer with separate arrays per channel
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PLANAR_BUFFER_H
+#define PLANAR_BUFFER_H
+
+#include <cstring>
+
+#include "lmms_basics.h"
+
+
+/*! \brief View of a stereo buffer stored as one array per channel
+ *
+ *  Per-channel loops over planar data vectorize without shuffling, unlike
+ *  loops over interleaved sampleFrames. The view doesn't own its memory,
+ *  buffers are acquired from and released to BufferManager. The conversion
+ *  functions translate from and to the interleaved layout used by most of
+ *  LMMS.
+ */
+class PlanarBuffer
+{
+public:
+	PlanarBuffer() :
+		m_left( NULL ),
+		m_right( NULL ),
+		m_frames( 0 )
+	{
+	}
+
+	PlanarBuffer( sample_t * left, sample_t * right, fpp_t frames ) :
+		m_left( left ),
+		m_right( right ),
+		m_frames( frames )
+	{
+	}
+
+	bool isNull() const
+	{
+		return m_left == NULL;
+	}
+
+	sample_t * left() const
+	{
+		return m_left;
+	}
+
+	sample_t * right() const
+	{
+		return m_right;
+	}
+
+	sample_t * channel( ch_cnt_t ch ) const
+	{
+		return ch == 0 ? m_left : m_right;
+	}
+
+	fpp_t frames() const
+	{
+		return m_frames;
+	}
+
+	void clear() const
+	{
+		memset( m_left, 0, sizeof( sample_t ) * m_frames );
+		memset( m_right, 0, sizeof( sample_t ) * m_frames );
+	}
+
+	//! Copies frames() interleaved frames from src
+	void deinterleave( const sampleFrame * src ) const
+	{
+		for( fpp_t f = 0; f < m_frames; ++f )
+		{
+			m_left[f] = src[f][0];
+			m_right[f] = src[f][1];
+		}
+	}
+
+	//! Copies frames() frames to the interleaved buffer dst
+	void interleave( sampleFrame * dst ) const
+	{
+		for( fpp_t f = 0; f < m_frames; ++f )
+		{
+			dst[f][0] = m_left[f];
+			dst[f][1] = m_right[f];
+		}
+	}
+
+private:
+	sample_t * m_left;
+	sample_t * m_right;
+	fpp_t m_frames;
+
+} ;
+
+
+#endif
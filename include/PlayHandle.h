@@ -28,6 +28,8 @@
 #include <QtCore/QList>
 #include <QtCore/QMutex>
 
+#include <atomic>
+
 #include "lmms_export.h"
 
 #include "MemoryManager.h"
@@ -57,6 +59,14 @@ public:
 		MaxNumber = 1024
 	} ;
 
+	//! Lists a handle can be in at the same time, see PlayHandleArray
+	enum Slot
+	{
+		MixerSlot,
+		AudioPortSlot,
+		SlotCount
+	} ;
+
 	PlayHandle( const Type type, f_cnt_t offset = 0 );
 
 	PlayHandle & operator = ( PlayHandle & p )
@@ -94,6 +104,8 @@ public:
 		return !isFinished();
 	}
 
+	virtual ProfilingTarget profilingTarget() const;
+
 	void lock()
 	{
 		m_processingLock.lock();
@@ -157,6 +169,15 @@ private:
 	bool m_bufferReleased;
 	bool m_usesBuffer;
 	AudioPort * m_audioPort;
+
+	// index in the PlayHandleArrays containing this handle, -1 if not in there
+	int m_slots[SlotCount];
+	// link in the mixer's queue of handles to remove
+	PlayHandle * m_nextRetired;
+	std::atomic_bool m_retired;
+
+	friend class Mixer;
+	friend class PlayHandleArray;
 } ;
 
 
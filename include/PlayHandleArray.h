@@ -0,0 +1,169 @@
+/*
+ * PlayHandleArray.h - slot array of play handles with constant-time removal
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PLAY_HANDLE_ARRAY_H
+#define PLAY_HANDLE_ARRAY_H
+
+#include <vector>
+
+#include "PlayHandle.h"
+
+
+/*! \brief Ordered list of play handles with constant-time removal
+ *
+ *  Every handle stores its index in the array (one per owner, see
+ *  PlayHandle::Slot), so removing it only clears its slot instead of
+ *  searching the list. Iteration skips cleared slots and keeps the order
+ *  handles were appended in; compact() closes the gaps.
+ *
+ *  Removing handles while iterating is fine, appending isn't.
+ */
+class PlayHandleArray
+{
+public:
+	class ConstIterator
+	{
+	public:
+		ConstIterator( PlayHandle * const * it, PlayHandle * const * end ) :
+			m_it( it ),
+			m_end( end )
+		{
+			skipEmpty();
+		}
+
+		PlayHandle * operator*() const
+		{
+			return *m_it;
+		}
+
+		ConstIterator & operator++()
+		{
+			++m_it;
+			skipEmpty();
+			return *this;
+		}
+
+		bool operator==( const ConstIterator & other ) const
+		{
+			return m_it == other.m_it;
+		}
+
+		bool operator!=( const ConstIterator & other ) const
+		{
+			return m_it != other.m_it;
+		}
+
+	private:
+		void skipEmpty()
+		{
+			while( m_it != m_end && *m_it == NULL )
+			{
+				++m_it;
+			}
+		}
+
+		PlayHandle * const * m_it;
+		PlayHandle * const * m_end;
+	} ;
+	typedef ConstIterator Iterator;
+
+	PlayHandleArray( PlayHandle::Slot slot ) :
+		m_slot( slot ),
+		m_size( 0 )
+	{
+	}
+
+	ConstIterator begin() const
+	{
+		return ConstIterator( m_handles.data(), m_handles.data() + m_handles.size() );
+	}
+
+	ConstIterator end() const
+	{
+		PlayHandle * const * end = m_handles.data() + m_handles.size();
+		return ConstIterator( end, end );
+	}
+
+	int size() const
+	{
+		return m_size;
+	}
+
+	bool isEmpty() const
+	{
+		return m_size == 0;
+	}
+
+	bool contains( const PlayHandle * handle ) const
+	{
+		return handle->m_slots[m_slot] >= 0;
+	}
+
+	void append( PlayHandle * handle )
+	{
+		handle->m_slots[m_slot] = m_handles.size();
+		m_handles.push_back( handle );
+		++m_size;
+	}
+
+	//! Returns false if the handle wasn't in the array
+	bool remove( PlayHandle * handle )
+	{
+		int & index = handle->m_slots[m_slot];
+		if( index < 0 )
+		{
+			return false;
+		}
+		m_handles[index] = NULL;
+		index = -1;
+		--m_size;
+		return true;
+	}
+
+	//! Closes the gaps left by removed handles, keeping the order
+	void compact()
+	{
+		if( static_cast<int>( m_handles.size() ) == m_size )
+		{
+			return;
+		}
+		int used = 0;
+		for( PlayHandle * handle : m_handles )
+		{
+			if( handle )
+			{
+				handle->m_slots[m_slot] = used;
+				m_handles[used++] = handle;
+			}
+		}
+		m_handles.resize( used );
+	}
+
+private:
+	const PlayHandle::Slot m_slot;
+	std::vector<PlayHandle *> m_handles;
+	int m_size;
+
+} ;
+
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * ProjectCache.h - keeps upgraded projects in a compact binary form
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef PROJECT_CACHE_H
+#define PROJECT_CACHE_H
+
+#include <QtCore/QString>
+
+class QDomDocument;
+class QFileInfo;
+
+
+/*! \brief Binary copies of loaded projects in the user's cache directory
+ *
+ *  Once a project got parsed and upgraded, its document is stored as a tree
+ *  of string table indices. Large attribute values, like embedded samples,
+ *  are kept out of line as plain bytes, so reopening the project neither
+ *  parses XML nor runs the upgrade routines again. A copy is only used while
+ *  the project file keeps its size and modification time and the same LMMS
+ *  version reads it.
+ */
+class ProjectCache
+{
+public:
+	//! Replaces the contents of doc by the cached copy of source and sets
+	//! creatorVersion to the version which created source, returns false
+	//! if there's no up-to-date copy
+	static bool load( const QFileInfo & source, QDomDocument & doc,
+						QString & creatorVersion );
+
+	//! Stores doc as the upgraded form of source, which was created with
+	//! creatorVersion, if source is large enough for caching to pay off
+	static void store( const QFileInfo & source, const QDomDocument & doc,
+					const QString & creatorVersion );
+
+	static void remove( const QString & source );
+
+private:
+	static QString cacheFile( const QString & source );
+
+} ;
+
+
+#endif
@@ -32,6 +32,8 @@
 
 #include "lmms_export.h"
 
+class StemExporter;
+
 class LMMS_EXPORT ProjectRenderer : public QThread
 {
 	Q_OBJECT
@@ -60,6 +62,10 @@ public:
 				const OutputSettings & _os,
 				ExportFileFormats _file_format,
 				const QString & _out_file );
+	//! Renders into given device, which is deleted by the mixer when
+	//! it gets replaced
+	ProjectRenderer( const Mixer::qualitySettings & _qs,
+				AudioFileDevice * fileDevice );
 	virtual ~ProjectRenderer();
 
 	bool isReady() const
@@ -74,6 +80,20 @@ public:
 
 	static const FileEncodeDevice fileEncodeDevices[];
 
+	//! Returns NULL if the format isn't available or the file can't be
+	//! written
+	static AudioFileDevice * createFileDevice(
+					const OutputSettings & _os,
+					ExportFileFormats _file_format,
+					const QString & _out_file );
+
+	//! Additionally writes the stems of given exporter while rendering,
+	//! it has to live until the renderer is finished
+	void setStemExporter( StemExporter * stemExporter )
+	{
+		m_stemExporter = stemExporter;
+	}
+
 public slots:
 	void startProcessing();
 	void abortProcessing();
@@ -89,6 +109,7 @@ private:
 	virtual void run();
 
 	AudioFileDevice * m_fileDev;
+	StemExporter * m_stemExporter;
 	Mixer::qualitySettings m_qualitySettings;
 
 	volatile int m_progress;
@@ -76,6 +76,12 @@ typedef int32_t key_t;
 #include <pthread.h>
 #endif
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 
 #ifdef BUILD_REMOTE_PLUGIN_CLIENT
 #undef LMMS_EXPORT
@@ -511,6 +517,11 @@ public:
 			return (float) atof( data[_p].c_str() );
 		}
 
+		inline int count() const
+		{
+			return data.size();
+		}
+
 		inline bool operator==( const message & _m ) const
 		{
 			return( id == _m.id );
@@ -564,6 +575,28 @@ public:
 		return m;
 	}
 
+	// In pipelined mode the client doesn't reply IdProcessingDone but
+	// stores the sequence number of the last period it processed in the
+	// last word of the shared processing memory, so the host can collect
+	// the period without a round trip
+	typedef std::atomic<int32_t> PeriodCounter;
+
+	static inline PeriodCounter * periodCounter( float * _shm, size_t _shm_size )
+	{
+		return reinterpret_cast<PeriodCounter *>(
+				reinterpret_cast<char *>( _shm ) + _shm_size -
+							sizeof( PeriodCounter ) );
+	}
+
+	static inline void wakePeriodWaiter( PeriodCounter * _counter )
+	{
+#ifdef __linux__
+		syscall( SYS_futex, _counter, FUTEX_WAKE, 1, NULL, NULL, 0 );
+#else
+		(void) _counter;
+#endif
+	}
+
 #ifndef SYNC_WITH_SHM_FIFO
 	inline int32_t readInt()
 	{
@@ -801,6 +834,22 @@ public:
 
 	bool process( const sampleFrame * _in_buf, sampleFrame * _out_buf );
 
+	// in pipelined mode process() hands the period to the remote process
+	// and returns the output of the previous one, so the calling thread
+	// doesn't wait for the remote process to compute it
+	void setPipelined( bool _on )
+	{
+		m_pipelined = _on;
+	}
+
+	bool isPipelined() const
+	{
+		return m_pipelined;
+	}
+
+	// number of frames the output of process() lags behind its input
+	fpp_t latencyFrames() const;
+
 	void processMidiEvent( const MidiEvent&, const f_cnt_t _offset );
 
 	void updateSampleRate( sample_rate_t _sr )
@@ -857,6 +906,9 @@ protected:
 	bool m_failed;
 private:
 	void resizeSharedProcessingMemory();
+	void writeInput( const sampleFrame * _in_buf, fpp_t _frames );
+	void readOutput( sampleFrame * _out_buf, fpp_t _frames );
+	bool waitForSubmittedPeriod();
 
 
 	QProcess m_process;
@@ -875,6 +927,12 @@ private:
 	int m_inputCount;
 	int m_outputCount;
 
+	volatile bool m_pipelined;
+	// sequence number of the last period sent to the client and whether
+	// its output still has to be collected
+	int32_t m_submittedPeriod;
+	bool m_periodPending;
+
 #ifndef SYNC_WITH_SHM_FIFO
 	int m_server;
 	QString m_socketFile;
@@ -984,6 +1042,7 @@ private:
 #endif
 	VstSyncData * m_vstSyncData;
 	float * m_shm;
+	size_t m_shmSize;
 
 	int m_inputCount;
 	int m_outputCount;
@@ -1187,6 +1246,7 @@ RemotePluginClient::RemotePluginClient( const char * socketPath ) :
 #endif
 	m_vstSyncData( NULL ),
 	m_shm( NULL ),
+	m_shmSize( 0 ),
 	m_inputCount( 0 ),
 	m_outputCount( 0 ),
 	m_sampleRate( 44100 ),
@@ -1346,8 +1406,19 @@ bool RemotePluginClient::processMessage( const message & _m )
 
 		case IdStartProcessing:
 			doProcessing();
-			reply_message.id = IdProcessingDone;
-			reply = true;
+			if( _m.count() > 0 && _m.getInt() && m_shm != NULL )
+			{
+				// the host is pipelining and waits for the period's
+				// sequence number
+				PeriodCounter * counter = periodCounter( m_shm, m_shmSize );
+				counter->store( _m.getInt( 1 ), std::memory_order_release );
+				wakePeriodWaiter( counter );
+			}
+			else
+			{
+				reply_message.id = IdProcessingDone;
+				reply = true;
+			}
 			break;
 
 		case IdChangeSharedMemoryKey:
@@ -1378,6 +1449,7 @@ bool RemotePluginClient::processMessage( const message & _m )
 
 void RemotePluginClient::setShmKey( key_t _key, int _size )
 {
+	m_shmSize = _size;
 #ifdef USE_QT_SHMEM
 	m_shmObj.setKey( QString::number( _key ) );
 	if( m_shmObj.attach() || m_shmObj.error() == QSharedMemory::NoError )
@@ -31,6 +31,8 @@
 #include "ProjectRenderer.h"
 #include "OutputSettings.h"
 
+class StemExporter;
+
 
 class RenderManager : public QObject
 {
@@ -50,6 +52,10 @@ public:
 	/// Export all unmuted tracks into individual file
 	void renderTracks();
 
+	/// Export the output of all unmuted tracks and optionally of all FX
+	/// channels into individual files, rendering the song only once
+	void renderStems( bool fxChannels );
+
 	void abortProcessing();
 
 signals:
@@ -62,9 +68,11 @@ private slots:
 
 private:
 	QString pathForTrack( const Track *track, int num );
+	QString pathForName( QString name, int num );
 	void restoreMutedState();
 
 	void render( QString outputPath );
+	void startRenderer();
 
 	const Mixer::qualitySettings m_qualitySettings;
 	const Mixer::qualitySettings m_oldQualitySettings;
@@ -73,6 +81,7 @@ private:
 	QString m_outputPath;
 
 	std::unique_ptr<ProjectRenderer> m_activeRenderer;
+	std::unique_ptr<StemExporter> m_stemExporter;
 
 	QVector<Track*> m_tracksToRender;
 	QVector<Track*> m_unmuted;
@@ -31,16 +31,20 @@
 
 #include <samplerate.h>
 
+#include <memory>
+
 #include "lmms_export.h"
 #include "interpolation.h"
 #include "lmms_basics.h"
 #include "lmms_math.h"
 #include "shared_object.h"
 #include "MemoryManager.h"
+#include "SampleCache.h"
 
 
 class QPainter;
 class QRect;
+class QTemporaryFile;
 
 // values for buffer margins, used for various libsamplerate interpolation modes
 // the array positions correspond to the converter_type parameter values in libsamplerate
@@ -97,6 +101,9 @@ public:
 		bool m_isBackwards;
 		SRC_STATE * m_resamplingData;
 		int m_interpolationMode;
+		// frames of a streamed sample which were last paged in ahead
+		f_cnt_t m_prefetchBegin;
+		f_cnt_t m_prefetchEnd;
 
 		friend class SampleBuffer;
 
@@ -211,6 +218,13 @@ public:
 		return m_data;
 	}
 
+	//! Whether data() is mapped from a cache file on disk rather than
+	//! held in memory, which is the case for large audio files
+	bool isStreamed() const
+	{
+		return m_sharedData && m_sharedData->isMapped();
+	}
+
 	QString openAudioFile() const;
 	QString openAndSetAudioFile();
 	QString openAndSetWaveformFile();
@@ -254,6 +268,11 @@ public:
 	static QString tryToMakeRelative( const QString & _file );
 	static QString tryToMakeAbsolute(const QString & file);
 
+	//! Sets up the directory large samples get decoded into and removes
+	//! the ones of instances which didn't exit cleanly. Called once on
+	//! startup.
+	static void initCacheDirectory();
+
 
 public slots:
 	void setAudioFile( const QString & _audio_file );
@@ -267,9 +286,13 @@ public slots:
 private:
 	void update( bool _keep_settings = false );
 
+	void freeData();
+
 	void convertIntToFloat ( int_sample_t * & _ibuf, f_cnt_t _frames, int _channels);
 	void directFloatWrite ( sample_t * & _fbuf, f_cnt_t _frames, int _channels);
 
+	f_cnt_t decodeSampleToCache( const QString & _f,
+						sample_rate_t & _sample_rate );
 	f_cnt_t decodeSampleSF( QString _f, sample_t * & _buf,
 						ch_cnt_t & _channels,
 						sample_rate_t & _sample_rate );
@@ -286,6 +309,11 @@ private:
 	sampleFrame * m_origData;
 	f_cnt_t m_origFrames;
 	sampleFrame * m_data;
+	// decoded frames of m_audioFile, shared with other buffers playing
+	// the same file, m_data points into them
+	std::shared_ptr<CachedSample> m_sharedData;
+	// the file m_data is mapped from until it gets shared
+	QTemporaryFile * m_cacheFile;
 	QReadWriteLock m_varLock;
 	f_cnt_t m_frames;
 	f_cnt_t m_startFrame;
@@ -297,6 +325,8 @@ private:
 	float m_frequency;
 	sample_rate_t m_sampleRate;
 
+	void prefetch( handleState * _state, f_cnt_t _index, bool _backwards ) const;
+
 	sampleFrame * getSampleFragment( f_cnt_t _index, f_cnt_t _frames,
 						LoopMode _loopmode,
 						sampleFrame * * _tmp,
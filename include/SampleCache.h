@@ -0,0 +1,103 @@
+/*
+ * SampleCache.h - shares decoded audio files between sample buffers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SAMPLE_CACHE_H
+#define SAMPLE_CACHE_H
+
+#include <QtCore/QString>
+
+#include <memory>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+class QTemporaryFile;
+
+
+//! Decoded frames of an audio file, which are never modified once
+//! they're shared
+class CachedSample
+{
+public:
+	//! Takes ownership of frames, which were either allocated with
+	//! MM_ALLOC or are mapped from mappedFile
+	CachedSample( sampleFrame * frames, f_cnt_t frameCount,
+					QTemporaryFile * mappedFile );
+	~CachedSample();
+
+	sampleFrame * frames() const
+	{
+		return m_frames;
+	}
+
+	f_cnt_t frameCount() const
+	{
+		return m_frameCount;
+	}
+
+	bool isMapped() const
+	{
+		return m_mappedFile != NULL;
+	}
+
+private:
+	sampleFrame * m_frames;
+	f_cnt_t m_frameCount;
+	QTemporaryFile * m_mappedFile;
+
+} ;
+
+
+/*! \brief Process-wide cache of decoded audio files
+ *
+ *  Entries are keyed by file path, modification time, size, target sample
+ *  rate and direction, so all SampleBuffers playing the same file share
+ *  one copy which is decoded only once. Edits which change the frames,
+ *  like reversing, look up or create another entry instead of modifying
+ *  the shared one. The cache only holds weak references, so entries go
+ *  away with the last buffer using them.
+ */
+class LMMS_EXPORT SampleCache
+{
+public:
+	static QString key( const QString & file, sample_rate_t sampleRate,
+							bool reversed );
+
+	//! Returns NULL if nobody uses the file with given key
+	static std::shared_ptr<CachedSample> find( const QString & key );
+
+	//! Shares frames under given key, see CachedSample for ownership
+	static std::shared_ptr<CachedSample> insert( const QString & key,
+						sampleFrame * frames,
+						f_cnt_t frameCount,
+						QTemporaryFile * mappedFile );
+
+	static int entryCount();
+	//! Bytes of decoded frames held in memory
+	static qint64 residentBytes();
+	//! Bytes of decoded frames mapped from cache files
+	static qint64 mappedBytes();
+
+} ;
+
+
+#endif
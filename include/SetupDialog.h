@@ -100,6 +100,7 @@ private slots:
 	void toggleDisableBackup( bool _enabled );
 	void toggleOpenLastProject( bool _enabled );
 	void toggleHQAudioDev( bool _enabled );
+	void toggleLowLatency( bool _enabled );
 
 	void openWorkingDir();
 	void openVSTDir();
@@ -139,6 +140,7 @@ private:
 	bool m_disableBackup;
 	bool m_openLastProject;
 	bool m_hqAudioDev;
+	bool m_lowLatency;
 	QString m_lang;
 	QStringList m_languages;
 
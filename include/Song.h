@@ -30,6 +30,7 @@
 #include <QtCore/QSharedMemory>
 #include <QtCore/QVector>
 
+#include "AutomationTimeline.h"
 #include "TrackContainer.h"
 #include "Controller.h"
 #include "MeterModel.h"
@@ -396,6 +397,7 @@ private:
 	void setProjectFileName(QString const & projectFileName);
 
 	AutomationTrack * m_globalAutomationTrack;
+	AutomationTimeline m_automationTimeline;
 
 	IntModel m_tempoModel;
 	MeterModel m_timeSigModel;
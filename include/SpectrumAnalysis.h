@@ -0,0 +1,138 @@
+/*
+ * SpectrumAnalysis.h - spectra of rendered audio, computed off the
+ *                      rendering threads
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef SPECTRUM_ANALYSIS_H
+#define SPECTRUM_ANALYSIS_H
+
+#include <QtCore/QMutex>
+
+#include <atomic>
+
+#include "fft_helpers.h"
+#include "lmms_basics.h"
+#include "lmms_export.h"
+#include "LocklessRingBuffer.h"
+
+class SpectrumAnalysisThread;
+
+
+/*! \brief Spectrum of audio taken from a rendering thread
+ *
+ *  push() only copies the frames into a lock-free ring, so analysing audio
+ *  costs the rendering threads nothing beyond a memcpy. A low priority
+ *  thread shared by all analyses drains the rings at the display rate and
+ *  runs a Blackman-Harris windowed FFT over the last WindowSize frames of
+ *  every analysis that got new frames, i.e. consecutive spectra overlap.
+ *  Any number of views can fetch the latest spectrum through spectrum().
+ */
+class LMMS_EXPORT SpectrumAnalysis
+{
+public:
+	static const int WindowSize = FFT_BUFFER_SIZE;
+	//! Frequencies from 0 to the Nyquist frequency, the window gets zero
+	//! padded to twice its size
+	static const int BinCount = FFT_BUFFER_SIZE + 1;
+
+	enum ChannelModes
+	{
+		MergeChannels,
+		LeftChannel,
+		RightChannel
+	} ;
+
+	struct Spectrum
+	{
+		float magnitudes[BinCount];
+		//! largest absolute sample of the analysed frames
+		float peak;
+		//! sum of squares of the analysed frames
+		float power;
+		//! increases with every computed spectrum, 0 means none
+		unsigned int serial = 0;
+	} ;
+
+	SpectrumAnalysis();
+	~SpectrumAnalysis();
+
+	//! Queues frames for analysis, called on a rendering thread. Never
+	//! blocks, frames get dropped while the analysis thread falls behind.
+	//! Frames are passed on in blocks of BlockFrames, so up to the last
+	//! BlockFrames - 1 frames wait for the next call.
+	void push( const sampleFrame * buf, const fpp_t frames );
+
+	//! Forgets the frames analysed so far, the next spectrum is one of
+	//! silence unless frames follow. Safe to call on a rendering thread.
+	void clear();
+
+	//! Frames pushed while inactive are ignored
+	void setActive( bool active )
+	{
+		m_active.store( active, std::memory_order_relaxed );
+	}
+
+	bool isActive() const
+	{
+		return m_active.load( std::memory_order_relaxed );
+	}
+
+	void setChannelMode( ChannelModes mode )
+	{
+		m_channelMode.store( mode, std::memory_order_relaxed );
+	}
+
+	//! Copies the latest spectrum to s unless s already holds it, returns
+	//! whether s changed
+	bool spectrum( Spectrum & s ) const;
+
+private:
+	static const int BlockFrames = 256;
+	// blocks only get queued once full, so this holds 16384 frames, enough
+	// for a display frame at 192 kHz with room to spare
+	static const int QueuedBlocks = 64;
+
+	struct Block
+	{
+		sampleFrame frames[BlockFrames];
+		fpp_t size;
+	} ;
+
+	LocklessRingBuffer<Block> m_blocks;
+	// block being filled by push(), not yet visible to the analysis thread
+	Block * m_open;
+	std::atomic<bool> m_active;
+	std::atomic<bool> m_clear;
+	std::atomic<int> m_channelMode;
+
+	// only touched by the analysis thread
+	sampleFrame m_history[WindowSize];
+	int m_historyPos;
+
+	mutable QMutex m_spectrumMutex;
+	Spectrum m_spectrum;
+
+	friend class SpectrumAnalysisThread;
+
+} ;
+
+
+#endif
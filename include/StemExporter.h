@@ -0,0 +1,109 @@
+/*
+ * StemExporter.h - writes outputs of tracks and FX channels to files
+ *                  while the project is rendered once
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef STEM_EXPORTER_H
+#define STEM_EXPORTER_H
+
+#include <QtCore/QSemaphore>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+
+#include <memory>
+#include <vector>
+
+#include "lmms_basics.h"
+#include "LocklessRingBuffer.h"
+
+class AudioFileDevice;
+class AudioPort;
+class FxChannel;
+
+
+/*! \brief Encodes audio ports and FX channels into files of their own
+ *
+ *  The mixer calls tapPeriod() on the rendering thread once the FX channels
+ *  of a period are processed, which copies the output of every stem into
+ *  its queue. Encoding happens on the exporter's own thread, so stems of
+ *  all tracks are written in a single render and the rendering thread only
+ *  waits when the encoder falls behind by more than QueuedPeriods.
+ */
+class StemExporter : public QThread
+{
+public:
+	StemExporter();
+	virtual ~StemExporter();
+
+	//! Writes the output of port, i.e. a track after its effects, to
+	//! device, which gets owned by the exporter
+	void addPortStem( AudioPort * port, AudioFileDevice * device );
+	//! Writes the output of channel after its effects and fader to device,
+	//! which gets owned by the exporter
+	void addChannelStem( FxChannel * channel, AudioFileDevice * device );
+
+	int stemCount() const
+	{
+		return m_stems.size();
+	}
+
+	//! Queues the current period of all stems, called by the mixer
+	void tapPeriod();
+
+	//! Waits until all queued periods are encoded and closes the files
+	void finish();
+
+	void removeOutputFiles();
+
+private:
+	static const int QueuedPeriods = 32;
+
+	struct Period
+	{
+		std::unique_ptr<surroundSampleFrame[]> frames;
+		fpp_t capacity = 0;
+		fpp_t size = 0;
+		float masterGain = 1.0f;
+	} ;
+
+	struct Stem
+	{
+		Stem( AudioPort * port, FxChannel * channel, AudioFileDevice * device );
+		~Stem();
+
+		AudioPort * m_port;
+		FxChannel * m_channel;
+		AudioFileDevice * m_device;
+		LocklessRingBuffer<Period> m_periods;
+		QSemaphore m_freePeriods;
+	} ;
+
+	virtual void run();
+
+	std::vector<std::unique_ptr<Stem>> m_stems;
+	QStringList m_outputFiles;
+
+	QSemaphore m_queuedPeriods;
+
+} ;
+
+
+#endif
@@ -25,6 +25,8 @@
 #ifndef THREADABLE_JOB_H
 #define THREADABLE_JOB_H
 
+#include <QtCore/QString>
+
 #include "lmms_basics.h"
 
 #include <atomic>
@@ -78,6 +80,23 @@ public:
 
 	virtual bool requiresProcessing() const = 0;
 
+	//! What the processing time of a job gets accounted to
+	struct ProfilingTarget
+	{
+		//! track, FX channel etc. the job belongs to, times of jobs with
+		//! the same owner and category get summed up
+		const void * owner;
+		QString name;
+		//! must be a string literal
+		const char * category;
+	} ;
+
+	//! Only called while profiling jobs, see MixerProfiler
+	virtual ProfilingTarget profilingTarget() const
+	{
+		return { this, QString(), "Job" };
+	}
+
 
 protected:
 	virtual void doProcessing() = 0;
@@ -28,6 +28,7 @@
 
 #include <QtCore/QVector>
 #include <QtCore/QList>
+#include <QtCore/QMutex>
 #include <QWidget>
 #include <QSignalMapper>
 #include <QColor>
@@ -41,6 +42,9 @@
 #include "ModelView.h"
 #include "DataFile.h"
 
+#include <atomic>
+#include <vector>
+
 
 class QMenu;
 class QPushButton;
@@ -535,6 +539,11 @@ public:
 	}
 	void getTCOsInRange( tcoVector & tcoV, const MidiTime & start,
 							const MidiTime & end );
+	// called when TCOs are added, removed, moved or resized
+	void invalidateTCOIndex()
+	{
+		m_tcoIndexDirty = true;
+	}
 	void swapPositionOfTCOs( int tcoNum1, int tcoNum2 );
 
 	void createTCOsForBB( int bb );
@@ -616,6 +625,14 @@ private:
 
 	tcoVector m_trackContentObjects;
 
+	// TCOs sorted by start position along with the running maximum of
+	// their end positions, rebuilt by the first lookup after a change
+	void rebuildTCOIndex();
+	tcoVector m_tcoIndex;
+	std::vector<int> m_tcoIndexMaxEnd;
+	std::atomic_bool m_tcoIndexDirty;
+	QMutex m_tcoIndexMutex;
+
 	QMutex m_processingLock;
 
 	friend class TrackView;
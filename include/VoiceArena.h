@@ -0,0 +1,118 @@
+/*
+ * VoiceArena.h - recycles the per-note state of instruments
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef VOICE_ARENA_H
+#define VOICE_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <utility>
+
+#include "LocklessAllocator.h"
+#include "MemoryManager.h"
+#include "debug.h"
+
+
+/*! \brief Slots for the state instruments keep per note
+ *
+ *  Instruments create the state of a note in playNote() and store it in
+ *  NotePlayHandle::m_pluginData, deleteNotePluginData() destroys it again.
+ *  An arena owned by the instrument constructs these objects in place in
+ *  slots allocated once along with the instrument, so starting a note
+ *  doesn't allocate. As notes of one instrument are started on all worker
+ *  threads, slots are taken from a LocklessAllocator. Notes which don't fit
+ *  in any more are allocated by the MemoryManager and counted by
+ *  heapAllocations().
+ */
+template<typename T>
+class VoiceArena
+{
+public:
+	static const size_t DefaultCapacity = 128;
+
+	VoiceArena( size_t capacity = DefaultCapacity ) :
+		m_slots( capacity, sizeof( T ) ),
+		m_heapAllocations( 0 )
+	{
+		// slots are aligned like memory returned by new
+		static_assert( alignof( T ) <= alignof( std::max_align_t ),
+					"VoiceArena can't align voices" );
+	}
+
+	~VoiceArena()
+	{
+#ifdef LMMS_DEBUG
+		if( heapAllocations() > 0 )
+		{
+			fprintf( stderr, "VoiceArena: %d voices didn't fit in\n",
+							heapAllocations() );
+		}
+#endif
+	}
+
+	template<typename... Args>
+	T * create( Args&&... args )
+	{
+		void * slot = m_slots.tryAlloc();
+		if( slot == NULL )
+		{
+			m_heapAllocations.fetch_add( 1, std::memory_order_relaxed );
+			slot = MemoryManager::alloc( sizeof( T ) );
+		}
+		// bypass class specific operator new, e.g. from MM_OPERATORS
+		return ::new( slot ) T( std::forward<Args>( args )... );
+	}
+
+	void destroy( T * voice )
+	{
+		if( voice == NULL )
+		{
+			return;
+		}
+		voice->~T();
+		if( m_slots.contains( voice ) )
+		{
+			m_slots.free( voice );
+		}
+		else
+		{
+			MemoryManager::free( voice );
+		}
+	}
+
+	//! Returns the number of voices which had to be allocated on the heap
+	//! as all slots were taken
+	int heapAllocations() const
+	{
+		return m_heapAllocations.load( std::memory_order_relaxed );
+	}
+
+private:
+	LocklessAllocator m_slots;
+	std::atomic_int m_heapAllocations;
+
+} ;
+
+
+#endif
@@ -23,10 +23,13 @@
  *
  */
 
+#include <cstring>
+
 #include "DualFilter.h"
 
 #include "embed.h"
 #include "BasicFilters.h"
+#include "BufferManager.h"
 #include "plugin_export.h"
 
 extern "C"
@@ -130,68 +133,85 @@ bool DualFilterEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames
 	const bool enabled1 = m_dfControls.m_enabled1Model.value();
 	const bool enabled2 = m_dfControls.m_enabled2Model.value();
 
-	
-	
+	// both filters process a copy of the whole buffer at once
+	sampleFrame * buf1 = NULL;
+	sampleFrame * buf2 = NULL;
 
-	// buffer processing loop
-	for( fpp_t f = 0; f < frames; ++f )
+	// update filter 1
+	if( enabled1 )
 	{
-		// get mix amounts for wet signals of both filters
-		const float mix2 = ( ( *mixPtr + 1.0f ) * 0.5f );
-		const float mix1 = 1.0f - mix2;
-		const float gain1 = *gain1Ptr * 0.01f;
-		const float gain2 = *gain2Ptr * 0.01f;
-		sample_t s[2] = { 0.0f, 0.0f };	// mix
-		sample_t s1[2] = { buf[f][0], buf[f][1] };	// filter 1
-		sample_t s2[2] = { buf[f][0], buf[f][1] };	// filter 2
+		buf1 = BufferManager::acquire();
+		memcpy( buf1, buf, sizeof( sampleFrame ) * frames );
 
-		// update filter 1
-		if( enabled1 )
+		if( cut1Buffer || res1Buffer )
+		{
+			// coefficients follow the automation smoothly
+			m_filter1->processBuffer( buf1, frames, cut1Ptr, cut1Inc, res1Ptr, res1Inc );
+			m_filter1changed = false;
+			m_currentCut1 = cut1Ptr[( frames - 1 ) * cut1Inc];
+			m_currentRes1 = res1Ptr[( frames - 1 ) * res1Inc];
+		}
+		else
 		{
-			//update filter 1 params here
 			// recalculate only when necessary: either cut/res is changed, or the changed-flag is set (filter type or samplerate changed)
-			if( ( ( *cut1Ptr != m_currentCut1 ||
-				*res1Ptr != m_currentRes1 ) ) || m_filter1changed )
+			if( cut1 != m_currentCut1 || res1 != m_currentRes1 || m_filter1changed )
 			{
-				m_filter1->calcFilterCoeffs( *cut1Ptr, *res1Ptr );
+				m_filter1->calcFilterCoeffs( cut1, res1 );
 				m_filter1changed = false;
-				m_currentCut1 = *cut1Ptr;
-				m_currentRes1 = *res1Ptr;
+				m_currentCut1 = cut1;
+				m_currentRes1 = res1;
 			}
-			s1[0] = m_filter1->update( s1[0], 0 );
-			s1[1] = m_filter1->update( s1[1], 1 );
+			m_filter1->processBuffer( buf1, frames );
+		}
+	}
 
-			// apply gain
-			s1[0] *= gain1;
-			s1[1] *= gain1;
+	// update filter 2
+	if( enabled2 )
+	{
+		buf2 = BufferManager::acquire();
+		memcpy( buf2, buf, sizeof( sampleFrame ) * frames );
 
-			// apply mix
-			s[0] += ( s1[0] * mix1 );
-			s[1] += ( s1[1] * mix1 );
+		if( cut2Buffer || res2Buffer )
+		{
+			m_filter2->processBuffer( buf2, frames, cut2Ptr, cut2Inc, res2Ptr, res2Inc );
+			m_filter2changed = false;
+			m_currentCut2 = cut2Ptr[( frames - 1 ) * cut2Inc];
+			m_currentRes2 = res2Ptr[( frames - 1 ) * res2Inc];
 		}
-
-		// update filter 2
-		if( enabled2 )
+		else
 		{
-			//update filter 2 params here
-			if( ( ( *cut2Ptr != m_currentCut2 ||
-								*res2Ptr != m_currentRes2 ) ) || m_filter2changed )
+			if( cut2 != m_currentCut2 || res2 != m_currentRes2 || m_filter2changed )
 			{
-				m_filter2->calcFilterCoeffs( *cut2Ptr, *res2Ptr );
+				m_filter2->calcFilterCoeffs( cut2, res2 );
 				m_filter2changed = false;
-				m_currentCut2 = *cut2Ptr;
-				m_currentRes2 = *res2Ptr;
+				m_currentCut2 = cut2;
+				m_currentRes2 = res2;
 			}
-			s2[0] = m_filter2->update( s2[0], 0 );
-			s2[1] = m_filter2->update( s2[1], 1 );
+			m_filter2->processBuffer( buf2, frames );
+		}
+	}
+
+	// buffer processing loop
+	for( fpp_t f = 0; f < frames; ++f )
+	{
+		// get mix amounts for wet signals of both filters
+		const float mix2 = ( ( *mixPtr + 1.0f ) * 0.5f );
+		const float mix1 = 1.0f - mix2;
+		const float gain1 = *gain1Ptr * 0.01f;
+		const float gain2 = *gain2Ptr * 0.01f;
+		sample_t s[2] = { 0.0f, 0.0f };	// mix
 
-			//apply gain
-			s2[0] *= gain2;
-			s2[1] *= gain2;
+		if( enabled1 )
+		{
+			// apply gain and mix
+			s[0] += ( buf1[f][0] * gain1 * mix1 );
+			s[1] += ( buf1[f][1] * gain1 * mix1 );
+		}
 
-			// apply mix
-			s[0] += ( s2[0] * mix2 );
-			s[1] += ( s2[1] * mix2 );
+		if( enabled2 )
+		{
+			s[0] += ( buf2[f][0] * gain2 * mix2 );
+			s[1] += ( buf2[f][1] * gain2 * mix2 );
 		}
 		outSum += buf[f][0]*buf[f][0] + buf[f][1]*buf[f][1];
 
@@ -200,15 +220,14 @@ bool DualFilterEffect::processAudioBuffer( sampleFrame* buf, const fpp_t frames
 		buf[f][1] = d * buf[f][1] + w * s[1];
 
 		//increment pointers
-		cut1Ptr += cut1Inc;
-		res1Ptr += res1Inc;
 		gain1Ptr += gain1Inc;
-		cut2Ptr += cut2Inc;
-		res2Ptr += res2Inc;
 		gain2Ptr += gain2Inc;
 		mixPtr += mixInc;
 	}
 
+	BufferManager::release( buf1 );
+	BufferManager::release( buf2 );
+
 	checkGate( outSum / frames );
 
 	return isRunning();
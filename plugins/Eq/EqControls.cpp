@@ -96,7 +96,6 @@ EqControls::EqControls( EqEffect *effect ) :
 	m_para3PeakL = 0; m_para3PeakR = 0;
 	m_para4PeakL = 0; m_para4PeakR = 0;
 	m_highShelfPeakL = 0; m_highShelfPeakR = 0;
-	m_inProgress = false;
 	m_inGainModel.setScaleLogarithmic( true );
 }
 
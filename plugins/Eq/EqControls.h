@@ -70,7 +70,6 @@ public:
 	EqAnalyser m_inFftBands;
 	EqAnalyser m_outFftBands;
 
-	bool m_inProgress;
 	bool visable();
 
 private:
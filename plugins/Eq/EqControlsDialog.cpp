@@ -32,12 +32,15 @@
 #include "AutomatableButton.h"
 #include "embed.h"
 #include "Engine.h"
+#include "GuiApplication.h"
 #include "Knob.h"
 #include "Fader.h"
 #include "LedCheckbox.h"
+#include "MainWindow.h"
 #include "PixmapButton.h"
 
 #include "EqControls.h"
+#include "EqEffect.h"
 #include "EqFader.h"
 #include "EqParameterWidget.h"
 #include "EqSpectrumView.h"
@@ -60,6 +63,8 @@ EqControlsDialog::EqControlsDialog( EqControls *controls ) :
 	EqSpectrumView * outSpec = new EqSpectrumView( &controls->m_outFftBands, this );
 	outSpec->setColor( QColor( 9, 166, 156, 150 ) );
 	outSpec->move( 26, 17 );
+	// after the view took the latest spectrum
+	connect( gui->mainWindow(), SIGNAL( periodicUpdate() ), this, SLOT( updateBandPeaks() ) );
 
 	m_parameterWidget = new EqParameterWidget( this , controls );
 	m_parameterWidget->move( 26, 17 );
@@ -213,6 +218,18 @@ EqControlsDialog::EqControlsDialog( EqControls *controls ) :
 
 
 
+void EqControlsDialog::updateBandPeaks()
+{
+	EqAnalyser * outFftBands = &m_controls->m_outFftBands;
+	if( m_controls->m_analyseOutModel.value() && outFftBands->getEnergy() > 0 )
+	{
+		m_controls->m_effect->setBandPeaks( outFftBands, outFftBands->getSampleRate() );
+	}
+}
+
+
+
+
 void EqControlsDialog::mouseDoubleClickEvent(QMouseEvent *event)
 {
 	m_originalHeight = parentWidget()->height() == 283 ? m_originalHeight : parentWidget()->height() ;
@@ -48,6 +48,9 @@ public:
 
 	EqBand * setBand( EqControls * controls );
 
+private slots:
+	void updateBandPeaks();
+
 private:
 	EqControls * m_controls;
 	EqParameterWidget * m_parameterWidget;
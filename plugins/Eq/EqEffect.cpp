@@ -153,7 +153,6 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 		m_inGain = dbfsToAmp(m_eqControls.m_inGainModel.value());
 	}
 
-	m_eqControls.m_inProgress = true;
 	double outSum = 0.0;
 
 	for( fpp_t f = 0; f < frames; ++f )
@@ -278,14 +277,12 @@ bool EqEffect::processAudioBuffer( sampleFrame *buf, const fpp_t frames )
 	if(m_eqControls.m_analyseOutModel.value( true ) && outSum > 0 && m_eqControls.isViewVisible() )
 	{
 		m_eqControls.m_outFftBands.analyze( buf, frames );
-		setBandPeaks( &m_eqControls.m_outFftBands , ( int )( sampleRate ) );
 	}
 	else
 	{
 		m_eqControls.m_outFftBands.clear();
 	}
 
-	m_eqControls.m_inProgress = false;
 	return isRunning();
 }
 
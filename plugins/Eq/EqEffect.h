@@ -42,6 +42,10 @@ public:
 	{
 		return &m_eqControls;
 	}
+
+	// called by the dialog with the spectrum of the output
+	void setBandPeaks( EqAnalyser * fft , int );
+
 	inline void  gain( sampleFrame * buf, const fpp_t frames, float scale, sampleFrame * peak )
 	{
 		peak[0][0] = 0.0f; peak[0][1] = 0.0f;
@@ -93,8 +97,6 @@ private:
 	{
 		return index * sampleRate / ( MAX_BANDS * 2 );
 	}
-
-	void setBandPeaks( EqAnalyser * fft , int );
 };
 
 #endif // EQEFFECT_H
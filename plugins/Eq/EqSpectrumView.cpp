@@ -29,29 +29,10 @@
 #include "Mixer.h"
 
 EqAnalyser::EqAnalyser() :
-	m_framesFilledUp ( 0 ),
 	m_energy ( 0 ),
-	m_sampleRate ( 1 ),
-	m_active ( true )
+	m_sampleRate ( 1 )
 {
-	m_inProgress=false;
-	m_specBuf = ( fftwf_complex * ) fftwf_malloc( ( FFT_BUFFER_SIZE + 1 ) * sizeof( fftwf_complex ) );
-	m_fftPlan = fftwf_plan_dft_r2c_1d( FFT_BUFFER_SIZE*2, m_buffer, m_specBuf, FFTW_MEASURE );
-
-	//initialize Blackman-Harris window, constants taken from
-	//https://en.wikipedia.org/wiki/Window_function#A_list_of_window_functions
-	const float a0 = 0.35875;
-	const float a1 = 0.48829;
-	const float a2 = 0.14128;
-	const float a3 = 0.01168;
-
-	for(int i = 0; i < FFT_BUFFER_SIZE; i++)
-	{
-		m_fftWindow[i] = ( a0 - a1 * cosf( 2 * F_PI * i / (float)FFT_BUFFER_SIZE - 1 )
-									  + a2 * cosf( 4 * F_PI * i / (float)FFT_BUFFER_SIZE-1)
-									  - a3 * cos( 6 * F_PI * i / (float)FFT_BUFFER_SIZE - 1.0 ));
-	}
-	clear();
+	memset( m_bands, 0, sizeof( m_bands ) );
 }
 
 
@@ -59,8 +40,6 @@ EqAnalyser::EqAnalyser() :
 
 EqAnalyser::~EqAnalyser()
 {
-	fftwf_destroy_plan( m_fftPlan );
-	fftwf_free( m_specBuf );
 }
 
 
@@ -68,54 +47,31 @@ EqAnalyser::~EqAnalyser()
 
 void EqAnalyser::analyze( sampleFrame *buf, const fpp_t frames )
 {
-	//only analyse if the view is visible
-	if ( m_active )
-	{
-		m_inProgress=true;
-		const int FFT_BUFFER_SIZE = 2048;
-		fpp_t f = 0;
-		if( frames > FFT_BUFFER_SIZE )
-		{
-			m_framesFilledUp = 0;
-			f = frames - FFT_BUFFER_SIZE;
-		}
-		// meger channels
-		for( ; f < frames; ++f )
-		{
-			m_buffer[m_framesFilledUp] =
-					( buf[f][0] + buf[f][1] ) * 0.5;
-			++m_framesFilledUp;
-		}
-
-		if( m_framesFilledUp < FFT_BUFFER_SIZE )
-		{
-			m_inProgress = false;
-			return;
-		}
+	// ignored unless the view is visible
+	m_analysis.push( buf, frames );
+}
 
-		m_sampleRate = Engine::mixer()->processingSampleRate();
-		const int LOWEST_FREQ = 0;
-		const int HIGHEST_FREQ = m_sampleRate / 2;
 
-		//apply FFT window
-		for( int i = 0; i < FFT_BUFFER_SIZE; i++ )
-		{
-			m_buffer[i] = m_buffer[i] * m_fftWindow[i];
-		}
 
-		fftwf_execute( m_fftPlan );
-		absspec( m_specBuf, m_absSpecBuf, FFT_BUFFER_SIZE+1 );
 
-		compressbands( m_absSpecBuf, m_bands, FFT_BUFFER_SIZE+1,
-					   MAX_BANDS,
-					   ( int )( LOWEST_FREQ * ( FFT_BUFFER_SIZE + 1 ) / ( float )( m_sampleRate / 2 ) ),
-					   ( int )( HIGHEST_FREQ * ( FFT_BUFFER_SIZE +  1) / ( float )( m_sampleRate / 2 ) ) );
-		m_energy = maximum( m_bands, MAX_BANDS ) / maximum( m_buffer, FFT_BUFFER_SIZE );
+void EqAnalyser::update()
+{
+	if( !m_analysis.spectrum( m_spectrum ) )
+	{
+		return;
+	}
 
-		m_framesFilledUp = 0;
-		m_inProgress = false;
-		m_active = false;
+	m_sampleRate = Engine::mixer()->processingSampleRate();
+	if( m_spectrum.peak <= 0 )
+	{
+		m_energy = 0;
+		memset( m_bands, 0, sizeof( m_bands ) );
+		return;
 	}
+
+	compressbands( m_spectrum.magnitudes, m_bands, SpectrumAnalysis::BinCount,
+				   MAX_BANDS, 0, SpectrumAnalysis::BinCount );
+	m_energy = maximum( m_bands, MAX_BANDS ) / m_spectrum.peak;
 }
 
 
@@ -139,7 +95,7 @@ int EqAnalyser::getSampleRate() const
 
 bool EqAnalyser::getActive() const
 {
-	return m_active;
+	return m_analysis.isActive();
 }
 
 
@@ -147,15 +103,7 @@ bool EqAnalyser::getActive() const
 
 void EqAnalyser::setActive(bool active)
 {
-	m_active = active;
-}
-
-
-
-
-bool EqAnalyser::getInProgress()
-{
-	return m_inProgress;
+	m_analysis.setActive( active );
 }
 
 
@@ -163,10 +111,7 @@ bool EqAnalyser::getInProgress()
 
 void EqAnalyser::clear()
 {
-	m_framesFilledUp = 0;
-	m_energy = 0;
-	memset( m_buffer, 0, sizeof( m_buffer ) );
-	memset( m_bands, 0, sizeof( m_bands ) );
+	m_analysis.clear();
 }
 
 
@@ -209,7 +154,7 @@ void EqSpectrumView::paintEvent(QPaintEvent *event)
 	painter.setPen( QPen( m_color, 1, Qt::SolidLine, Qt::RoundCap, Qt::BevelJoin ) );
 	painter.setRenderHint(QPainter::Antialiasing, true);
 
-	if( m_analyser->getInProgress() || m_periodicalUpdate == false )
+	if( m_periodicalUpdate == false )
 	{
 		//only paint the cached path
 		painter.fillPath( m_path, QBrush( m_color ) );
@@ -291,5 +236,6 @@ void EqSpectrumView::periodicalUpdate()
 {
 	m_periodicalUpdate = true;
 	m_analyser->setActive( isVisible() );
+	m_analyser->update();
 	update();
 }
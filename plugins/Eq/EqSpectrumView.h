@@ -29,6 +29,7 @@
 #include "fft_helpers.h"
 #include "lmms_basics.h"
 #include "lmms_math.h"
+#include "SpectrumAnalysis.h"
 
 
 const int MAX_BANDS = 2048;
@@ -39,10 +40,12 @@ public:
 	virtual ~EqAnalyser();
 
 	float m_bands[MAX_BANDS];
-	bool getInProgress();
 	void clear();
 
+	//! Queues frames for the analysis thread, called by the effect
 	void analyze( sampleFrame *buf, const fpp_t frames );
+	//! Takes the latest spectrum of the analysis thread, called by the view
+	void update();
 
 	float getEnergy() const;
 	int getSampleRate() const;
@@ -51,16 +54,10 @@ public:
 	void setActive(bool active);
 
 private:
-	fftwf_plan m_fftPlan;
-	fftwf_complex * m_specBuf;
-	float m_absSpecBuf[FFT_BUFFER_SIZE+1];
-	float m_buffer[FFT_BUFFER_SIZE*2];
-	int m_framesFilledUp;
+	SpectrumAnalysis m_analysis;
+	SpectrumAnalysis::Spectrum m_spectrum;
 	float m_energy;
 	int m_sampleRate;
-	bool m_active;
-	bool m_inProgress;
-	float m_fftWindow[FFT_BUFFER_SIZE];
 };
 
 
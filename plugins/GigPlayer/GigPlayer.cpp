@@ -29,7 +29,9 @@
  */
 
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
 #include <QDebug>
 #include <QLayout>
 #include <QLabel>
@@ -91,6 +93,8 @@ GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	InstrumentPlayHandle * iph = new InstrumentPlayHandle( this, _instrument_track );
 	Engine::mixer()->addPlayHandle( iph );
 
+	m_streamer.start();
+
 	updateSampleRate();
 
 	connect( &m_bankNum, SIGNAL( dataChanged() ), this, SLOT( updatePatch() ) );
@@ -185,14 +189,16 @@ void GigInstrument::freeInstance()
 
 	if( m_instance != NULL )
 	{
-		delete m_instance;
-		m_instance = NULL;
-
 		// If we're changing instruments, we got to make sure that we
 		// remove all pointers to the old samples and don't try accessing
 		// that instrument again
 		m_instrument = NULL;
 		m_notes.clear();
+		m_heads.clear();
+		m_streamer.flush();
+
+		delete m_instance;
+		m_instance = NULL;
 	}
 }
 
@@ -490,6 +496,7 @@ void GigInstrument::play( sampleFrame * _working_buffer )
 			// Update note position with how many samples we actually used
 			sample->pos += used;
 			sample->adsr.inc( used );
+			sample->stream->consume( sample->pos );
 		}
 	}
 
@@ -516,167 +523,19 @@ void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cn
 		return;
 	}
 
-	// Determine if we need to loop part of this sample
-	bool loop = false;
-	gig::loop_type_t loopType = gig::loop_type_normal;
-	f_cnt_t loopStart = 0;
-	f_cnt_t loopLength = 0;
-
-	if( sample.region->pSampleLoops != NULL )
-	{
-		for( uint32_t i = 0; i < sample.region->SampleLoops; ++i )
-		{
-			loop = true;
-			loopType = static_cast<gig::loop_type_t>( sample.region->pSampleLoops[i].LoopType );
-			loopStart = sample.region->pSampleLoops[i].LoopStart;
-			loopLength = sample.region->pSampleLoops[i].LoopLength;
-
-			// Currently only support at max one loop
-			break;
-		}
-	}
-
-	unsigned long allocationsize = samples * sample.sample->FrameSize;
-	int8_t buffer[allocationsize];
-
-	// Load the sample in different ways depending on if we're looping or not
-	if( loop == true && ( sample.pos >= loopStart || sample.pos + samples > loopStart ) )
-	{
-		// Calculate the new position based on the type of loop
-		if( loopType == gig::loop_type_bidirectional )
-		{
-			sample.pos = getPingPongIndex( sample.pos, loopStart, loopStart + loopLength );
-		}
-		else
-		{
-			sample.pos = getLoopedIndex( sample.pos, loopStart, loopStart + loopLength );
-			// TODO: also implement loop_type_backward support
-		}
-
-		sample.sample->SetPos( sample.pos );
+	// Only reads from memory, looping is done by the stream
+	sample.stream->read( sample.pos, sampleData, samples );
 
-		// Load the samples (based on gig::Sample::ReadAndLoop) even around the end
-		// of a loop boundary wrapping to the beginning of the loop region
-		long samplestoread = samples;
-		long samplestoloopend = 0;
-		long readsamples = 0;
-		long totalreadsamples = 0;
-		long loopEnd = loopStart + loopLength;
-
-		do
-		{
-			samplestoloopend = loopEnd - sample.sample->GetPos();
-			readsamples = sample.sample->Read( &buffer[totalreadsamples * sample.sample->FrameSize],
-					min( samplestoread, samplestoloopend ) );
-			samplestoread -= readsamples;
-			totalreadsamples += readsamples;
-
-			if( readsamples >= samplestoloopend )
-			{
-				sample.sample->SetPos( loopStart );
-			}
-		}
-		while( samplestoread > 0 && readsamples > 0 );
-	}
-	else
+	for( f_cnt_t i = 0; i < samples; ++i )
 	{
-		sample.sample->SetPos( sample.pos );
-
-		unsigned long size = sample.sample->Read( &buffer, samples ) * sample.sample->FrameSize;
-		std::memset( (int8_t*) &buffer + size, 0, allocationsize - size );
-	}
-
-	// Convert from 16 or 24 bit into 32-bit float
-	if( sample.sample->BitDepth == 24 ) // 24 bit
-	{
-		uint8_t * pInt = reinterpret_cast<uint8_t*>( &buffer );
-
-		for( f_cnt_t i = 0; i < samples; ++i )
-		{
-			// libgig gives 24-bit data as little endian, so we must
-			// convert if on a big endian system
-			int32_t valueLeft = swap32IfBE(
-						( pInt[ 3 * sample.sample->Channels * i ] << 8 ) |
-						( pInt[ 3 * sample.sample->Channels * i + 1 ] << 16 ) |
-						( pInt[ 3 * sample.sample->Channels * i + 2 ] << 24 ) );
-
-			// Store the notes to this buffer before saving to output
-			// so we can fade them out as needed
-			sampleData[i][0] = 1.0 / 0x100000000 * sample.attenuation * valueLeft;
-
-			if( sample.sample->Channels == 1 )
-			{
-				sampleData[i][1] = sampleData[i][0];
-			}
-			else
-			{
-				int32_t valueRight = swap32IfBE(
-							( pInt[ 3 * sample.sample->Channels * i + 3 ] << 8 ) |
-							( pInt[ 3 * sample.sample->Channels * i + 4 ] << 16 ) |
-							( pInt[ 3 * sample.sample->Channels * i + 5 ] << 24 ) );
-
-				sampleData[i][1] = 1.0 / 0x100000000 * sample.attenuation * valueRight;
-			}
-		}
-	}
-	else // 16 bit
-	{
-		int16_t * pInt = reinterpret_cast<int16_t*>( &buffer );
-
-		for( f_cnt_t i = 0; i < samples; ++i )
-		{
-			sampleData[i][0] = 1.0 / 0x10000 *
-				pInt[ sample.sample->Channels * i ] * sample.attenuation;
-
-			if( sample.sample->Channels == 1 )
-			{
-				sampleData[i][1] = sampleData[i][0];
-			}
-			else
-			{
-				sampleData[i][1] = 1.0 / 0x10000 *
-					pInt[ sample.sample->Channels * i + 1 ] * sample.attenuation;
-			}
-		}
+		sampleData[i][0] *= sample.attenuation;
+		sampleData[i][1] *= sample.attenuation;
 	}
 }
 
 
 
 
-// These two loop index functions taken from SampleBuffer.cpp
-f_cnt_t GigInstrument::getLoopedIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const
-{
-	if( index < endf )
-	{
-		return index;
-	}
-
-	return startf + ( index - startf )
-				% ( endf - startf );
-}
-
-
-
-
-f_cnt_t GigInstrument::getPingPongIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const
-{
-	if( index < endf )
-	{
-		return index;
-	}
-
-	const f_cnt_t looplen = endf - startf;
-	const f_cnt_t looppos = ( index - endf ) % ( looplen * 2 );
-
-	return ( looppos < looplen )
-		? endf - looppos
-		: startf + ( looppos - looplen );
-}
-
-
-
-
 // A key has been released
 void GigInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
@@ -738,6 +597,10 @@ void GigInstrument::addSamples( GigNote & gignote, bool wantReleaseSample )
 		gig::DimensionRegion * pDimRegion = pRegion->GetDimensionRegionByValue( dim.DimValues );
 		gig::Sample * pSample = pDimRegion->pSample;
 
+		// Heads of all samples got loaded with the instrument, without
+		// one we'd have to wait for the disk
+		std::shared_ptr<GigSampleHead> head = m_heads.value( pSample );
+
 		// If this is a release sample, the note won't ever be
 		// released, so we handle it differently
 		gignote.isRelease = wantReleaseSample;
@@ -749,7 +612,7 @@ void GigInstrument::addSamples( GigNote & gignote, bool wantReleaseSample )
 			gignote.release = dim.release;
 		}
 
-		if( pSample != NULL && pSample->SamplesTotal != 0 )
+		if( pSample != NULL && pSample->SamplesTotal != 0 && head )
 		{
 			int keyLow = pRegion->KeyRange.low;
 			int keyHigh = pRegion->KeyRange.high;
@@ -771,8 +634,15 @@ void GigInstrument::addSamples( GigNote & gignote, bool wantReleaseSample )
 					attenuation *= pDimRegion->SampleAttenuation;
 				}
 
-				gignote.samples.push_back( GigSample( pSample, pDimRegion,
-							attenuation, m_interpolation, gignote.frequency ) );
+				// Without a free stream the sample isn't played
+				GigStream * stream = m_streamer.startStream( head,
+							GigLoop( pDimRegion ) );
+				if( stream != NULL )
+				{
+					gignote.samples.push_back( GigSample( pSample, pDimRegion,
+						stream, attenuation, m_interpolation,
+						gignote.frequency ) );
+				}
 			}
 		}
 
@@ -870,11 +740,18 @@ void GigInstrument::getInstrument()
 	int iBankSelected = m_bankNum.value();
 	int iProgSelected = m_patchNum.value();
 
-	QMutexLocker locker( &m_synthMutex );
+	gig::Instrument * pInstrument = NULL;
+	QHash<gig::Sample *, std::shared_ptr<GigSampleHead> > heads;
 
-	if( m_instance != NULL )
 	{
-		gig::Instrument * pInstrument = m_instance->gig.GetFirstInstrument();
+		QMutexLocker locker( &m_synthMutex );
+
+		if( m_instance == NULL )
+		{
+			return;
+		}
+
+		pInstrument = m_instance->gig.GetFirstInstrument();
 
 		while( pInstrument != NULL )
 		{
@@ -889,8 +766,42 @@ void GigInstrument::getInstrument()
 			pInstrument = m_instance->gig.GetNextInstrument();
 		}
 
-		m_instrument = pInstrument;
+		heads = m_heads;
+	}
+
+	// Load the beginnings of all samples the instrument may play without
+	// blocking the audio thread meanwhile. Going through the key table
+	// rather than GetFirstRegion() leaves libgig's region iterator to
+	// addSamples().
+	QHash<gig::Sample *, std::shared_ptr<GigSampleHead> > newHeads;
+	if( pInstrument != NULL )
+	{
+		for( int key = 0; key < 128; ++key )
+		{
+			gig::Region * pRegion = pInstrument->RegionKeyTable[key];
+			if( pRegion == NULL )
+			{
+				continue;
+			}
+
+			for( uint32_t i = 0; i < pRegion->DimensionRegions; ++i )
+			{
+				gig::Sample * pSample = pRegion->pDimensionRegions[i]->pSample;
+				if( pSample == NULL || pSample->SamplesTotal == 0 ||
+						newHeads.contains( pSample ) )
+				{
+					continue;
+				}
+
+				std::shared_ptr<GigSampleHead> head = heads.value( pSample );
+				newHeads[pSample] = head ? head : m_streamer.loadHead( pSample );
+			}
+		}
 	}
+
+	QMutexLocker locker( &m_synthMutex );
+	m_instrument = pInstrument;
+	m_heads = newHeads;
 }
 
 
@@ -1098,8 +1009,10 @@ void GigInstrumentView::showPatchDialog()
 
 // Store information related to playing a sample from the GIG file
 GigSample::GigSample( gig::Sample * pSample, gig::DimensionRegion * pDimRegion,
+		GigStream * stream,
 		float attenuation, int interpolation, float desiredFreq )
-	: sample( pSample ), region( pDimRegion ), attenuation( attenuation ),
+	: sample( pSample ), region( pDimRegion ), stream( stream ),
+	  attenuation( attenuation ),
 	  pos( 0 ), interpolation( interpolation ), srcState( NULL ),
 	  sampleFreq( 0 ), freqFactor( 1 )
 {
@@ -1133,6 +1046,8 @@ GigSample::GigSample( gig::Sample * pSample, gig::DimensionRegion * pDimRegion,
 
 GigSample::~GigSample()
 {
+	stream->removeUser();
+
 	if( srcState != NULL )
 	{
 		src_delete( srcState );
@@ -1143,10 +1058,13 @@ GigSample::~GigSample()
 
 
 GigSample::GigSample( const GigSample& g )
-	: sample( g.sample ), region( g.region ), attenuation( g.attenuation ),
+	: sample( g.sample ), region( g.region ), stream( g.stream ),
+	  attenuation( g.attenuation ),
 	  adsr( g.adsr ), pos( g.pos ), interpolation( g.interpolation ),
 	  srcState( NULL ), sampleFreq( g.sampleFreq ), freqFactor( g.freqFactor )
 {
+	stream->addUser();
+
 	// On the copy, we want to create the object
 	updateSampleRate();
 }
@@ -1158,6 +1076,9 @@ GigSample& GigSample::operator=( const GigSample& g )
 {
 	sample = g.sample;
 	region= g.region;
+	g.stream->addUser();
+	stream->removeUser();
+	stream = g.stream;
 	attenuation = g.attenuation;
 	adsr = g.adsr;
 	pos = g.pos;
@@ -1243,6 +1164,474 @@ bool GigSample::convertSampleRate( sampleFrame & oldBuf, sampleFrame & newBuf,
 
 
 
+// Convert from 16 or 24 bit into 32-bit float, mono samples get played on
+// both channels
+static void convertFrames( const gig::Sample * sample, const int8_t * raw,
+					sampleFrame * out, f_cnt_t frames )
+{
+	if( sample->BitDepth == 24 ) // 24 bit
+	{
+		const uint8_t * pInt = reinterpret_cast<const uint8_t*>( raw );
+
+		for( f_cnt_t i = 0; i < frames; ++i )
+		{
+			// libgig gives 24-bit data as little endian, so we must
+			// convert if on a big endian system
+			int32_t valueLeft = swap32IfBE(
+						( pInt[ 3 * sample->Channels * i ] << 8 ) |
+						( pInt[ 3 * sample->Channels * i + 1 ] << 16 ) |
+						( pInt[ 3 * sample->Channels * i + 2 ] << 24 ) );
+
+			out[i][0] = 1.0 / 0x100000000 * valueLeft;
+
+			if( sample->Channels == 1 )
+			{
+				out[i][1] = out[i][0];
+			}
+			else
+			{
+				int32_t valueRight = swap32IfBE(
+							( pInt[ 3 * sample->Channels * i + 3 ] << 8 ) |
+							( pInt[ 3 * sample->Channels * i + 4 ] << 16 ) |
+							( pInt[ 3 * sample->Channels * i + 5 ] << 24 ) );
+
+				out[i][1] = 1.0 / 0x100000000 * valueRight;
+			}
+		}
+	}
+	else // 16 bit
+	{
+		const int16_t * pInt = reinterpret_cast<const int16_t*>( raw );
+
+		for( f_cnt_t i = 0; i < frames; ++i )
+		{
+			out[i][0] = 1.0 / 0x10000 * pInt[ sample->Channels * i ];
+
+			if( sample->Channels == 1 )
+			{
+				out[i][1] = out[i][0];
+			}
+			else
+			{
+				out[i][1] = 1.0 / 0x10000 * pInt[ sample->Channels * i + 1 ];
+			}
+		}
+	}
+}
+
+
+
+
+// Read frames from the file starting at first, frames behind the end of the
+// sample are silent
+static void readFrames( gig::Sample * sample, f_cnt_t first, sampleFrame * out,
+				f_cnt_t frames, std::vector<int8_t> & raw )
+{
+	f_cnt_t read = 0;
+	if( first < f_cnt_t( sample->SamplesTotal ) )
+	{
+		raw.resize( frames * sample->FrameSize );
+		sample->SetPos( first );
+		read = sample->Read( raw.data(), frames );
+		convertFrames( sample, raw.data(), out, read );
+	}
+	std::memset( out + read, 0, ( frames - read ) * sizeof( sampleFrame ) );
+}
+
+
+
+
+GigSampleHead::GigSampleHead( gig::Sample * sample )
+	: sample( sample ),
+	  frames( qMin<f_cnt_t>( sample->SamplesTotal, f_cnt_t( HeadFrames ) ) ),
+	  complete( frames == f_cnt_t( sample->SamplesTotal ) ),
+	  data( new sampleFrame[frames] )
+{
+	std::vector<int8_t> raw;
+	readFrames( sample, 0, data.get(), frames, raw );
+}
+
+
+
+
+GigLoop::GigLoop()
+	: enabled( false ), pingPong( false ), start( 0 ), length( 0 )
+{
+}
+
+
+
+
+GigLoop::GigLoop( gig::DimensionRegion * region )
+	: enabled( false ), pingPong( false ), start( 0 ), length( 0 )
+{
+	// Currently only support at max one loop
+	// TODO: also implement loop_type_backward support
+	if( region->pSampleLoops != NULL && region->SampleLoops > 0 &&
+			region->pSampleLoops[0].LoopLength > 0 )
+	{
+		enabled = true;
+		pingPong = region->pSampleLoops[0].LoopType ==
+					gig::loop_type_bidirectional;
+		start = region->pSampleLoops[0].LoopStart;
+		length = region->pSampleLoops[0].LoopLength;
+	}
+}
+
+
+
+
+f_cnt_t GigLoop::index( f_cnt_t pos, f_cnt_t & run, int & step ) const
+{
+	const f_cnt_t end = start + length;
+
+	step = 1;
+	if( !enabled )
+	{
+		run = std::numeric_limits<f_cnt_t>::max() - pos;
+		return pos;
+	}
+	if( pos < end )
+	{
+		run = end - pos;
+		return pos;
+	}
+
+	if( !pingPong )
+	{
+		const f_cnt_t i = start + ( pos - start ) % length;
+		run = end - i;
+		return i;
+	}
+
+	// Going back from the end of the loop, then forth from its start
+	const f_cnt_t looppos = ( pos - end ) % ( length * 2 );
+	if( looppos < length )
+	{
+		step = -1;
+		run = length - looppos;
+		return end - 1 - looppos;
+	}
+	run = length * 2 - looppos;
+	return start + ( looppos - length );
+}
+
+
+
+
+GigStream::GigStream()
+	: m_ring( new sampleFrame[RingFrames] ),
+	  m_streamStart( 0 ),
+	  m_readPos( 0 ), m_writePos( 0 ), m_users( 0 )
+{
+}
+
+
+
+
+void GigStream::start( const std::shared_ptr<GigSampleHead> & head,
+						const GigLoop & loop )
+{
+	m_head = head;
+	m_loop = loop;
+	// Complete heads provide every frame of the note, looped or not
+	m_streamStart = head->complete ? std::numeric_limits<f_cnt_t>::max() :
+								head->frames;
+	m_readPos.store( 0, std::memory_order_relaxed );
+	m_writePos.store( head->frames, std::memory_order_relaxed );
+	m_users.store( 1, std::memory_order_relaxed );
+}
+
+
+
+
+void GigStream::read( f_cnt_t pos, sampleFrame * out, f_cnt_t frames ) const
+{
+	// Frames before m_streamStart never loop to frames behind the head
+	const f_cnt_t fromHead = qBound<f_cnt_t>( 0, m_streamStart - pos, frames );
+	produce( pos, out, fromHead, NULL );
+	pos += fromHead;
+	out += fromHead;
+	frames -= fromHead;
+
+	const f_cnt_t available = qBound<f_cnt_t>( 0,
+			m_writePos.load( std::memory_order_acquire ) - pos, frames );
+	for( f_cnt_t copied = 0; copied < available; )
+	{
+		const f_cnt_t index = ( pos + copied ) % RingFrames;
+		const f_cnt_t count = qMin( available - copied, RingFrames - index );
+		std::memcpy( out + copied, m_ring.get() + index,
+						count * sizeof( sampleFrame ) );
+		copied += count;
+	}
+
+	// The disk couldn't keep up
+	std::memset( out + available, 0,
+			( frames - available ) * sizeof( sampleFrame ) );
+}
+
+
+
+
+void GigStream::consume( f_cnt_t pos )
+{
+	m_readPos.store( pos, std::memory_order_release );
+}
+
+
+
+
+bool GigStream::fill( std::vector<int8_t> & raw )
+{
+	if( m_head->complete )
+	{
+		return false;
+	}
+
+	const f_cnt_t writePos = m_writePos.load( std::memory_order_relaxed );
+	const f_cnt_t space = m_readPos.load( std::memory_order_acquire ) +
+							RingFrames - writePos;
+	if( space < ChunkFrames )
+	{
+		return false;
+	}
+
+	const f_cnt_t index = writePos % RingFrames;
+	const f_cnt_t count = qMin( f_cnt_t( ChunkFrames ), RingFrames - index );
+	produce( writePos, m_ring.get() + index, count, &raw );
+	m_writePos.store( writePos + count, std::memory_order_release );
+
+	return true;
+}
+
+
+
+
+void GigStream::stop()
+{
+	// The head may be the last reference to it
+	m_head.reset();
+}
+
+
+
+
+void GigStream::produce( f_cnt_t pos, sampleFrame * out, f_cnt_t frames,
+					std::vector<int8_t> * raw ) const
+{
+	while( frames > 0 )
+	{
+		f_cnt_t run;
+		int step;
+		const f_cnt_t index = m_loop.index( pos, run, step );
+		run = qMin( run, frames );
+
+		if( step > 0 )
+		{
+			copySource( index, out, run, raw );
+		}
+		else
+		{
+			copySource( index - run + 1, out, run, raw );
+			std::reverse( out, out + run );
+		}
+
+		pos += run;
+		out += run;
+		frames -= run;
+	}
+}
+
+
+
+
+void GigStream::copySource( f_cnt_t first, sampleFrame * out, f_cnt_t frames,
+					std::vector<int8_t> * raw ) const
+{
+	const f_cnt_t fromHead = qBound<f_cnt_t>( 0, m_head->frames - first, frames );
+	std::memcpy( out, m_head->data.get() + first,
+					fromHead * sizeof( sampleFrame ) );
+
+	if( fromHead < frames )
+	{
+		if( raw != NULL && !m_head->complete )
+		{
+			readFrames( m_head->sample, first + fromHead, out + fromHead,
+						frames - fromHead, *raw );
+		}
+		else
+		{
+			std::memset( out + fromHead, 0,
+				( frames - fromHead ) * sizeof( sampleFrame ) );
+		}
+	}
+}
+
+
+
+
+GigStreamer::GigStreamer() :
+	QThread(),
+	m_created( 0 ),
+	m_free( MaxStreams ),
+	m_started( MaxStreams ),
+	m_quit( false )
+{
+	m_playing.reserve( MaxStreams );
+	createSpares();
+}
+
+
+
+
+GigStreamer::~GigStreamer()
+{
+	m_quit = true;
+	m_wake.release();
+	wait();
+	flush();
+}
+
+
+
+
+std::shared_ptr<GigSampleHead> GigStreamer::loadHead( gig::Sample * sample )
+{
+	QMutexLocker locker( &m_mutex );
+	return std::make_shared<GigSampleHead>( sample );
+}
+
+
+
+
+GigStream * GigStreamer::startStream( const std::shared_ptr<GigSampleHead> & head,
+						const GigLoop & loop )
+{
+	int * free = m_free.beginRead();
+	if( free == NULL )
+	{
+		return NULL;
+	}
+	const int index = *free;
+	m_free.endRead();
+
+	GigStream * stream = m_streams[index].get();
+	stream->start( head, loop );
+
+	// Never full, there are no more streams than it has room for
+	*m_started.beginWrite() = index;
+	m_started.endWrite();
+	m_wake.release();
+
+	return stream;
+}
+
+
+
+
+void GigStreamer::flush()
+{
+	QMutexLocker locker( &m_mutex );
+	takeStarted();
+	for( int index : m_playing )
+	{
+		recycle( index );
+	}
+	m_playing.clear();
+}
+
+
+
+
+void GigStreamer::run()
+{
+	while( !m_quit )
+	{
+		bool busy = false;
+		bool idle = false;
+		{
+			QMutexLocker locker( &m_mutex );
+			takeStarted();
+
+			// Each stream gets a chunk per round, so the ones which
+			// just started don't wait for a long one to be filled
+			for( size_t i = 0; i < m_playing.size(); )
+			{
+				GigStream * stream = m_streams[m_playing[i]].get();
+				// Nobody plays the sample anymore
+				if( !stream->isUsed() )
+				{
+					recycle( m_playing[i] );
+					m_playing[i] = m_playing.back();
+					m_playing.pop_back();
+					continue;
+				}
+				busy |= stream->fill( m_raw );
+				++i;
+			}
+
+			createSpares();
+			idle = m_playing.empty();
+		}
+
+		if( idle )
+		{
+			// Sleep until a note starts
+			m_wake.acquire();
+		}
+		else if( !busy )
+		{
+			// The ring buffers last for many periods, the heads for
+			// several, so only notes which start wake us up early
+			m_wake.tryAcquire( 1, 5 );
+		}
+		// Streams started meanwhile get picked up by the next round
+		m_wake.tryAcquire( m_wake.available() );
+	}
+}
+
+
+
+
+void GigStreamer::takeStarted()
+{
+	while( int * index = m_started.beginRead() )
+	{
+		m_playing.push_back( *index );
+		m_started.endRead();
+	}
+}
+
+
+
+
+void GigStreamer::recycle( int index )
+{
+	m_streams[index]->stop();
+	*m_free.beginWrite() = index;
+	m_free.endWrite();
+}
+
+
+
+
+void GigStreamer::createSpares()
+{
+	// Streams handed out but not picked up yet count as spares, which
+	// only delays creating new ones by a round
+	while( m_created < MaxStreams &&
+		m_created - static_cast<int>( m_playing.size() ) < SpareStreams )
+	{
+		m_streams[m_created].reset( new GigStream );
+		*m_free.beginWrite() = m_created;
+		m_free.endWrite();
+		++m_created;
+	}
+}
+
+
+
+
 ADSR::ADSR()
 	: preattack( 0 ), attack( 0 ), decay1( 0 ), decay2( 0 ), infiniteSustain( false ),
 	  sustain( 0 ), release( 0 ),
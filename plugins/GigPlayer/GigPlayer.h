@@ -27,17 +27,25 @@
 #ifndef GIG_PLAYER_H
 #define GIG_PLAYER_H
 
+#include <QHash>
 #include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QSemaphore>
+#include <QThread>
 #include <samplerate.h>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "Instrument.h"
 #include "PixmapButton.h"
 #include "InstrumentView.h"
 #include "Knob.h"
 #include "LcdSpinBox.h"
 #include "LedCheckbox.h"
+#include "LocklessRingBuffer.h"
 #include "MemoryManager.h"
 #include "gig.h"
 
@@ -133,12 +141,182 @@ public:
 
 
 
+// The beginning of a sample from the GIG file converted to float, so notes can
+// start playing without waiting for the disk. Short samples are kept
+// completely, the rest of longer ones gets streamed by GigStreamer.
+class GigSampleHead
+{
+public:
+	static const f_cnt_t HeadFrames = 8192;
+
+	// Reads from the file, so only GigStreamer creates heads
+	GigSampleHead( gig::Sample * sample );
+
+	gig::Sample * sample;
+	f_cnt_t frames;
+	// Whether frames covers the whole sample
+	bool complete;
+	std::unique_ptr<sampleFrame[]> data;
+} ;
+
+
+
+
+// The loop of a dimension region, maps positions in the played note to
+// frames of the sample
+class GigLoop
+{
+public:
+	GigLoop();
+	GigLoop( gig::DimensionRegion * region );
+
+	// Returns the frame played at pos, run is set to how many frames from
+	// there on follow in the same direction, which step tells
+	f_cnt_t index( f_cnt_t pos, f_cnt_t & run, int & step ) const;
+
+private:
+	bool enabled;
+	bool pingPong;
+	f_cnt_t start;
+	f_cnt_t length;
+} ;
+
+
+
+
+// Provides the frames of one playing sample. Reading happens on the audio
+// thread and only touches memory: frames before the end of the head come from
+// there, later ones from a ring buffer GigStreamer keeps filled ahead of the
+// play position. Streams are owned by GigStreamer and reused for later notes.
+class GigStream
+{
+public:
+	static const f_cnt_t RingFrames = 32768;
+	static const f_cnt_t ChunkFrames = 4096;
+
+	GigStream();
+
+	// Prepares the stream for a new note with one user, called on the audio
+	// thread
+	void start( const std::shared_ptr<GigSampleHead> & head,
+						const GigLoop & loop );
+
+	// GigSamples count their copies, the stream can be reused once there
+	// are none left
+	void addUser()
+	{
+		m_users.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	void removeUser()
+	{
+		m_users.fetch_sub( 1, std::memory_order_release );
+	}
+
+	bool isUsed() const
+	{
+		return m_users.load( std::memory_order_acquire ) > 0;
+	}
+
+	// Writes the frames played from pos on to out, frames which didn't
+	// arrive from the disk yet are silent
+	void read( f_cnt_t pos, sampleFrame * out, f_cnt_t frames ) const;
+	// Frames before pos won't be read anymore
+	void consume( f_cnt_t pos );
+
+	// Called by the streaming thread, reads the next chunk if there's room
+	// for it in the ring buffer
+	bool fill( std::vector<int8_t> & raw );
+
+	// Called by the streaming thread once nobody uses the stream anymore
+	void stop();
+
+private:
+	// Writes the frames played from pos on, raw is NULL on the audio thread
+	// which mustn't read anything that's not in the head
+	void produce( f_cnt_t pos, sampleFrame * out, f_cnt_t frames,
+					std::vector<int8_t> * raw ) const;
+	void copySource( f_cnt_t first, sampleFrame * out, f_cnt_t frames,
+					std::vector<int8_t> * raw ) const;
+
+	std::shared_ptr<GigSampleHead> m_head;
+	GigLoop m_loop;
+
+	// Holds the frames from m_streamStart on
+	std::unique_ptr<sampleFrame[]> m_ring;
+	f_cnt_t m_streamStart;
+	std::atomic<f_cnt_t> m_readPos;
+	std::atomic<f_cnt_t> m_writePos;
+	std::atomic<int> m_users;
+} ;
+
+
+
+
+// Dedicated thread which does all the reading from the GIG file, so the audio
+// thread never waits for the disk. It also owns the streams along with their
+// ring buffers and creates them ahead of time, so starting a note doesn't
+// allocate. Streams travel between both threads as indices.
+class GigStreamer : public QThread
+{
+public:
+	// Streams played at once, further notes get dropped
+	static const int MaxStreams = 256;
+	// Streams kept ready for notes to start
+	static const int SpareStreams = 32;
+
+	GigStreamer();
+	virtual ~GigStreamer();
+
+	std::shared_ptr<GigSampleHead> loadHead( gig::Sample * sample );
+
+	// Returns a stream for a new note or NULL if all are playing. Neither
+	// blocks nor allocates, so it's safe on the audio thread. Only one
+	// thread at a time may start streams.
+	GigStream * startStream( const std::shared_ptr<GigSampleHead> & head,
+						const GigLoop & loop );
+
+	// Takes back all streams, which mustn't be used anymore. Afterwards no
+	// sample gets accessed until a stream is started again.
+	void flush();
+
+private:
+	virtual void run();
+
+	void takeStarted();
+	void recycle( int index );
+	void createSpares();
+
+	// Held while accessing samples
+	QMutex m_mutex;
+
+	std::unique_ptr<GigStream> m_streams[MaxStreams];
+	// Number of streams created so far, only touched by the streaming thread
+	int m_created;
+	// Indices of streams ready to start, from the streaming thread
+	LocklessRingBuffer<int> m_free;
+	// Indices of started streams, to the streaming thread
+	LocklessRingBuffer<int> m_started;
+	// Indices of the streams the streaming thread fills
+	std::vector<int> m_playing;
+	std::vector<int8_t> m_raw;
+
+	// Released whenever a stream starts
+	QSemaphore m_wake;
+	std::atomic_bool m_quit;
+} ;
+
+
+
+
 // The sample from the GIG file with our current position in both the sample
 // and the envelope
 class GigSample
 {
 public:
+	// Takes over the user the stream was started with
 	GigSample( gig::Sample * pSample, gig::DimensionRegion * pDimRegion,
+			GigStream * stream,
 			float attenuation, int interpolation, float desiredFreq );
 	~GigSample();
 
@@ -153,6 +331,7 @@ public:
 
 	gig::Sample * sample;
 	gig::DimensionRegion * region;
+	GigStream * stream;
 	float attenuation;
 	ADSR adsr;
 
@@ -295,9 +474,15 @@ private:
 	// Used for resampling
 	int m_interpolation;
 
+	// Declared before the notes, whose samples use its streams
+	GigStreamer m_streamer;
+
 	// List of all the currently playing notes
 	QList<GigNote> m_notes;
 
+	// Beginnings of all samples of the current instrument
+	QHash<gig::Sample *, std::shared_ptr<GigSampleHead> > m_heads;
+
 	// Used when determining which samples to use
 	uint32_t m_RandomSeed;
 	float m_currentKeyDimension;
@@ -313,10 +498,8 @@ private:
 	// parameters such as velocity
 	Dimension getDimensions( gig::Region * pRegion, int velocity, bool release );
 
-	// Load sample data from the Gig file, looping the sample where needed
+	// Load sample data of a note, looping the sample where needed
 	void loadSample( GigSample& sample, sampleFrame* sampleData, f_cnt_t samples );
-	f_cnt_t getLoopedIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const;
-	f_cnt_t getPingPongIndex( f_cnt_t index, f_cnt_t startf, f_cnt_t endf ) const;
 
 	// Add the desired samples to the note, either normal samples or release
 	// samples
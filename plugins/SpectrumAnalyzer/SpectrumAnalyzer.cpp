@@ -50,14 +50,8 @@ Plugin::Descriptor PLUGIN_EXPORT spectrumanalyzer_plugin_descriptor =
 SpectrumAnalyzer::SpectrumAnalyzer( Model * _parent,
 			const Descriptor::SubPluginFeatures::Key * _key ) :
 	Effect( &spectrumanalyzer_plugin_descriptor, _parent, _key ),
-	m_saControls( this ),
-	m_framesFilledUp( 0 ),
-	m_energy( 0 )
+	m_saControls( this )
 {
-	memset( m_buffer, 0, sizeof( m_buffer ) );
-
-	m_specBuf = (fftwf_complex *) fftwf_malloc( ( FFT_BUFFER_SIZE + 1 ) * sizeof( fftwf_complex ) );
-	m_fftPlan = fftwf_plan_dft_r2c_1d( FFT_BUFFER_SIZE*2, m_buffer, m_specBuf, FFTW_MEASURE );
 }
 
 
@@ -65,8 +59,6 @@ SpectrumAnalyzer::SpectrumAnalyzer( Model * _parent,
 
 SpectrumAnalyzer::~SpectrumAnalyzer()
 {
-	fftwf_destroy_plan( m_fftPlan );
-	fftwf_free( m_specBuf );
 }
 
 
@@ -84,71 +76,10 @@ bool SpectrumAnalyzer::processAudioBuffer( sampleFrame* _buf, const fpp_t _frame
 		return true;
 	}
 
-	fpp_t f = 0;
-	if( _frames > FFT_BUFFER_SIZE )
-	{
-		m_framesFilledUp = 0;
-		f = _frames - FFT_BUFFER_SIZE;
-	}
-
-	const int cm = m_saControls.m_channelMode.value();
-
-	switch( cm )
-	{
-		case MergeChannels:
-			for( ; f < _frames; ++f )
-			{
-				m_buffer[m_framesFilledUp] =
-					( _buf[f][0] + _buf[f][1] ) * 0.5;
-				++m_framesFilledUp;
-			}
-			break;
-		case LeftChannel:
-			for( ; f < _frames; ++f )
-			{
-				m_buffer[m_framesFilledUp] = _buf[f][0];
-				++m_framesFilledUp;
-			}
-			break;
-		case RightChannel:
-			for( ; f < _frames; ++f )
-			{
-				m_buffer[m_framesFilledUp] = _buf[f][1];
-				++m_framesFilledUp;
-			}
-			break;
-	}
-
-	if( m_framesFilledUp < FFT_BUFFER_SIZE )
-	{
-		return isRunning();
-	}
-
-
-//	hanming( m_buffer, FFT_BUFFER_SIZE, HAMMING );
-
-	const sample_rate_t sr = Engine::mixer()->processingSampleRate();
-	const int LOWEST_FREQ = 0;
-	const int HIGHEST_FREQ = sr / 2;
-
-	fftwf_execute( m_fftPlan );
-	absspec( m_specBuf, m_absSpecBuf, FFT_BUFFER_SIZE+1 );
-	if( m_saControls.m_linearSpec.value() )
-	{
-		compressbands( m_absSpecBuf, m_bands, FFT_BUFFER_SIZE+1,
-			MAX_BANDS,
-			(int)(LOWEST_FREQ*(FFT_BUFFER_SIZE+1)/(float)(sr/2)),
-			(int)(HIGHEST_FREQ*(FFT_BUFFER_SIZE+1)/(float)(sr/2)));
-		m_energy = maximum( m_bands, MAX_BANDS ) / maximum( m_buffer, FFT_BUFFER_SIZE );
-	}
-	else
-	{
-		calc13octaveband31( m_absSpecBuf, m_bands, FFT_BUFFER_SIZE+1, sr/2.0 );
-		m_energy = signalpower( m_buffer, FFT_BUFFER_SIZE ) / maximum( m_buffer, FFT_BUFFER_SIZE );
-	}
-
-
-	m_framesFilledUp = 0;
+	// the spectrum gets computed on the analysis thread
+	m_analysis.setChannelMode( static_cast<SpectrumAnalysis::ChannelModes>(
+					m_saControls.m_channelMode.value() ) );
+	m_analysis.push( _buf, _frames );
 
 	checkGate( 1 );
 
@@ -27,7 +27,7 @@
 #define _SPECTRUM_ANALYZER_H
 
 #include "Effect.h"
-#include "fft_helpers.h"
+#include "SpectrumAnalysis.h"
 #include "SpectrumAnalyzerControls.h"
 
 
@@ -59,15 +59,7 @@ public:
 private:
 	SpectrumAnalyzerControls m_saControls;
 
-	fftwf_plan m_fftPlan;
-
-	fftwf_complex * m_specBuf;
-	float m_absSpecBuf[FFT_BUFFER_SIZE+1];
-	float m_buffer[FFT_BUFFER_SIZE*2];
-	int m_framesFilledUp;
-
-	float m_bands[MAX_BANDS];
-	float m_energy;
+	SpectrumAnalysis m_analysis;
 
 	friend class SpectrumAnalyzerControls;
 	friend class SpectrumView;
@@ -59,7 +59,8 @@ public:
 		QWidget( _parent ),
 		m_sa( s ),
 		m_backgroundPlain( PLUGIN_NAME::getIconPixmap( "spectrum_background_plain" ).toImage() ),
-		m_background( PLUGIN_NAME::getIconPixmap( "spectrum_background" ).toImage() )
+		m_background( PLUGIN_NAME::getIconPixmap( "spectrum_background" ).toImage() ),
+		m_energy( 0 )
 	{
 		setFixedSize( 249, 151 );
 		connect( gui->mainWindow(), SIGNAL( periodicUpdate() ), this, SLOT( update() ) );
@@ -75,7 +76,9 @@ public:
 		QPainter p( this );
 		QImage i = m_sa->m_saControls.m_linearSpec.value() ?
 					m_backgroundPlain : m_background;
-		const float e = m_sa->m_energy;
+		m_sa->m_analysis.spectrum( m_spectrum );
+		updateBands();
+		const float e = m_energy;
 		if( e <= 0 )
 		{
 			darken( i, 0, 0, i.width(), i.height() );
@@ -84,7 +87,7 @@ public:
 		}
 
 		const bool lin_y = m_sa->m_saControls.m_linearYAxis.value();
-		float * b = m_sa->m_bands;
+		float * b = m_bands;
 		const int LOWER_Y = -60;	// dB
 		int h;
 		const int fh = height();
@@ -136,10 +139,38 @@ public:
 
 
 private:
+	// reduces the spectrum to the bands of the current mode
+	void updateBands()
+	{
+		if( m_spectrum.serial == 0 || m_spectrum.peak <= 0 )
+		{
+			m_energy = 0;
+			return;
+		}
+
+		const sample_rate_t sr = Engine::mixer()->processingSampleRate();
+		if( m_sa->m_saControls.m_linearSpec.value() )
+		{
+			compressbands( m_spectrum.magnitudes, m_bands, SpectrumAnalysis::BinCount,
+				MAX_BANDS, 0, SpectrumAnalysis::BinCount );
+			m_energy = maximum( m_bands, MAX_BANDS ) / m_spectrum.peak;
+		}
+		else
+		{
+			calc13octaveband31( m_spectrum.magnitudes, m_bands,
+					SpectrumAnalysis::BinCount, sr / 2.0 );
+			m_energy = m_spectrum.power / m_spectrum.peak;
+		}
+	}
+
 	SpectrumAnalyzer * m_sa;
 	QImage m_backgroundPlain;
 	QImage m_background;
 
+	SpectrumAnalysis::Spectrum m_spectrum;
+	float m_bands[MAX_BANDS];
+	float m_energy;
+
 } ;
 
 
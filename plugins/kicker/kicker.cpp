@@ -33,7 +33,6 @@
 #include "Knob.h"
 #include "Mixer.h"
 #include "NotePlayHandle.h"
-#include "KickerOsc.h"
 
 #include "embed.h"
 #include "plugin_export.h"
@@ -157,10 +156,6 @@ QString kickerInstrument::nodeName() const
 
 
 
-typedef DspEffectLibrary::Distortion DistFX;
-typedef KickerOsc<DspEffectLibrary::MonoToStereoAdaptor<DistFX> > SweepOsc;
-
-
 void kickerInstrument::playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
@@ -172,7 +167,7 @@ void kickerInstrument::playNote( NotePlayHandle * _n,
 
 	if ( tfp == 0 )
 	{
-		_n->m_pluginData = new SweepOsc(
+		_n->m_pluginData = m_voices.create(
 					DistFX( m_distModel.value(),
 							m_gainModel.value() ),
 					m_startNoteModel.value() ? _n->frequency() : m_startFreqModel.value(),
@@ -213,7 +208,7 @@ void kickerInstrument::playNote( NotePlayHandle * _n,
 
 void kickerInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<SweepOsc *>( _n->m_pluginData );
+	m_voices.destroy( static_cast<SweepOsc *>( _n->m_pluginData ) );
 }
 
 
@@ -33,6 +33,8 @@
 #include "Knob.h"
 #include "LedCheckbox.h"
 #include "TempoSyncKnob.h"
+#include "VoiceArena.h"
+#include "KickerOsc.h"
 
 
 #define KICKER_PRESET_VERSION 1
@@ -41,6 +43,9 @@
 class kickerInstrumentView;
 class NotePlayHandle;
 
+typedef DspEffectLibrary::Distortion DistFX;
+typedef KickerOsc<DspEffectLibrary::MonoToStereoAdaptor<DistFX> > SweepOsc;
+
 
 class kickerInstrument : public Instrument
 {
@@ -88,6 +93,8 @@ private:
 
 	IntModel m_versionModel;
 
+	VoiceArena<SweepOsc> m_voices;
+
 	friend class kickerInstrumentView;
 
 } ;
@@ -233,70 +233,11 @@ void organicInstrument::playNote( NotePlayHandle * _n,
 	
 	if( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		Oscillator * oscs_l[NUM_OSCILLATORS];
-		Oscillator * oscs_r[NUM_OSCILLATORS];
-
-		_n->m_pluginData = new oscPtr;
-
-		for( int i = m_numOscillators - 1; i >= 0; --i )
-		{
-			static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i] 
-				= rand() / ( RAND_MAX + 1.0f );
-			static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i] 
-				= rand() / ( RAND_MAX + 1.0f );
-			
-			// initialise ocillators
-			
-			if( i == m_numOscillators - 1 )
-			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i],
-						m_osc[i]->m_volumeLeft );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i],
-						m_osc[i]->m_volumeRight );
-			}
-			else
-			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i],
-						m_osc[i]->m_volumeLeft,
-						oscs_l[i + 1] );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i],
-						m_osc[i]->m_volumeRight,
-						oscs_r[i + 1] );
-			}
-			
-				
-		}
-
-		static_cast<oscPtr *>( _n->m_pluginData )->oscLeft = oscs_l[0];
-		static_cast<oscPtr *>( _n->m_pluginData )->oscRight = oscs_r[0];
+		_n->m_pluginData = m_voices.create( this, _n->frequency() );
 	}
 
-	Oscillator * osc_l = static_cast<oscPtr *>( _n->m_pluginData )->oscLeft;
-	Oscillator * osc_r = static_cast<oscPtr *>( _n->m_pluginData)->oscRight;
+	Oscillator * osc_l = static_cast<Voice *>( _n->m_pluginData )->oscLeft;
+	Oscillator * osc_r = static_cast<Voice *>( _n->m_pluginData )->oscRight;
 
 	osc_l->update( _working_buffer + offset, frames, 0 );
 	osc_r->update( _working_buffer + offset, frames, 1 );
@@ -325,12 +266,55 @@ void organicInstrument::playNote( NotePlayHandle * _n,
 
 void organicInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-	
-	delete static_cast<oscPtr *>( _n->m_pluginData );
+	m_voices.destroy( static_cast<Voice *>( _n->m_pluginData ) );
+}
+
+
+
+
+organicInstrument::Voice::Voice( const organicInstrument * _o,
+						const float & _frequency ) :
+	m_numOscillators( _o->m_numOscillators )
+{
+	// the last oscillator needs no sub-oscillator...
+	Oscillator * left = NULL;
+	Oscillator * right = NULL;
+	for( int i = m_numOscillators - 1; i >= 0; --i )
+	{
+		phaseOffsetLeft[i] = rand() / ( RAND_MAX + 1.0f );
+		phaseOffsetRight[i] = rand() / ( RAND_MAX + 1.0f );
+
+		const OscillatorObject * osc = _o->m_osc[i];
+		left = ::new( &m_oscillators[2 * i] ) Oscillator(
+						&osc->m_waveShape,
+						&_o->m_modulationAlgo,
+						_frequency,
+						osc->m_detuningLeft,
+						phaseOffsetLeft[i],
+						osc->m_volumeLeft,
+						left );
+		right = ::new( &m_oscillators[2 * i + 1] ) Oscillator(
+						&osc->m_waveShape,
+						&_o->m_modulationAlgo,
+						_frequency,
+						osc->m_detuningRight,
+						phaseOffsetRight[i],
+						osc->m_volumeRight,
+						right );
+	}
+	oscLeft = left;
+	oscRight = right;
+}
+
+
+
+
+organicInstrument::Voice::~Voice()
+{
+	for( int i = 0; i < 2 * m_numOscillators; ++i )
+	{
+		reinterpret_cast<Oscillator *>( &m_oscillators[i] )->~Oscillator();
+	}
 }
 
 /*float inline organicInstrument::foldback(float in, float threshold)
@@ -28,10 +28,13 @@
 
 #include <QString>
 
+#include <type_traits>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Oscillator.h"
 #include "AutomatableModel.h"
+#include "VoiceArena.h"
 
 class QPixmap;
 
@@ -149,15 +152,26 @@ private:
 
 	OscillatorObject ** m_osc;
 
-	struct oscPtr
+	// the oscillators of a note, each one modulated by the next one
+	struct Voice
 	{
-		MM_OPERATORS
+		Voice( const organicInstrument * _o, const float & _frequency );
+		~Voice();
+
 		Oscillator * oscLeft;
 		Oscillator * oscRight;
 		float phaseOffsetLeft[NUM_OSCILLATORS];
-		float phaseOffsetRight[NUM_OSCILLATORS];		
+		float phaseOffsetRight[NUM_OSCILLATORS];
+
+	private:
+		typedef std::aligned_storage<sizeof( Oscillator ),
+				alignof( Oscillator )>::type OscillatorStorage;
+		OscillatorStorage m_oscillators[2 * NUM_OSCILLATORS];
+		int m_numOscillators;
 	} ;
 
+	VoiceArena<Voice> m_voices;
+
 	const IntModel m_modulationAlgo;
 
 	FloatModel  m_fx1Model;
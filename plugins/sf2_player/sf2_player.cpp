@@ -28,6 +28,9 @@
 #include <QLabel>
 #include <QDomDocument>
 
+#include <algorithm>
+#include <cstring>
+
 #include "ConfigManager.h"
 #include "FileDialog.h"
 #include "sf2_player.h"
@@ -70,9 +73,7 @@ Plugin::Descriptor PLUGIN_EXPORT sf2player_plugin_descriptor =
 struct SF2PluginData
 {
 	int midiNote;
-	int lastPanning;
 	float lastVelocity;
-	fluid_voice_t * fluidVoice;
 	bool isNew;
 	f_cnt_t offset;
 	bool noteOffSent;
@@ -90,6 +91,8 @@ sf2Instrument::sf2Instrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &sf2player_plugin_descriptor ),
 	m_srcState( NULL ),
 	m_font( NULL ),
+	m_engine( NULL ),
+	m_useSharedEngine( ConfigManager::inst()->value( "sf2", "sharedengine" ).toInt() ),
 	m_fontId( 0 ),
 	m_filename( "" ),
 	m_lastMidiPitch( -1 ),
@@ -300,6 +303,14 @@ void sf2Instrument::freeFont()
 {
 	m_synthMutex.lock();
 
+	// the engine only uses the font as long as we're part of it
+	if( m_engine != NULL )
+	{
+		m_engine->leave( m_channel );
+		m_engine = NULL;
+		m_channel = 1;
+	}
+
 	if ( m_font != NULL )
 	{
 		s_fontsMutex.lock();
@@ -375,6 +386,16 @@ void sf2Instrument::openFile( const QString & _sf2File, bool updateTrackName )
 	}
 
 	s_fontsMutex.unlock();
+
+	if( m_useSharedEngine && m_font != NULL )
+	{
+		m_engine = sf2SharedEngine::join( relativePath, m_font, &m_channel );
+
+		// the channel might have been used with other settings before
+		m_lastMidiPitch = -1;
+		m_lastMidiPitchRange = -1;
+	}
+
 	m_synthMutex.unlock();
 
 	if( m_fontId >= 0 )
@@ -403,8 +424,16 @@ void sf2Instrument::updatePatch()
 {
 	if( m_bankNum.value() >= 0 && m_patchNum.value() >= 0 )
 	{
-		fluid_synth_program_select( m_synth, m_channel, m_fontId,
-				m_bankNum.value(), m_patchNum.value() );
+		if( m_engine != NULL )
+		{
+			m_engine->selectProgram( m_channel, m_bankNum.value(),
+							m_patchNum.value() );
+		}
+		else
+		{
+			fluid_synth_program_select( m_synth, m_channel, m_fontId,
+					m_bankNum.value(), m_patchNum.value() );
+		}
 	}
 }
 
@@ -564,6 +593,11 @@ void sf2Instrument::updateSampleRate()
 	updateChorusOn();
 	updateGain();
 
+	if( m_engine != NULL )
+	{
+		m_engine->updateSampleRate();
+	}
+
 	// Reset last MIDI pitch properties, which will be set to the correct values
 	// upon playing the next note
 	m_lastMidiPitch = -1;
@@ -597,9 +631,7 @@ void sf2Instrument::playNote( NotePlayHandle * _n, sampleFrame * )
 
 		SF2PluginData * pluginData = new SF2PluginData;
 		pluginData->midiNote = midiNote;
-		pluginData->lastPanning = 0;
 		pluginData->lastVelocity = _n->midiVelocity( baseVelocity );
-		pluginData->fluidVoice = NULL;
 		pluginData->isNew = true;
 		pluginData->offset = _n->offset();
 		pluginData->noteOffSent = false;
@@ -627,36 +659,14 @@ void sf2Instrument::playNote( NotePlayHandle * _n, sampleFrame * )
 void sf2Instrument::noteOn( SF2PluginData * n )
 {
 	m_synthMutex.lock();
-
-	// get list of current voice IDs so we can easily spot the new
-	// voice after the fluid_synth_noteon() call
-	const int poly = fluid_synth_get_polyphony( m_synth );
-	fluid_voice_t * voices[poly];
-	unsigned int id[poly];
-	fluid_synth_get_voicelist( m_synth, voices, poly, -1 );
-	for( int i = 0; i < poly; ++i )
+	if( m_engine != NULL )
 	{
-		id[i] = 0;
+		m_engine->noteOn( m_channel, n->offset, n->midiNote, n->lastVelocity );
 	}
-	for( int i = 0; i < poly && voices[i]; ++i )
-	{
-		id[i] = fluid_voice_get_id( voices[i] );
-	}
-
-	fluid_synth_noteon( m_synth, m_channel, n->midiNote, n->lastVelocity );
-
-	// get new voice and save it
-	fluid_synth_get_voicelist( m_synth, voices, poly, -1 );
-	for( int i = 0; i < poly && voices[i]; ++i )
+	else
 	{
-		const unsigned int newID = fluid_voice_get_id( voices[i] );
-		if( id[i] != newID || newID == 0 )
-		{
-			n->fluidVoice = voices[i];
-			break;
-		}
+		fluid_synth_noteon( m_synth, m_channel, n->midiNote, n->lastVelocity );
 	}
-
 	m_synthMutex.unlock();
 
 	m_notesRunningMutex.lock();
@@ -675,7 +685,14 @@ void sf2Instrument::noteOff( SF2PluginData * n )
 	if( notes <= 0 )
 	{
 		m_synthMutex.lock();
-		fluid_synth_noteoff( m_synth, m_channel, n->midiNote );
+		if( m_engine != NULL )
+		{
+			m_engine->noteOff( m_channel, n->offset, n->midiNote );
+		}
+		else
+		{
+			fluid_synth_noteoff( m_synth, m_channel, n->midiNote );
+		}
 		m_synthMutex.unlock();
 	}
 
@@ -684,6 +701,12 @@ void sf2Instrument::noteOff( SF2PluginData * n )
 
 void sf2Instrument::play( sampleFrame * _working_buffer )
 {
+	if( m_useSharedEngine )
+	{
+		playShared( _working_buffer );
+		return;
+	}
+
 	const fpp_t frames = Engine::mixer()->framesPerPeriod();
 
 	// set midi pitch for this period
@@ -771,6 +794,64 @@ void sf2Instrument::play( sampleFrame * _working_buffer )
 }
 
 
+void sf2Instrument::playShared( sampleFrame * _working_buffer )
+{
+	const fpp_t frames = Engine::mixer()->framesPerPeriod();
+
+	m_synthMutex.lock();
+	if( m_engine == NULL )
+	{
+		m_synthMutex.unlock();
+		memset( _working_buffer, 0, frames * sizeof( sampleFrame ) );
+		instrumentTrack()->processAudioBuffer( _working_buffer, frames, NULL );
+		return;
+	}
+
+	// the engine renders the events of the previous period only, so
+	// everything we queue below sounds with the next period, no matter
+	// in which order the instruments get played
+	m_engine->read( m_channel, _working_buffer, frames, m_gain.value() );
+
+	const int currentMidiPitch = instrumentTrack()->midiPitch();
+	if( m_lastMidiPitch != currentMidiPitch )
+	{
+		m_lastMidiPitch = currentMidiPitch;
+		m_engine->pitchBend( m_channel, m_lastMidiPitch );
+	}
+
+	const int currentMidiPitchRange = instrumentTrack()->midiPitchRange();
+	if( m_lastMidiPitchRange != currentMidiPitchRange )
+	{
+		m_lastMidiPitchRange = currentMidiPitchRange;
+		m_engine->pitchWheelSens( m_channel, m_lastMidiPitchRange );
+	}
+	m_synthMutex.unlock();
+
+	// the engine orders the events by their offsets
+	m_playingNotesMutex.lock();
+	for( NotePlayHandle * note : m_playingNotes )
+	{
+		SF2PluginData * data = static_cast<SF2PluginData *>( note->m_pluginData );
+		if( data->isNew )
+		{
+			noteOn( data );
+			data->isNew = false;
+			// released during the same period
+			if( !note->isReleased() )
+			{
+				continue;
+			}
+			data->offset = note->framesBeforeRelease();
+		}
+		noteOff( data );
+	}
+	m_playingNotes.clear();
+	m_playingNotesMutex.unlock();
+
+	instrumentTrack()->processAudioBuffer( _working_buffer, frames, NULL );
+}
+
+
 void sf2Instrument::renderFrames( f_cnt_t frames, sampleFrame * buf )
 {
 	m_synthMutex.lock();
@@ -835,6 +916,461 @@ void sf2Instrument::deleteNotePluginData( NotePlayHandle * _n )
 
 
 
+QMutex sf2SharedEngine::s_enginesMutex;
+QMultiHash<QString, sf2SharedEngine *> sf2SharedEngine::s_engines;
+
+
+
+static SRC_STATE * newSrcState()
+{
+	int error;
+	SRC_STATE * state = src_new( Engine::mixer()->currentQualitySettings().libsrcInterpolation(), DEFAULT_CHANNELS, &error );
+	if( state == NULL || error )
+	{
+		qCritical( "error while creating libsamplerate data structure in sf2SharedEngine" );
+	}
+	return state;
+}
+
+
+
+
+sf2SharedEngine::sf2SharedEngine( const QString & file, sf2Font * font ) :
+	m_file( file ),
+	m_font( font ),
+	m_settings( new_fluid_settings() ),
+	m_synth( NULL ),
+	m_fontId( -1 ),
+	m_internalSampleRate( 0 ),
+	m_sampleRate( 0 ),
+	m_interpolation( -1 ),
+	m_channelCount( 0 ),
+	m_outputCapacity( 0 ),
+	m_frames( 0 ),
+	// makes the first read() render the current period
+	m_renderedPeriod( Engine::mixer()->periodCounter() - 1 ),
+	m_queuedPeriod( Engine::mixer()->periodCounter() )
+{
+	for( int i = 0; i < Channels; ++i )
+	{
+		m_used[i] = false;
+		m_programs[i][0] = 0;
+		m_programs[i][1] = 0;
+		m_srcStates[i] = NULL;
+	}
+	m_queued.reserve( 256 );
+	m_due.reserve( 256 );
+
+	// voices of every channel get mixed into an output of their own
+	fluid_settings_setint( m_settings, (char *) "synth.audio-channels", Channels );
+	fluid_settings_setint( m_settings, (char *) "synth.audio-groups", Channels );
+
+	updateSampleRate();
+}
+
+
+
+
+sf2SharedEngine::~sf2SharedEngine()
+{
+	fluid_synth_remove_sfont( m_synth, m_font->fluidFont );
+	delete_fluid_synth( m_synth );
+	delete_fluid_settings( m_settings );
+	for( int i = 0; i < Channels; ++i )
+	{
+		if( m_srcStates[i] != NULL )
+		{
+			src_delete( m_srcStates[i] );
+		}
+	}
+}
+
+
+
+
+sf2SharedEngine * sf2SharedEngine::join( const QString & file, sf2Font * font,
+								int * channel )
+{
+	QMutexLocker lock( &s_enginesMutex );
+
+	sf2SharedEngine * engine = NULL;
+	for( sf2SharedEngine * e : s_engines.values( file ) )
+	{
+		// all channels but the drum channel are usable
+		if( e->m_channelCount < Channels - 1 )
+		{
+			engine = e;
+			break;
+		}
+	}
+	if( engine == NULL )
+	{
+		engine = new sf2SharedEngine( file, font );
+		s_engines.insert( file, engine );
+	}
+
+	QMutexLocker engineLock( &engine->m_mutex );
+
+	int c = 0;
+	while( engine->m_used[c] || c == DrumChannel )
+	{
+		++c;
+	}
+	engine->m_used[c] = true;
+	++engine->m_channelCount;
+
+	// the current period may be rendered already, don't let the channel
+	// play what its last user left behind
+	if( engine->m_output[c] )
+	{
+		memset( engine->m_output[c].get(), 0,
+				engine->m_frames * sizeof( sampleFrame ) );
+	}
+	if( engine->m_internalSampleRate < engine->m_sampleRate )
+	{
+		engine->m_srcStates[c] = newSrcState();
+	}
+
+	*channel = c;
+	return engine;
+}
+
+
+
+
+void sf2SharedEngine::leave( int channel )
+{
+	QMutexLocker lock( &s_enginesMutex );
+
+	{
+		QMutexLocker engineLock( &m_mutex );
+
+		// leave a clean channel for the next one using it
+		fluid_synth_cc( m_synth, channel, 120, 0 ); // all sound off
+		fluid_synth_cc( m_synth, channel, 121, 0 ); // reset controllers
+		for( std::vector<Event> * events : { &m_queued, &m_due } )
+		{
+			events->erase( std::remove_if( events->begin(),
+								events->end(),
+				[channel]( const Event & event )
+				{
+					return event.channel == channel;
+				} ), events->end() );
+		}
+
+		if( m_srcStates[channel] != NULL )
+		{
+			src_delete( m_srcStates[channel] );
+			m_srcStates[channel] = NULL;
+		}
+		m_used[channel] = false;
+
+		if( --m_channelCount > 0 )
+		{
+			return;
+		}
+	}
+
+	s_engines.remove( m_file, this );
+	delete this;
+}
+
+
+
+
+void sf2SharedEngine::selectProgram( int channel, int bank, int patch )
+{
+	QMutexLocker lock( &m_mutex );
+	m_programs[channel][0] = bank;
+	m_programs[channel][1] = patch;
+	fluid_synth_program_select( m_synth, channel, m_fontId, bank, patch );
+}
+
+
+
+
+void sf2SharedEngine::noteOn( int channel, f_cnt_t offset, int key, int velocity )
+{
+	queue( Event::NoteOn, channel, offset, key, velocity );
+}
+
+
+
+
+void sf2SharedEngine::noteOff( int channel, f_cnt_t offset, int key )
+{
+	queue( Event::NoteOff, channel, offset, key, 0 );
+}
+
+
+
+
+void sf2SharedEngine::pitchBend( int channel, int value )
+{
+	queue( Event::PitchBend, channel, 0, value, 0 );
+}
+
+
+
+
+void sf2SharedEngine::pitchWheelSens( int channel, int value )
+{
+	queue( Event::PitchWheelSens, channel, 0, value, 0 );
+}
+
+
+
+
+void sf2SharedEngine::updateSampleRate()
+{
+	const sample_rate_t sampleRate = Engine::mixer()->processingSampleRate();
+	const int interpolation = Engine::mixer()->currentQualitySettings().interpolation;
+
+	QMutexLocker lock( &m_mutex );
+
+	// every instrument on the engine forwards the change
+	if( m_synth != NULL && sampleRate == m_sampleRate &&
+					interpolation == m_interpolation )
+	{
+		return;
+	}
+	m_sampleRate = sampleRate;
+	m_interpolation = interpolation;
+
+	// Set & get, returns the true sample rate
+	double tempRate;
+	fluid_settings_setnum( m_settings, (char *) "synth.sample-rate", sampleRate );
+	fluid_settings_getnum( m_settings, (char *) "synth.sample-rate", &tempRate );
+	m_internalSampleRate = static_cast<int>( tempRate );
+
+	if( m_synth != NULL )
+	{
+		fluid_synth_remove_sfont( m_synth, m_font->fluidFont );
+		delete_fluid_synth( m_synth );
+	}
+	m_synth = new_fluid_synth( m_settings );
+	m_fontId = fluid_synth_add_sfont( m_synth, m_font->fluidFont );
+
+	// instruments apply their gain to their channel's output
+	fluid_synth_set_gain( m_synth, 1.0f );
+	fluid_synth_set_reverb_on( m_synth, 0 );
+	fluid_synth_set_chorus_on( m_synth, 0 );
+	fluid_synth_set_interp_method( m_synth, -1,
+		interpolation >= Mixer::qualitySettings::Interpolation_SincFastest ?
+					FLUID_INTERP_7THORDER : FLUID_INTERP_DEFAULT );
+
+	for( int i = 0; i < Channels; ++i )
+	{
+		if( m_srcStates[i] != NULL )
+		{
+			src_delete( m_srcStates[i] );
+			m_srcStates[i] = NULL;
+		}
+		if( m_used[i] )
+		{
+			fluid_synth_program_select( m_synth, i, m_fontId,
+					m_programs[i][0], m_programs[i][1] );
+			if( m_internalSampleRate < m_sampleRate )
+			{
+				m_srcStates[i] = newSrcState();
+			}
+		}
+	}
+
+	// the voices these were meant for are gone with the old synth
+	m_queued.clear();
+	m_due.clear();
+}
+
+
+
+
+void sf2SharedEngine::read( int channel, sampleFrame * buf, fpp_t frames,
+								float gain )
+{
+	QMutexLocker lock( &m_mutex );
+
+	const unsigned long period = Engine::mixer()->periodCounter();
+	advance( period );
+	if( m_renderedPeriod != period )
+	{
+		render( frames );
+		m_renderedPeriod = period;
+	}
+
+	const fpp_t available = qMin( frames, m_frames );
+	const sampleFrame * src = m_output[channel].get();
+	for( fpp_t f = 0; f < available; ++f )
+	{
+		buf[f][0] = src[f][0] * gain;
+		buf[f][1] = src[f][1] * gain;
+	}
+	if( available < frames )
+	{
+		memset( buf + available, 0,
+			( frames - available ) * sizeof( sampleFrame ) );
+	}
+}
+
+
+
+
+void sf2SharedEngine::advance( unsigned long period )
+{
+	if( m_queuedPeriod != period )
+	{
+		m_due.insert( m_due.end(), m_queued.begin(), m_queued.end() );
+		m_queued.clear();
+		m_queuedPeriod = period;
+	}
+}
+
+
+
+
+void sf2SharedEngine::render( fpp_t frames )
+{
+	if( m_outputCapacity < frames )
+	{
+		for( int i = 0; i < Channels; ++i )
+		{
+			m_output[i].reset( new sampleFrame[frames] );
+		}
+		m_outputCapacity = frames;
+	}
+
+	const bool resample = m_internalSampleRate < m_sampleRate;
+	const fpp_t internalFrames = resample ?
+			frames * m_internalSampleRate / m_sampleRate : frames;
+
+	// fluidsynth wants buffers for all of its outputs
+	float * left[Channels];
+	float * right[Channels];
+	for( int i = 0; i < Channels; ++i )
+	{
+		if( m_left[i].size() < size_t( internalFrames ) )
+		{
+			m_left[i].resize( internalFrames );
+			m_right[i].resize( internalFrames );
+		}
+	}
+	fpp_t done = 0;
+	auto write = [&]( fpp_t end )
+	{
+		for( int i = 0; i < Channels; ++i )
+		{
+			left[i] = m_left[i].data() + done;
+			right[i] = m_right[i].data() + done;
+		}
+		fluid_synth_nwrite_float( m_synth, end - done, left, right,
+								NULL, NULL );
+		done = end;
+	};
+
+	// keeps note offs behind note ons of the same frame
+	std::stable_sort( m_due.begin(), m_due.end(),
+		[]( const Event & a, const Event & b )
+		{
+			return a.offset < b.offset;
+		} );
+
+	for( const Event & event : m_due )
+	{
+		const f_cnt_t offset = resample ?
+			event.offset * m_internalSampleRate / m_sampleRate :
+								event.offset;
+		const fpp_t frame = qBound<f_cnt_t>( done, offset, internalFrames );
+		if( frame > done )
+		{
+			write( frame );
+		}
+		switch( event.type )
+		{
+			case Event::NoteOn:
+				fluid_synth_noteon( m_synth, event.channel,
+						event.param1, event.param2 );
+				break;
+			case Event::NoteOff:
+				fluid_synth_noteoff( m_synth, event.channel,
+								event.param1 );
+				break;
+			case Event::PitchBend:
+				fluid_synth_pitch_bend( m_synth, event.channel,
+								event.param1 );
+				break;
+			case Event::PitchWheelSens:
+				fluid_synth_pitch_wheel_sens( m_synth,
+						event.channel, event.param1 );
+				break;
+		}
+	}
+	m_due.clear();
+	if( done < internalFrames )
+	{
+		write( internalFrames );
+	}
+
+	for( int i = 0; i < Channels; ++i )
+	{
+		if( !m_used[i] )
+		{
+			continue;
+		}
+
+		sampleFrame * dst = m_output[i].get();
+		if( resample && m_srcStates[i] != NULL )
+		{
+			m_interleaved.resize( internalFrames * DEFAULT_CHANNELS );
+			for( fpp_t f = 0; f < internalFrames; ++f )
+			{
+				m_interleaved[f * 2] = m_left[i][f];
+				m_interleaved[f * 2 + 1] = m_right[i][f];
+			}
+
+			SRC_DATA src_data;
+			src_data.data_in = m_interleaved.data();
+			src_data.data_out = (float *)dst;
+			src_data.input_frames = internalFrames;
+			src_data.output_frames = frames;
+			src_data.src_ratio = (double) frames / internalFrames;
+			src_data.end_of_input = 0;
+			const int error = src_process( m_srcStates[i], &src_data );
+			if( error )
+			{
+				qCritical( "sf2SharedEngine: error while resampling: %s", src_strerror( error ) );
+			}
+			// don't play what's left from earlier periods
+			for( f_cnt_t f = src_data.output_frames_gen; f < frames; ++f )
+			{
+				dst[f][0] = dst[f][1] = 0.0f;
+			}
+		}
+		else
+		{
+			for( fpp_t f = 0; f < internalFrames; ++f )
+			{
+				dst[f][0] = m_left[i][f];
+				dst[f][1] = m_right[i][f];
+			}
+		}
+	}
+	m_frames = frames;
+}
+
+
+
+
+void sf2SharedEngine::queue( Event::Types type, int channel, f_cnt_t offset,
+							int param1, int param2 )
+{
+	QMutexLocker lock( &m_mutex );
+	advance( Engine::mixer()->periodCounter() );
+	m_queued.push_back( { type, channel, offset, param1, param2 } );
+}
+
+
+
+
 PluginView * sf2Instrument::instantiateView( QWidget * _parent )
 {
 	return new sf2InstrumentView( this, _parent );
@@ -28,8 +28,12 @@
 #define SF2_PLAYER_H
 
 #include <QMutex>
+#include <QMultiHash>
 #include <samplerate.h>
 
+#include <memory>
+#include <vector>
+
 #include "Instrument.h"
 #include "PixmapButton.h"
 #include "InstrumentView.h"
@@ -41,6 +45,7 @@
 
 class sf2InstrumentView;
 class sf2Font;
+class sf2SharedEngine;
 class NotePlayHandle;
 
 class patchesDialog;
@@ -118,6 +123,11 @@ private:
 
 	sf2Font* m_font;
 
+	// set while the instrument plays through the synth shared by all
+	// instruments using the same soundfont, m_channel is ours then
+	sf2SharedEngine * m_engine;
+	const bool m_useSharedEngine;
+
 	int m_fontId;
 	QString m_filename;
 
@@ -159,6 +169,7 @@ private:
 	void noteOn( SF2PluginData * n );
 	void noteOff( SF2PluginData * n );
 	void renderFrames( f_cnt_t frames, sampleFrame * buf );
+	void playShared( sampleFrame * _working_buffer );
 
 	friend class sf2InstrumentView;
 
@@ -187,6 +198,104 @@ public:
 
 
 
+// One synth per soundfont that instruments share by playing on MIDI channels
+// of their own. The first instrument asking for its output in a period
+// renders that period for all channels at once. Events queued during a
+// period are rendered at the start of the next one, keyed to the mixer's
+// period counter, so whether another track's events come before or after
+// that render doesn't matter. This delays shared instruments by exactly one
+// period, but keeps GM-style projects with many tracks on a single font at
+// the cost of one synth. Reverb and chorus are left off, as they can't be
+// applied per channel.
+class sf2SharedEngine
+{
+	MM_OPERATORS
+public:
+	// returns an engine with a free channel for font, whose number gets
+	// stored in channel
+	static sf2SharedEngine * join( const QString & file, sf2Font * font,
+								int * channel );
+	// releases channel, deletes the engine with its last channel
+	void leave( int channel );
+
+	void selectProgram( int channel, int bank, int patch );
+	void noteOn( int channel, f_cnt_t offset, int key, int velocity );
+	void noteOff( int channel, f_cnt_t offset, int key );
+	void pitchBend( int channel, int value );
+	void pitchWheelSens( int channel, int value );
+
+	void updateSampleRate();
+
+	// copies the current period of channel to buf, renders it along with
+	// the events queued during the previous periods if nobody did yet
+	void read( int channel, sampleFrame * buf, fpp_t frames, float gain );
+
+private:
+	static const int Channels = 16;
+	// fluidsynth treats MIDI channel 10 as drum channel
+	static const int DrumChannel = 9;
+
+	struct Event
+	{
+		enum Types
+		{
+			NoteOn,
+			NoteOff,
+			PitchBend,
+			PitchWheelSens
+		} type;
+		int channel;
+		f_cnt_t offset;
+		int param1;
+		int param2;
+	} ;
+
+	sf2SharedEngine( const QString & file, sf2Font * font );
+	~sf2SharedEngine();
+
+	// moves the events queued before period to the ones due for rendering
+	void advance( unsigned long period );
+	void render( fpp_t frames );
+	void queue( Event::Types type, int channel, f_cnt_t offset,
+						int param1, int param2 );
+
+	static QMutex s_enginesMutex;
+	static QMultiHash<QString, sf2SharedEngine *> s_engines;
+
+	QString m_file;
+	sf2Font * m_font;
+
+	fluid_settings_t * m_settings;
+	fluid_synth_t * m_synth;
+	int m_fontId;
+
+	sample_rate_t m_internalSampleRate;
+	sample_rate_t m_sampleRate;
+	int m_interpolation;
+
+	int m_channelCount;
+	bool m_used[Channels];
+	int m_programs[Channels][2];
+	SRC_STATE * m_srcStates[Channels];
+
+	std::vector<float> m_left[Channels];
+	std::vector<float> m_right[Channels];
+	std::vector<float> m_interleaved;
+	std::unique_ptr<sampleFrame[]> m_output[Channels];
+	fpp_t m_outputCapacity;
+	fpp_t m_frames;
+	unsigned long m_renderedPeriod;
+	unsigned long m_queuedPeriod;
+	// events of m_queuedPeriod and the ones to render with the next period
+	std::vector<Event> m_queued;
+	std::vector<Event> m_due;
+
+	QMutex m_mutex;
+
+} ;
+
+
+
 class sf2InstrumentView : public InstrumentView
 {
 	Q_OBJECT
@@ -76,6 +76,10 @@ Plugin::Descriptor PLUGIN_EXPORT sfxr_plugin_descriptor =
 }
 
 
+// frames of the synth's output rendered at once in playNote()
+static const int32_t PitchedChunkFrames = 256;
+
+
 
 
 SfxrSynth::SfxrSynth( const sfxrInstrument * s ):
@@ -355,7 +359,8 @@ sfxrInstrument::sfxrInstrument( InstrumentTrack * _instrument_track ) :
 	m_lpFilResoModel(0.0f, this, "LP Filter Resonance"),
 	m_hpFilCutModel(0.0f, this, "HP Filter Cutoff"),
 	m_hpFilCutSweepModel(0.0f, this, "HP Filter Cutoff Sweep"),
-	m_waveFormModel( SQR_WAVE, 0, WAVES_NUM-1, this, tr( "Wave" ) )
+	m_waveFormModel( SQR_WAVE, 0, WAVES_NUM-1, this, tr( "Wave" ) ),
+	m_voices( 32 )
 {
 }
 
@@ -462,7 +467,7 @@ void sfxrInstrument::playNote( NotePlayHandle * _n, sampleFrame * _working_buffe
     const f_cnt_t offset = _n->noteOffset();
 	if ( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		_n->m_pluginData = new SfxrSynth( this );
+		_n->m_pluginData = m_voices.create( this );
 	}
 	else if( static_cast<SfxrSynth*>(_n->m_pluginData)->isPlaying() == false )
 	{
@@ -474,21 +479,39 @@ void sfxrInstrument::playNote( NotePlayHandle * _n, sampleFrame * _working_buffe
 	int32_t pitchedFrameNum = (_n->frequency()/BaseFreq)*frameNum;
 
 	pitchedFrameNum /= ( currentSampleRate / 44100 );
+	// very low notes still advance the synth
+	pitchedFrameNum = qMax<int32_t>( pitchedFrameNum, 1 );
 
 // debug code
 //	qDebug( "pFN %d", pitchedFrameNum );
 
-	sampleFrame * pitchedBuffer = new sampleFrame[pitchedFrameNum];
-	static_cast<SfxrSynth*>(_n->m_pluginData)->update( pitchedBuffer, pitchedFrameNum );
+	// the synth's output gets rendered in chunks of a fixed buffer and
+	// stretched to the period
+	SfxrSynth * synth = static_cast<SfxrSynth*>(_n->m_pluginData);
+	sampleFrame pitchedBuffer[PitchedChunkFrames];
+	int32_t chunkStart = 0;
+	int32_t chunkEnd = 0;
 	for( fpp_t i=0; i<frameNum; i++ )
 	{
+		const int32_t pitchedFrame = i*pitchedFrameNum/frameNum;
+		while( pitchedFrame >= chunkEnd )
+		{
+			chunkStart = chunkEnd;
+			chunkEnd = qMin( chunkStart + PitchedChunkFrames, pitchedFrameNum );
+			synth->update( pitchedBuffer, chunkEnd - chunkStart );
+		}
 		for( ch_cnt_t j=0; j<DEFAULT_CHANNELS; j++ )
 		{
-			_working_buffer[i+offset][j] = pitchedBuffer[i*pitchedFrameNum/frameNum][j];
+			_working_buffer[i+offset][j] = pitchedBuffer[pitchedFrame - chunkStart][j];
 		}
 	}
-
-	delete[] pitchedBuffer;
+	// frames which got skipped still have to be rendered
+	while( chunkEnd < pitchedFrameNum )
+	{
+		chunkStart = chunkEnd;
+		chunkEnd = qMin( chunkStart + PitchedChunkFrames, pitchedFrameNum );
+		synth->update( pitchedBuffer, chunkEnd - chunkStart );
+	}
 
 	applyRelease( _working_buffer, _n );
 
@@ -501,7 +524,7 @@ void sfxrInstrument::playNote( NotePlayHandle * _n, sampleFrame * _working_buffe
 
 void sfxrInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<SfxrSynth *>( _n->m_pluginData );
+	m_voices.destroy( static_cast<SfxrSynth *>( _n->m_pluginData ) );
 }
 
 
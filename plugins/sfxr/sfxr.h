@@ -35,6 +35,7 @@
 #include "PixmapButton.h"
 #include "LedCheckbox.h"
 #include "MemoryManager.h"
+#include "VoiceArena.h"
 
 
 enum SfxrWaves
@@ -217,6 +218,9 @@ private:
 
 	IntModel m_waveFormModel;
 
+	// synths are 4 KB each, sound effects rarely overlap a lot
+	VoiceArena<SfxrSynth> m_voices;
+
 	friend class sfxrInstrumentView;
 	friend class SfxrSynth;
 };
@@ -300,63 +300,11 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 {
 	if( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		Oscillator * oscs_l[NUM_OF_OSCILLATORS];
-		Oscillator * oscs_r[NUM_OF_OSCILLATORS];
-
-		for( int i = NUM_OF_OSCILLATORS - 1; i >= 0; --i )
-		{
-
-			// the last oscs needs no sub-oscs...
-			if( i == NUM_OF_OSCILLATORS - 1 )
-			{
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						m_osc[i]->m_phaseOffsetLeft,
-						m_osc[i]->m_volumeLeft );
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						m_osc[i]->m_phaseOffsetRight,
-						m_osc[i]->m_volumeRight );
-			}
-			else
-			{
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						m_osc[i]->m_phaseOffsetLeft,
-						m_osc[i]->m_volumeLeft,
-						oscs_l[i + 1] );
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShapeModel,
-						&m_osc[i]->m_modulationAlgoModel,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						m_osc[i]->m_phaseOffsetRight,
-						m_osc[i]->m_volumeRight,
-						oscs_r[i + 1] );
-			}
-
-			oscs_l[i]->setUserWave( m_osc[i]->m_sampleBuffer );
-			oscs_r[i]->setUserWave( m_osc[i]->m_sampleBuffer );
-
-		}
-
-		_n->m_pluginData = new oscPtr;
-		static_cast<oscPtr *>( _n->m_pluginData )->oscLeft = oscs_l[0];
-		static_cast< oscPtr *>( _n->m_pluginData )->oscRight =
-								oscs_r[0];
+		_n->m_pluginData = m_voices.create( this, _n->frequency() );
 	}
 
-	Oscillator * osc_l = static_cast<oscPtr *>( _n->m_pluginData )->oscLeft;
-	Oscillator * osc_r = static_cast<oscPtr *>( _n->m_pluginData )->oscRight;
+	Oscillator * osc_l = static_cast<Voice *>( _n->m_pluginData )->oscLeft;
+	Oscillator * osc_r = static_cast<Voice *>( _n->m_pluginData )->oscRight;
 
 	const fpp_t frames = _n->framesLeftForCurrentPeriod();
 	const f_cnt_t offset = _n->noteOffset();
@@ -374,11 +322,54 @@ void TripleOscillator::playNote( NotePlayHandle * _n,
 
 void TripleOscillator::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-	delete static_cast<oscPtr *>( _n->m_pluginData );
+	m_voices.destroy( static_cast<Voice *>( _n->m_pluginData ) );
+}
+
+
+
+
+TripleOscillator::Voice::Voice( const TripleOscillator * _t,
+						const float & _frequency )
+{
+	// the last oscillator needs no sub-oscillator...
+	Oscillator * left = NULL;
+	Oscillator * right = NULL;
+	for( int i = NUM_OF_OSCILLATORS - 1; i >= 0; --i )
+	{
+		const OscillatorObject * osc = _t->m_osc[i];
+		left = ::new( &m_oscillators[2 * i] ) Oscillator(
+						&osc->m_waveShapeModel,
+						&osc->m_modulationAlgoModel,
+						_frequency,
+						osc->m_detuningLeft,
+						osc->m_phaseOffsetLeft,
+						osc->m_volumeLeft,
+						left );
+		right = ::new( &m_oscillators[2 * i + 1] ) Oscillator(
+						&osc->m_waveShapeModel,
+						&osc->m_modulationAlgoModel,
+						_frequency,
+						osc->m_detuningRight,
+						osc->m_phaseOffsetRight,
+						osc->m_volumeRight,
+						right );
+
+		left->setUserWave( osc->m_sampleBuffer );
+		right->setUserWave( osc->m_sampleBuffer );
+	}
+	oscLeft = left;
+	oscRight = right;
+}
+
+
+
+
+TripleOscillator::Voice::~Voice()
+{
+	for( OscillatorStorage & storage : m_oscillators )
+	{
+		reinterpret_cast<Oscillator *>( &storage )->~Oscillator();
+	}
 }
 
 
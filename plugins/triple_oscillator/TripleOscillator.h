@@ -26,10 +26,13 @@
 #ifndef _TRIPLE_OSCILLATOR_H
 #define _TRIPLE_OSCILLATOR_H
 
+#include <type_traits>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Oscillator.h"
 #include "AutomatableModel.h"
+#include "VoiceArena.h"
 
 
 class automatableButtonGroup;
@@ -122,13 +125,23 @@ protected slots:
 private:
 	OscillatorObject * m_osc[NUM_OF_OSCILLATORS];
 
-	struct oscPtr
+	// the oscillators of a note, each one modulated by the next one
+	struct Voice
 	{
-		MM_OPERATORS
+		Voice( const TripleOscillator * _t, const float & _frequency );
+		~Voice();
+
 		Oscillator * oscLeft;
 		Oscillator * oscRight;
+
+	private:
+		typedef std::aligned_storage<sizeof( Oscillator ),
+				alignof( Oscillator )>::type OscillatorStorage;
+		OscillatorStorage m_oscillators[2 * NUM_OF_OSCILLATORS];
 	} ;
 
+	VoiceArena<Voice> m_voices;
+
 
 	friend class TripleOscillatorView;
 
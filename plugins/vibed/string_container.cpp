@@ -22,20 +22,23 @@
  *
  */
 
+#include <new>
+
 #include "string_container.h"
 
 
 stringContainer::stringContainer(const float _pitch, 
 				const sample_rate_t _sample_rate,
 				const int _buffer_length,
-				const int _strings ) :
+				LocklessAllocator * _delay_lines ) :
 	m_pitch( _pitch ),
 	m_sampleRate( _sample_rate ),
-	m_bufferLength( _buffer_length )
+	m_bufferLength( _buffer_length ),
+	m_delayLines( _delay_lines )
 {
-	for( int i = 0; i < _strings; i++ )
+	for( int i = 0; i < MaxStrings; i++ )
 	{
-		m_exists.append( false );
+		m_exists[i] = false;
 	}
 }
 
@@ -87,7 +90,8 @@ void stringContainer::addString(int _harm,
 			harm = 1.0f;
 	}
 
-	m_strings.append( new vibratingString(	m_pitch * harm,
+	new( string( _id ) ) vibratingString(	m_delayLines,
+						m_pitch * harm,
 						_pick, 
 						_pickup,
 						const_cast<float*>(_impulse),
@@ -97,6 +101,6 @@ void stringContainer::addString(int _harm,
 						_randomize,
 						_string_loss,
 						_detune,
-						_state ) );
+						_state );
 	m_exists[_id] = true;
 }
@@ -24,7 +24,7 @@
 #ifndef _STRING_CONTAINER_H
 #define _STRING_CONTAINER_H
 
-#include <QVector>
+#include <type_traits>
 
 #include "vibrating_string.h"
 #include "MemoryManager.h"
@@ -34,10 +34,12 @@ class stringContainer
 {
 	MM_OPERATORS
 public:
+	static const int MaxStrings = 9;
+
 	stringContainer(const float _pitch, 
 			const sample_rate_t _sample_rate,
 			const int _buffer_length,
-			const int _strings = 9 );
+			LocklessAllocator * _delay_lines );
 	
 	void addString(	int _harm,
 			const float _pick,
@@ -57,24 +59,35 @@ public:
 	
 	~stringContainer()
 	{
-		int strings = m_strings.count();
-		for( int i = 0; i < strings; i++ )
+		for( int i = 0; i < MaxStrings; i++ )
 		{
-			delete m_strings[i];
+			if( m_exists[i] )
+			{
+				string( i )->~vibratingString();
+			}
 		}
 	}
 	
-	float getStringSample( int _string )
+	float getStringSample( int _id )
 	{
-		return m_strings[_string]->nextSample();
+		return string( _id )->nextSample();
 	}
 	
 private:
-	QVector<vibratingString *> m_strings;
+	vibratingString * string( int _id )
+	{
+		return reinterpret_cast<vibratingString *>( &m_strings[_id] );
+	}
+
+	// strings are constructed in place, so containers kept in a
+	// VoiceArena don't allocate them
+	std::aligned_storage<sizeof( vibratingString ),
+			alignof( vibratingString )>::type m_strings[MaxStrings];
 	const float m_pitch;
 	const sample_rate_t m_sampleRate;
 	const int m_bufferLength;
-	QVector<bool> m_exists;
+	LocklessAllocator * m_delayLines;
+	bool m_exists[MaxStrings];
 } ;
 
 #endif
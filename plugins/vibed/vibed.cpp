@@ -63,7 +63,9 @@ Plugin::Descriptor PLUGIN_EXPORT vibedstrings_plugin_descriptor =
 
 
 vibed::vibed( InstrumentTrack * _instrumentTrack ) :
-	Instrument( _instrumentTrack, &vibedstrings_plugin_descriptor )
+	Instrument( _instrumentTrack, &vibedstrings_plugin_descriptor ),
+	m_delayLines( 64, vibratingString::PoolBlockLength * sizeof( sample_t ) ),
+	m_voices( 64 )
 {
 
 	FloatModel * knob;
@@ -276,9 +278,9 @@ void vibed::playNote( NotePlayHandle * _n, sampleFrame * _working_buffer )
 {
 	if ( _n->totalFramesPlayed() == 0 || _n->m_pluginData == NULL )
 	{
-		_n->m_pluginData = new stringContainer( _n->frequency(),
+		_n->m_pluginData = m_voices.create( _n->frequency(),
 				Engine::mixer()->processingSampleRate(),
-						__sampleLength );
+						__sampleLength, &m_delayLines );
 		
 		for( int i = 0; i < 9; ++i )
 		{
@@ -310,17 +312,15 @@ void vibed::playNote( NotePlayHandle * _n, sampleFrame * _working_buffer )
 	{
 		_working_buffer[i][0] = 0.0f;
 		_working_buffer[i][1] = 0.0f;
-		int s = 0;
 		for( int string = 0; string < 9; ++string )
 		{
 			if( ps->exists( string ) )
 			{
 				// pan: 0 -> left, 1 -> right
 				const float pan = ( m_panKnobs[string]->value() + 1 ) / 2.0f;
-				const sample_t sample = ps->getStringSample( s ) * m_volumeKnobs[string]->value() / 100.0f;
+				const sample_t sample = ps->getStringSample( string ) * m_volumeKnobs[string]->value() / 100.0f;
 				_working_buffer[i][0] += ( 1.0f - pan ) * sample;
 				_working_buffer[i][1] += pan * sample;
-				s++;
 			}
 		}
 	}
@@ -333,7 +333,7 @@ void vibed::playNote( NotePlayHandle * _n, sampleFrame * _working_buffer )
 
 void vibed::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<stringContainer *>( _n->m_pluginData );
+	m_voices.destroy( static_cast<stringContainer *>( _n->m_pluginData ) );
 }
 
 
@@ -31,6 +31,8 @@
 #include "PixmapButton.h"
 #include "LedCheckbox.h"
 #include "nine_button_selector.h"
+#include "string_container.h"
+#include "VoiceArena.h"
 
 class vibedView;
 class NotePlayHandle;
@@ -77,6 +79,11 @@ private:
 
 	static const int __sampleLength = 128;
 
+	// buffers of the strings, 24 KB each
+	LocklessAllocator m_delayLines;
+	// containers hold their strings, i.e. they are about 2 KB each
+	VoiceArena<stringContainer> m_voices;
+
 	friend class vibedView;
 } ;
 
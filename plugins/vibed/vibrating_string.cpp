@@ -30,7 +30,13 @@
 #include "Engine.h"
 
 
-vibratingString::vibratingString(	float _pitch, 
+const int vibratingString::MaxOversample;
+const int vibratingString::PooledLength;
+const int vibratingString::PoolBlockLength;
+
+
+vibratingString::vibratingString(	LocklessAllocator * _pool,
+					float _pitch, 
 					float _pick,
 					float _pickup,
 					float * _impulse, 
@@ -41,13 +47,14 @@ vibratingString::vibratingString(	float _pitch,
 					float _string_loss,
 					float _detune,
 					bool _state ) :
-	m_oversample( 2 * _oversample / (int)( _sample_rate /
-				Engine::mixer()->baseSampleRate() ) ),
+	m_oversample( qMin( 2 * _oversample / (int)( _sample_rate /
+				Engine::mixer()->baseSampleRate() ), MaxOversample ) ),
 	m_randomize( _randomize ),
 	m_stringLoss( 1.0f - _string_loss ),
+	m_pool( _pool ),
+	m_buffer( NULL ),
 	m_state( 0.1f )
 {
-	m_outsamp = new sample_t[m_oversample];
 	int string_length;
 	
 	string_length = static_cast<int>( m_oversample * _sample_rate /
@@ -56,28 +63,43 @@ vibratingString::vibratingString(	float _pitch,
 
 	int pick = static_cast<int>( ceil( string_length * _pick ) );
 	
+	// one block for all buffers, the string gets created on a rendering
+	// thread
+	const int impulse_length = _state ? _len : string_length;
+	const int buffer_length = impulse_length + 2 * string_length;
+	if( buffer_length <= PoolBlockLength )
+	{
+		m_buffer = static_cast<sample_t *>( m_pool->tryAlloc() );
+	}
+	if( m_buffer == NULL )
+	{
+		m_buffer = MM_ALLOC( sample_t, buffer_length );
+	}
+	m_impulse = m_buffer;
+
 	if( ! _state )
 	{
-		m_impulse = new float[string_length];
 		resample( _impulse, _len, string_length );
 	}
 	else
  	{
-		m_impulse = new float[_len];
 		for( int i = 0; i < _len; i++ )
 		{
 			m_impulse[i] = _impulse[i];
 		}
 	}
 	
-	m_toBridge = vibratingString::initDelayLine( string_length, pick );
-	m_fromBridge = vibratingString::initDelayLine( string_length, pick );
+	vibratingString::initDelayLine( &m_toBridge,
+				m_buffer + impulse_length, string_length );
+	vibratingString::initDelayLine( &m_fromBridge,
+				m_buffer + impulse_length + string_length,
+							string_length );
 
 	
-	vibratingString::setDelayLine( m_toBridge, pick, 
+	vibratingString::setDelayLine( &m_toBridge, pick, 
 						m_impulse, _len, 0.5f, 
 						_state );
-	vibratingString::setDelayLine( m_fromBridge, pick, 
+	vibratingString::setDelayLine( &m_fromBridge, pick, 
 						m_impulse, _len, 0.5f,
 						_state);
 	
@@ -90,46 +112,31 @@ vibratingString::vibratingString(	float _pitch,
 
 
 
-vibratingString::delayLine * vibratingString::initDelayLine( int _len,
-								int _pick )
+void vibratingString::initDelayLine( delayLine * _dl, sample_t * _data,
+								int _len )
 {
-	delayLine * dl = new vibratingString::delayLine[_len];
-	dl->length = _len;
+	_dl->length = _len;
 	if( _len > 0 )
 	{
-		dl->data = new sample_t[_len];
+		_dl->data = _data;
 		float r;
 		float offset = 0.0f;
-		for( int i = 0; i < dl->length; i++ )
+		for( int i = 0; i < _dl->length; i++ )
 		{
 			r = static_cast<float>( rand() ) /
 					RAND_MAX;
 			offset =  ( m_randomize / 2.0f -
 					m_randomize ) * r;
-			dl->data[i] = offset;
+			_dl->data[i] = offset;
 		}
 	}
 	else
 	{
-		dl->data = NULL;
+		_dl->data = NULL;
 	}
 
-	dl->pointer = dl->data;
-	dl->end = dl->data + _len - 1;
-
-	return( dl );
-}
-
-
-
-
-void vibratingString::freeDelayLine( delayLine * _dl )
-{
-	if( _dl )
-	{
-		delete[] _dl->data;
-		delete[] _dl;
-	}
+	_dl->pointer = _dl->data;
+	_dl->end = _dl->data + _len - 1;
 }
 
 
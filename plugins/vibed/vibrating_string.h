@@ -28,12 +28,22 @@
 #include <stdlib.h>
 
 #include "lmms_basics.h"
+#include "LocklessAllocator.h"
+#include "MemoryManager.h"
 
 class vibratingString
 {
 
 public:
-	vibratingString(	float _pitch, 
+	// strings up to this length take their buffers from the pool of the
+	// instrument, which covers the default string length down to about
+	// 45 Hz
+	static const int PooledLength = 2048;
+	// the impulse and both delay lines of such a string
+	static const int PoolBlockLength = 3 * PooledLength;
+
+	vibratingString(	LocklessAllocator * _pool,
+				float _pitch, 
 				float _pick, 
 				float _pickup,
 				float * impluse,
@@ -47,10 +57,14 @@ public:
 	
 	inline ~vibratingString()
 	{
-		delete[] m_outsamp;
-		delete[] m_impulse;
-		vibratingString::freeDelayLine( m_fromBridge );
-		vibratingString::freeDelayLine( m_toBridge );
+		if( m_pool->contains( m_buffer ) )
+		{
+			m_pool->free( m_buffer );
+		}
+		else
+		{
+			MM_FREE( m_buffer );
+		}
 	}
 
 	inline sample_t nextSample()
@@ -60,29 +74,32 @@ public:
 		for( int i = 0; i < m_oversample; i++)
 		{
 			// Output at pickup position
-			m_outsamp[i] = fromBridgeAccess( m_fromBridge, 
+			m_outsamp[i] = fromBridgeAccess( &m_fromBridge, 
 								m_pickupLoc );
-			m_outsamp[i] += toBridgeAccess( m_toBridge, 
+			m_outsamp[i] += toBridgeAccess( &m_toBridge, 
 								m_pickupLoc );
 		
 			// Sample traveling into "bridge"
-			ym0 = toBridgeAccess( m_toBridge, 1 );
+			ym0 = toBridgeAccess( &m_toBridge, 1 );
 			// Sample to "nut"
-			ypM = fromBridgeAccess( m_fromBridge,
-						m_fromBridge->length - 2 );
+			ypM = fromBridgeAccess( &m_fromBridge,
+						m_fromBridge.length - 2 );
 
 			// String state update
 
 			// Decrement pointer and then update
-			fromBridgeUpdate( m_fromBridge, 
+			fromBridgeUpdate( &m_fromBridge, 
 						-bridgeReflection( ym0 ) );
 			// Update and then increment pointer
-			toBridgeUpdate( m_toBridge, -ypM );
+			toBridgeUpdate( &m_toBridge, -ypM );
 		}
 		return( m_outsamp[m_choice] );
 	}
 
 private:
+	// twice the longest string length setting
+	static const int MaxOversample = 32;
+
 	struct delayLine
 	{
 		sample_t * data;
@@ -91,21 +108,23 @@ private:
 		sample_t * end;
 	} ;
 
-	delayLine * m_fromBridge;
-	delayLine * m_toBridge;
+	delayLine m_fromBridge;
+	delayLine m_toBridge;
 	int m_pickupLoc;
 	int m_oversample;
 	float m_randomize;
 	float m_stringLoss;
 	
+	// the impulse and both delay lines, allocated at once
+	LocklessAllocator * m_pool;
+	sample_t * m_buffer;
 	float * m_impulse;
 	int m_choice;
 	float m_state;
 	
-	sample_t * m_outsamp;
+	sample_t m_outsamp[MaxOversample];
 
-	delayLine * initDelayLine( int _len, int _pick );
-	static void freeDelayLine( delayLine * _dl );
+	void initDelayLine( delayLine * _dl, sample_t * _data, int _len );
 	void resample( float *_src, f_cnt_t _src_frames, f_cnt_t _dst_frames );
 	
 	/* setDelayLine initializes the string with an impulse at the pick
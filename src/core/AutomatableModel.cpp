@@ -24,15 +24,61 @@
 
 #include "AutomatableModel.h"
 
+#include <algorithm>
+#include <memory>
+
 #include "lmms_math.h"
 
 #include "AutomationPattern.h"
 #include "ControllerConnection.h"
 #include "LocaleHelper.h"
 #include "Mixer.h"
+#include "MixerWorkerThread.h"
 #include "ProjectJournal.h"
+#include "ThreadableJob.h"
 
 long AutomatableModel::s_periodCounter = 0;
+std::vector<AutomatableModel *> AutomatableModel::s_activeModels;
+QMutex AutomatableModel::s_activeModelsMutex;
+
+
+
+// updates a range of s_activeModels on a worker thread
+class AutomatableModel::ValueBufferJob : public ThreadableJob
+{
+public:
+	ValueBufferJob() :
+		m_begin( 0 ),
+		m_end( 0 )
+	{
+	}
+
+	void setRange( size_t begin, size_t end )
+	{
+		m_begin = begin;
+		m_end = end;
+	}
+
+	virtual bool requiresProcessing() const
+	{
+		return m_begin < m_end;
+	}
+
+private:
+	virtual void doProcessing()
+	{
+		for( size_t i = m_begin; i < m_end; ++i )
+		{
+			AutomatableModel * model = s_activeModels[i];
+			QMutexLocker m( &model->m_valueBufferMutex );
+			model->updateValueBuffer();
+		}
+	}
+
+	size_t m_begin;
+	size_t m_end;
+
+} ;
 
 
 
@@ -52,7 +98,8 @@ AutomatableModel::AutomatableModel(
 	m_controllerConnection( NULL ),
 	m_valueBuffer( static_cast<int>( Engine::mixer()->framesPerPeriod() ) ),
 	m_lastUpdatedPeriod( -1 ),
-	m_hasSampleExactData( false )
+	m_hasSampleExactData( false ),
+	m_active( false )
 
 {
 	m_value = fittedValue( val );
@@ -75,6 +122,16 @@ AutomatableModel::~AutomatableModel()
 		delete m_controllerConnection;
 	}
 
+	{
+		QMutexLocker m( &s_activeModelsMutex );
+		if( m_active )
+		{
+			s_activeModels.erase( std::remove( s_activeModels.begin(),
+							s_activeModels.end(), this ),
+						s_activeModels.end() );
+		}
+	}
+
 	m_valueBuffer.clear();
 
 	emit destroyed( id() );
@@ -291,6 +348,7 @@ void AutomatableModel::setValue( const float value )
 	{
 		// add changes to history so user can undo it
 		addJournalCheckPoint();
+		markActive();
 
 		// notify linked models
 		for( AutoModelVector::Iterator it = m_linkedModels.begin(); it != m_linkedModels.end(); ++it )
@@ -373,6 +431,7 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 	if( oldValue != m_value )
 	{
+		markActive();
 		// notify linked models
 		for( AutoModelVector::Iterator it = m_linkedModels.begin();
 									it != m_linkedModels.end(); ++it )
@@ -392,6 +451,27 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 
 
+bool AutomatableModel::setAutomatedValueBuffer( const float * values )
+{
+	if( hasLinkedModels() || m_controllerConnection )
+	{
+		return false;
+	}
+
+	QMutexLocker m( &m_valueBufferMutex );
+	float * nvalues = m_valueBuffer.values();
+	for( int i = 0; i < m_valueBuffer.length(); ++i )
+	{
+		nvalues[i] = fittedValue( scaledValue( values[i] ) );
+	}
+	// valueBuffer() returns this buffer until the period counter advances
+	m_hasSampleExactData = true;
+	m_lastUpdatedPeriod.store( s_periodCounter, std::memory_order_release );
+	return true;
+}
+
+
+
 void AutomatableModel::setRange( const float min, const float max,
 							const float step )
 {
@@ -463,6 +543,7 @@ void AutomatableModel::linkModel( AutomatableModel* model )
 	if( !m_linkedModels.contains( model ) && model != this )
 	{
 		m_linkedModels.push_back( model );
+		markActive();
 
 		if( !model->hasLinkedModels() )
 		{
@@ -522,6 +603,7 @@ void AutomatableModel::setControllerConnection( ControllerConnection* c )
 	m_controllerConnection = c;
 	if( c )
 	{
+		markActive();
 		QObject::connect( m_controllerConnection, SIGNAL( valueChanged() ), this, SIGNAL( dataChanged() ) );
 		QObject::connect( m_controllerConnection, SIGNAL( destroyed() ), this, SLOT( unlinkControllerConnection() ) );
 		m_valueChanged = true;
@@ -570,13 +652,32 @@ float AutomatableModel::controllerValue( int frameOffset ) const
 
 ValueBuffer * AutomatableModel::valueBuffer()
 {
+	// usually updateValueBuffers() did the work already
+	if( m_lastUpdatedPeriod.load( std::memory_order_acquire ) == s_periodCounter )
+	{
+		return m_hasSampleExactData ? &m_valueBuffer : NULL;
+	}
+
+	// neither connected, linked nor changed, so there's no sample-exact data
+	if( !m_active )
+	{
+		return NULL;
+	}
+
 	QMutexLocker m( &m_valueBufferMutex );
-	// if we've already calculated the valuebuffer this period, return the cached buffer
-	if( m_lastUpdatedPeriod == s_periodCounter )
+	updateValueBuffer();
+	return m_hasSampleExactData ? &m_valueBuffer : NULL;
+}
+
+
+
+
+void AutomatableModel::updateValueBuffer()
+{
+	// if we've already calculated the valuebuffer this period, keep it
+	if( m_lastUpdatedPeriod.load( std::memory_order_relaxed ) == s_periodCounter )
 	{
-		return m_hasSampleExactData
-			? &m_valueBuffer
-			: NULL;
+		return;
 	}
 
 	float val = m_value; // make sure our m_value doesn't change midway
@@ -608,9 +709,9 @@ ValueBuffer * AutomatableModel::valueBuffer()
 					"lacks implementation for a scale type");
 				break;
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
 			m_hasSampleExactData = true;
-			return &m_valueBuffer;
+			m_lastUpdatedPeriod.store( s_periodCounter, std::memory_order_release );
+			return;
 		}
 	}
 	AutomatableModel* lm = NULL;
@@ -627,25 +728,105 @@ ValueBuffer * AutomatableModel::valueBuffer()
 		{
 			nvalues[i] = fittedValue( values[i] );
 		}
-		m_lastUpdatedPeriod = s_periodCounter;
 		m_hasSampleExactData = true;
-		return &m_valueBuffer;
+		m_lastUpdatedPeriod.store( s_periodCounter, std::memory_order_release );
+		return;
 	}
 
 	if( m_oldValue != val )
 	{
 		m_valueBuffer.interpolate( m_oldValue, val );
 		m_oldValue = val;
-		m_lastUpdatedPeriod = s_periodCounter;
 		m_hasSampleExactData = true;
-		return &m_valueBuffer;
+		m_lastUpdatedPeriod.store( s_periodCounter, std::memory_order_release );
+		return;
 	}
 
-	// if we have no sample-exact source for a ValueBuffer, return NULL to signify that no data is available at the moment
-	// in which case the recipient knows to use the static value() instead
-	m_lastUpdatedPeriod = s_periodCounter;
+	// if we have no sample-exact source for a ValueBuffer, valueBuffer() returns NULL to signify that no data is available at
+	// the moment in which case the recipient knows to use the static value() instead
 	m_hasSampleExactData = false;
-	return NULL;
+	m_lastUpdatedPeriod.store( s_periodCounter, std::memory_order_release );
+}
+
+
+
+
+void AutomatableModel::updateValueBuffers()
+{
+	// don't bother the workers for a handful of models
+	static const size_t MinModelsPerJob = 32;
+	static std::vector<std::unique_ptr<ValueBufferJob>> jobs;
+
+	QMutexLocker m( &s_activeModelsMutex );
+
+	// controllers compute their buffers lazily without any locking, so
+	// have them computed before several workers read them
+	for( AutomatableModel * model : s_activeModels )
+	{
+		if( model->m_controllerConnection &&
+			model->m_controllerConnection->getController()->isSampleExact() )
+		{
+			model->m_controllerConnection->valueBuffer();
+		}
+	}
+
+	const size_t jobCount = qMin<size_t>( MixerWorkerThread::workerCount(),
+					s_activeModels.size() / MinModelsPerJob );
+	if( jobCount > 1 )
+	{
+		while( jobs.size() < jobCount )
+		{
+			jobs.emplace_back( new ValueBufferJob );
+		}
+		MixerWorkerThread::resetJobQueue();
+		for( size_t j = 0; j < jobCount; ++j )
+		{
+			jobs[j]->setRange( s_activeModels.size() * j / jobCount,
+					s_activeModels.size() * ( j + 1 ) / jobCount );
+			MixerWorkerThread::addJob( jobs[j].get() );
+		}
+		MixerWorkerThread::startAndWaitForJobs();
+	}
+	else
+	{
+		for( AutomatableModel * model : s_activeModels )
+		{
+			QMutexLocker vm( &model->m_valueBufferMutex );
+			model->updateValueBuffer();
+		}
+	}
+
+	// drop models which settled; markActive() adds them again if their
+	// value changes meanwhile, so whoever flips m_active back first keeps
+	// the model listed
+	for( size_t i = 0; i < s_activeModels.size(); )
+	{
+		AutomatableModel * model = s_activeModels[i];
+		model->m_active.exchange( false );
+		if( ( model->m_controllerConnection || model->hasLinkedModels() ||
+				model->m_value != model->m_oldValue ) &&
+			!model->m_active.exchange( true ) )
+		{
+			++i;
+		}
+		else
+		{
+			s_activeModels[i] = s_activeModels.back();
+			s_activeModels.pop_back();
+		}
+	}
+}
+
+
+
+
+void AutomatableModel::markActive()
+{
+	if( !m_active.exchange( true ) )
+	{
+		QMutexLocker m( &s_activeModelsMutex );
+		s_activeModels.push_back( this );
+	}
 }
 
 
@@ -27,6 +27,7 @@
 #include "AutomationPattern.h"
 
 #include "AutomationPatternView.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "LocaleHelper.h"
 #include "Note.h"
@@ -34,6 +35,7 @@
 #include "BBTrackContainer.h"
 #include "Song.h"
 
+#include <algorithm>
 #include <cmath>
 
 int AutomationPattern::s_quantization = 1;
@@ -114,6 +116,7 @@ bool AutomationPattern::addObject( AutomatableModel * _obj, bool _search_dup )
 	}
 
 	m_objects += _obj;
+	AutomationTimeline::invalidate();
 
 	connect( _obj, SIGNAL( destroyed( jo_id_t ) ),
 			this, SLOT( objectDestroyed( jo_id_t ) ),
@@ -395,6 +398,115 @@ float AutomationPattern::valueAt( timeMap::const_iterator v, int offset ) const
 
 
 
+/**
+ * @brief Renders the curve into a buffer, sample by sample
+ * @param time Position of the first value in ticks, relative to the pattern
+ * @param step Distance between two values in ticks
+ * @param values Buffer receiving the values
+ * @param count Number of values to render
+ * @param maxTime Positions after this are clamped to it
+ *
+ * Gives the same results as valueAt() at integer positions, but walks the
+ * time map only once per segment instead of once per value.
+ */
+void AutomationPattern::valuesAt( float time, float step, float * values,
+					int count, float maxTime ) const
+{
+	if( m_timeMap.isEmpty() )
+	{
+		std::fill( values, values + count, 0.0f );
+		return;
+	}
+
+	// number of values before we reach maxTime
+	int unclamped = count;
+	if( step > 0 && time + ( count - 1 ) * step > maxTime )
+	{
+		unclamped = qBound( 0, (int) ceilf( ( maxTime - time ) / step ), count );
+	}
+	else if( step <= 0 && time > maxTime )
+	{
+		unclamped = 0;
+	}
+
+	int i = 0;
+	while( i < unclamped )
+	{
+		const float t = time + i * step;
+
+		// first point behind t - points are on integer positions, so
+		// this is the same as the lowerBound() in valueAt()
+		timeMap::ConstIterator next = m_timeMap.upperBound( (int) floorf( t ) );
+
+		// number of values until we reach the next point
+		int n = unclamped - i;
+		if( next != m_timeMap.end() && step > 0 )
+		{
+			n = qBound( 1, (int) ceilf( ( next.key() - t ) / step ), n );
+			// make sure rounding didn't move a value onto the point
+			while( n > 1 && time + ( i + n - 1 ) * step >= next.key() )
+			{
+				--n;
+			}
+		}
+
+		float * out = values + i;
+		if( next == m_timeMap.begin() )
+		{
+			std::fill( out, out + n, 0.0f );
+		}
+		else if( next == m_timeMap.end() ||
+				m_progressionType == DiscreteProgression )
+		{
+			std::fill( out, out + n, ( next - 1 ).value() );
+		}
+		else
+		{
+			timeMap::ConstIterator v = next - 1;
+			const float offset = t - v.key();
+			const float v1 = v.value();
+			const float v2 = next.value();
+			const float numValues = next.key() - v.key();
+
+			if( m_progressionType == LinearProgression )
+			{
+				const float slope = ( v2 - v1 ) / numValues;
+				for( int j = 0; j < n; ++j )
+				{
+					out[j] = v1 + ( offset + j * step ) * slope;
+				}
+			}
+			else /* CubicHermiteProgression */
+			{
+				// same spline as in valueAt(), expanded into a
+				// polynomial in t
+				const float m1 = m_tangents[v.key()] * numValues * m_tension;
+				const float m2 = m_tangents[next.key()] * numValues * m_tension;
+				const float a = 2 * v1 + m1 - 2 * v2 + m2;
+				const float b = -3 * v1 - 2 * m1 + 3 * v2 - m2;
+				const float t0 = offset / numValues;
+				const float dt = step / numValues;
+				for( int j = 0; j < n; ++j )
+				{
+					const float x = t0 + j * dt;
+					out[j] = ( ( a * x + b ) * x + m1 ) * x + v1;
+				}
+			}
+		}
+		i += n;
+	}
+
+	if( unclamped < count )
+	{
+		float last;
+		valuesAt( maxTime, 0, &last, 1 );
+		std::fill( values + unclamped, values + count, last );
+	}
+}
+
+
+
+
 float *AutomationPattern::valuesAfter( const MidiTime & _time ) const
 {
 	timeMap::ConstIterator v = m_timeMap.lowerBound( _time );
@@ -811,6 +923,7 @@ void AutomationPattern::objectDestroyed( jo_id_t _id )
 		{
 			//Assign to objIt so that this loop work even break; is removed.
 			objIt = m_objects.erase( objIt );
+			AutomationTimeline::invalidate();
 			break;
 		}
 	}
@@ -832,6 +945,7 @@ void AutomationPattern::cleanObjects()
 		else
 		{
 			it = m_objects.erase( it );
+			AutomationTimeline::invalidate();
 		}
 	}
 }
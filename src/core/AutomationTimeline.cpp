@@ -0,0 +1,440 @@
+/*
+ * AutomationTimeline.cpp - precompiled automation lookup for song playback
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AutomationTimeline.h"
+
+#include <QtCore/QHash>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "AutomationPattern.h"
+#include "BBTrack.h"
+#include "BBTrackContainer.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "TrackContainer.h"
+
+
+std::atomic_uint AutomationTimeline::s_revision( 0 );
+
+
+AutomationTimeline::AutomationTimeline( TrackContainer * container, Track * globalTrack ) :
+	m_container( container ),
+	m_globalTrack( globalTrack ),
+	m_revision( s_revision - 1 ),
+	m_cursorTime( 0 ),
+	m_nextSegment( 0 )
+{
+}
+
+
+
+
+void AutomationTimeline::invalidate()
+{
+	++s_revision;
+}
+
+
+
+
+const AutomationTimeline::ValueVector & AutomationTimeline::valuesAt( MidiTime time )
+{
+	seek( time );
+
+	m_values.clear();
+	for( int model : m_activeModels )
+	{
+		AutomatableModel * m = m_models[model];
+		if( m == NULL )
+		{
+			continue;
+		}
+
+		// usually the latest segment delivers the value, older ones are
+		// only used if it is muted or has no automation
+		const std::vector<int> & started = m_startedSegments[model];
+		for( auto it = started.rbegin(); it != started.rend(); ++it )
+		{
+			float value;
+			if( valueOf( m_segments[*it], time, value ) )
+			{
+				m_values.push_back( { m, value } );
+				break;
+			}
+		}
+	}
+
+	return m_values;
+}
+
+
+
+
+void AutomationTimeline::renderValueBuffers( float position, float ticksPerFrame,
+						float loopBegin, float loopEnd )
+{
+	if( m_revision != s_revision )
+	{
+		compile();
+	}
+
+	const int frames = Engine::mixer()->framesPerPeriod();
+	m_renderBuffers.resize( m_models.size() );
+	m_renderedFrames.assign( m_models.size(), 0 );
+	m_renderedModels.clear();
+
+	// split the period where playback loops, the position moves linearly
+	// in between - see Song::processNextBuffer()
+	int offset = 0;
+	while( offset < frames )
+	{
+		int spanFrames = frames - offset;
+		bool wraps = false;
+		if( loopEnd > loopBegin )
+		{
+			// the first frame at or behind the loop end is played from
+			// the loop begin on
+			const int framesToEnd = qMax( 0, (int) ceilf(
+							( loopEnd - position ) / ticksPerFrame ) );
+			if( framesToEnd < spanFrames )
+			{
+				spanFrames = framesToEnd;
+				wraps = true;
+			}
+		}
+
+		if( spanFrames > 0 )
+		{
+			renderSpan( position, ticksPerFrame, offset, spanFrames );
+		}
+		offset += spanFrames;
+		position += spanFrames * ticksPerFrame;
+		if( wraps )
+		{
+			position -= loopEnd - loopBegin;
+		}
+	}
+
+	for( int model : m_renderedModels )
+	{
+		if( m_renderedFrames[model] == frames )
+		{
+			m_models[model]->setAutomatedValueBuffer(
+						m_renderBuffers[model].data() );
+		}
+	}
+}
+
+
+
+
+void AutomationTimeline::renderSpan( float position, float ticksPerFrame,
+							int offset, int frames )
+{
+	const float end = position + frames * ticksPerFrame;
+
+	int done = 0;
+	while( done < frames )
+	{
+		const float subPosition = position + done * ticksPerFrame;
+		const MidiTime time = (tick_t) floorf( subPosition );
+		seek( time );
+
+		// a pattern starting inside the span takes over from the first
+		// frame at or behind its start on
+		int subFrames = frames - done;
+		if( m_nextSegment < m_segments.size() &&
+				m_segments[m_nextSegment].start.getTicks() < end )
+		{
+			const float start = m_segments[m_nextSegment].start.getTicks();
+			subFrames = qBound( 1, (int) ceilf( ( start - position ) /
+						ticksPerFrame ) - done, subFrames );
+		}
+
+		for( int model : m_activeModels )
+		{
+			AutomatableModel * m = m_models[model];
+			if( m == NULL || m_renderedFrames[model] < 0 )
+			{
+				continue;
+			}
+			// a gap in the model's curve, e.g. after looping back to
+			// where none of its patterns started yet
+			if( m_renderedFrames[model] != offset + done )
+			{
+				m_renderedFrames[model] = -1;
+				continue;
+			}
+
+			const std::vector<int> & started = m_startedSegments[model];
+			for( auto it = started.rbegin(); it != started.rend(); ++it )
+			{
+				const Segment & segment = m_segments[*it];
+				float value;
+				if( valueOf( segment, time, value ) == false )
+				{
+					continue;
+				}
+
+				// patterns in BB tracks loop, which doesn't make a
+				// continuous curve, and recorded models must not be
+				// overwritten - leave them to the per-tick values
+				if( segment.bbTCO || isRecorded( model ) )
+				{
+					m_renderedFrames[model] = -1;
+					break;
+				}
+
+				if( m_renderedFrames[model] == 0 )
+				{
+					m_renderedModels.push_back( model );
+				}
+				std::vector<float> & buffer = m_renderBuffers[model];
+				buffer.resize( Engine::mixer()->framesPerPeriod() );
+
+				AutomationPattern * p = segment.pattern;
+				p->valuesAt( subPosition - p->startPosition().getTicks(),
+						ticksPerFrame, buffer.data() + offset + done,
+						subFrames, p->getAutoResize() ?
+							std::numeric_limits<float>::max() :
+							(float) p->length() );
+				m_renderedFrames[model] += subFrames;
+				break;
+			}
+		}
+
+		done += subFrames;
+	}
+}
+
+
+
+
+void AutomationTimeline::seek( MidiTime time )
+{
+	if( m_revision != s_revision )
+	{
+		compile();
+	}
+	else if( time < m_cursorTime )
+	{
+		// jumped backwards (loop, seek) - start over
+		rewind();
+	}
+	m_cursorTime = time;
+
+	// start all segments we passed since the last call. Segments are
+	// sorted, so a segment started later always takes precedence over
+	// the ones started before, just like in automatedValuesFromTracks()
+	while( m_nextSegment < m_segments.size() &&
+				m_segments[m_nextSegment].start <= time )
+	{
+		const Segment & segment = m_segments[m_nextSegment];
+		for( int model : segment.models )
+		{
+			std::vector<int> & started = m_startedSegments[model];
+			if( started.empty() )
+			{
+				m_activeModels.push_back( model );
+			}
+			started.push_back( m_nextSegment );
+		}
+		if( segment.recordable )
+		{
+			m_startedPatterns.push_back( segment.pattern );
+		}
+		++m_nextSegment;
+	}
+}
+
+
+
+
+bool AutomationTimeline::isRecorded( int model ) const
+{
+	for( int segment : m_startedSegments[model] )
+	{
+		if( m_segments[segment].pattern->isRecording() )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+void AutomationTimeline::compile()
+{
+	m_revision = s_revision;
+	m_segments.clear();
+	m_models.clear();
+
+	TrackContainer::TrackList tracks;
+	if( m_globalTrack )
+	{
+		tracks << m_globalTrack;
+	}
+	tracks += m_container->tracks();
+
+	BBTrackContainer * bbContainer = Engine::getBBTrackContainer();
+	QHash<AutomatableModel *, int> modelIndices;
+
+	for( Track * track : tracks )
+	{
+		switch( track->type() )
+		{
+		case Track::AutomationTrack:
+		case Track::HiddenAutomationTrack:
+			for( TrackContentObject * tco : track->getTCOs() )
+			{
+				if( auto p = dynamic_cast<AutomationPattern *>( tco ) )
+				{
+					Segment segment = { tco->startPosition(), track, p,
+						NULL, -1, track->type() == Track::AutomationTrack &&
+											track != m_globalTrack, {} };
+					m_segments << segment;
+				}
+			}
+			break;
+		case Track::BBTrack:
+		{
+			const int bbIndex = static_cast<BBTrack *>( track )->index();
+			for( TrackContentObject * tco : track->getTCOs() )
+			{
+				for( Track * bbTrack : bbContainer->tracks() )
+				{
+					if( ( bbTrack->type() != Track::AutomationTrack &&
+						bbTrack->type() != Track::HiddenAutomationTrack ) ||
+						bbTrack->numOfTCOs() <= bbIndex )
+					{
+						continue;
+					}
+					if( auto p = dynamic_cast<AutomationPattern *>(
+											bbTrack->getTCO( bbIndex ) ) )
+					{
+						Segment segment = { tco->startPosition(), track, p,
+											tco, bbIndex, false, {} };
+						m_segments << segment;
+					}
+				}
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	// same order as the sorted insertion in Track::getTCOsInRange()
+	std::stable_sort( m_segments.begin(), m_segments.end(),
+		[]( const Segment & a, const Segment & b ) { return a.start < b.start; } );
+
+	for( Segment & segment : m_segments )
+	{
+		for( AutomatableModel * model : segment.pattern->objects() )
+		{
+			if( model == NULL )
+			{
+				continue;
+			}
+			auto it = modelIndices.find( model );
+			if( it == modelIndices.end() )
+			{
+				it = modelIndices.insert( model, m_models.size() );
+				m_models << model;
+			}
+			segment.models << it.value();
+		}
+	}
+
+	rewind();
+}
+
+
+
+
+void AutomationTimeline::rewind()
+{
+	m_nextSegment = 0;
+	m_cursorTime = 0;
+	m_startedSegments.resize( m_models.size() );
+	for( std::vector<int> & started : m_startedSegments )
+	{
+		started.clear();
+	}
+	m_activeModels.clear();
+	m_startedPatterns.clear();
+}
+
+
+
+
+bool AutomationTimeline::valueOf( const Segment & segment, MidiTime time, float & value ) const
+{
+	AutomationPattern * p = segment.pattern;
+	if( segment.track->isMuted() )
+	{
+		return false;
+	}
+
+	if( segment.bbTCO )
+	{
+		// see automatedValuesFromTracks() and BBTrackContainer::automatedValuesAt()
+		if( segment.bbTCO->isMuted() || p->getTrack()->isMuted() )
+		{
+			return false;
+		}
+		BBTrackContainer * bbContainer = Engine::getBBTrackContainer();
+		const MidiTime bbLength = bbContainer->lengthOfBB( segment.bbIndex ) *
+													MidiTime::ticksPerTact();
+		MidiTime bbTime = time - segment.bbTCO->startPosition();
+		bbTime = std::min( bbTime, segment.bbTCO->length() );
+		bbTime = bbTime % bbLength;
+		if( bbTime > bbLength )
+		{
+			bbTime = bbLength;
+		}
+		time = bbTime + MidiTime::ticksPerTact() * segment.bbIndex;
+
+		if( p->startPosition() > time )
+		{
+			return false;
+		}
+	}
+
+	if( p->isMuted() || p->hasAutomation() == false )
+	{
+		return false;
+	}
+
+	MidiTime relTime = time - p->startPosition();
+	if( p->getAutoResize() == false )
+	{
+		relTime = qMin( relTime, p->length() );
+	}
+	value = p->valueAt( relTime );
+	return true;
+}
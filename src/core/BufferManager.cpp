@@ -26,23 +26,187 @@
 
 #include "BufferManager.h"
 
-#include "Engine.h"
-#include "Mixer.h"
-#include "MemoryManager.h"
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include <QtCore/QThread>
+
+#include "MemoryHelper.h"
+
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+#include <xmmintrin.h>
+#endif
+
+// a cache line, and the size of the widest vector registers
+static const size_t BUFFER_ALIGNMENT = 64;
+// number of buffers allocated at once when the free list runs empty
+static const int BUFFERS_PER_SLAB = 64;
+
+// number of pause iterations before a waiting thread gives up its time slice
+static const int SPIN_COUNT = 64;
 
 static fpp_t framesPerPeriod;
+// samples per channel of planar buffers, padded to keep the right channel aligned
+static size_t planarStride;
+static size_t bufferSize;
+
+static std::vector<char *> slabs;
+static std::vector<void *> freeList;
+static std::atomic_flag freeListLock = ATOMIC_FLAG_INIT;
+
+// slabs of a previous init() which still have buffers in use
+struct RetiredSlab
+{
+	char * slab;
+	size_t size;
+	int buffersInUse;
+} ;
+static std::vector<RetiredSlab> retiredSlabs;
+
+
+static inline void cpuRelax()
+{
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+	_mm_pause();
+#endif
+}
+
+
+class FreeListLocker
+{
+public:
+	FreeListLocker()
+	{
+		// the lock is only held for a few instructions, so spinning
+		// usually is cheaper than sleeping
+		int spins = 0;
+		while( freeListLock.test_and_set( std::memory_order_acquire ) )
+		{
+			if( ++spins < SPIN_COUNT )
+			{
+				cpuRelax();
+			}
+			else
+			{
+				QThread::yieldCurrentThread();
+			}
+		}
+	}
+
+	~FreeListLocker()
+	{
+		freeListLock.clear( std::memory_order_release );
+	}
+} ;
+
+
+// has to be called with the free list locked
+static void addSlab()
+{
+	char * slab = static_cast<char *>( MemoryHelper::alignedMalloc(
+				bufferSize * BUFFERS_PER_SLAB, BUFFER_ALIGNMENT ) );
+	slabs.push_back( slab );
+	// reserve space for all buffers, so release() never reallocates
+	freeList.reserve( slabs.size() * BUFFERS_PER_SLAB );
+	for( int i = 0; i < BUFFERS_PER_SLAB; ++i )
+	{
+		freeList.push_back( slab + i * bufferSize );
+	}
+}
+
+
+static void * acquireBuffer()
+{
+	FreeListLocker locker;
+	if( freeList.empty() )
+	{
+		addSlab();
+	}
+	void * buf = freeList.back();
+	freeList.pop_back();
+	return buf;
+}
+
+
+static void releaseBuffer( void * buf )
+{
+	if( buf == NULL )
+	{
+		return;
+	}
+	FreeListLocker locker;
+	for( auto it = retiredSlabs.begin(); it != retiredSlabs.end(); ++it )
+	{
+		char * b = static_cast<char *>( buf );
+		if( b >= it->slab && b < it->slab + it->size )
+		{
+			if( --it->buffersInUse == 0 )
+			{
+				MemoryHelper::alignedFree( it->slab );
+				retiredSlabs.erase( it );
+			}
+			return;
+		}
+	}
+	freeList.push_back( buf );
+}
+
+
 
 void BufferManager::init( fpp_t framesPerPeriod )
 {
+	FreeListLocker locker;
+
+	// buffers of another size can't be reused. Slabs whose buffers are all
+	// free go right away, the others once their last buffer got released.
+	const size_t slabSize = bufferSize * BUFFERS_PER_SLAB;
+	for( char * slab : slabs )
+	{
+		int buffersInUse = BUFFERS_PER_SLAB;
+		for( void * buf : freeList )
+		{
+			char * b = static_cast<char *>( buf );
+			if( b >= slab && b < slab + slabSize )
+			{
+				--buffersInUse;
+			}
+		}
+		if( buffersInUse == 0 )
+		{
+			MemoryHelper::alignedFree( slab );
+		}
+		else
+		{
+			retiredSlabs.push_back( { slab, slabSize, buffersInUse } );
+		}
+	}
+	slabs.clear();
+	freeList.clear();
+
 	::framesPerPeriod = framesPerPeriod;
+	const size_t samplesPerLine = BUFFER_ALIGNMENT / sizeof( sample_t );
+	planarStride = ( framesPerPeriod + samplesPerLine - 1 ) / samplesPerLine * samplesPerLine;
+	// large enough for both layouts
+	bufferSize = 2 * planarStride * sizeof( sample_t );
+
+	addSlab();
 }
 
 
 sampleFrame * BufferManager::acquire()
 {
-	return MM_ALLOC( sampleFrame, ::framesPerPeriod );
+	return static_cast<sampleFrame *>( acquireBuffer() );
+}
+
+
+PlanarBuffer BufferManager::acquirePlanar()
+{
+	sample_t * buf = static_cast<sample_t *>( acquireBuffer() );
+	return PlanarBuffer( buf, buf + planarStride, ::framesPerPeriod );
 }
 
+
 void BufferManager::clear( sampleFrame *ab, const f_cnt_t frames, const f_cnt_t offset )
 {
 	memset( ab + offset, 0, sizeof( *ab ) * frames );
@@ -59,6 +223,12 @@ void BufferManager::clear( surroundSampleFrame * ab, const f_cnt_t frames,
 
 void BufferManager::release( sampleFrame * buf )
 {
-	MM_FREE( buf );
+	releaseBuffer( buf );
 }
 
+
+void BufferManager::release( const PlanarBuffer & buf )
+{
+	// the left channel starts the block
+	releaseBuffer( buf.left() );
+}
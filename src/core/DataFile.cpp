@@ -28,10 +28,12 @@
 
 #include <math.h>
 
+#include <QBuffer>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QXmlStreamReader>
 
 #include "base64.h"
 #include "ConfigManager.h"
@@ -40,6 +42,7 @@
 #include "GuiApplication.h"
 #include "LocaleHelper.h"
 #include "PluginFactory.h"
+#include "ProjectCache.h"
 #include "ProjectVersion.h"
 #include "SongEditor.h"
 #include "TextFloat.h"
@@ -93,9 +96,10 @@ DataFile::DataFile( Type type ) :
 
 
 DataFile::DataFile( const QString & _fileName ) :
-	QDomDocument(),
+	QDomDocument( "lmms-project" ),
 	m_content(),
-	m_head()
+	m_head(),
+	m_type( UnknownType )
 {
 	QFile inFile( _fileName );
 	if( !inFile.open( QIODevice::ReadOnly ) )
@@ -114,16 +118,46 @@ DataFile::DataFile( const QString & _fileName ) :
 		return;
 	}
 
-	loadData( inFile.readAll(), _fileName );
+	const QFileInfo fileInfo( inFile );
+	QString creatorVersion;
+	if( ProjectCache::load( fileInfo, *this, creatorVersion ) )
+	{
+		findHeadAndContent();
+		// the copy got upgraded already, but the user still wants to know
+		checkVersion( creatorVersion, _fileName );
+		return;
+	}
+
+	QString error;
+	if( !parse( inFile, error ) )
+	{
+		reportError( error, _fileName );
+		return;
+	}
+
+	findHeadAndContent();
+	creatorVersion = documentElement().attribute( "creatorversion" );
+	if( checkVersion( creatorVersion, _fileName ) )
+	{
+		upgrade();
+		// the upgrade routines may replace elements
+		findHeadAndContent();
+	}
+
+	if( m_type == SongProject || m_type == SongProjectTemplate )
+	{
+		ProjectCache::store( fileInfo, *this, creatorVersion );
+	}
 }
 
 
 
 
 DataFile::DataFile( const QByteArray & _data ) :
-	QDomDocument(),
+	QDomDocument( "lmms-project" ),
 	m_content(),
-	m_head()
+	m_head(),
+	m_type( UnknownType )
 {
 	loadData( _data, "<internal data>" );
 }
@@ -290,6 +324,7 @@ bool DataFile::writeFile( const QString& filename )
 		}
 		// move temporary file to current file
 		QFile::rename( fullNameTemp, fullName );
+		ProjectCache::remove( fullName );
 
 		return true;
 	}
@@ -1444,85 +1479,245 @@ void DataFile::upgrade()
 
 
 
-void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
+bool DataFile::isCompressed( const QByteArray & data )
 {
-	QString errorMsg;
-	int line = -1, col = -1;
-	if( !setContent( _data, &errorMsg, &line, &col ) )
+	// markup starts with '<', possibly after whitespace or a byte order mark
+	for( const char c : data )
 	{
-		// parsing failed? then try to uncompress data
-		QByteArray uncompressed = qUncompress( _data );
-		if( !uncompressed.isEmpty() )
+		if( c != ' ' && c != '\t' && c != '\r' && c != '\n' )
 		{
-			if( setContent( uncompressed, &errorMsg, &line, &col ) )
-			{
-				line = col = -1;
-			}
+			return c != '<' && c != '\xef';
 		}
-		if( line >= 0 && col >= 0 )
-		{
-			qWarning() << "at line" << line << "column" << errorMsg;
-			if( gui )
-			{
-				QMessageBox::critical( NULL,
-					SongEditor::tr( "Error in file" ),
-					SongEditor::tr( "The file %1 seems to contain "
-							"errors and therefore can't be "
-							"loaded." ).
-								arg( _sourceFile ) );
-			}
+	}
+	return false;
+}
 
-			return;
-		}
+
+
+
+bool DataFile::parse( QIODevice & device, QString & error )
+{
+	// compressed projects (mmpz) start with their uncompressed size, all
+	// others get parsed right from the device without reading it at once
+	const bool compressed = isCompressed( device.peek( 16 ) );
+	if( compressed ? parseCompressed( device, error ) :
+						parseXml( device, error ) )
+	{
+		return true;
 	}
 
-	QDomElement root = documentElement();
-	m_type = type( root.attribute( "type" ) );
-	m_head = root.elementsByTagName( "head" ).item( 0 ).toElement();
+	// the guess can be wrong, compressed data whose size starts with
+	// whitespace bytes may look like markup
+	QString otherError;
+	return device.seek( 0 ) && ( compressed ?
+					parseXml( device, otherError ) :
+					parseCompressed( device, otherError ) );
+}
+
 
 
-	if( root.hasAttribute( "creatorversion" ) )
+
+bool DataFile::parseCompressed( QIODevice & device, QString & error )
+{
+	// the compressed data of files only lives until it got uncompressed
+	QFile * file = qobject_cast<QFile *>( &device );
+	uchar * data = file ? file->map( 0, file->size() ) : NULL;
+	const QByteArray xml = data ? qUncompress( data, file->size() ) :
+						qUncompress( device.readAll() );
+	if( data )
 	{
-		// compareType defaults to Build,so it doesn't have to be set here
-		ProjectVersion createdWith = root.attribute( "creatorversion" );
-		ProjectVersion openedWith = LMMS_VERSION;
+		file->unmap( data );
+	}
 
-		if ( createdWith != openedWith )
+	if( xml.isEmpty() )
+	{
+		error = "could not uncompress the data";
+		return false;
+	}
+	QBuffer buffer;
+	buffer.setData( xml );
+	buffer.open( QIODevice::ReadOnly );
+	return parseXml( buffer, error );
+}
+
+
+
+
+bool DataFile::parseXml( QIODevice & device, QString & error )
+{
+	// build the document while reading, like setContent() does but
+	// without going through QXmlSimpleReader
+	QXmlStreamReader reader( &device );
+	reader.setNamespaceProcessing( false );
+	QDomNode parent = *this;
+	while( !reader.atEnd() )
+	{
+		switch( reader.readNext() )
 		{
-			// only one compareType needs to be set, and we can compare on one line because setCompareType returns ProjectVersion
-			if( createdWith.setCompareType( ProjectVersion::Minor )
-								!= openedWith )
+			case QXmlStreamReader::StartDocument:
+				if( !reader.documentVersion().isEmpty() )
+				{
+					appendChild( createProcessingInstruction( "xml",
+						QString( "version=\"%1\"" ).arg(
+							reader.documentVersion().toString() ) ) );
+				}
+				break;
+			case QXmlStreamReader::StartElement:
 			{
-				if( gui != nullptr && root.attribute( "type" ) == "song" )
+				QDomElement element = createElement(
+						reader.qualifiedName().toString() );
+				for( const QXmlStreamAttribute & attribute :
+							reader.attributes() )
 				{
-					TextFloat::displayMessage(
-						SongEditor::tr( "Version difference" ),
-						SongEditor::tr(
-							"This %1 was created with "
-							"LMMS %2."
-						).arg(
-							_sourceFile.endsWith( ".mpt" ) ?
-								SongEditor::tr( "template" ) :
-								SongEditor::tr( "project" )
-						)
-						.arg( root.attribute( "creatorversion" ) ),
-						embed::getIconPixmap( "whatsthis", 24, 24 ),
-						2500
-					);
+					element.setAttribute(
+						attribute.qualifiedName().toString(),
+						attribute.value().toString() );
 				}
+				parent = parent.appendChild( element );
+				break;
 			}
+			case QXmlStreamReader::EndElement:
+				parent = parent.parentNode();
+				break;
+			case QXmlStreamReader::Characters:
+				// whitespace between elements isn't kept, just like
+				// setContent() does
+				if( reader.isCDATA() )
+				{
+					parent.appendChild( createCDATASection(
+						reader.text().toString() ) );
+				}
+				else if( !reader.isWhitespace() )
+				{
+					parent.appendChild( createTextNode(
+						reader.text().toString() ) );
+				}
+				break;
+			case QXmlStreamReader::Comment:
+				parent.appendChild( createComment(
+						reader.text().toString() ) );
+				break;
+			case QXmlStreamReader::ProcessingInstruction:
+				parent.appendChild( createProcessingInstruction(
+					reader.processingInstructionTarget().toString(),
+					reader.processingInstructionData().toString() ) );
+				break;
+			default:
+				break;
+		}
+	}
 
-			// the upgrade needs to happen after the warning as it updates the project version.
-			if( createdWith.setCompareType( ProjectVersion::Build )
-								< openedWith )
-			{
-				upgrade();
-			}
+	if( reader.hasError() )
+	{
+		error = QString( "at line %1 column %2: %3" ).
+				arg( reader.lineNumber() ).
+				arg( reader.columnNumber() ).
+				arg( reader.errorString() );
+		// leave an empty document for another try
+		QDomDocument::operator=( QDomDocument( doctype().name() ) );
+		return false;
+	}
+	return true;
+}
+
+
+
+
+void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
+{
+	QBuffer buffer;
+	buffer.setData( _data );
+	buffer.open( QIODevice::ReadOnly );
+
+	QString error;
+	if( !parse( buffer, error ) )
+	{
+		reportError( error, _sourceFile );
+		return;
+	}
+
+	findHeadAndContent();
+	if( checkVersion( documentElement().attribute( "creatorversion" ),
+								_sourceFile ) )
+	{
+		upgrade();
+		// the upgrade routines may replace elements
+		findHeadAndContent();
+	}
+}
+
+
+
+
+void DataFile::reportError( const QString & error, const QString & sourceFile )
+{
+	qWarning() << sourceFile << error;
+	if( gui )
+	{
+		QMessageBox::critical( NULL,
+			SongEditor::tr( "Error in file" ),
+			SongEditor::tr( "The file %1 seems to contain "
+					"errors and therefore can't be "
+					"loaded." ).
+						arg( sourceFile ) );
+	}
+}
+
+
+
+
+bool DataFile::checkVersion( const QString & creatorVersion,
+					const QString & sourceFile ) const
+{
+	if( creatorVersion.isEmpty() )
+	{
+		return false;
+	}
+
+	// compareType defaults to Build,so it doesn't have to be set here
+	ProjectVersion createdWith = creatorVersion;
+	ProjectVersion openedWith = LMMS_VERSION;
+
+	if( createdWith == openedWith )
+	{
+		return false;
+	}
+
+	// only one compareType needs to be set, and we can compare on one line because setCompareType returns ProjectVersion
+	if( createdWith.setCompareType( ProjectVersion::Minor ) != openedWith )
+	{
+		if( gui != nullptr && documentElement().attribute( "type" ) == "song" )
+		{
+			TextFloat::displayMessage(
+				SongEditor::tr( "Version difference" ),
+				SongEditor::tr(
+					"This %1 was created with "
+					"LMMS %2."
+				).arg(
+					sourceFile.endsWith( ".mpt" ) ?
+						SongEditor::tr( "template" ) :
+						SongEditor::tr( "project" )
+				)
+				.arg( creatorVersion ),
+				embed::getIconPixmap( "whatsthis", 24, 24 ),
+				2500
+			);
 		}
 	}
 
-	m_content = root.elementsByTagName( typeName( m_type ) ).
-							item( 0 ).toElement();
+	// the upgrade needs to happen after the warning as it updates the project version.
+	return createdWith.setCompareType( ProjectVersion::Build ) < openedWith;
+}
+
+
+
+
+void DataFile::findHeadAndContent()
+{
+	QDomElement root = documentElement();
+	m_type = type( root.attribute( "type" ) );
+	m_head = root.firstChildElement( "head" );
+	m_content = root.firstChildElement( typeName( m_type ) );
 }
 
 
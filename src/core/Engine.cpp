@@ -31,6 +31,7 @@
 #include "Mixer.h"
 #include "PresetPreviewPlayHandle.h"
 #include "ProjectJournal.h"
+#include "SampleBuffer.h"
 #include "Song.h"
 #include "BandLimitedWave.h"
 
@@ -55,6 +56,7 @@ void LmmsCore::init( bool renderOnly )
 	BandLimitedWave::generateWaves();
 
 	emit engine->initProgress(tr("Initializing data structures"));
+	SampleBuffer::initCacheDirectory();
 	s_projectJournal = new ProjectJournal;
 	s_mixer = new Mixer( renderOnly );
 	s_song = new Song;
@@ -24,6 +24,9 @@
 
 #include <QDomElement>
 
+#include <cstring>
+
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "FxMixer.h"
 #include "Mixer.h"
@@ -63,15 +66,15 @@ FxChannel::FxChannel( int idx, Model * _parent ) :
 	m_stillRunning( false ),
 	m_peakLeft( 0.0f ),
 	m_peakRight( 0.0f ),
-	m_buffer( new sampleFrame[Engine::mixer()->framesPerPeriod()] ),
+	m_buffer( BufferManager::acquire() ),
+	m_planarBuffer( BufferManager::acquirePlanar() ),
 	m_muteModel( false, _parent ),
 	m_soloModel( false, _parent ),
 	m_volumeModel( 1.0, 0.0, 2.0, 0.001, _parent ),
 	m_name(),
-	m_lock(),
 	m_channelIndex( idx ),
-	m_queued( false ),
-	m_dependenciesMet(0)
+	m_muted( false ),
+	m_pendingDependencies( 0 )
 {
 	BufferManager::clear( m_buffer, Engine::mixer()->framesPerPeriod() );
 }
@@ -81,7 +84,9 @@ FxChannel::FxChannel( int idx, Model * _parent ) :
 
 FxChannel::~FxChannel()
 {
-	delete[] m_buffer;
+	resizePartialSums( 0 );
+	BufferManager::release( m_planarBuffer );
+	BufferManager::release( m_buffer );
 }
 
 
@@ -91,21 +96,49 @@ inline void FxChannel::processed()
 	{
 		if( receiverRoute->receiver()->m_muted == false )
 		{
-			receiverRoute->receiver()->incrementDeps();
+			receiverRoute->receiver()->resolveDependency();
 		}
 	}
 }
 
-void FxChannel::incrementDeps()
+void FxChannel::resolveDependency()
 {
-	int i = m_dependenciesMet++ + 1;
-	if( i >= m_receives.size() && ! m_queued )
+	// whoever resolves the last dependency queues us
+	if( m_pendingDependencies.fetch_sub( 1 ) == 1 )
 	{
-		m_queued = true;
 		MixerWorkerThread::addJob( this );
 	}
 }
 
+void FxChannel::resizePartialSums( int workers )
+{
+	while( m_partialSums.size() > (size_t) workers )
+	{
+		BufferManager::release( m_partialSums.back().buffer );
+		m_partialSums.pop_back();
+	}
+	while( m_partialSums.size() < (size_t) workers )
+	{
+		m_partialSums.push_back( { BufferManager::acquire(), false } );
+	}
+}
+
+void FxChannel::mixPartialSums()
+{
+	const fpp_t fpp = Engine::mixer()->framesPerPeriod();
+	// silent ports never reach the partial sums, so workers which only
+	// processed silent ports are skipped here
+	for( PartialSum & sum : m_partialSums )
+	{
+		if( sum.used )
+		{
+			MixHelpers::add( m_buffer, sum.buffer, fpp );
+			sum.used = false;
+			m_hasInput = true;
+		}
+	}
+}
+
 void FxChannel::unmuteForSolo()
 {
 	//TODO: Recursively activate every channel, this channel sends to
@@ -114,51 +147,75 @@ void FxChannel::unmuteForSolo()
 
 
 
+ThreadableJob::ProfilingTarget FxChannel::profilingTarget() const
+{
+	return { this, m_name, "FX channel" };
+}
+
+
+
 void FxChannel::doProcessing()
 {
 	const fpp_t fpp = Engine::mixer()->framesPerPeriod();
 
 	if( m_muted == false )
 	{
+		mixPartialSums();
+
+		bool receivedSends = false;
 		for( FxRoute * senderRoute : m_receives )
 		{
 			FxChannel * sender = senderRoute->sender();
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if( sender->m_hasInput || sender->m_stillRunning )
+			// muted senders weren't processed, so their planar buffer
+			// is out of date
+			if( sender->m_muted == false &&
+				( sender->m_hasInput || sender->m_stillRunning ) )
 			{
+				if( receivedSends == false )
+				{
+					m_planarBuffer.deinterleave( m_buffer );
+					receivedSends = true;
+				}
+
 				// figure out if we're getting sample-exact input
 				ValueBuffer * sendBuf = sendModel->valueBuffer();
 				ValueBuffer * volBuf = sender->m_volumeModel.valueBuffer();
 
 				// mix it's output with this one's output
-				sampleFrame * ch_buf = sender->m_buffer;
+				const PlanarBuffer & ch_buf = sender->m_planarBuffer;
 
 				// use sample-exact mixing if sample-exact values are available
 				if( ! volBuf && ! sendBuf ) // neither volume nor send has sample-exact data...
 				{
 					const float v = sender->m_volumeModel.value() * sendModel->value();
-					MixHelpers::addSanitizedMultiplied( m_buffer, ch_buf, v, fpp );
+					MixHelpers::addSanitizedMultiplied( m_planarBuffer, ch_buf, v, fpp );
 				}
 				else if( volBuf && sendBuf ) // both volume and send have sample-exact data
 				{
-					MixHelpers::addSanitizedMultipliedByBuffers( m_buffer, ch_buf, volBuf, sendBuf, fpp );
+					MixHelpers::addSanitizedMultipliedByBuffers( m_planarBuffer, ch_buf, volBuf, sendBuf, fpp );
 				}
 				else if( volBuf ) // volume has sample-exact data but send does not
 				{
 					const float v = sendModel->value();
-					MixHelpers::addSanitizedMultipliedByBuffer( m_buffer, ch_buf, v, volBuf, fpp );
+					MixHelpers::addSanitizedMultipliedByBuffer( m_planarBuffer, ch_buf, v, volBuf, fpp );
 				}
 				else // vice versa
 				{
 					const float v = sender->m_volumeModel.value();
-					MixHelpers::addSanitizedMultipliedByBuffer( m_buffer, ch_buf, v, sendBuf, fpp );
+					MixHelpers::addSanitizedMultipliedByBuffer( m_planarBuffer, ch_buf, v, sendBuf, fpp );
 				}
 				m_hasInput = true;
 			}
 		}
 
+		if( receivedSends )
+		{
+			m_planarBuffer.interleave( m_buffer );
+		}
+
 
 		const float v = m_volumeModel.value();
 
@@ -173,14 +230,21 @@ void FxChannel::doProcessing()
 		Mixer::StereoSample peakSamples = Engine::mixer()->getPeakValues(m_buffer, fpp);
 		m_peakLeft = qMax( m_peakLeft, peakSamples.left * v );
 		m_peakRight = qMax( m_peakRight, peakSamples.right * v );
+
+		// receivers only mix senders with input or running effects
+		if( ( m_hasInput || m_stillRunning ) && m_sends.isEmpty() == false )
+		{
+			m_planarBuffer.deinterleave( m_buffer );
+		}
+
+		// resolve dependency of all receivers - muted channels are
+		// not counted as dependencies in the first place
+		processed();
 	}
 	else
 	{
 		m_peakLeft = m_peakRight = 0.0f;
 	}
-
-	// increment dependency counter of all receivers
-	processed();
 }
 
 
@@ -188,7 +252,9 @@ void FxChannel::doProcessing()
 FxMixer::FxMixer() :
 	Model( NULL ),
 	JournallingObject(),
-	m_fxChannels()
+	m_fxChannels(),
+	m_graphOrder(),
+	m_graphDirty( true )
 {
 	// create master channel
 	createChannel();
@@ -218,6 +284,7 @@ int FxMixer::createChannel()
 	const int index = m_fxChannels.size();
 	// create new channel
 	m_fxChannels.push_back( new FxChannel( index, this ) );
+	m_graphDirty = true;
 
 	// reset channel state
 	clearChannel( index );
@@ -321,6 +388,7 @@ void FxMixer::deleteChannel( int index )
 
 	// actually delete the channel
 	m_fxChannels.remove(index);
+	m_graphDirty = true;
 	delete ch;
 
 	for( int i = index; i < m_fxChannels.size(); ++i )
@@ -439,6 +507,7 @@ FxRoute * FxMixer::createRoute( FxChannel * from, FxChannel * to, float amount )
 
 	// add us to fxmixer's list
 	Engine::fxMixer()->m_fxRoutes.append( route );
+	m_graphDirty = true;
 	Engine::mixer()->doneChangeInModel();
 
 	return route;
@@ -473,6 +542,7 @@ void FxMixer::deleteChannelSend( FxRoute * route )
 	route->receiver()->m_receives.remove( route->receiver()->m_receives.indexOf( route ) );
 	// remove us from fxmixer's list
 	Engine::fxMixer()->m_fxRoutes.remove( Engine::fxMixer()->m_fxRoutes.indexOf( route ) );
+	m_graphDirty = true;
 	delete route;
 	Engine::mixer()->doneChangeInModel();
 }
@@ -541,12 +611,23 @@ FloatModel * FxMixer::channelSendModel( fx_ch_t fromChannel, fx_ch_t toChannel )
 
 void FxMixer::mixToChannel( const sampleFrame * _buf, fx_ch_t _ch )
 {
-	if( m_fxChannels[_ch]->m_muteModel.value() == false )
+	FxChannel * channel = m_fxChannels[_ch];
+	if( channel->m_muted == false )
 	{
-		m_fxChannels[_ch]->m_lock.lock();
-		MixHelpers::add( m_fxChannels[_ch]->m_buffer, _buf, Engine::mixer()->framesPerPeriod() );
-		m_fxChannels[_ch]->m_hasInput = true;
-		m_fxChannels[_ch]->m_lock.unlock();
+		// nobody else writes to the sum of this worker, and the channel
+		// only reads it after all of its ports are done
+		FxChannel::PartialSum & sum =
+			channel->m_partialSums[MixerWorkerThread::currentWorker()];
+		const fpp_t fpp = Engine::mixer()->framesPerPeriod();
+		if( sum.used )
+		{
+			MixHelpers::add( sum.buffer, _buf, fpp );
+		}
+		else
+		{
+			memcpy( sum.buffer, _buf, sizeof( sampleFrame ) * fpp );
+			sum.used = true;
+		}
 	}
 }
 
@@ -561,51 +642,110 @@ void FxMixer::prepareMasterMix()
 
 
 
-void FxMixer::masterMix( sampleFrame * _buf )
+void FxMixer::rebuildGraph()
 {
-	const int fpp = Engine::mixer()->framesPerPeriod();
-
-	// add the channels that have no dependencies (no incoming senders, ie.
-	// no receives) to the jobqueue. The channels that have receives get
-	// added when their senders get processed, which is detected by
-	// dependency counting.
-	// also instantly add all muted channels as they don't need to care
-	// about their senders, and can just increment the deps of their
-	// recipients right away.
-	MixerWorkerThread::resetJobQueue( MixerWorkerThread::JobQueue::Dynamic );
+	// Kahn's algorithm: start with all channels without senders and
+	// append every receiver once all of its senders have been appended
+	QVector<int> pendingSenders( m_fxChannels.size() );
+	m_graphOrder.clear();
 	for( FxChannel * ch : m_fxChannels )
 	{
-		ch->m_muted = ch->m_muteModel.value();
-		if( ch->m_muted ) // instantly "process" muted channels
+		pendingSenders[ch->m_channelIndex] = ch->m_receives.size();
+		if( ch->m_receives.isEmpty() )
+		{
+			m_graphOrder.append( ch );
+		}
+	}
+
+	for( int i = 0; i < m_graphOrder.size(); ++i )
+	{
+		for( const FxRoute * route : m_graphOrder[i]->m_sends )
 		{
-			ch->processed();
-			ch->done();
+			FxChannel * receiver = route->receiver();
+			if( --pendingSenders[receiver->m_channelIndex] == 0 )
+			{
+				m_graphOrder.append( receiver );
+			}
 		}
-		else if( ch->m_receives.size() == 0 )
+	}
+
+	m_graphDirty = false;
+}
+
+
+
+
+void FxMixer::processChannels( const QVector<AudioPort *> & _ports )
+{
+	if( m_graphDirty )
+	{
+		rebuildGraph();
+	}
+
+	const int workers = MixerWorkerThread::workerCount();
+	for( FxChannel * ch : m_graphOrder )
+	{
+		ch->m_muted = ch->m_muteModel.value();
+		if( ch->m_partialSums.size() != (size_t) workers )
 		{
-			ch->m_queued = true;
-			MixerWorkerThread::addJob( ch );
+			ch->resizePartialSums( workers );
 		}
 	}
-	while (m_fxChannels[0]->state() != ThreadableJob::ProcessingState::Done)
+
+	// muted channels neither wait for anything nor are they waited for,
+	// all other channels wait for their unmuted senders...
+	for( FxChannel * ch : m_graphOrder )
 	{
-		bool found = false;
-		for( FxChannel * ch : m_fxChannels )
+		int dependencies = 0;
+		if( ch->m_muted == false )
 		{
-			const auto s = ch->state();
-			if (s == ThreadableJob::ProcessingState::Queued
-				|| s == ThreadableJob::ProcessingState::InProgress)
+			for( const FxRoute * route : ch->m_receives )
 			{
-				found = true;
-				break;
+				if( route->sender()->m_muted == false )
+				{
+					++dependencies;
+				}
 			}
 		}
-		if( !found )
+		ch->m_pendingDependencies = dependencies;
+	}
+
+	// ...and for all audio ports feeding them
+	for( AudioPort * port : _ports )
+	{
+		const fx_ch_t ch = port->nextFxChannel();
+		port->m_pendingFxChannel = NULL;
+		if( ch < m_fxChannels.size() && m_fxChannels[ch]->m_muted == false )
 		{
-			break;
+			port->m_pendingFxChannel = m_fxChannels[ch];
+			++port->m_pendingFxChannel->m_pendingDependencies;
+		}
+	}
+
+	// queue channels without dependencies before any port, as ports may
+	// start resolving dependencies as soon as they are queued
+	MixerWorkerThread::resetJobQueue( MixerWorkerThread::JobQueue::Dynamic );
+	for( FxChannel * ch : m_graphOrder )
+	{
+		if( ch->m_pendingDependencies == 0 )
+		{
+			MixerWorkerThread::addJob( ch );
 		}
-		MixerWorkerThread::startAndWaitForJobs();
 	}
+	for( AudioPort * port : _ports )
+	{
+		MixerWorkerThread::addJob( port );
+	}
+
+	MixerWorkerThread::startAndWaitForJobs();
+}
+
+
+
+
+void FxMixer::masterMix( sampleFrame * _buf )
+{
+	const int fpp = Engine::mixer()->framesPerPeriod();
 
 	// handle sample-exact data in master volume fader
 	ValueBuffer * volBuf = m_fxChannels[0]->m_volumeModel.valueBuffer();
@@ -631,10 +771,8 @@ void FxMixer::masterMix( sampleFrame * _buf )
 		BufferManager::clear( m_fxChannels[i]->m_buffer,
 				Engine::mixer()->framesPerPeriod() );
 		m_fxChannels[i]->reset();
-		m_fxChannels[i]->m_queued = false;
 		// also reset hasInput
 		m_fxChannels[i]->m_hasInput = false;
-		m_fxChannels[i]->m_dependenciesMet = 0;
 	}
 }
 
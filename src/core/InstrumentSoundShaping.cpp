@@ -38,7 +38,6 @@
 
 const float CUT_FREQ_MULTIPLIER = 6000.0f;
 const float RES_MULTIPLIER = 2.0f;
-const float RES_PRECISION = 1000.0f;
 
 
 // names for env- and lfo-targets - first is name being displayed to user
@@ -145,104 +144,62 @@ void InstrumentSoundShaping::processAudioBuffer( sampleFrame* buffer,
 		envReleaseBegin += frames;
 	}
 
-	// because of optimizations, there's special code for several cases:
-	// 	- cut- and res-lfo/envelope active
-	// 	- cut-lfo/envelope active
-	// 	- res-lfo/envelope active
-	//	- no lfo/envelope active but filter is used
+	// the filter only follows cut- and res-lfo/envelope if either is
+	// active, otherwise it runs with fixed coefficients
 
 	// only use filter, if it is really needed
 
 	if( m_filterEnabledModel.value() )
 	{
-		QVarLengthArray<float> cutBuffer(frames);
-		QVarLengthArray<float> resBuffer(frames);
-
-		int old_filter_cut = 0;
-		int old_filter_res = 0;
-
 		if( n->m_filter == nullptr )
 		{
 			n->m_filter = make_unique<BasicFilters<>>( Engine::mixer()->processingSampleRate() );
 		}
 		n->m_filter->setFilterType( m_filterModel.value() );
 
-		if( m_envLfoParameters[Cut]->isUsed() )
-		{
-			m_envLfoParameters[Cut]->fillLevel( cutBuffer.data(), envTotalFrames, envReleaseBegin, frames );
-		}
-		if( m_envLfoParameters[Resonance]->isUsed() )
-		{
-			m_envLfoParameters[Resonance]->fillLevel( resBuffer.data(), envTotalFrames, envReleaseBegin, frames );
-		}
-
 		const float fcv = m_filterCutModel.value();
 		const float frv = m_filterResModel.value();
 
-		if( m_envLfoParameters[Cut]->isUsed() &&
+		if( m_envLfoParameters[Cut]->isUsed() ||
 			m_envLfoParameters[Resonance]->isUsed() )
 		{
-			for( fpp_t frame = 0; frame < frames; ++frame )
+			QVarLengthArray<float> cutBuffer(frames);
+			QVarLengthArray<float> resBuffer(frames);
+			const float * cut = &fcv;
+			const float * res = &frv;
+			int cutInc = 0;
+			int resInc = 0;
+
+			if( m_envLfoParameters[Cut]->isUsed() )
 			{
-				const float new_cut_val = EnvelopeAndLfoParameters::expKnobVal( cutBuffer[frame] ) *
-								CUT_FREQ_MULTIPLIER + fcv;
-
-				const float new_res_val = frv + RES_MULTIPLIER * resBuffer[frame];
-
-				if( static_cast<int>( new_cut_val ) != old_filter_cut ||
-					static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res )
+				m_envLfoParameters[Cut]->fillLevel( cutBuffer.data(), envTotalFrames, envReleaseBegin, frames );
+				for( fpp_t frame = 0; frame < frames; ++frame )
 				{
-					n->m_filter->calcFilterCoeffs( new_cut_val, new_res_val );
-					old_filter_cut = static_cast<int>( new_cut_val );
-					old_filter_res = static_cast<int>( new_res_val*RES_PRECISION );
-				}
-
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
-			}
-		}
-		else if( m_envLfoParameters[Cut]->isUsed() )
-		{
-			for( fpp_t frame = 0; frame < frames; ++frame )
-			{
-				float new_cut_val = EnvelopeAndLfoParameters::expKnobVal( cutBuffer[frame] ) *
+					cutBuffer[frame] = EnvelopeAndLfoParameters::expKnobVal( cutBuffer[frame] ) *
 								CUT_FREQ_MULTIPLIER + fcv;
-
-				if( static_cast<int>( new_cut_val ) != old_filter_cut )
-				{
-					n->m_filter->calcFilterCoeffs( new_cut_val, frv );
-					old_filter_cut = static_cast<int>( new_cut_val );
 				}
-
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
+				cut = cutBuffer.data();
+				cutInc = 1;
 			}
-		}
-		else if( m_envLfoParameters[Resonance]->isUsed() )
-		{
-			for( fpp_t frame = 0; frame < frames; ++frame )
+			if( m_envLfoParameters[Resonance]->isUsed() )
 			{
-				float new_res_val = frv + RES_MULTIPLIER * resBuffer[frame];
-
-				if( static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res )
+				m_envLfoParameters[Resonance]->fillLevel( resBuffer.data(), envTotalFrames, envReleaseBegin, frames );
+				for( fpp_t frame = 0; frame < frames; ++frame )
 				{
-					n->m_filter->calcFilterCoeffs( fcv, new_res_val );
-					old_filter_res = static_cast<int>( new_res_val*RES_PRECISION );
+					resBuffer[frame] = frv + RES_MULTIPLIER * resBuffer[frame];
 				}
-
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
+				res = resBuffer.data();
+				resInc = 1;
 			}
+
+			// coefficients get interpolated across the buffer instead
+			// of being recalculated whenever the cutoff changes
+			n->m_filter->processBuffer( buffer, frames, cut, cutInc, res, resInc );
 		}
 		else
 		{
 			n->m_filter->calcFilterCoeffs( fcv, frv );
-
-			for( fpp_t frame = 0; frame < frames; ++frame )
-			{
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
-			}
+			n->m_filter->processBuffer( buffer, frames );
 		}
 	}
 
@@ -31,16 +31,29 @@
  * @param byteNum is the number of bytes
  */
 void* MemoryHelper::alignedMalloc( size_t byteNum )
+{
+	return alignedMalloc( byteNum, ALIGN_SIZE );
+}
+
+
+
+
+/**
+ * Allocate a number of bytes aligned to given boundary and return them.
+ * @param byteNum is the number of bytes
+ * @param alignment is the alignment in bytes, a power of two
+ */
+void* MemoryHelper::alignedMalloc( size_t byteNum, size_t alignment )
 {
 	char *ptr, *ptr2, *aligned_ptr;
-	int align_mask = ALIGN_SIZE - 1;
+	size_t align_mask = alignment - 1;
 
-	ptr = static_cast<char*>( malloc( byteNum + ALIGN_SIZE + sizeof( int ) ) );
+	ptr = static_cast<char*>( malloc( byteNum + alignment + sizeof( int ) ) );
 
 	if( ptr == NULL ) return NULL;
 
 	ptr2 = ptr + sizeof( int );
-	aligned_ptr = ptr2 + ( ALIGN_SIZE - ( ( size_t ) ptr2 & align_mask ) );
+	aligned_ptr = ptr2 + ( alignment - ( ( size_t ) ptr2 & align_mask ) );
 
 	ptr2 = aligned_ptr - sizeof( int );
 	*( ( int* ) ptr2 ) = ( int )( aligned_ptr - ptr );
@@ -25,9 +25,14 @@
 
 #include "MemoryManager.h"
 
+#include <atomic>
+
 #include <QtCore/QtGlobal>
 #include "rpmalloc.h"
 
+static std::atomic<bool> s_countAllocations(false);
+static std::atomic<long long> s_allocationCount(0);
+
 /// Global static object handling rpmalloc intializing and finalizing
 struct MemoryManagerGlobalGuard {
 	MemoryManagerGlobalGuard() {
@@ -65,6 +70,10 @@ void* MemoryManager::alloc(size_t size)
 	// Compilers may optimize the instance away otherwise.
 	Q_UNUSED(&local_mm_thread_guard);
 	Q_ASSERT_X(rpmalloc_is_thread_initialized(), "MemoryManager::alloc", "Thread not initialized");
+	if (s_countAllocations.load(std::memory_order_relaxed))
+	{
+		s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	}
 	return rpmalloc(size);
 }
 
@@ -75,3 +84,15 @@ void MemoryManager::free(void * ptr)
 	Q_ASSERT_X(rpmalloc_is_thread_initialized(), "MemoryManager::free", "Thread not initialized");
 	return rpfree(ptr);
 }
+
+
+void MemoryManager::setCountingAllocations(bool enabled)
+{
+	s_countAllocations.store(enabled, std::memory_order_relaxed);
+}
+
+
+long long MemoryManager::allocationCount()
+{
+	return s_allocationCount.load(std::memory_order_relaxed);
+}
@@ -23,9 +23,21 @@
  */
 
 #include "MixHelpers.h"
+#include "MixHelpersKernels.h"
 #include "lmms_math.h"
+#include "PlanarBuffer.h"
 #include "ValueBuffer.h"
 
+#include <cfloat>
+
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
 
 namespace MixHelpers
 {
@@ -52,8 +64,12 @@ static inline void run( sampleFrame* dst, const sample_t* srcLeft, const sample_
 }
 
 
+/*! \brief Reference implementations, used if the CPU has no suitable vector
+ *         instructions and for the frames the vector kernels leave over */
+namespace Generic
+{
 
-bool isSilent( const sampleFrame* src, int frames )
+static bool isSilent( const sampleFrame* src, int frames )
 {
 	const float silenceThreshold = 0.0000001f;
 
@@ -70,7 +86,7 @@ bool isSilent( const sampleFrame* src, int frames )
 
 
 /*! \brief Function for sanitizing a buffer of infs/nans - returns true if those are found */
-bool sanitize( sampleFrame * src, int frames )
+static bool sanitize( sampleFrame * src, int frames )
 {
 	bool found = false;
 	for( int f = 0; f < frames; ++f )
@@ -101,7 +117,7 @@ struct AddOp
 	}
 } ;
 
-void add( sampleFrame* dst, const sampleFrame* src, int frames )
+static void add( sampleFrame* dst, const sampleFrame* src, int frames )
 {
 	run<>( dst, src, frames, AddOp() );
 }
@@ -122,69 +138,50 @@ struct AddMultipliedOp
 } ;
 
 
-void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+static void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, AddMultipliedOp(coeffSrc) );
 }
 
 
-struct AddSwappedMultipliedOp
-{
-	AddSwappedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
-
-	void operator()( sampleFrame& dst, const sampleFrame& src ) const
-	{
-		dst[0] += src[1] * m_coeff;
-		dst[1] += src[0] * m_coeff;
-	}
-
-	const float m_coeff;
-};
-
-void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
-{
-	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
-}
-
-
-void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+static void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
 {
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf[f];
 	}
 }
 
-void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+static void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
 {
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+		dst[f][0] += src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+		dst[f][1] += src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
 	}
 
 }
 
-void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+static void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
 {
 	for( int f = 0; f < frames; ++f )
 	{
-		dst[f][0] += ( isinf( src[f][0] ) || isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += ( isinf( src[f][1] ) || isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		dst[f][0] += ( isinf( src[f][0] ) || isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += ( isinf( src[f][1] ) || isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf[f];
 	}
 }
 
-void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+static void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
 {
 	for( int f = 0; f < frames; ++f )
 	{
 		dst[f][0] += ( isinf( src[f][0] ) || isnan( src[f][0] ) )
 			? 0.0f
-			: src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+			: src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
 		dst[f][1] += ( isinf( src[f][1] ) || isnan( src[f][1] ) )
 			? 0.0f
-			: src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+			: src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
 	}
 
 }
@@ -203,7 +200,7 @@ struct AddSanitizedMultipliedOp
 	const float m_coeff;
 };
 
-void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+static void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
 }
@@ -228,7 +225,7 @@ struct AddMultipliedStereoOp
 } ;
 
 
-void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
+static void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
 {
 
 	run<>( dst, src, frames, AddMultipliedStereoOp(coeffSrcLeft, coeffSrcRight) );
@@ -256,14 +253,14 @@ struct MultiplyAndAddMultipliedOp
 } ;
 
 
-void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
+static void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
 }
 
 
 
-void multiplyAndAddMultipliedJoined( sampleFrame* dst,
+static void multiplyAndAddMultipliedJoined( sampleFrame* dst,
 										const sample_t* srcLeft,
 										const sample_t* srcRight,
 										float coeffDst, float coeffSrc, int frames )
@@ -271,5 +268,340 @@ void multiplyAndAddMultipliedJoined( sampleFrame* dst,
 	run<>( dst, srcLeft, srcRight, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
 }
 
+} // namespace Generic
+
+
+
+const Kernels genericKernels = {
+	Generic::isSilent,
+	Generic::sanitize,
+	Generic::add,
+	Generic::addMultiplied,
+	Generic::addMultipliedByBuffer,
+	Generic::addMultipliedByBuffers,
+	Generic::addSanitizedMultiplied,
+	Generic::addSanitizedMultipliedByBuffer,
+	Generic::addSanitizedMultipliedByBuffers,
+	Generic::addMultipliedStereo,
+	Generic::multiplyAndAddMultiplied,
+	Generic::multiplyAndAddMultipliedJoined
+};
+
+
+
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+static void cpuid( unsigned int leaf, unsigned int regs[4] )
+{
+#ifdef _MSC_VER
+	__cpuidex( reinterpret_cast<int *>( regs ), leaf, 0 );
+#else
+	__cpuid_count( leaf, 0, regs[0], regs[1], regs[2], regs[3] );
+#endif
+}
+
+// state components the OS saves on context switches
+static unsigned long long xgetbv()
+{
+#ifdef _MSC_VER
+	return _xgetbv( 0 );
+#else
+	unsigned int eax, edx;
+	__asm__( "xgetbv" : "=a" ( eax ), "=d" ( edx ) : "c" ( 0 ) );
+	return ( (unsigned long long) edx << 32 ) | eax;
+#endif
+}
+#endif
+
+
+bool isSupported( InstructionSet set )
+{
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+	unsigned int regs[4];
+	cpuid( 0, regs );
+	const unsigned int maxLeaf = regs[0];
+
+	cpuid( 1, regs );
+	const bool sse2 = regs[3] & ( 1 << 26 );
+	const bool osxsave = regs[2] & ( 1 << 27 );
+	const bool avx = regs[2] & ( 1 << 28 );
+
+	// YMM and ZMM registers have to be enabled by the OS too
+	const unsigned long long xcr0 = osxsave ? xgetbv() : 0;
+	const bool osAvx = ( xcr0 & 0x06 ) == 0x06;
+	const bool osAvx512 = ( xcr0 & 0xe6 ) == 0xe6;
+
+	unsigned int ebx7 = 0;
+	if( maxLeaf >= 7 )
+	{
+		cpuid( 7, regs );
+		ebx7 = regs[1];
+	}
+
+	switch( set )
+	{
+	case InstructionSet::Generic:
+		return true;
+	case InstructionSet::SSE2:
+		return sse2;
+	case InstructionSet::AVX2:
+		return avx && osAvx && ( ebx7 & ( 1 << 5 ) );
+	case InstructionSet::AVX512:
+		return avx && osAvx512 && ( ebx7 & ( 1 << 16 ) );
+	}
+	return false;
+#else
+	return set == InstructionSet::Generic;
+#endif
+}
+
+
+static const Kernels * kernelsFor( InstructionSet set )
+{
+	switch( set )
+	{
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+	case InstructionSet::SSE2:
+		return &sse2Kernels;
+	case InstructionSet::AVX2:
+		return &avx2Kernels;
+	case InstructionSet::AVX512:
+		return &avx512Kernels;
+#endif
+	default:
+		return &genericKernels;
+	}
+}
+
+
+static InstructionSet bestInstructionSet()
+{
+	const InstructionSet sets[] = {
+		InstructionSet::AVX512,
+		InstructionSet::AVX2,
+		InstructionSet::SSE2
+	};
+	for( InstructionSet set : sets )
+	{
+		if( isSupported( set ) )
+		{
+			return set;
+		}
+	}
+	return InstructionSet::Generic;
+}
+
+
+// picked once at startup, the kernels are called for every buffer
+static InstructionSet s_instructionSet = bestInstructionSet();
+static const Kernels * s_kernels = kernelsFor( s_instructionSet );
+
+
+InstructionSet instructionSet()
+{
+	return s_instructionSet;
+}
+
+
+bool setInstructionSet( InstructionSet set )
+{
+	if( isSupported( set ) == false )
+	{
+		return false;
+	}
+	s_instructionSet = set;
+	s_kernels = kernelsFor( set );
+	return true;
+}
+
+
+
+bool isSilent( const sampleFrame* src, int frames )
+{
+	return s_kernels->isSilent( src, frames );
+}
+
+
+bool sanitize( sampleFrame * src, int frames )
+{
+	return s_kernels->sanitize( src, frames );
+}
+
+
+void add( sampleFrame* dst, const sampleFrame* src, int frames )
+{
+	s_kernels->add( dst, src, frames );
+}
+
+
+void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	s_kernels->addMultiplied( dst, src, coeffSrc, frames );
+}
+
+
+struct AddSwappedMultipliedOp
+{
+	AddSwappedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
+
+	void operator()( sampleFrame& dst, const sampleFrame& src ) const
+	{
+		dst[0] += src[1] * m_coeff;
+		dst[1] += src[0] * m_coeff;
+	}
+
+	const float m_coeff;
+};
+
+void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
+}
+
+
+void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	s_kernels->addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+
+void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	s_kernels->addMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+
+void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
+{
+	s_kernels->addSanitizedMultiplied( dst, src, coeffSrc, frames );
+}
+
+
+void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	s_kernels->addSanitizedMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+
+void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	s_kernels->addSanitizedMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+
+void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
+{
+	s_kernels->addMultipliedStereo( dst, src, coeffSrcLeft, coeffSrcRight, frames );
+}
+
+
+void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
+{
+	s_kernels->multiplyAndAddMultiplied( dst, src, coeffDst, coeffSrc, frames );
+}
+
+
+void multiplyAndAddMultipliedJoined( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames )
+{
+	s_kernels->multiplyAndAddMultipliedJoined( dst, srcLeft, srcRight, coeffDst, coeffSrc, frames );
+}
+
+
+
+// Planar buffers have contiguous channels, so these plain loops are
+// vectorized by the compiler. Infs and NaNs are detected by comparing against
+// FLT_MAX, which vectorizes unlike isinf()/isnan().
+
+bool isSilent( const PlanarBuffer& src, int frames )
+{
+	const float silenceThreshold = 0.0000001f;
+
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		const sample_t * s = src.channel( ch );
+		bool loud = false;
+		for( int f = 0; f < frames; ++f )
+		{
+			loud |= fabsf( s[f] ) >= silenceThreshold;
+		}
+		if( loud )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void add( const PlanarBuffer& dst, const PlanarBuffer& src, int frames )
+{
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		sample_t * d = dst.channel( ch );
+		const sample_t * s = src.channel( ch );
+		for( int f = 0; f < frames; ++f )
+		{
+			d[f] += s[f];
+		}
+	}
+}
+
+
+void addMultiplied( const PlanarBuffer& dst, const PlanarBuffer& src, float coeffSrc, int frames )
+{
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		sample_t * d = dst.channel( ch );
+		const sample_t * s = src.channel( ch );
+		for( int f = 0; f < frames; ++f )
+		{
+			d[f] += s[f] * coeffSrc;
+		}
+	}
+}
+
+
+void addSanitizedMultiplied( const PlanarBuffer& dst, const PlanarBuffer& src, float coeffSrc, int frames )
+{
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		sample_t * d = dst.channel( ch );
+		const sample_t * s = src.channel( ch );
+		for( int f = 0; f < frames; ++f )
+		{
+			d[f] += fabsf( s[f] ) <= FLT_MAX ? s[f] * coeffSrc : 0.0f;
+		}
+	}
 }
 
+
+void addSanitizedMultipliedByBuffer( const PlanarBuffer& dst, const PlanarBuffer& src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	const float * c = coeffSrcBuf->values();
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		sample_t * d = dst.channel( ch );
+		const sample_t * s = src.channel( ch );
+		for( int f = 0; f < frames; ++f )
+		{
+			d[f] += fabsf( s[f] ) <= FLT_MAX ? s[f] * coeffSrc * c[f] : 0.0f;
+		}
+	}
+}
+
+
+void addSanitizedMultipliedByBuffers( const PlanarBuffer& dst, const PlanarBuffer& src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	const float * c1 = coeffSrcBuf1->values();
+	const float * c2 = coeffSrcBuf2->values();
+	for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
+	{
+		sample_t * d = dst.channel( ch );
+		const sample_t * s = src.channel( ch );
+		for( int f = 0; f < frames; ++f )
+		{
+			d[f] += fabsf( s[f] ) <= FLT_MAX ? s[f] * c1[f] * c2[f] : 0.0f;
+		}
+	}
+}
+
+}
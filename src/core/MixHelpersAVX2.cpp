@@ -0,0 +1,89 @@
+/*
+ * MixHelpersAVX2.cpp - MixHelpers implemented with AVX2
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpersKernels.h"
+
+#include <cfloat>
+#include <immintrin.h>
+
+
+namespace MixHelpers
+{
+
+struct Avx2
+{
+	typedef __m256 Type;
+	static const int Size = 8;
+
+	static inline Type load( const float* p ) { return _mm256_loadu_ps( p ); }
+	static inline void store( float* p, Type x ) { _mm256_storeu_ps( p, x ); }
+	static inline Type set1( float x ) { return _mm256_set1_ps( x ); }
+	static inline Type add( Type a, Type b ) { return _mm256_add_ps( a, b ); }
+	static inline Type mul( Type a, Type b ) { return _mm256_mul_ps( a, b ); }
+	static inline Type min( Type a, Type b ) { return _mm256_min_ps( a, b ); }
+	static inline Type max( Type a, Type b ) { return _mm256_max_ps( a, b ); }
+
+	static inline Type abs( Type x )
+	{
+		return _mm256_and_ps( x, _mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) ) );
+	}
+
+	static inline Type keepFinite( Type x, Type y )
+	{
+		return _mm256_and_ps( _mm256_cmp_ps( abs( x ), set1( FLT_MAX ), _CMP_LE_OQ ), y );
+	}
+
+	static inline bool anyGreaterEqual( Type a, Type b )
+	{
+		return _mm256_movemask_ps( _mm256_cmp_ps( a, b, _CMP_GE_OQ ) ) != 0;
+	}
+
+	static inline bool anyNonFinite( Type x )
+	{
+		return _mm256_movemask_ps( _mm256_cmp_ps( abs( x ), set1( FLT_MAX ), _CMP_NLE_UQ ) ) != 0;
+	}
+
+	static inline void dupPairs( const float* c, Type& lo, Type& hi )
+	{
+		// unpacking works per 128 bit lane, so sort the lanes afterwards
+		const Type x = load( c );
+		const Type a = _mm256_unpacklo_ps( x, x );
+		const Type b = _mm256_unpackhi_ps( x, x );
+		lo = _mm256_permute2f128_ps( a, b, 0x20 );
+		hi = _mm256_permute2f128_ps( a, b, 0x31 );
+	}
+
+	static inline void interleave( const float* l, const float* r, Type& lo, Type& hi )
+	{
+		const Type x = load( l );
+		const Type y = load( r );
+		const Type a = _mm256_unpacklo_ps( x, y );
+		const Type b = _mm256_unpackhi_ps( x, y );
+		lo = _mm256_permute2f128_ps( a, b, 0x20 );
+		hi = _mm256_permute2f128_ps( a, b, 0x31 );
+	}
+} ;
+
+
+const Kernels avx2Kernels = VectorKernels<Avx2>::table();
+
+}
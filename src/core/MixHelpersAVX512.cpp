@@ -0,0 +1,90 @@
+/*
+ * MixHelpersAVX512.cpp - MixHelpers implemented with AVX-512
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpersKernels.h"
+
+#include <cfloat>
+#include <immintrin.h>
+
+
+namespace MixHelpers
+{
+
+struct Avx512
+{
+	typedef __m512 Type;
+	static const int Size = 16;
+
+	static inline Type load( const float* p ) { return _mm512_loadu_ps( p ); }
+	static inline void store( float* p, Type x ) { _mm512_storeu_ps( p, x ); }
+	static inline Type set1( float x ) { return _mm512_set1_ps( x ); }
+	static inline Type add( Type a, Type b ) { return _mm512_add_ps( a, b ); }
+	static inline Type mul( Type a, Type b ) { return _mm512_mul_ps( a, b ); }
+	static inline Type min( Type a, Type b ) { return _mm512_min_ps( a, b ); }
+	static inline Type max( Type a, Type b ) { return _mm512_max_ps( a, b ); }
+
+	static inline Type abs( Type x )
+	{
+		// AVX512F has no floating point and
+		return _mm512_castsi512_ps( _mm512_and_si512( _mm512_castps_si512( x ),
+							_mm512_set1_epi32( 0x7fffffff ) ) );
+	}
+
+	static inline Type keepFinite( Type x, Type y )
+	{
+		return _mm512_maskz_mov_ps( _mm512_cmp_ps_mask( abs( x ), set1( FLT_MAX ), _CMP_LE_OQ ), y );
+	}
+
+	static inline bool anyGreaterEqual( Type a, Type b )
+	{
+		return _mm512_cmp_ps_mask( a, b, _CMP_GE_OQ ) != 0;
+	}
+
+	static inline bool anyNonFinite( Type x )
+	{
+		return _mm512_cmp_ps_mask( abs( x ), set1( FLT_MAX ), _CMP_NLE_UQ ) != 0;
+	}
+
+	static inline void dupPairs( const float* c, Type& lo, Type& hi )
+	{
+		const Type x = load( c );
+		lo = _mm512_permutexvar_ps( _mm512_setr_epi32( 0, 0, 1, 1, 2, 2, 3, 3,
+							4, 4, 5, 5, 6, 6, 7, 7 ), x );
+		hi = _mm512_permutexvar_ps( _mm512_setr_epi32( 8, 8, 9, 9, 10, 10, 11, 11,
+							12, 12, 13, 13, 14, 14, 15, 15 ), x );
+	}
+
+	static inline void interleave( const float* l, const float* r, Type& lo, Type& hi )
+	{
+		const Type x = load( l );
+		const Type y = load( r );
+		lo = _mm512_permutex2var_ps( x, _mm512_setr_epi32( 0, 16, 1, 17, 2, 18, 3, 19,
+							4, 20, 5, 21, 6, 22, 7, 23 ), y );
+		hi = _mm512_permutex2var_ps( x, _mm512_setr_epi32( 8, 24, 9, 25, 10, 26, 11, 27,
+							12, 28, 13, 29, 14, 30, 15, 31 ), y );
+	}
+} ;
+
+
+const Kernels avx512Kernels = VectorKernels<Avx512>::table();
+
+}
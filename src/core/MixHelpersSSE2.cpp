@@ -0,0 +1,85 @@
+/*
+ * MixHelpersSSE2.cpp - MixHelpers implemented with SSE2
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MixHelpersKernels.h"
+
+#include <cfloat>
+#include <emmintrin.h>
+
+
+namespace MixHelpers
+{
+
+struct Sse2
+{
+	typedef __m128 Type;
+	static const int Size = 4;
+
+	static inline Type load( const float* p ) { return _mm_loadu_ps( p ); }
+	static inline void store( float* p, Type x ) { _mm_storeu_ps( p, x ); }
+	static inline Type set1( float x ) { return _mm_set1_ps( x ); }
+	static inline Type add( Type a, Type b ) { return _mm_add_ps( a, b ); }
+	static inline Type mul( Type a, Type b ) { return _mm_mul_ps( a, b ); }
+	static inline Type min( Type a, Type b ) { return _mm_min_ps( a, b ); }
+	static inline Type max( Type a, Type b ) { return _mm_max_ps( a, b ); }
+
+	static inline Type abs( Type x )
+	{
+		return _mm_and_ps( x, _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) ) );
+	}
+
+	static inline Type keepFinite( Type x, Type y )
+	{
+		// NaNs compare false as well
+		return _mm_and_ps( _mm_cmple_ps( abs( x ), set1( FLT_MAX ) ), y );
+	}
+
+	static inline bool anyGreaterEqual( Type a, Type b )
+	{
+		return _mm_movemask_ps( _mm_cmpge_ps( a, b ) ) != 0;
+	}
+
+	static inline bool anyNonFinite( Type x )
+	{
+		return _mm_movemask_ps( _mm_cmpnle_ps( abs( x ), set1( FLT_MAX ) ) ) != 0;
+	}
+
+	static inline void dupPairs( const float* c, Type& lo, Type& hi )
+	{
+		const Type x = load( c );
+		lo = _mm_unpacklo_ps( x, x );
+		hi = _mm_unpackhi_ps( x, x );
+	}
+
+	static inline void interleave( const float* l, const float* r, Type& lo, Type& hi )
+	{
+		const Type a = load( l );
+		const Type b = load( r );
+		lo = _mm_unpacklo_ps( a, b );
+		hi = _mm_unpackhi_ps( a, b );
+	}
+} ;
+
+
+const Kernels sse2Kernels = VectorKernels<Sse2>::table();
+
+}
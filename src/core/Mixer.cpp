@@ -36,6 +36,7 @@
 #include "NotePlayHandle.h"
 #include "ConfigManager.h"
 #include "SamplePlayHandle.h"
+#include "StemExporter.h"
 #include "MemoryHelper.h"
 
 // platform-specific audio-interface-classes
@@ -66,26 +67,41 @@ typedef LocklessList<PlayHandle *>::Element LocklessListElement;
 
 static thread_local bool s_renderingThread;
 
+// written to the FIFO when the writer hands rendering over to the reader
+static surroundSampleFrame s_handOverMarker[1];
+
+
+// number of threads processing jobs, including the mixer thread
+static int jobThreadCount()
+{
+	const int threads = ConfigManager::inst()->value( "mixer", "threads" ).toInt();
+	return threads > 0 ? threads : QThread::idealThreadCount();
+}
+
 
 
 
 Mixer::Mixer( bool renderOnly ) :
 	m_renderOnly( renderOnly ),
 	m_framesPerPeriod( DEFAULT_BUFFER_SIZE ),
+	m_periodCounter( 0 ),
 	m_inputBufferRead( 0 ),
 	m_inputBufferWrite( 1 ),
 	m_readBuf( NULL ),
 	m_writeBuf( NULL ),
 	m_workers(),
-	m_numWorkers( QThread::idealThreadCount()-1 ),
+	m_numWorkers( jobThreadCount()-1 ),
+	m_playHandles( PlayHandle::MixerSlot ),
 	m_newPlayHandles( PlayHandle::MaxNumber ),
+	m_retiredPlayHandles( nullptr ),
 	m_qualitySettings( qualitySettings::Mode_Draft ),
 	m_masterGain( 1.0f ),
 	m_isProcessing( false ),
 	m_audioDev( NULL ),
 	m_oldAudioDev( NULL ),
 	m_audioDevStartFailed( false ),
-	m_profiler(),
+	m_profiler( m_numWorkers + 1 ),
+	m_stemExporter( NULL ),
 	m_metronomeActive(false),
 	m_clearSignal( false ),
 	m_changesSignal( false ),
@@ -129,9 +145,34 @@ Mixer::Mixer( bool renderOnly ) :
 			m_framesPerPeriod = DEFAULT_BUFFER_SIZE;
 		}
 	}
+	else
+	{
+		// renders don't depend on the user's setup, except for
+		// benchmarks which explicitly ask for another period size
+		const int renderFrames = ConfigManager::inst()->
+				value( "mixer", "renderframes" ).toInt();
+		if( renderFrames > 0 )
+		{
+			m_framesPerPeriod = qBound<int>( MINIMUM_BUFFER_SIZE,
+						renderFrames, DEFAULT_BUFFER_SIZE );
+		}
+	}
 
-	// allocte the FIFO from the determined size
-	m_fifo = new fifo( fifoSize );
+	// the FIFO can hold all buffers in circulation plus a marker, so
+	// markers never block. The number of periods rendered in advance is
+	// limited by the number of buffers the writer puts into circulation.
+	m_fifo = new fifo( MaxLookAhead + 2 );
+	m_freeBuffers = new fifo( MaxLookAhead + 2 );
+	m_fifoWriter = NULL;
+	m_lastFifoBuffer = NULL;
+	m_renderingDirectly = false;
+	m_pipelineMode = Pipeline_LookAhead;
+	m_lookAhead = qBound( 1, fifoSize, static_cast<int>( MaxLookAhead ) );
+	if( renderOnly == false &&
+		ConfigManager::inst()->value( "mixer", "lowlatency" ).toInt() )
+	{
+		m_pipelineMode = Pipeline_LowLatency;
+	}
 
 	// now that framesPerPeriod is fixed initialize global BufferManager
 	BufferManager::init( m_framesPerPeriod );
@@ -180,11 +221,8 @@ Mixer::~Mixer()
 		m_workers[w]->wait( 500 );
 	}
 
-	while( m_fifo->available() )
-	{
-		delete[] m_fifo->read();
-	}
 	delete m_fifo;
+	delete m_freeBuffers;
 
 	delete m_audioDev;
 	delete m_midiClient;
@@ -222,6 +260,7 @@ void Mixer::initDevices()
 
 void Mixer::startProcessing( bool _needs_fifo )
 {
+	m_renderingDirectly = false;
 	if( _needs_fifo )
 	{
 		m_fifoWriter = new fifoWriter( this, m_fifo );
@@ -251,6 +290,23 @@ void Mixer::stopProcessing()
 		m_audioDev->stopProcessing();
 		delete m_fifoWriter;
 		m_fifoWriter = NULL;
+
+		// drop whatever the device didn't read anymore, then all
+		// buffers are either free or still held by the reader
+		while( m_fifo->available() )
+		{
+			surroundSampleFrame * buffer = m_fifo->read();
+			if( buffer != s_handOverMarker )
+			{
+				delete[] buffer;
+			}
+		}
+		while( m_freeBuffers->available() )
+		{
+			delete[] m_freeBuffers->read();
+		}
+		delete[] m_lastFifoBuffer;
+		m_lastFifoBuffer = NULL;
 	}
 	else
 	{
@@ -389,25 +445,7 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 
 	// remove all play-handles that have to be deleted and delete
 	// them if they still exist...
-	// maybe this algorithm could be optimized...
-	ConstPlayHandleList::Iterator it_rem = m_playHandlesToRemove.begin();
-	while( it_rem != m_playHandlesToRemove.end() )
-	{
-		PlayHandleList::Iterator it = std::find( m_playHandles.begin(), m_playHandles.end(), *it_rem );
-
-		if( it != m_playHandles.end() )
-		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			m_playHandles.erase( it );
-		}
-
-		it_rem = m_playHandlesToRemove.erase( it_rem );
-	}
+	removeRetiredPlayHandles();
 
 	// rotate buffers
 	m_writeBuffer = ( m_writeBuffer + 1 ) % m_poolDepth;
@@ -429,52 +467,62 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 	// add all play-handles that have to be added
 	for( LocklessListElement * e = m_newPlayHandles.popList(); e; )
 	{
-		m_playHandles += e->value;
+		m_playHandles.append( e->value );
 		LocklessListElement * next = e->next;
 		m_newPlayHandles.free( e );
 		e = next;
 	}
 
+	// compute the ValueBuffers of automated and controlled models, so jobs
+	// of the following stages just read them
+	m_profiler.startStage( MixerProfiler::Stage_ValueBuffers );
+	AutomatableModel::updateValueBuffers();
+	m_profiler.finishStage( MixerProfiler::Stage_ValueBuffers );
+
 	// STAGE 1: run and render all play handles
-	MixerWorkerThread::fillJobQueue<PlayHandleList>( m_playHandles );
+	m_profiler.startStage( MixerProfiler::Stage_PlayHandles );
+	MixerWorkerThread::fillJobQueue<PlayHandleArray>( m_playHandles );
 	MixerWorkerThread::startAndWaitForJobs();
+	m_profiler.finishStage( MixerProfiler::Stage_PlayHandles );
 
 	// removed all play handles which are done
-	for( PlayHandleList::Iterator it = m_playHandles.begin();
-						it != m_playHandles.end(); )
+	for( PlayHandle * handle : m_playHandles )
 	{
-		if( ( *it )->affinityMatters() &&
-			( *it )->affinity() != QThread::currentThread() )
+		// retired handles are deleted by removeRetiredPlayHandles()
+		if( ( handle->affinityMatters() &&
+			handle->affinity() != QThread::currentThread() ) ||
+				handle->m_retired.load( std::memory_order_relaxed ) )
 		{
-			++it;
 			continue;
 		}
-		if( ( *it )->isFinished() )
+		if( handle->isFinished() )
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			it = m_playHandles.erase( it );
-		}
-		else
-		{
-			++it;
+			m_playHandles.remove( handle );
+			deletePlayHandle( handle );
 		}
 	}
+	m_playHandles.compact();
 
-	// STAGE 2: process effects of all instrument- and sampletracks
-	MixerWorkerThread::fillJobQueue<QVector<AudioPort *> >( m_audioPorts );
-	MixerWorkerThread::startAndWaitForJobs();
+	// STAGE 2: process effects of all instrument- and sampletracks and
+	// the FX channels they feed; a channel gets processed as soon as all
+	// of its inputs are complete
+	m_profiler.startStage( MixerProfiler::Stage_FxChannels );
+	fxMixer->processChannels( m_audioPorts );
+	m_profiler.finishStage( MixerProfiler::Stage_FxChannels );
+
+	if( m_stemExporter )
+	{
+		m_stemExporter->tapPeriod();
+	}
 
 
 	// STAGE 3: do master mix in FX mixer
+	m_profiler.startStage( MixerProfiler::Stage_MasterMix );
 	fxMixer->masterMix( m_writeBuf );
+	m_profiler.finishStage( MixerProfiler::Stage_MasterMix );
 
 
-	emit nextAudioBuffer( m_readBuf );
+	emit nextAudioBuffer( m_writeBuf );
 
 	runChangesInModel();
 
@@ -482,12 +530,13 @@ const surroundSampleFrame * Mixer::renderNextBuffer()
 	EnvelopeAndLfoParameters::instances()->trigger();
 	Controller::triggerFrameCounter();
 	AutomatableModel::incrementPeriodCounter();
+	++m_periodCounter;
 
 	s_renderingThread = false;
 
 	m_profiler.finishPeriod( processingSampleRate(), m_framesPerPeriod );
 
-	return m_readBuf;
+	return m_writeBuf;
 }
 
 
@@ -520,15 +569,73 @@ void Mixer::clearNewPlayHandles()
 void Mixer::clearInternal()
 {
 	// TODO: m_midiClient->noteOffAll();
-	for( PlayHandleList::Iterator it = m_playHandles.begin(); it != m_playHandles.end(); ++it )
+	for( PlayHandle * handle : m_playHandles )
 	{
 		// we must not delete instrument-play-handles as they exist
 		// during the whole lifetime of an instrument
-		if( ( *it )->type() != PlayHandle::TypeInstrumentPlayHandle )
+		if( handle->type() != PlayHandle::TypeInstrumentPlayHandle )
+		{
+			retirePlayHandle( handle );
+		}
+	}
+}
+
+
+
+
+void Mixer::retirePlayHandle( PlayHandle * handle )
+{
+	if( handle->m_retired.exchange( true ) )
+	{
+		// already queued
+		return;
+	}
+	PlayHandle * head = m_retiredPlayHandles.load( std::memory_order_relaxed );
+	do
+	{
+		handle->m_nextRetired = head;
+	}
+	while( !m_retiredPlayHandles.compare_exchange_weak( head, handle,
+					std::memory_order_release,
+					std::memory_order_relaxed ) );
+}
+
+
+
+
+void Mixer::removeRetiredPlayHandles()
+{
+	PlayHandle * handle = m_retiredPlayHandles.exchange( nullptr,
+						std::memory_order_acquire );
+	while( handle )
+	{
+		PlayHandle * next = handle->m_nextRetired;
+		handle->m_nextRetired = nullptr;
+		if( m_playHandles.remove( handle ) )
+		{
+			deletePlayHandle( handle );
+		}
+		else
 		{
-			m_playHandlesToRemove.push_back( *it );
+			// not added yet, so there's nothing to remove
+			handle->m_retired.store( false, std::memory_order_relaxed );
 		}
+		handle = next;
 	}
+	m_playHandles.compact();
+}
+
+
+
+
+void Mixer::deletePlayHandle( PlayHandle * handle )
+{
+	handle->audioPort()->removePlayHandle( handle );
+	if( handle->type() == PlayHandle::TypeNotePlayHandle )
+	{
+		NotePlayHandleManager::release( (NotePlayHandle*) handle );
+	}
+	else delete handle;
 }
 
 
@@ -560,6 +667,60 @@ Mixer::StereoSample Mixer::getPeakValues(sampleFrame * _ab, const f_cnt_t _frame
 
 
 
+const surroundSampleFrame * Mixer::nextBuffer()
+{
+	if( !hasFifoWriter() )
+	{
+		return renderNextBuffer();
+	}
+
+	if( m_lastFifoBuffer )
+	{
+		m_freeBuffers->write( m_lastFifoBuffer );
+		m_lastFifoBuffer = NULL;
+	}
+
+	// while rendering directly the writer is parked, so the FIFO is empty
+	// unless it got finished
+	if( m_renderingDirectly && !m_fifo->available() )
+	{
+		if( pipelineMode() == Pipeline_LowLatency )
+		{
+			// the device may call us from another thread than the one
+			// which took over rendering
+			disable_denormals();
+			return renderNextBuffer();
+		}
+		m_renderingDirectly = false;
+		m_fifoWriter->resume();
+	}
+
+	surroundSampleFrame * buffer = m_fifo->read();
+	if( buffer == s_handOverMarker )
+	{
+		// rendering moves to the device's thread, which needs the same
+		// FPU setup as the FIFO writer
+		m_renderingDirectly = true;
+		disable_denormals();
+		return renderNextBuffer();
+	}
+
+	m_lastFifoBuffer = buffer;
+	return buffer;
+}
+
+
+
+
+void Mixer::setPipelineMode( PipelineModes mode, int lookAhead )
+{
+	m_lookAhead = qBound( 1, lookAhead, static_cast<int>( MaxLookAhead ) );
+	m_pipelineMode = mode;
+}
+
+
+
+
 void Mixer::changeQuality( const struct qualitySettings & _qs )
 {
 	// don't delete the audio-device
@@ -696,9 +857,13 @@ bool Mixer::addPlayHandle( PlayHandle* handle )
 void Mixer::removePlayHandle( PlayHandle * _ph )
 {
 	requestChangeInModel();
+	if( _ph->m_retired.load( std::memory_order_relaxed ) )
+	{
+		// already queued for removal
+	}
 	// check thread affinity as we must not delete play-handles
 	// which were created in a thread different than mixer thread
-	if( _ph->affinityMatters() &&
+	else if( _ph->affinityMatters() &&
 				_ph->affinity() == QThread::currentThread() )
 	{
 		_ph->audioPort()->removePlayHandle( _ph );
@@ -724,11 +889,8 @@ void Mixer::removePlayHandle( PlayHandle * _ph )
 			}
 		}
 		// Now check m_playHandles
-		PlayHandleList::Iterator it = std::find( m_playHandles.begin(),
-					m_playHandles.end(), _ph );
-		if( it != m_playHandles.end() )
+		if( m_playHandles.remove( _ph ) )
 		{
-			m_playHandles.erase( it );
 			removedFromList = true;
 		}
 		// Only deleting PlayHandles that were actually found in the list
@@ -745,7 +907,7 @@ void Mixer::removePlayHandle( PlayHandle * _ph )
 	}
 	else
 	{
-		m_playHandlesToRemove.push_back( _ph );
+		retirePlayHandle( _ph );
 	}
 	doneChangeInModel();
 }
@@ -756,24 +918,18 @@ void Mixer::removePlayHandle( PlayHandle * _ph )
 void Mixer::removePlayHandlesOfTypes( Track * _track, const quint8 types )
 {
 	requestChangeInModel();
-	PlayHandleList::Iterator it = m_playHandles.begin();
-	while( it != m_playHandles.end() )
+	// the track may be gone before the next period, so get rid of queued
+	// handles now
+	removeRetiredPlayHandles();
+	for( PlayHandle * handle : m_playHandles )
 	{
-		if( ( *it )->isFromTrack( _track ) && ( ( *it )->type() & types ) )
+		if( handle->isFromTrack( _track ) && ( handle->type() & types ) )
 		{
-			( *it )->audioPort()->removePlayHandle( ( *it ) );
-			if( ( *it )->type() == PlayHandle::TypeNotePlayHandle )
-			{
-				NotePlayHandleManager::release( (NotePlayHandle*) *it );
-			}
-			else delete *it;
-			it = m_playHandles.erase( it );
-		}
-		else
-		{
-			++it;
+			m_playHandles.remove( handle );
+			deletePlayHandle( handle );
 		}
 	}
+	m_playHandles.compact();
 	doneChangeInModel();
 }
 
@@ -1220,7 +1376,8 @@ MidiClient * Mixer::tryMidiClients()
 Mixer::fifoWriter::fifoWriter( Mixer* mixer, fifo * _fifo ) :
 	m_mixer( mixer ),
 	m_fifo( _fifo ),
-	m_writing( true )
+	m_writing( true ),
+	m_resume( false )
 {
 	setObjectName("Mixer::fifoWriter");
 }
@@ -1230,7 +1387,21 @@ Mixer::fifoWriter::fifoWriter( Mixer* mixer, fifo * _fifo ) :
 
 void Mixer::fifoWriter::finish()
 {
+	m_parkMutex.lock();
 	m_writing = false;
+	m_parkCondition.wakeOne();
+	m_parkMutex.unlock();
+}
+
+
+
+
+void Mixer::fifoWriter::resume()
+{
+	m_parkMutex.lock();
+	m_resume = true;
+	m_parkCondition.wakeOne();
+	m_parkMutex.unlock();
 }
 
 
@@ -1252,11 +1423,40 @@ void Mixer::fifoWriter::run()
 #endif
 
 	const fpp_t frames = m_mixer->framesPerPeriod();
+	// buffers in circulation, the reader holds one of them
+	int buffers = 0;
 	while( m_writing )
 	{
-		surroundSampleFrame * buffer = new surroundSampleFrame[frames];
-		const surroundSampleFrame * b = m_mixer->renderNextBuffer();
-		memcpy( buffer, b, frames * sizeof( surroundSampleFrame ) );
+		if( m_mixer->pipelineMode() == Pipeline_LowLatency )
+		{
+			if( !park() )
+			{
+				// the reader is rendering, so don't touch the
+				// mixer anymore
+				m_fifo->write( NULL );
+				m_fifo->waitUntilRead();
+				return;
+			}
+			continue;
+		}
+
+		const int lookAhead = m_mixer->lookAhead();
+		for( ; buffers <= lookAhead; ++buffers )
+		{
+			m_mixer->m_freeBuffers->write(
+					new surroundSampleFrame[frames] );
+		}
+		surroundSampleFrame * buffer = nextFreeBuffer();
+		if( buffers > lookAhead + 1 )
+		{
+			// look-ahead got reduced
+			delete[] buffer;
+			--buffers;
+			continue;
+		}
+
+		memcpy( buffer, m_mixer->renderNextBuffer(),
+				frames * sizeof( surroundSampleFrame ) );
 		write( buffer );
 	}
 
@@ -1268,15 +1468,62 @@ void Mixer::fifoWriter::run()
 
 
 
+bool Mixer::fifoWriter::park()
+{
+	// the reader may start rendering as soon as it reads the marker, so
+	// the writer must not allow model changes on its behalf anymore
+	m_fifo->write( s_handOverMarker );
+
+	m_parkMutex.lock();
+	while( !m_resume && m_writing )
+	{
+		m_parkCondition.wait( &m_parkMutex );
+	}
+	const bool resumed = m_resume;
+	m_resume = false;
+	m_parkMutex.unlock();
+
+	return resumed;
+}
+
+
+
+
+surroundSampleFrame * Mixer::fifoWriter::nextFreeBuffer()
+{
+	beginWaiting();
+	surroundSampleFrame * buffer = m_mixer->m_freeBuffers->read();
+	endWaiting();
+	return buffer;
+}
+
+
+
+
 void Mixer::fifoWriter::write( surroundSampleFrame * buffer )
+{
+	beginWaiting();
+	m_fifo->write( buffer );
+	endWaiting();
+}
+
+
+
+
+// model changes can be done right away while the writer is blocked
+void Mixer::fifoWriter::beginWaiting()
 {
 	m_mixer->m_waitChangesMutex.lock();
 	m_mixer->m_waitingForWrite = true;
 	m_mixer->m_waitChangesMutex.unlock();
 	m_mixer->runChangesInModel();
+}
+
 
-	m_fifo->write( buffer );
 
+
+void Mixer::fifoWriter::endWaiting()
+{
 	m_mixer->m_doChangesMutex.lock();
 	m_mixer->m_waitingForWrite = false;
 	m_mixer->m_doChangesMutex.unlock();
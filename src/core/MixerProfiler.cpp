@@ -24,18 +24,64 @@
 
 #include "MixerProfiler.h"
 
+#include <algorithm>
+#include <functional>
 
-MixerProfiler::MixerProfiler() :
+#include "ThreadableJob.h"
+
+
+std::atomic<MixerProfiler *> MixerProfiler::s_jobProfiler( nullptr );
+
+
+static QString jsonString( const QString& s )
+{
+	QString escaped;
+	escaped.reserve( s.size() + 2 );
+	escaped += '"';
+	for( QChar c : s )
+	{
+		if( c == '"' || c == '\\' )
+		{
+			escaped += '\\';
+			escaped += c;
+		}
+		else if( c.unicode() < 0x20 )
+		{
+			escaped += QString( "\\u%1" ).arg( c.unicode(), 4, 16, QChar( '0' ) );
+		}
+		else
+		{
+			escaped += c;
+		}
+	}
+	escaped += '"';
+	return escaped;
+}
+
+
+
+MixerProfiler::MixerProfiler( int workers ) :
 	m_periodTimer(),
 	m_cpuLoad( 0 ),
-	m_outputFile()
+	m_outputFile(),
+	m_workers( workers ),
+	m_periodStart(),
+	m_periods( 64 ),
+	m_traceFile(),
+	m_traceStart( now() )
 {
+	for( WorkerEvents & worker : m_workers )
+	{
+		worker.events.reserve( 256 );
+	}
 }
 
 
 
 MixerProfiler::~MixerProfiler()
 {
+	setTraceFile( QString() );
+	setJobProfilingEnabled( false );
 }
 
 
@@ -50,6 +96,20 @@ void MixerProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPerio
 	{
 		m_outputFile.write( QString( "%1\n" ).arg( periodElapsed ).toLatin1() );
 	}
+
+	if( m_periodStart != TimePoint() )
+	{
+		collectJobs( periodElapsed );
+		m_periodStart = TimePoint();
+	}
+	else
+	{
+		// job profiling got enabled during this period
+		for( WorkerEvents & worker : m_workers )
+		{
+			worker.events.clear();
+		}
+	}
 }
 
 
@@ -61,3 +121,203 @@ void MixerProfiler::setOutputFile( const QString& outputFile )
 	m_outputFile.open( QFile::WriteOnly | QFile::Truncate );
 }
 
+
+
+void MixerProfiler::setTraceFile( const QString& traceFile )
+{
+	if( m_traceFile.isOpen() )
+	{
+		setJobProfilingEnabled( false );
+		m_traceFile.write( "\n]\n" );
+		m_traceFile.close();
+	}
+	if( traceFile.isEmpty() )
+	{
+		return;
+	}
+
+	m_traceFile.setFileName( traceFile );
+	if( !m_traceFile.open( QFile::WriteOnly | QFile::Truncate ) )
+	{
+		return;
+	}
+	m_traceFile.write( "[\n" );
+	const int mixerThread = m_workers.size();
+	for( int thread = 0; thread <= mixerThread; ++thread )
+	{
+		const QString name = thread == mixerThread ? QString( "Mixer" ) :
+					QString( "Worker %1" ).arg( thread + 1 );
+		// events are separated by leading commas as trailing ones are
+		// not allowed
+		m_traceFile.write( QString( "%1{\"name\":\"thread_name\",\"ph\":\"M\","
+					"\"pid\":1,\"tid\":%2,\"args\":{\"name\":%3}}" ).
+				arg( thread ? ",\n" : "" ).
+				arg( thread ).arg( jsonString( name ) ).toUtf8() );
+	}
+	setJobProfilingEnabled( true );
+}
+
+
+
+void MixerProfiler::setJobProfilingEnabled( bool enabled )
+{
+	if( enabled )
+	{
+		s_jobProfiler = this;
+	}
+	else
+	{
+		MixerProfiler * self = this;
+		s_jobProfiler.compare_exchange_strong( self, nullptr );
+	}
+}
+
+
+
+void MixerProfiler::processJob( ThreadableJob * job, int worker )
+{
+	const TimePoint start = now();
+	job->process();
+	const TimePoint end = now();
+
+	const ThreadableJob::ProfilingTarget target = job->profilingTarget();
+	m_workers[worker].events.push_back( { target.owner, target.name,
+						target.category, start, end } );
+}
+
+
+
+bool MixerProfiler::takePeriodStats( PeriodStats & stats )
+{
+	PeriodStats * period = m_periods.beginRead();
+	if( period == NULL )
+	{
+		return false;
+	}
+	stats.periodUsecs = period->periodUsecs;
+	std::copy( period->stageUsecs, period->stageUsecs + StageCount,
+							stats.stageUsecs );
+	// hand our storage to the writer so it doesn't have to allocate
+	stats.jobs.swap( period->jobs );
+	m_periods.endRead();
+	return true;
+}
+
+
+
+int MixerProfiler::usecs( TimePoint start, TimePoint end ) const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+							end - start ).count();
+}
+
+
+
+void MixerProfiler::collectJobs( int periodElapsed )
+{
+	const TimePoint periodEnd = now();
+	const bool tracing = m_traceFile.isOpen();
+
+	m_periodEvents.clear();
+	for( size_t worker = 0; worker < m_workers.size(); ++worker )
+	{
+		std::vector<JobEvent> & events = m_workers[worker].events;
+		for( JobEvent & event : events )
+		{
+			if( tracing )
+			{
+				writeTraceEvent( event.name.isEmpty() ?
+						QString( event.category ) : event.name,
+						event.category, worker,
+						event.start, event.end );
+			}
+			m_periodEvents.push_back( std::move( event ) );
+		}
+		events.clear();
+	}
+
+	if( tracing )
+	{
+		static const char * stageNames[StageCount] =
+		{
+			"Value buffers", "Play handles", "FX channels", "Master mix"
+		} ;
+		const int mixerThread = m_workers.size();
+		writeTraceEvent( "Period", "Mixer", mixerThread, m_periodStart, periodEnd );
+		for( int stage = 0; stage < StageCount; ++stage )
+		{
+			writeTraceEvent( stageNames[stage], "Mixer", mixerThread,
+						m_stageTimes[stage].start,
+						m_stageTimes[stage].end );
+		}
+	}
+
+	// sum up the jobs of each owner and category
+	std::sort( m_periodEvents.begin(), m_periodEvents.end(),
+		[]( const JobEvent & a, const JobEvent & b )
+		{
+			// the same string literal may have different addresses
+			// in different binaries, that's fine though
+			return a.owner != b.owner ?
+				std::less<const void *>()( a.owner, b.owner ) :
+				std::less<const char *>()( a.category, b.category );
+		} );
+	m_periodJobs.clear();
+	std::chrono::steady_clock::duration total( 0 );
+	size_t first = 0;
+	for( size_t i = 0; i < m_periodEvents.size(); ++i )
+	{
+		const JobEvent & event = m_periodEvents[i];
+		total += event.end - event.start;
+		if( i + 1 == m_periodEvents.size() ||
+			m_periodEvents[i + 1].owner != event.owner ||
+			m_periodEvents[i + 1].category != event.category )
+		{
+			const int jobs = i + 1 - first;
+			m_periodJobs.push_back( { event.name, event.category, jobs,
+				static_cast<int>( std::chrono::duration_cast<
+					std::chrono::microseconds>( total ).count() ) } );
+			total = std::chrono::steady_clock::duration( 0 );
+			first = i + 1;
+		}
+	}
+
+	PeriodStats * period = m_periods.beginWrite();
+	if( period == NULL )
+	{
+		// nobody is reading
+		return;
+	}
+	period->periodUsecs = periodElapsed;
+	for( int stage = 0; stage < StageCount; ++stage )
+	{
+		period->stageUsecs[stage] = usecs( m_stageTimes[stage].start,
+						m_stageTimes[stage].end );
+	}
+	period->jobs.assign( m_periodJobs.begin(), m_periodJobs.end() );
+	std::sort( period->jobs.begin(), period->jobs.end(),
+		[]( const JobStats & a, const JobStats & b )
+		{
+			return a.usecs > b.usecs;
+		} );
+	m_periods.endWrite();
+}
+
+
+
+void MixerProfiler::writeTraceEvent( const QString& name, const char * category,
+				int thread, TimePoint start, TimePoint end )
+{
+	using std::chrono::nanoseconds;
+	const double ts = std::chrono::duration_cast<nanoseconds>(
+					start - m_traceStart ).count() / 1000.0;
+	const double dur = std::chrono::duration_cast<nanoseconds>(
+					end - start ).count() / 1000.0;
+	// names are user input, so don't run QString::arg() on them
+	m_traceFile.write( ( ",\n{\"name\":" + jsonString( name ) +
+				",\"cat\":" + jsonString( category ) +
+				",\"ph\":\"X\",\"ts\":" + QString::number( ts, 'f', 3 ) +
+				",\"dur\":" + QString::number( dur, 'f', 3 ) +
+				",\"pid\":1,\"tid\":" + QString::number( thread ) +
+				"}" ).toUtf8() );
+}
@@ -25,25 +25,184 @@
 #include "MixerWorkerThread.h"
 
 #include <QDebug>
-#include <QMutex>
-#include <QWaitCondition>
+
+#include <vector>
 
 #include "denormals.h"
 #include "ThreadableJob.h"
 #include "Mixer.h"
+#include "MixerProfiler.h"
 
 #if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
 #include <xmmintrin.h>
 #endif
 
+
+// number of pause iterations before a waiting thread gives up its time slice
+static const int SPIN_COUNT = 4096;
+
+static inline void cpuRelax()
+{
+#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
+	_mm_pause();
+#endif
+}
+
+// index of the deque owned by the current thread, -1 for non-worker threads
+static thread_local int s_workerIndex = -1;
+
+
 MixerWorkerThread::JobQueue MixerWorkerThread::globalJobQueue;
-QWaitCondition * MixerWorkerThread::queueReadyWaitCond = NULL;
 QList<MixerWorkerThread *> MixerWorkerThread::workerThreads;
+QMutex MixerWorkerThread::s_roundMutex;
+QWaitCondition MixerWorkerThread::s_roundCond;
+std::atomic_uint MixerWorkerThread::s_round( 0 );
+
+
+
+
+// per-worker job deque. The owner takes jobs from the back (most recently
+// added, still warm in cache), thieves take them from the front. Accesses are
+// serialized by a tiny spinlock which is practically uncontended as every
+// worker mostly stays on its own deque. Storage keeps its capacity across
+// periods, so no allocations happen once the queue has warmed up.
+class MixerWorkerThread::JobQueue::WorkerDeque
+{
+public:
+	WorkerDeque() :
+		m_jobs(),
+		m_head( 0 ),
+		m_pending( 0 )
+	{
+		m_lock.clear();
+		m_jobs.reserve( 256 );
+	}
+
+	void clear()
+	{
+		lock();
+		m_jobs.clear();
+		m_head = 0;
+		m_pending = 0;
+		unlock();
+	}
+
+	void push( ThreadableJob * _job )
+	{
+		lock();
+		m_jobs.push_back( _job );
+		++m_pending;
+		unlock();
+	}
+
+	ThreadableJob * pop()
+	{
+		if( m_pending == 0 )
+		{
+			return nullptr;
+		}
+		ThreadableJob * job = nullptr;
+		lock();
+		if( m_jobs.size() > m_head )
+		{
+			job = m_jobs.back();
+			m_jobs.pop_back();
+			--m_pending;
+		}
+		unlock();
+		return job;
+	}
+
+	ThreadableJob * steal()
+	{
+		if( m_pending == 0 )
+		{
+			return nullptr;
+		}
+		ThreadableJob * job = nullptr;
+		lock();
+		if( m_jobs.size() > m_head )
+		{
+			job = m_jobs[m_head++];
+			--m_pending;
+			if( m_head == m_jobs.size() )
+			{
+				m_jobs.clear();
+				m_head = 0;
+			}
+		}
+		unlock();
+		return job;
+	}
+
+private:
+	inline void lock()
+	{
+		while( m_lock.test_and_set( std::memory_order_acquire ) )
+		{
+			cpuRelax();
+		}
+	}
+
+	inline void unlock()
+	{
+		m_lock.clear( std::memory_order_release );
+	}
+
+	std::atomic_flag m_lock;
+	std::vector<ThreadableJob *> m_jobs;
+	size_t m_head;
+	// lets pop() and steal() skip empty deques without taking the lock
+	std::atomic_int m_pending;
+	// keep neighbouring deques on separate cache lines
+	char m_padding[64];
+
+} ;
+
+
+
 
 // implementation of internal JobQueue
+MixerWorkerThread::JobQueue::JobQueue() :
+	m_deques(),
+	m_nextDeque( 0 ),
+	m_opMode( Static ),
+	m_itemsQueued( 0 ),
+	m_itemsDone( 0 ),
+	m_waiterParked( false )
+{
+}
+
+
+
+
+MixerWorkerThread::JobQueue::~JobQueue()
+{
+	for( WorkerDeque * d : m_deques )
+	{
+		delete d;
+	}
+}
+
+
+
+
+int MixerWorkerThread::JobQueue::addWorker()
+{
+	m_deques.push_back( new WorkerDeque );
+	return m_deques.size() - 1;
+}
+
+
+
+
 void MixerWorkerThread::JobQueue::reset( OperationMode _opMode )
 {
-	m_writeIndex = 0;
+	for( WorkerDeque * d : m_deques )
+	{
+		d->clear();
+	}
+	m_itemsQueued = 0;
 	m_itemsDone = 0;
 	m_opMode = _opMode;
 }
@@ -51,43 +210,106 @@ void MixerWorkerThread::JobQueue::reset( OperationMode _opMode )
 
 
 
+int MixerWorkerThread::JobQueue::currentWorker() const
+{
+	// the mixer thread is processed inline as the last worker
+	return s_workerIndex >= 0 ? s_workerIndex : m_deques.size() - 1;
+}
+
+
+
+
 void MixerWorkerThread::JobQueue::addJob( ThreadableJob * _job )
 {
 	if( _job->requiresProcessing() )
 	{
 		// update job state
 		_job->queue();
-		// actually queue the job via atomic operations
-		auto index = m_writeIndex++;
-		if (index < JOB_QUEUE_SIZE) {
-			m_items[index] = _job;
-		} else {
-			qWarning() << "Job queue is full!";
-			++m_itemsDone;
+		++m_itemsQueued;
+
+		// workers keep jobs they spawn themselves (e.g. FX channels whose
+		// dependencies just got fulfilled), everything else is spread
+		// evenly so all workers start the round with local work
+		const int worker = s_workerIndex >= 0 ? s_workerIndex :
+				m_nextDeque.fetch_add( 1, std::memory_order_relaxed ) %
+							unsigned( m_deques.size() );
+		m_deques[worker]->push( _job );
+	}
+}
+
+
+
+
+ThreadableJob * MixerWorkerThread::JobQueue::popOrSteal( int _worker )
+{
+	ThreadableJob * job = m_deques[_worker]->pop();
+	if( job )
+	{
+		return job;
+	}
+
+	const int numDeques = m_deques.size();
+	for( int i = 1; i < numDeques; ++i )
+	{
+		job = m_deques[( _worker + i ) % numDeques]->steal();
+		if( job )
+		{
+			return job;
 		}
 	}
+	return nullptr;
 }
 
 
 
+
+void MixerWorkerThread::JobQueue::jobDone()
+{
+	if( ++m_itemsDone >= m_itemsQueued && m_waiterParked )
+	{
+		m_waitMutex.lock();
+		m_waitCond.wakeAll();
+		m_waitMutex.unlock();
+	}
+}
+
+
+
+
 void MixerWorkerThread::JobQueue::run()
 {
-	bool processedJob = true;
-	while (processedJob && m_itemsDone < m_writeIndex)
+	if( m_deques.isEmpty() )
+	{
+		return;
+	}
+
+	const int worker = currentWorker();
+	MixerProfiler * profiler = MixerProfiler::jobProfiler();
+	int idleSpins = 0;
+	while( m_itemsDone < m_itemsQueued )
 	{
-		processedJob = false;
-		for( int i = 0; i < m_writeIndex && i < JOB_QUEUE_SIZE; ++i )
+		ThreadableJob * job = popOrSteal( worker );
+		if( job )
 		{
-			ThreadableJob * job = m_items[i].exchange(nullptr);
-			if( job )
+			if( profiler )
+			{
+				profiler->processJob( job, worker );
+			}
+			else
 			{
 				job->process();
-				processedJob = true;
-				++m_itemsDone;
 			}
+			jobDone();
+			idleSpins = 0;
+			continue;
 		}
-		// always exit loop if we're not in dynamic mode
-		processedJob = processedJob && ( m_opMode == Dynamic );
+		// in static mode nothing can show up anymore, in dynamic mode
+		// jobs being processed right now may queue their dependents
+		if( m_opMode == Static || ++idleSpins > SPIN_COUNT )
+		{
+			break;
+		}
+		cpuRelax();
 	}
 }
 
@@ -96,12 +318,25 @@ void MixerWorkerThread::JobQueue::run()
 
 void MixerWorkerThread::JobQueue::wait()
 {
-	while (m_itemsDone < m_writeIndex)
+	// jobs usually finish within a few microseconds, so spin a little
+	// before parking the thread
+	for( int i = 0; i < SPIN_COUNT; ++i )
 	{
-#if defined(LMMS_HOST_X86) || defined(LMMS_HOST_X86_64)
-		_mm_pause();
-#endif
+		if( m_itemsDone >= m_itemsQueued )
+		{
+			return;
+		}
+		cpuRelax();
+	}
+
+	m_waitMutex.lock();
+	m_waiterParked = true;
+	while( m_itemsDone < m_itemsQueued )
+	{
+		m_waitCond.wait( &m_waitMutex );
 	}
+	m_waiterParked = false;
+	m_waitMutex.unlock();
 }
 
 
@@ -112,14 +347,9 @@ void MixerWorkerThread::JobQueue::wait()
 
 MixerWorkerThread::MixerWorkerThread( Mixer* mixer ) :
 	QThread( mixer ),
+	m_index( globalJobQueue.addWorker() ),
 	m_quit( false )
 {
-	// initialize global static data
-	if( queueReadyWaitCond == NULL )
-	{
-		queueReadyWaitCond = new QWaitCondition;
-	}
-
 	// keep track of all instantiated worker threads - this is used for
 	// processing the last worker thread "inline", see comments in
 	// MixerWorkerThread::startAndWaitForJobs() for details
@@ -150,7 +380,11 @@ void MixerWorkerThread::quit()
 
 void MixerWorkerThread::startAndWaitForJobs()
 {
-	queueReadyWaitCond->wakeAll();
+	s_roundMutex.lock();
+	++s_round;
+	s_roundCond.wakeAll();
+	s_roundMutex.unlock();
+
 	// The last worker-thread is never started. Instead it's processed "inline"
 	// i.e. within the global Mixer thread. This way we can reduce latencies
 	// that otherwise would be caused by synchronizing with another thread.
@@ -166,14 +400,29 @@ void MixerWorkerThread::run()
 	MemoryManager::ThreadGuard mmThreadGuard; Q_UNUSED(mmThreadGuard);
 	disable_denormals();
 
-	QMutex m;
+	s_workerIndex = m_index;
+
+	unsigned int lastRound = s_round;
 	while( m_quit == false )
 	{
-		m.lock();
-		queueReadyWaitCond->wait( &m );
+		// the next round usually starts right away (stages follow each
+		// other closely), so spin for a while before going to sleep
+		for( int i = 0; i < SPIN_COUNT && s_round == lastRound; ++i )
+		{
+			cpuRelax();
+		}
+
+		if( s_round == lastRound )
+		{
+			s_roundMutex.lock();
+			while( s_round == lastRound && m_quit == false )
+			{
+				s_roundCond.wait( &s_roundMutex );
+			}
+			s_roundMutex.unlock();
+		}
+		lastRound = s_round;
+
 		globalJobQueue.run();
-		m.unlock();
 	}
 }
-
-
@@ -32,6 +32,9 @@
 #include "Mixer.h"
 #include "Song.h"
 
+#include <atomic>
+#include <utility>
+
 
 NotePlayHandle::BaseDetuning::BaseDetuning( DetuningHelper *detuning ) :
 	m_value( detuning ? detuning->automationPattern()->valueAt( 0 ) : 0 )
@@ -429,9 +432,9 @@ void NotePlayHandle::mute()
 
 int NotePlayHandle::index() const
 {
-	const PlayHandleList & playHandles = Engine::mixer()->playHandles();
+	const PlayHandleArray & playHandles = Engine::mixer()->playHandles();
 	int idx = 0;
-	for( PlayHandleList::ConstIterator it = playHandles.begin(); it != playHandles.end(); ++it )
+	for( PlayHandleArray::ConstIterator it = playHandles.begin(); it != playHandles.end(); ++it )
 	{
 		const NotePlayHandle * nph = dynamic_cast<const NotePlayHandle *>( *it );
 		if( nph == NULL || nph->m_instrumentTrack != m_instrumentTrack || nph->isReleased() || nph->hasParent() )
@@ -452,10 +455,10 @@ int NotePlayHandle::index() const
 
 ConstNotePlayHandleList NotePlayHandle::nphsOfInstrumentTrack( const InstrumentTrack * _it, bool _all_ph )
 {
-	const PlayHandleList & playHandles = Engine::mixer()->playHandles();
+	const PlayHandleArray & playHandles = Engine::mixer()->playHandles();
 	ConstNotePlayHandleList cnphv;
 
-	for( PlayHandleList::ConstIterator it = playHandles.begin(); it != playHandles.end(); ++it )
+	for( PlayHandleArray::ConstIterator it = playHandles.begin(); it != playHandles.end(); ++it )
 	{
 		const NotePlayHandle * nph = dynamic_cast<const NotePlayHandle *>( *it );
 		if( nph != NULL && nph->m_instrumentTrack == _it && ( ( nph->isReleased() == false && nph->hasParent() == false ) || _all_ph == true ) )
@@ -542,25 +545,240 @@ void NotePlayHandle::resize( const bpm_t _new_tempo )
 }
 
 
-NotePlayHandle ** NotePlayHandleManager::s_available;
-QReadWriteLock NotePlayHandleManager::s_mutex;
-std::atomic_int NotePlayHandleManager::s_availableIndex;
-int NotePlayHandleManager::s_size;
+namespace
+{
 
+const int MAGAZINE_SIZE = 32;
+// limits the number of cached handles to MAX_MAGAZINES * MAGAZINE_SIZE
+const int MAX_MAGAZINES = 512;
+const int NO_MAGAZINE = -1;
 
-void NotePlayHandleManager::init()
+struct Magazine
+{
+	int count;
+	void * handles[MAGAZINE_SIZE];
+	// next magazine on the depot stack this one is on
+	std::atomic_int next;
+} ;
+
+Magazine s_magazines[MAX_MAGAZINES];
+// magazines from here on have never been used
+std::atomic_int s_unusedMagazine( 0 );
+
+
+// Treiber stack of magazine indices. The upper half of the head holds a tag
+// which changes with every update, so a head that got popped and pushed
+// again in between can't be mistaken for the one we read (ABA problem).
+class MagazineStack
+{
+public:
+	MagazineStack() :
+		m_head( pack( NO_MAGAZINE, 0 ) )
+	{
+	}
+
+	void push( int magazine )
+	{
+		uint64_t head = m_head.load( std::memory_order_relaxed );
+		do
+		{
+			s_magazines[magazine].next.store( index( head ),
+						std::memory_order_relaxed );
+		}
+		while( !m_head.compare_exchange_weak( head,
+					pack( magazine, tag( head ) + 1 ),
+					std::memory_order_release,
+					std::memory_order_relaxed ) );
+	}
+
+	int pop()
+	{
+		uint64_t head = m_head.load( std::memory_order_acquire );
+		while( index( head ) != NO_MAGAZINE )
+		{
+			const int next = s_magazines[index( head )].next.load(
+						std::memory_order_relaxed );
+			if( m_head.compare_exchange_weak( head,
+						pack( next, tag( head ) + 1 ),
+						std::memory_order_acquire,
+						std::memory_order_acquire ) )
+			{
+				return index( head );
+			}
+		}
+		return NO_MAGAZINE;
+	}
+
+private:
+	static uint64_t pack( int index, uint32_t tag )
+	{
+		return ( uint64_t( tag ) << 32 ) | uint32_t( index );
+	}
+
+	static int index( uint64_t head )
+	{
+		return int32_t( uint32_t( head ) );
+	}
+
+	static uint32_t tag( uint64_t head )
+	{
+		return head >> 32;
+	}
+
+	std::atomic<uint64_t> m_head;
+} ;
+
+MagazineStack s_fullMagazines;
+MagazineStack s_emptyMagazines;
+
+
+// the magazines owned by a thread, the loaded one is used first
+struct ThreadCache
 {
-	s_available = MM_ALLOC( NotePlayHandle*, INITIAL_NPH_CACHE );
+	int loaded = NO_MAGAZINE;
+	int previous = NO_MAGAZINE;
+
+	~ThreadCache()
+	{
+		// hand the handles of exiting threads to the others
+		for( int magazine : { loaded, previous } )
+		{
+			if( magazine == NO_MAGAZINE )
+			{
+				continue;
+			}
+			if( s_magazines[magazine].count > 0 )
+			{
+				s_fullMagazines.push( magazine );
+			}
+			else
+			{
+				s_emptyMagazines.push( magazine );
+			}
+		}
+	}
+} ;
+
+thread_local ThreadCache s_threadCache;
+
+std::atomic<uint64_t> s_hits( 0 );
+std::atomic<uint64_t> s_misses( 0 );
+std::atomic_int s_inUse( 0 );
+std::atomic_int s_highWaterMark( 0 );
 
-	NotePlayHandle * n = MM_ALLOC( NotePlayHandle, INITIAL_NPH_CACHE );
 
-	for( int i=0; i < INITIAL_NPH_CACHE; ++i )
+int emptyMagazine()
+{
+	const int magazine = s_emptyMagazines.pop();
+	if( magazine != NO_MAGAZINE )
+	{
+		return magazine;
+	}
+	if( s_unusedMagazine.load( std::memory_order_relaxed ) >= MAX_MAGAZINES )
 	{
-		s_available[ i ] = n;
-		++n;
+		return NO_MAGAZINE;
+	}
+	const int unused = s_unusedMagazine.fetch_add( 1, std::memory_order_relaxed );
+	if( unused >= MAX_MAGAZINES )
+	{
+		return NO_MAGAZINE;
+	}
+	s_magazines[unused].count = 0;
+	return unused;
+}
+
+
+void * takeHandle()
+{
+	ThreadCache & cache = s_threadCache;
+	if( cache.loaded == NO_MAGAZINE || s_magazines[cache.loaded].count == 0 )
+	{
+		if( cache.previous != NO_MAGAZINE &&
+				s_magazines[cache.previous].count > 0 )
+		{
+			std::swap( cache.loaded, cache.previous );
+		}
+		else
+		{
+			const int full = s_fullMagazines.pop();
+			if( full == NO_MAGAZINE )
+			{
+				s_misses.fetch_add( 1, std::memory_order_relaxed );
+				return MM_ALLOC( NotePlayHandle, 1 );
+			}
+			// both magazines are empty, keep one of them for
+			// handles released by this thread
+			if( cache.previous != NO_MAGAZINE )
+			{
+				s_emptyMagazines.push( cache.previous );
+			}
+			cache.previous = cache.loaded;
+			cache.loaded = full;
+		}
+	}
+
+	s_hits.fetch_add( 1, std::memory_order_relaxed );
+	Magazine & magazine = s_magazines[cache.loaded];
+	return magazine.handles[--magazine.count];
+}
+
+
+void putHandle( void * handle )
+{
+	ThreadCache & cache = s_threadCache;
+	if( cache.loaded == NO_MAGAZINE ||
+			s_magazines[cache.loaded].count == MAGAZINE_SIZE )
+	{
+		if( cache.previous != NO_MAGAZINE &&
+				s_magazines[cache.previous].count < MAGAZINE_SIZE )
+		{
+			std::swap( cache.loaded, cache.previous );
+		}
+		else
+		{
+			const int empty = emptyMagazine();
+			if( empty == NO_MAGAZINE )
+			{
+				// the pool is full
+				MM_FREE( handle );
+				return;
+			}
+			// both magazines are full, keep one of them for
+			// handles acquired by this thread
+			if( cache.previous != NO_MAGAZINE )
+			{
+				s_fullMagazines.push( cache.previous );
+			}
+			cache.previous = cache.loaded;
+			cache.loaded = empty;
+		}
+	}
+
+	Magazine & magazine = s_magazines[cache.loaded];
+	magazine.handles[magazine.count++] = handle;
+}
+
+} // namespace
+
+
+
+
+void NotePlayHandleManager::init()
+{
+	for( int i = 0; i < INITIAL_NPH_CACHE; ++i )
+	{
+		putHandle( MM_ALLOC( NotePlayHandle, 1 ) );
+	}
+	// make them available to all threads
+	ThreadCache & cache = s_threadCache;
+	for( int * magazine : { &cache.loaded, &cache.previous } )
+	{
+		if( *magazine != NO_MAGAZINE && s_magazines[*magazine].count > 0 )
+		{
+			s_fullMagazines.push( *magazine );
+			*magazine = NO_MAGAZINE;
+		}
 	}
-	s_availableIndex = INITIAL_NPH_CACHE - 1;
-	s_size = INITIAL_NPH_CACHE;
 }
 
 
@@ -572,42 +790,46 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 				int midiEventChannel,
 				NotePlayHandle::Origin origin )
 {
-	if( s_availableIndex < 0 )
-	{
-		s_mutex.lockForWrite();
-		if( s_availableIndex < 0 ) extend( NPH_CACHE_INCREMENT );
-		s_mutex.unlock();
-	}
-	s_mutex.lockForRead();
-	NotePlayHandle * nph = s_available[s_availableIndex--];
-	s_mutex.unlock();
-
-	new( (void*)nph ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
-	return nph;
+	return new( allocate() ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
 }
 
 
 void NotePlayHandleManager::release( NotePlayHandle * nph )
 {
 	nph->NotePlayHandle::~NotePlayHandle();
-	s_mutex.lockForRead();
-	s_available[++s_availableIndex] = nph;
-	s_mutex.unlock();
+	deallocate( nph );
 }
 
 
-void NotePlayHandleManager::extend( int c )
+void * NotePlayHandleManager::allocate()
 {
-	s_size += c;
-	NotePlayHandle ** tmp = MM_ALLOC( NotePlayHandle*, s_size );
-	MM_FREE( s_available );
-	s_available = tmp;
-
-	NotePlayHandle * n = MM_ALLOC( NotePlayHandle, c );
+	void * storage = takeHandle();
 
-	for( int i=0; i < c; ++i )
+	const int inUse = s_inUse.fetch_add( 1, std::memory_order_relaxed ) + 1;
+	int highWaterMark = s_highWaterMark.load( std::memory_order_relaxed );
+	while( inUse > highWaterMark &&
+		!s_highWaterMark.compare_exchange_weak( highWaterMark, inUse,
+						std::memory_order_relaxed ) )
 	{
-		s_available[++s_availableIndex] = n;
-		++n;
 	}
+
+	return storage;
+}
+
+
+void NotePlayHandleManager::deallocate( void * storage )
+{
+	s_inUse.fetch_sub( 1, std::memory_order_relaxed );
+	putHandle( storage );
+}
+
+
+NotePlayHandleManager::Stats NotePlayHandleManager::stats()
+{
+	Stats s;
+	s.hits = s_hits.load( std::memory_order_relaxed );
+	s.misses = s_misses.load( std::memory_order_relaxed );
+	s.inUse = s_inUse.load( std::memory_order_relaxed );
+	s.highWaterMark = s_highWaterMark.load( std::memory_order_relaxed );
+	return s;
 }
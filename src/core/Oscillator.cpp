@@ -24,6 +24,7 @@
 
 #include "Oscillator.h"
 
+#include "BandLimitedWave.h"
 #include "BufferManager.h"
 #include "Engine.h"
 #include "Mixer.h"
@@ -47,7 +48,9 @@ Oscillator::Oscillator( const IntModel * _wave_shape_model,
 	m_subOsc( _sub_osc ),
 	m_phaseOffset( _phase_offset ),
 	m_phase( _phase_offset ),
-	m_userWave( NULL )
+	m_userWave( NULL ),
+	m_blTable( MAXTBL ),
+	m_blTableLength( TLENS[MAXTBL] )
 {
 }
 
@@ -323,6 +326,18 @@ inline void Oscillator::recalcPhase()
 
 
 
+// should be called every time the frequency may have changed, i.e. once per
+// period, so the per-sample lookup doesn't have to search the mipmap
+inline void Oscillator::selectBLTable( const float _osc_coeff )
+{
+	m_blTable = BandLimitedWave::tableIndex(
+				BandLimitedWave::pdToLen( fabsf( _osc_coeff ) ) );
+	m_blTableLength = TLENS[m_blTable];
+}
+
+
+
+
 inline bool Oscillator::syncOk( float _osc_coeff )
 {
 	const float v1 = m_phase;
@@ -355,6 +370,7 @@ void Oscillator::updateNoSub( sampleFrame * _ab, const fpp_t _frames,
 {
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning;
+	selectBLTable( osc_coeff );
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
@@ -374,6 +390,7 @@ void Oscillator::updatePM( sampleFrame * _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning;
+	selectBLTable( osc_coeff );
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
@@ -395,6 +412,7 @@ void Oscillator::updateAM( sampleFrame * _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning;
+	selectBLTable( osc_coeff );
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
@@ -414,6 +432,7 @@ void Oscillator::updateMix( sampleFrame * _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning;
+	selectBLTable( osc_coeff );
 
 	for( fpp_t frame = 0; frame < _frames; ++frame )
 	{
@@ -434,6 +453,7 @@ void Oscillator::updateSync( sampleFrame * _ab, const fpp_t _frames,
 	const float sub_osc_coeff = m_subOsc->syncInit( _ab, _frames, _chnl );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning;
+	selectBLTable( osc_coeff );
 
 	for( fpp_t frame = 0; frame < _frames ; ++frame )
 	{
@@ -457,6 +477,7 @@ void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning;
+	selectBLTable( osc_coeff );
 	const float sampleRateCorrection = 44100.0f /
 				Engine::mixer()->processingSampleRate();
 
@@ -471,6 +492,38 @@ void Oscillator::updateFM( sampleFrame * _ab, const fpp_t _frames,
 
 
 
+// interpolated sample of a band-limited table, see BandLimitedWave::oscillate()
+static inline sample_t blSample( const sample_t * _table, const int _length,
+							const float _sample )
+{
+	const float lookupf = fraction( _sample ) * _length;
+	int lookup = static_cast<int>( lookupf );
+	const float ip = lookupf - lookup;
+
+	// fraction() might have been rounded up to 1
+	if( lookup >= _length )
+	{
+		lookup -= _length;
+	}
+	const int lm = lookup == 0 ? _length - 1 : lookup - 1;
+	int l1 = lookup + 1;
+	if( l1 >= _length )
+	{
+		l1 -= _length;
+	}
+	int l2 = l1 + 1;
+	if( l2 >= _length )
+	{
+		l2 -= _length;
+	}
+
+	return optimal4pInterpolate( _table[lm], _table[lookup], _table[l1],
+							_table[l2], ip );
+}
+
+
+
+
 template<>
 inline sample_t Oscillator::getSample<Oscillator::SineWave>(
 							const float _sample )
@@ -485,7 +538,8 @@ template<>
 inline sample_t Oscillator::getSample<Oscillator::TriangleWave>(
 							const float _sample )
 {
-	return( triangleSample( _sample ) );
+	return( blSample( BandLimitedWave::s_waveforms[BandLimitedWave::BLTriangle].
+				table( m_blTable ), m_blTableLength, _sample ) );
 }
 
 
@@ -495,7 +549,8 @@ template<>
 inline sample_t Oscillator::getSample<Oscillator::SawWave>(
 							const float _sample )
 {
-	return( sawSample( _sample ) );
+	return( blSample( BandLimitedWave::s_waveforms[BandLimitedWave::BLSaw].
+				table( m_blTable ), m_blTableLength, _sample ) );
 }
 
 
@@ -505,7 +560,8 @@ template<>
 inline sample_t Oscillator::getSample<Oscillator::SquareWave>(
 							const float _sample )
 {
-	return( squareSample( _sample ) );
+	return( blSample( BandLimitedWave::s_waveforms[BandLimitedWave::BLSquare].
+				table( m_blTable ), m_blTableLength, _sample ) );
 }
 
 
@@ -515,7 +571,16 @@ template<>
 inline sample_t Oscillator::getSample<Oscillator::MoogSawWave>(
 							const float _sample )
 {
-	return( moogSawSample( _sample ) );
+	// BandLimitedWave::BLMoog has a shape of its own, so build ours
+	// from a triangle rising over the first half and a saw dropping in
+	// the middle
+	const sample_t tri = blSample( BandLimitedWave::s_waveforms[
+				BandLimitedWave::BLTriangle].table( m_blTable ),
+					m_blTableLength, _sample - 0.25f );
+	const sample_t saw = blSample( BandLimitedWave::s_waveforms[
+				BandLimitedWave::BLSaw].table( m_blTable ),
+					m_blTableLength, _sample + 0.5f );
+	return( 0.75f * tri + 0.5f * saw - 0.25f );
 }
 
 
@@ -23,6 +23,7 @@
  */
  
 #include "PlayHandle.h"
+#include "AudioPort.h"
 #include "BufferManager.h"
 #include "Engine.h"
 #include "Mixer.h"
@@ -30,6 +31,7 @@
 #include <QtCore/QThread>
 #include <QDebug>
 
+#include <algorithm>
 #include <iterator>
 
 PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
@@ -38,8 +40,11 @@ PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
 		m_affinity(QThread::currentThread()),
 		m_playHandleBuffer(BufferManager::acquire()),
 		m_bufferReleased(true),
-		m_usesBuffer(true)
+		m_usesBuffer(true),
+		m_nextRetired(nullptr),
+		m_retired(false)
 {
+	std::fill(m_slots, m_slots + SlotCount, -1);
 }
 
 
@@ -64,6 +69,25 @@ void PlayHandle::doProcessing()
 }
 
 
+ThreadableJob::ProfilingTarget PlayHandle::profilingTarget() const
+{
+	// all handles playing into the same port belong to the same track
+	const QString name = m_audioPort ? m_audioPort->name() : QString();
+	switch( m_type )
+	{
+		case TypeNotePlayHandle:
+			return { m_audioPort, name, "Notes" };
+		case TypeInstrumentPlayHandle:
+			return { m_audioPort, name, "Instrument" };
+		case TypeSamplePlayHandle:
+			return { m_audioPort, name, "Samples" };
+		case TypePresetPreviewHandle:
+			return { m_audioPort, name, "Preset preview" };
+	}
+	return { m_audioPort, name, "Play handle" };
+}
+
+
 void PlayHandle::releaseBuffer()
 {
 	m_bufferReleased = true;
@@ -0,0 +1,412 @@
+/*
+ * ProjectCache.cpp - keeps upgraded projects in a compact binary form
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QVector>
+#include <QtXml/QDomDocument>
+
+#include "ProjectCache.h"
+#include "ConfigManager.h"
+
+#include "lmmsversion.h"
+
+
+namespace
+{
+
+const quint32 Magic = 0x4c4d5043; // "LMPC"
+const quint32 FormatVersion = 2;
+
+// attribute values from this length on are stored out of line
+const int PayloadLength = 4096;
+
+// number of projects whose copies are kept
+const int MaxCachedProjects = 16;
+
+enum NodeKinds : quint8
+{
+	ElementNode,
+	TextNode,
+	CDataNode,
+	CommentNode,
+	ProcessingInstructionNode,
+	EndOfChildren
+} ;
+
+enum ValueKinds : quint8
+{
+	InlineValue,
+	PayloadValue
+} ;
+
+
+// project size in KB from which on projects get cached
+qint64 cacheThreshold()
+{
+	const int threshold = ConfigManager::inst()->value( "app",
+					"projectcachethreshold" ).toInt();
+	return qint64( threshold > 0 ? threshold : 512 ) * 1024;
+}
+
+
+
+bool isLatin1( const QString & s )
+{
+	for( const QChar c : s )
+	{
+		if( c.unicode() > 0xff )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+class Writer
+{
+public:
+	Writer() :
+		m_tree( &m_treeData, QIODevice::WriteOnly )
+	{
+		m_tree.setVersion( QDataStream::Qt_5_0 );
+	}
+
+	void writeChildren( const QDomNode & parent )
+	{
+		for( QDomNode node = parent.firstChild(); !node.isNull();
+						node = node.nextSibling() )
+		{
+			if( node.isElement() )
+			{
+				const QDomElement element = node.toElement();
+				const QDomNamedNodeMap attributes = element.attributes();
+				m_tree << quint8( ElementNode )
+					<< nameIndex( element.tagName() )
+					<< quint32( attributes.count() );
+				for( int i = 0; i < attributes.count(); ++i )
+				{
+					const QDomAttr attribute = attributes.item( i ).toAttr();
+					m_tree << nameIndex( attribute.name() );
+					writeValue( attribute.value() );
+				}
+				writeChildren( node );
+			}
+			// CDATA sections are text nodes as well
+			else if( node.isCDATASection() )
+			{
+				m_tree << quint8( CDataNode ) << node.nodeValue();
+			}
+			else if( node.isText() )
+			{
+				m_tree << quint8( TextNode ) << node.nodeValue();
+			}
+			else if( node.isComment() )
+			{
+				m_tree << quint8( CommentNode ) << node.nodeValue();
+			}
+			else if( node.isProcessingInstruction() )
+			{
+				const QDomProcessingInstruction pi =
+						node.toProcessingInstruction();
+				m_tree << quint8( ProcessingInstructionNode )
+						<< pi.target() << pi.data();
+			}
+		}
+		m_tree << quint8( EndOfChildren );
+	}
+
+	void write( QDataStream & out ) const
+	{
+		out << m_names;
+		out << quint32( m_payloads.size() );
+		for( const QByteArray & payload : m_payloads )
+		{
+			out << quint32( payload.size() );
+			out.writeRawData( payload.constData(), payload.size() );
+		}
+		out.writeRawData( m_treeData.constData(), m_treeData.size() );
+	}
+
+private:
+	quint32 nameIndex( const QString & name )
+	{
+		QHash<QString, quint32>::ConstIterator it = m_nameIndices.find( name );
+		if( it != m_nameIndices.end() )
+		{
+			return *it;
+		}
+		m_names.push_back( name );
+		return m_nameIndices[name] = m_names.size() - 1;
+	}
+
+	void writeValue( const QString & value )
+	{
+		if( value.size() >= PayloadLength && isLatin1( value ) )
+		{
+			m_tree << quint8( PayloadValue ) << quint32( m_payloads.size() );
+			m_payloads.push_back( value.toLatin1() );
+		}
+		else
+		{
+			m_tree << quint8( InlineValue ) << value;
+		}
+	}
+
+	QVector<QString> m_names;
+	QHash<QString, quint32> m_nameIndices;
+	QVector<QByteArray> m_payloads;
+	QByteArray m_treeData;
+	QDataStream m_tree;
+
+} ;
+
+
+
+bool readTree( QDataStream & in, const QVector<QString> & names,
+		const QVector<QPair<const char *, int> > & payloads,
+		QDomDocument & doc )
+{
+	QDomNode parent = doc;
+	while( in.status() == QDataStream::Ok )
+	{
+		quint8 kind;
+		in >> kind;
+		if( in.status() != QDataStream::Ok )
+		{
+			return false;
+		}
+		switch( kind )
+		{
+			case ElementNode:
+			{
+				quint32 name, attributeCount;
+				in >> name >> attributeCount;
+				if( name >= quint32( names.size() ) )
+				{
+					return false;
+				}
+				QDomElement element = doc.createElement( names[name] );
+				for( quint32 i = 0; i < attributeCount; ++i )
+				{
+					quint32 attributeName;
+					quint8 valueKind;
+					in >> attributeName >> valueKind;
+					if( attributeName >= quint32( names.size() ) )
+					{
+						return false;
+					}
+					if( valueKind == PayloadValue )
+					{
+						quint32 payload;
+						in >> payload;
+						if( payload >= quint32( payloads.size() ) )
+						{
+							return false;
+						}
+						element.setAttribute( names[attributeName],
+							QString::fromLatin1( payloads[payload].first,
+									payloads[payload].second ) );
+					}
+					else
+					{
+						QString value;
+						in >> value;
+						element.setAttribute( names[attributeName], value );
+					}
+				}
+				parent = parent.appendChild( element );
+				break;
+			}
+			case TextNode:
+			case CDataNode:
+			case CommentNode:
+			{
+				QString value;
+				in >> value;
+				parent.appendChild( kind == TextNode ?
+						QDomNode( doc.createTextNode( value ) ) :
+					kind == CDataNode ?
+						QDomNode( doc.createCDATASection( value ) ) :
+						QDomNode( doc.createComment( value ) ) );
+				break;
+			}
+			case ProcessingInstructionNode:
+			{
+				QString target, data;
+				in >> target >> data;
+				parent.appendChild( doc.createProcessingInstruction(
+								target, data ) );
+				break;
+			}
+			case EndOfChildren:
+				if( parent.isDocument() )
+				{
+					return in.status() == QDataStream::Ok;
+				}
+				parent = parent.parentNode();
+				break;
+			default:
+				return false;
+		}
+	}
+	return false;
+}
+
+}
+
+
+
+
+bool ProjectCache::load( const QFileInfo & source, QDomDocument & doc,
+							QString & creatorVersion )
+{
+	QFile file( cacheFile( source.absoluteFilePath() ) );
+	if( source.size() < cacheThreshold() || !file.open( QIODevice::ReadOnly ) )
+	{
+		return false;
+	}
+
+	// payloads are turned into strings right from the mapping
+	const qint64 size = file.size();
+	const char * data = reinterpret_cast<const char *>( file.map( 0, size ) );
+	if( data == NULL )
+	{
+		return false;
+	}
+	QDataStream in( QByteArray::fromRawData( data, size ) );
+	in.setVersion( QDataStream::Qt_5_0 );
+
+	quint32 magic, formatVersion;
+	QString lmmsVersion, createdWith;
+	qint64 sourceSize, sourceModified;
+	in >> magic >> formatVersion >> lmmsVersion >> sourceSize >> sourceModified
+		>> createdWith;
+	if( in.status() != QDataStream::Ok || magic != Magic ||
+		formatVersion != FormatVersion || lmmsVersion != LMMS_VERSION ||
+		sourceSize != source.size() ||
+		sourceModified != source.lastModified().toMSecsSinceEpoch() )
+	{
+		return false;
+	}
+
+	QVector<QString> names;
+	quint32 payloadCount;
+	in >> names >> payloadCount;
+	QVector<QPair<const char *, int> > payloads;
+	for( quint32 i = 0; i < payloadCount && in.status() == QDataStream::Ok; ++i )
+	{
+		quint32 length;
+		in >> length;
+		payloads.push_back( qMakePair( data + in.device()->pos(), int( length ) ) );
+		if( in.skipRawData( length ) != int( length ) )
+		{
+			return false;
+		}
+	}
+
+	if( in.status() != QDataStream::Ok || !readTree( in, names, payloads, doc ) )
+	{
+		qWarning( "Ignoring damaged project cache %s",
+					qPrintable( file.fileName() ) );
+		doc = QDomDocument( doc.doctype().name() );
+		return false;
+	}
+
+	creatorVersion = createdWith;
+	return true;
+}
+
+
+
+
+void ProjectCache::store( const QFileInfo & source, const QDomDocument & doc,
+						const QString & creatorVersion )
+{
+	if( source.size() < cacheThreshold() )
+	{
+		return;
+	}
+
+	const QString fileName = cacheFile( source.absoluteFilePath() );
+	QDir dir = QFileInfo( fileName ).dir();
+	if( !dir.mkpath( "." ) )
+	{
+		return;
+	}
+
+	Writer writer;
+	writer.writeChildren( doc );
+
+	QSaveFile file( fileName );
+	if( !file.open( QIODevice::WriteOnly ) )
+	{
+		return;
+	}
+	QDataStream out( &file );
+	out.setVersion( QDataStream::Qt_5_0 );
+	out << Magic << FormatVersion << QString( LMMS_VERSION )
+		<< qint64( source.size() )
+		<< qint64( source.lastModified().toMSecsSinceEpoch() )
+		<< creatorVersion;
+	writer.write( out );
+	if( out.status() != QDataStream::Ok || !file.commit() )
+	{
+		return;
+	}
+
+	// drop the oldest copies
+	const QFileInfoList copies = dir.entryInfoList( QStringList( "*.mmpc" ),
+							QDir::Files, QDir::Time );
+	for( int i = MaxCachedProjects; i < copies.size(); ++i )
+	{
+		QFile::remove( copies[i].absoluteFilePath() );
+	}
+}
+
+
+
+
+void ProjectCache::remove( const QString & source )
+{
+	QFile::remove( cacheFile( QFileInfo( source ).absoluteFilePath() ) );
+}
+
+
+
+
+QString ProjectCache::cacheFile( const QString & source )
+{
+	const QByteArray hash = QCryptographicHash::hash( source.toUtf8(),
+					QCryptographicHash::Sha1 ).toHex();
+	return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+				"/projects/" + QString::fromLatin1( hash ) + ".mmpc";
+}
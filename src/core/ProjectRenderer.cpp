@@ -28,6 +28,7 @@
 #include "ProjectRenderer.h"
 #include "Song.h"
 #include "PerfLog.h"
+#include "StemExporter.h"
 
 #include "AudioFileWave.h"
 #include "AudioFileOgg.h"
@@ -82,26 +83,27 @@ ProjectRenderer::ProjectRenderer( const Mixer::qualitySettings & qualitySettings
 					ExportFileFormats exportFileFormat,
 					const QString & outputFilename ) :
 	QThread( Engine::mixer() ),
-	m_fileDev( NULL ),
+	m_fileDev( createFileDevice( outputSettings, exportFileFormat,
+							outputFilename ) ),
+	m_stemExporter( NULL ),
 	m_qualitySettings( qualitySettings ),
 	m_progress( 0 ),
 	m_abort( false )
 {
-	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[exportFileFormat].m_getDevInst;
+}
 
-	if (audioEncoderFactory)
-	{
-		bool successful = false;
 
-		m_fileDev = audioEncoderFactory(
-					outputFilename, outputSettings, DEFAULT_CHANNELS,
-					Engine::mixer(), successful );
-		if( !successful )
-		{
-			delete m_fileDev;
-			m_fileDev = NULL;
-		}
-	}
+
+
+ProjectRenderer::ProjectRenderer( const Mixer::qualitySettings & qualitySettings,
+					AudioFileDevice * fileDevice ) :
+	QThread( Engine::mixer() ),
+	m_fileDev( fileDevice ),
+	m_stemExporter( NULL ),
+	m_qualitySettings( qualitySettings ),
+	m_progress( 0 ),
+	m_abort( false )
+{
 }
 
 
@@ -114,6 +116,32 @@ ProjectRenderer::~ProjectRenderer()
 
 
 
+AudioFileDevice * ProjectRenderer::createFileDevice(
+					const OutputSettings & outputSettings,
+					ExportFileFormats exportFileFormat,
+					const QString & outputFilename )
+{
+	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[exportFileFormat].m_getDevInst;
+	if( !audioEncoderFactory )
+	{
+		return NULL;
+	}
+
+	bool successful = false;
+	AudioFileDevice * fileDev = audioEncoderFactory(
+				outputFilename, outputSettings, DEFAULT_CHANNELS,
+				Engine::mixer(), successful );
+	if( !successful )
+	{
+		delete fileDev;
+		return NULL;
+	}
+	return fileDev;
+}
+
+
+
+
 // Little help function for getting file format from a file extension
 // (only for registered file-encoders).
 ProjectRenderer::ExportFileFormats ProjectRenderer::getFileFormatFromExtension(
@@ -182,8 +210,15 @@ void ProjectRenderer::run()
 
 	Engine::getSong()->startExport();
 	Engine::getSong()->updateLength();
-	// Skip first empty buffer.
-	Engine::mixer()->nextBuffer();
+
+	// installed before the first period renders. We render directly in
+	// this thread and nextBuffer() returns the period just rendered, so
+	// the mixer taps the stems of exactly the periods we write.
+	if( m_stemExporter )
+	{
+		m_stemExporter->start();
+		Engine::mixer()->m_stemExporter = m_stemExporter;
+	}
 
 	m_progress = 0;
 
@@ -205,6 +240,12 @@ void ProjectRenderer::run()
 	// Notify mixer of the end of processing.
 	Engine::mixer()->stopProcessing();
 
+	if( m_stemExporter )
+	{
+		Engine::mixer()->m_stemExporter = NULL;
+		m_stemExporter->finish();
+	}
+
 	Engine::getSong()->stopExport();
 
 	perfLog.end();
@@ -214,6 +255,10 @@ void ProjectRenderer::run()
 	if( m_abort )
 	{
 		QFile( f ).remove();
+		if( m_stemExporter )
+		{
+			m_stemExporter->removeOutputFiles();
+		}
 	}
 }
 
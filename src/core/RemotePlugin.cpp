@@ -30,11 +30,13 @@
 
 #include "BufferManager.h"
 #include "RemotePlugin.h"
+#include "ConfigManager.h"
 #include "Mixer.h"
 #include "Engine.h"
 
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 
 #ifndef SYNC_WITH_SHM_FIFO
 #include <QtCore/QUuid>
@@ -91,7 +93,11 @@ RemotePlugin::RemotePlugin() :
 	m_shmSize( 0 ),
 	m_shm( NULL ),
 	m_inputCount( DEFAULT_CHANNELS ),
-	m_outputCount( DEFAULT_CHANNELS )
+	m_outputCount( DEFAULT_CHANNELS ),
+	m_pipelined( ConfigManager::inst()->value( "mixer",
+					"pipelineremoteplugins" ).toInt() ),
+	m_submittedPeriod( 0 ),
+	m_periodPending( false )
 {
 #ifndef SYNC_WITH_SHM_FIFO
 	struct sockaddr_un sa;
@@ -296,7 +302,73 @@ bool RemotePlugin::process( const sampleFrame * _in_buf,
 		return false;
 	}
 
-	memset( m_shm, 0, m_shmSize );
+	lock();
+
+	// collect what's left from pipelined mode, even if it got disabled
+	const bool havePrevious = m_periodPending && waitForSubmittedPeriod();
+	m_periodPending = false;
+
+	if( m_pipelined )
+	{
+		if( _out_buf != NULL )
+		{
+			if( havePrevious )
+			{
+				readOutput( _out_buf, frames );
+			}
+			else
+			{
+				BufferManager::clear( _out_buf, frames );
+			}
+		}
+
+		// unsigned, so it wraps around without overflowing
+		const int32_t period = static_cast<int32_t>(
+				static_cast<uint32_t>( m_submittedPeriod ) + 1 );
+		writeInput( _in_buf, frames );
+		sendMessage( message( IdStartProcessing ).addInt( 1 ).
+							addInt( period ) );
+		if( !m_failed )
+		{
+			m_submittedPeriod = period;
+			m_periodPending = true;
+		}
+		unlock();
+		return havePrevious;
+	}
+
+	writeInput( _in_buf, frames );
+	sendMessage( message( IdStartProcessing ).addInt( 0 ) );
+
+	if( m_failed || _out_buf == NULL || m_outputCount == 0 )
+	{
+		unlock();
+		return false;
+	}
+
+	waitForMessage( IdProcessingDone );
+	unlock();
+
+	readOutput( _out_buf, frames );
+
+	return true;
+}
+
+
+
+
+fpp_t RemotePlugin::latencyFrames() const
+{
+	return m_pipelined ? Engine::mixer()->framesPerPeriod() : 0;
+}
+
+
+
+
+void RemotePlugin::writeInput( const sampleFrame * _in_buf, fpp_t frames )
+{
+	// leave the period counter behind the samples alone
+	memset( m_shm, 0, m_shmSize - sizeof( PeriodCounter ) );
 
 	ch_cnt_t inputs = qMin<ch_cnt_t>( m_inputCount, DEFAULT_CHANNELS );
 
@@ -329,19 +401,13 @@ bool RemotePlugin::process( const sampleFrame * _in_buf,
 			}
 		}
 	}
+}
 
-	lock();
-	sendMessage( IdStartProcessing );
 
-	if( m_failed || _out_buf == NULL || m_outputCount == 0 )
-	{
-		unlock();
-		return false;
-	}
 
-	waitForMessage( IdProcessingDone );
-	unlock();
 
+void RemotePlugin::readOutput( sampleFrame * _out_buf, fpp_t frames )
+{
 	const ch_cnt_t outputs = qMin<ch_cnt_t>( m_outputCount,
 							DEFAULT_CHANNELS );
 	if( m_splitChannels )
@@ -376,8 +442,45 @@ bool RemotePlugin::process( const sampleFrame * _in_buf,
 			}
 		}
 	}
+}
 
-	return true;
+
+
+
+// waits until the client finished the last submitted period, which it
+// usually did already while the mixer was busy with the rest of the period
+bool RemotePlugin::waitForSubmittedPeriod()
+{
+	PeriodCounter * counter = periodCounter( m_shm, m_shmSize );
+
+	QElapsedTimer timer;
+	timer.start();
+	for( int spins = 0; ; ++spins )
+	{
+		const int32_t done = counter->load( std::memory_order_acquire );
+		if( done == m_submittedPeriod )
+		{
+			return true;
+		}
+		if( m_failed || !isRunning() || timer.elapsed() > 1000 )
+		{
+			// the client went away or is stuck. If it finishes the
+			// period later on, it stores a number which doesn't match
+			// the next period anymore.
+			return false;
+		}
+		if( spins < 64 )
+		{
+			continue;
+		}
+#ifdef __linux__
+		const struct timespec timeout = { 0, 1000000 };
+		syscall( SYS_futex, counter, FUTEX_WAIT, done, &timeout,
+								NULL, 0 );
+#else
+		QThread::usleep( 100 );
+#endif
+	}
 }
 
 
@@ -418,7 +521,7 @@ void RemotePlugin::resizeSharedProcessingMemory()
 {
 	const size_t s = ( m_inputCount+m_outputCount ) *
 				Engine::mixer()->framesPerPeriod() *
-							sizeof( float );
+					sizeof( float ) + sizeof( PeriodCounter );
 	if( m_shm != NULL )
 	{
 #ifdef USE_QT_SHMEM
@@ -447,6 +550,9 @@ void RemotePlugin::resizeSharedProcessingMemory()
 	m_shm = (float *) shmat( m_shmID, 0, 0 );
 #endif
 	m_shmSize = s;
+	periodCounter( m_shm, m_shmSize )->store( 0 );
+	m_submittedPeriod = 0;
+	m_periodPending = false;
 	sendMessage( message( IdChangeSharedMemoryKey ).
 				addInt( shm_key ).addInt( m_shmSize ) );
 }
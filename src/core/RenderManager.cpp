@@ -29,6 +29,10 @@
 #include "Song.h"
 #include "BBTrackContainer.h"
 #include "BBTrack.h"
+#include "FxMixer.h"
+#include "InstrumentTrack.h"
+#include "SampleTrack.h"
+#include "StemExporter.h"
 #include "stdshims.h"
 
 
@@ -128,6 +132,92 @@ void RenderManager::renderTracks()
 	renderNextTrack();
 }
 
+// Render the song once and write the output of each track into its own file
+void RenderManager::renderStems( bool fxChannels )
+{
+	m_stemExporter = make_unique<StemExporter>();
+
+	QVector<Track*> tracks;
+	for( Track* tk : Engine::getSong()->tracks() )
+	{
+		tracks.push_back( tk );
+	}
+	for( Track* tk : Engine::getBBTrackContainer()->tracks() )
+	{
+		tracks.push_back( tk );
+	}
+
+	int num = 1;
+	for( Track* tk : tracks )
+	{
+		AudioPort * port = NULL;
+		if( tk->type() == Track::InstrumentTrack )
+		{
+			port = static_cast<InstrumentTrack *>( tk )->audioPort();
+		}
+		else if( tk->type() == Track::SampleTrack )
+		{
+			port = static_cast<SampleTrack *>( tk )->audioPort();
+		}
+		if( port == NULL || tk->isMuted() )
+		{
+			continue;
+		}
+
+		AudioFileDevice * dev = ProjectRenderer::createFileDevice(
+				m_outputSettings, m_format, pathForTrack( tk, num ) );
+		if( dev )
+		{
+			m_stemExporter->addPortStem( port, dev );
+			++num;
+		}
+		else
+		{
+			qDebug( "Could not create file device for track %s",
+						qPrintable( tk->name() ) );
+		}
+	}
+
+	if( fxChannels )
+	{
+		FxMixer * fxMixer = Engine::fxMixer();
+		for( int i = 1; i < fxMixer->numChannels(); ++i )
+		{
+			FxChannel * ch = fxMixer->effectChannel( i );
+			if( ch->m_muteModel.value() )
+			{
+				continue;
+			}
+			AudioFileDevice * dev = ProjectRenderer::createFileDevice(
+					m_outputSettings, m_format,
+					pathForName( ch->m_name, num ) );
+			if( dev )
+			{
+				m_stemExporter->addChannelStem( ch, dev );
+				++num;
+			}
+		}
+
+		// the master channel is the mix itself
+		m_activeRenderer = make_unique<ProjectRenderer>(
+				m_qualitySettings,
+				m_outputSettings,
+				m_format,
+				pathForName( "Master", 0 ) );
+	}
+	else
+	{
+		// nobody asked for the mix, so throw it away
+		m_activeRenderer = make_unique<ProjectRenderer>(
+				m_qualitySettings,
+				new AudioFileDevice( m_outputSettings, DEFAULT_CHANNELS,
+							QString(), Engine::mixer() ) );
+	}
+	m_activeRenderer->setStemExporter( m_stemExporter.get() );
+
+	startRenderer();
+}
+
 // Render the song into a single track
 void RenderManager::renderProject()
 {
@@ -142,6 +232,11 @@ void RenderManager::render(QString outputPath)
 			m_format,
 			outputPath);
 
+	startRenderer();
+}
+
+void RenderManager::startRenderer()
+{
 	if( m_activeRenderer->isReady() )
 	{
 		// pass progress signals through
@@ -175,9 +270,13 @@ void RenderManager::restoreMutedState()
 
 // Determine the output path for a track when rendering tracks individually
 QString RenderManager::pathForTrack(const Track *track, int num)
+{
+	return pathForName( track->name(), num );
+}
+
+QString RenderManager::pathForName(QString name, int num)
 {
 	QString extension = ProjectRenderer::getFileExtensionFromFormat( m_format );
-	QString name = track->name();
 	name = name.remove(QRegExp("[^a-zA-Z]"));
 	name = QString( "%1_%2%3" ).arg( num ).arg( name ).arg( extension );
 	return QDir(m_outputPath).filePath(name);
@@ -26,11 +26,17 @@
 
 
 #include <QBuffer>
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QLockFile>
 #include <QMessageBox>
 #include <QPainter>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
 
+#include <memory>
 
 #include <sndfile.h>
 
@@ -58,6 +64,35 @@
 
 #include "FileDialog.h"
 
+#ifdef LMMS_BUILD_LINUX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+// frames decoded at once when decoding into a cache file
+static const f_cnt_t CACHE_CHUNK_FRAMES = 65536;
+
+// frames of a cache file paged in ahead of a play cursor, about three
+// seconds at 44.1 kHz
+static const f_cnt_t PREFETCH_FRAMES = 131072;
+
+// decoded size in MB from which on files get decoded into a memory-mapped
+// cache file instead of memory
+static qint64 streamingThreshold()
+{
+	const int threshold = ConfigManager::inst()->value( "app",
+					"samplestreamthreshold" ).toInt();
+	return qint64( threshold > 0 ? threshold : 64 ) * 1024 * 1024;
+}
+
+// Every instance decodes into a directory of its own, which is locked as long
+// as the instance runs and removed when it exits. The directories of crashed
+// instances are left unlocked, see SampleBuffer::initCacheDirectory(). The
+// lock is declared first, so that it's released after removing the directory.
+static std::unique_ptr<QLockFile> cacheDirectoryLock;
+static std::unique_ptr<QTemporaryDir> cacheDirectory;
+
 
 
 SampleBuffer::SampleBuffer() :
@@ -65,6 +100,7 @@ SampleBuffer::SampleBuffer() :
 	m_origData( NULL ),
 	m_origFrames( 0 ),
 	m_data( NULL ),
+	m_cacheFile( NULL ),
 	m_frames( 0 ),
 	m_startFrame( 0 ),
 	m_endFrame( 0 ),
@@ -133,7 +169,31 @@ SampleBuffer::SampleBuffer( const f_cnt_t _frames )
 SampleBuffer::~SampleBuffer()
 {
 	MM_FREE( m_origData );
-	MM_FREE( m_data );
+	freeData();
+}
+
+
+
+
+void SampleBuffer::freeData()
+{
+	if( m_sharedData )
+	{
+		// other buffers may still use it
+		m_sharedData.reset();
+	}
+	else if( m_cacheFile )
+	{
+		// removes the file as well
+		m_cacheFile->unmap( reinterpret_cast<uchar *>( m_data ) );
+		delete m_cacheFile;
+		m_cacheFile = NULL;
+	}
+	else
+	{
+		MM_FREE( m_data );
+	}
+	m_data = NULL;
 }
 
 
@@ -151,7 +211,7 @@ void SampleBuffer::update( bool _keep_settings )
 	{
 		Engine::mixer()->requestChangeInModel();
 		m_varLock.lockForWrite();
-		MM_FREE( m_data );
+		freeData();
 	}
 
 	// File size and sample length limits
@@ -179,14 +239,30 @@ void SampleBuffer::update( bool _keep_settings )
 		sample_t * fbuf = NULL;
 		ch_cnt_t channels = DEFAULT_CHANNELS;
 		sample_rate_t samplerate = Engine::mixer()->baseSampleRate();
-		m_frames = 0;
+		// buffers playing the same file share its frames, so it's
+		// decoded only once
+		const QString cacheKey = SampleCache::key( file,
+				Engine::mixer()->baseSampleRate(), m_reversed );
+		m_sharedData = SampleCache::find( cacheKey );
+		if( m_sharedData )
+		{
+			m_data = m_sharedData->frames();
+			m_frames = m_sharedData->frameCount();
+			samplerate = Engine::mixer()->baseSampleRate();
+		}
+		else
+		{
+			// large files are decoded into a memory-mapped cache
+			// file, which isn't subject to the limits
+			m_frames = decodeSampleToCache( file, samplerate );
+		}
 
 		const QFileInfo fileInfo( file );
-		if( fileInfo.size() > fileSizeMax * 1024 * 1024 )
+		if( m_frames == 0 && fileInfo.size() > fileSizeMax * 1024 * 1024 )
 		{
 			fileLoadError = true;
 		}
-		else
+		else if( m_frames == 0 )
 		{
 			// Use QFile to handle unicode file names on Windows
 			QFile f(file);
@@ -250,6 +326,12 @@ void SampleBuffer::update( bool _keep_settings )
 		else // otherwise normalize sample rate
 		{
 			normalizeSampleRate( samplerate, _keep_settings );
+			if( !m_sharedData )
+			{
+				m_sharedData = SampleCache::insert( cacheKey, m_data,
+							m_frames, m_cacheFile );
+				m_cacheFile = NULL;
+			}
 		}
 	}
 	else
@@ -370,7 +452,7 @@ void SampleBuffer::normalizeSampleRate( const sample_rate_t _src_sr,
 	{
 		SampleBuffer * resampled = resample( _src_sr,
 					Engine::mixer()->baseSampleRate() );
-		MM_FREE( m_data );
+		freeData();
 		m_frames = resampled->frames();
 		m_data = MM_ALLOC( sampleFrame, m_frames );
 		memcpy( m_data, resampled->data(), m_frames *
@@ -389,6 +471,191 @@ void SampleBuffer::normalizeSampleRate( const sample_rate_t _src_sr,
 
 
 
+f_cnt_t SampleBuffer::decodeSampleToCache( const QString & _f,
+						sample_rate_t & _samplerate )
+{
+	// Use QFile to handle unicode file names on Windows
+	QFile f( _f );
+	if( !f.open( QIODevice::ReadOnly ) )
+	{
+		return 0;
+	}
+	SF_INFO sf_info;
+	sf_info.format = 0;
+	SNDFILE * snd_file = sf_open_fd( f.handle(), SFM_READ, &sf_info, false );
+	if( snd_file == NULL )
+	{
+		return 0;
+	}
+
+	const sample_rate_t dstRate = Engine::mixer()->baseSampleRate();
+	const double ratio = (double) dstRate / sf_info.samplerate;
+	// reversed files are read backwards in chunks
+	if( sf_info.frames * ratio * BYTES_PER_FRAME < streamingThreshold() ||
+		( m_reversed && !sf_info.seekable ) )
+	{
+		sf_close( snd_file );
+		return 0;
+	}
+
+	if( cacheDirectory == NULL )
+	{
+		sf_close( snd_file );
+		return 0;
+	}
+
+	std::unique_ptr<QTemporaryFile> cache( new QTemporaryFile(
+			cacheDirectory->path() + "/lmms-sample-XXXXXX.raw" ) );
+	SRC_STATE * state = NULL;
+	int error = 0;
+	if( !cache->open() || ( ratio != 1.0 && ( state = src_new(
+		SRC_SINC_MEDIUM_QUALITY, DEFAULT_CHANNELS, &error ) ) == NULL ) )
+	{
+		sf_close( snd_file );
+		return 0;
+	}
+
+	const int channels = sf_info.channels;
+	const int ch = ( channels > 1 ) ? 1 : 0;
+	const f_cnt_t outFrames = static_cast<f_cnt_t>( CACHE_CHUNK_FRAMES * ratio ) + 1;
+	std::unique_ptr<sample_t[]> in( new sample_t[CACHE_CHUNK_FRAMES * channels] );
+	std::unique_ptr<sampleFrame[]> frames( new sampleFrame[CACHE_CHUNK_FRAMES] );
+	std::unique_ptr<sampleFrame[]> out( new sampleFrame[outFrames] );
+
+	bool ok = true;
+	sf_count_t done = 0;
+	while( ok && done < sf_info.frames )
+	{
+		const sf_count_t todo = qMin<sf_count_t>( CACHE_CHUNK_FRAMES,
+						sf_info.frames - done );
+		if( m_reversed )
+		{
+			sf_seek( snd_file, sf_info.frames - done - todo, SEEK_SET );
+		}
+		if( sf_readf_float( snd_file, in.get(), todo ) < todo )
+		{
+			// keep what we got so far
+			break;
+		}
+		done += todo;
+
+		for( f_cnt_t frame = 0; frame < todo; ++frame )
+		{
+			const int idx = ( m_reversed ? todo - 1 - frame : frame ) * channels;
+			frames[frame][0] = in[idx+0];
+			frames[frame][1] = in[idx+ch];
+		}
+
+		if( state == NULL )
+		{
+			ok = cache->write( reinterpret_cast<const char *>( frames.get() ),
+						todo * BYTES_PER_FRAME ) == todo * BYTES_PER_FRAME;
+			continue;
+		}
+
+		SRC_DATA src_data;
+		src_data.data_in = frames[0];
+		src_data.input_frames = todo;
+		src_data.end_of_input = done >= sf_info.frames;
+		src_data.src_ratio = ratio;
+		do
+		{
+			src_data.data_out = out[0];
+			src_data.output_frames = outFrames;
+			if( ( error = src_process( state, &src_data ) ) )
+			{
+				printf( "SampleBuffer: error while resampling: %s\n",
+							src_strerror( error ) );
+				ok = false;
+				break;
+			}
+			const qint64 bytes = src_data.output_frames_gen * BYTES_PER_FRAME;
+			ok = cache->write( reinterpret_cast<const char *>( out.get() ),
+								bytes ) == bytes;
+			src_data.data_in += src_data.input_frames_used * DEFAULT_CHANNELS;
+			src_data.input_frames -= src_data.input_frames_used;
+		}
+		// at the end of input, flush until the converter is empty
+		while( ok && ( src_data.input_frames > 0 ||
+			( src_data.end_of_input && src_data.output_frames_gen > 0 ) ) );
+	}
+
+	if( state )
+	{
+		src_delete( state );
+	}
+	sf_close( snd_file );
+	f.close();
+
+	const f_cnt_t cachedFrames = cache->size() / BYTES_PER_FRAME;
+	uchar * mapped = ok && cachedFrames > 0 && cache->flush()
+		? cache->map( 0, cachedFrames * BYTES_PER_FRAME )
+		: NULL;
+	if( mapped == NULL )
+	{
+		// let the regular decoders try
+		return 0;
+	}
+
+#ifdef LMMS_BUILD_LINUX
+	// samples are mostly played from start to end, so let the kernel read ahead
+	madvise( mapped, cachedFrames * BYTES_PER_FRAME, MADV_SEQUENTIAL );
+#endif
+
+	m_data = reinterpret_cast<sampleFrame *>( mapped );
+	m_cacheFile = cache.release();
+	_samplerate = dstRate;
+	return cachedFrames;
+}
+
+
+
+
+void SampleBuffer::initCacheDirectory()
+{
+	// not in the temp dir, which often is a tmpfs and thus lives in memory
+	const QString root = QStandardPaths::writableLocation(
+				QStandardPaths::CacheLocation ) + "/samples";
+	QDir rootDir( root );
+	if( !rootDir.mkpath( "." ) )
+	{
+		// decode everything into memory
+		return;
+	}
+
+	// a lock we get belongs to an instance which is gone. Directories
+	// without a lock file are just being set up by another instance.
+	const QStringList sessions = rootDir.entryList(
+			QStringList( "session-*" ), QDir::Dirs | QDir::NoDotAndDotDot );
+	for( const QString & session : sessions )
+	{
+		const QString path = rootDir.filePath( session );
+		QLockFile lock( path + ".lock" );
+		if( QFileInfo::exists( path + ".lock" ) && lock.tryLock( 0 ) )
+		{
+			QDir( path ).removeRecursively();
+			lock.unlock();
+		}
+	}
+
+	std::unique_ptr<QTemporaryDir> dir(
+				new QTemporaryDir( root + "/session-XXXXXX" ) );
+	if( !dir->isValid() )
+	{
+		return;
+	}
+	std::unique_ptr<QLockFile> lock( new QLockFile( dir->path() + ".lock" ) );
+	if( !lock->tryLock( 0 ) )
+	{
+		return;
+	}
+	cacheDirectoryLock = std::move( lock );
+	cacheDirectory = std::move( dir );
+}
+
+
+
+
 f_cnt_t SampleBuffer::decodeSampleSF(QString _f,
 					sample_t * & _buf,
 					ch_cnt_t & _channels,
@@ -665,6 +932,8 @@ bool SampleBuffer::play( sampleFrame * _ab, handleState * _state,
 		play_frame = getPingPongIndex( play_frame, loopStartFrame, loopEndFrame );
 	}
 
+	prefetch( _state, play_frame, is_backwards );
+
 	f_cnt_t fragment_size = (f_cnt_t)( _frames * freq_factor ) + MARGIN[ _state->interpolationMode() ];
 
 	sampleFrame * tmp = NULL;
@@ -783,6 +1052,47 @@ bool SampleBuffer::play( sampleFrame * _ab, handleState * _state,
 
 
 
+void SampleBuffer::prefetch( handleState * _state, f_cnt_t _index,
+							bool _backwards ) const
+{
+#ifdef LMMS_BUILD_LINUX
+	if( !isStreamed() )
+	{
+		return;
+	}
+
+	// advise again once the cursor got halfway through the last window, so
+	// the kernel reads ahead of it instead of the audio thread faulting
+	const f_cnt_t half = PREFETCH_FRAMES / 2;
+	if( _backwards ? _index <= _state->m_prefetchEnd &&
+				qMax<f_cnt_t>( _index - half, 0 ) >= _state->m_prefetchBegin
+			: _index >= _state->m_prefetchBegin &&
+				qMin<f_cnt_t>( _index + half, m_frames ) <= _state->m_prefetchEnd )
+	{
+		return;
+	}
+
+	const f_cnt_t begin = _backwards ? qMax<f_cnt_t>( _index - PREFETCH_FRAMES, 0 ) : _index;
+	const f_cnt_t end = _backwards ? _index : qMin<f_cnt_t>( _index + PREFETCH_FRAMES, m_frames );
+	if( begin >= end )
+	{
+		return;
+	}
+
+	// madvise() wants page aligned addresses
+	static const uintptr_t pageMask = sysconf( _SC_PAGESIZE ) - 1;
+	const uintptr_t first = reinterpret_cast<uintptr_t>( m_data + begin ) & ~pageMask;
+	const uintptr_t last = reinterpret_cast<uintptr_t>( m_data + end );
+	madvise( reinterpret_cast<void *>( first ), last - first, MADV_WILLNEED );
+
+	_state->m_prefetchBegin = begin;
+	_state->m_prefetchEnd = end;
+#endif
+}
+
+
+
+
 sampleFrame * SampleBuffer::getSampleFragment( f_cnt_t _index,
 		f_cnt_t _frames, LoopMode _loopmode, sampleFrame * * _tmp, bool * _backwards,
 		f_cnt_t _loopstart, f_cnt_t _loopend, f_cnt_t _end ) const
@@ -1466,7 +1776,9 @@ QString SampleBuffer::tryToMakeAbsolute(const QString& file)
 SampleBuffer::handleState::handleState( bool _varying_pitch, int interpolation_mode ) :
 	m_frameIndex( 0 ),
 	m_varyingPitch( _varying_pitch ),
-	m_isBackwards( false )
+	m_isBackwards( false ),
+	m_prefetchBegin( 0 ),
+	m_prefetchEnd( 0 )
 {
 	int error;
 	m_interpolationMode = interpolation_mode;
@@ -0,0 +1,164 @@
+/*
+ * SampleCache.cpp - shares decoded audio files between sample buffers
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QTemporaryFile>
+
+#include "SampleCache.h"
+#include "MemoryManager.h"
+
+
+static QMutex s_mutex;
+static QHash<QString, std::weak_ptr<CachedSample>> s_entries;
+
+
+CachedSample::CachedSample( sampleFrame * frames, f_cnt_t frameCount,
+						QTemporaryFile * mappedFile ) :
+	m_frames( frames ),
+	m_frameCount( frameCount ),
+	m_mappedFile( mappedFile )
+{
+}
+
+
+
+
+CachedSample::~CachedSample()
+{
+	if( m_mappedFile )
+	{
+		// removes the file as well
+		m_mappedFile->unmap( reinterpret_cast<uchar *>( m_frames ) );
+		delete m_mappedFile;
+	}
+	else
+	{
+		MM_FREE( m_frames );
+	}
+}
+
+
+
+
+QString SampleCache::key( const QString & file, sample_rate_t sampleRate,
+								bool reversed )
+{
+	// a file which got changed on disk gets decoded again
+	const QFileInfo info( file );
+	return QString( "%1\n%2\n%3\n%4\n%5" ).
+		arg( info.absoluteFilePath() ).
+		arg( info.lastModified().toMSecsSinceEpoch() ).
+		arg( info.size() ).
+		arg( sampleRate ).
+		arg( reversed ? 1 : 0 );
+}
+
+
+
+
+std::shared_ptr<CachedSample> SampleCache::find( const QString & key )
+{
+	QMutexLocker locker( &s_mutex );
+	return s_entries.value( key ).lock();
+}
+
+
+
+
+std::shared_ptr<CachedSample> SampleCache::insert( const QString & key,
+						sampleFrame * frames,
+						f_cnt_t frameCount,
+						QTemporaryFile * mappedFile )
+{
+	std::shared_ptr<CachedSample> sample = std::make_shared<CachedSample>(
+					frames, frameCount, mappedFile );
+
+	QMutexLocker locker( &s_mutex );
+	// forget about files nobody uses anymore
+	auto it = s_entries.begin();
+	while( it != s_entries.end() )
+	{
+		if( it->expired() )
+		{
+			it = s_entries.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+	s_entries.insert( key, sample );
+	return sample;
+}
+
+
+
+
+int SampleCache::entryCount()
+{
+	QMutexLocker locker( &s_mutex );
+	int count = 0;
+	for( const std::weak_ptr<CachedSample> & entry : s_entries )
+	{
+		count += entry.expired() ? 0 : 1;
+	}
+	return count;
+}
+
+
+
+
+qint64 SampleCache::residentBytes()
+{
+	QMutexLocker locker( &s_mutex );
+	qint64 bytes = 0;
+	for( const std::weak_ptr<CachedSample> & entry : s_entries )
+	{
+		std::shared_ptr<CachedSample> sample = entry.lock();
+		if( sample && !sample->isMapped() )
+		{
+			bytes += sample->frameCount() * sizeof( sampleFrame );
+		}
+	}
+	return bytes;
+}
+
+
+
+
+qint64 SampleCache::mappedBytes()
+{
+	QMutexLocker locker( &s_mutex );
+	qint64 bytes = 0;
+	for( const std::weak_ptr<CachedSample> & entry : s_entries )
+	{
+		std::shared_ptr<CachedSample> sample = entry.lock();
+		if( sample && sample->isMapped() )
+		{
+			bytes += sample->frameCount() * sizeof( sampleFrame );
+		}
+	}
+	return bytes;
+}
@@ -64,6 +64,7 @@ Song::Song() :
 	m_globalAutomationTrack( dynamic_cast<AutomationTrack *>(
 				Track::create( Track::HiddenAutomationTrack,
 								this ) ) ),
+	m_automationTimeline( this, m_globalAutomationTrack ),
 	m_tempoModel( DefaultTempo, MinTempo, MaxTempo, this, tr( "Tempo" ) ),
 	m_timeSigModel( this ),
 	m_oldTicksPerTact( DefaultTicksPerTact ),
@@ -136,8 +137,8 @@ void Song::setTempo()
 {
 	Engine::mixer()->requestChangeInModel();
 	const bpm_t tempo = ( bpm_t ) m_tempoModel.value();
-	PlayHandleList & playHandles = Engine::mixer()->playHandles();
-	for( PlayHandleList::Iterator it = playHandles.begin();
+	PlayHandleArray & playHandles = Engine::mixer()->playHandles();
+	for( PlayHandleArray::Iterator it = playHandles.begin();
 						it != playHandles.end(); ++it )
 	{
 		NotePlayHandle * nph = dynamic_cast<NotePlayHandle *>( *it );
@@ -277,6 +278,25 @@ void Song::processNextBuffer()
 	f_cnt_t framesPlayed = 0;
 	const float framesPerTick = Engine::framesPerTick();
 
+	if( m_playMode == Mode_PlaySong )
+	{
+		// sample-exact automation for this period - the per-tick values
+		// set in processAutomations() still keep value() up to date
+		const float position = m_playPos[m_playMode].getTicks() +
+				m_playPos[m_playMode].currentFrame() / framesPerTick;
+		if( tl != NULL && ( checkLoop || m_loopRenderRemaining > 1 ) )
+		{
+			m_automationTimeline.renderValueBuffers( position,
+					1.0f / framesPerTick,
+					tl->loopBegin().getTicks(), tl->loopEnd().getTicks() );
+		}
+		else
+		{
+			m_automationTimeline.renderValueBuffers( position,
+							1.0f / framesPerTick );
+		}
+	}
+
 	while( framesPlayed < Engine::mixer()->framesPerPeriod() )
 	{
 		m_vstSyncController.update();
@@ -411,36 +431,52 @@ void Song::processNextBuffer()
 
 void Song::processAutomations(const TrackList &tracklist, MidiTime timeStart, fpp_t)
 {
-	AutomatedValueMap values;
-
 	QSet<const AutomatableModel*> recordedModels;
 
-	TrackContainer* container = this;
-	int tcoNum = -1;
-
-	switch (m_playMode)
+	if (m_playMode == Mode_PlaySong)
 	{
-	case Mode_PlaySong:
-		break;
-	case Mode_PlayBB:
-	{
-		Q_ASSERT(tracklist.size() == 1);
-		Q_ASSERT(tracklist.at(0)->type() == Track::BBTrack);
-		auto bbTrack = dynamic_cast<BBTrack*>(tracklist.at(0));
-		auto bbContainer = Engine::getBBTrackContainer();
-		container = bbContainer;
-		tcoNum = bbTrack->index();
+		// song playback runs through the precompiled timeline, which
+		// delivers the same values as automatedValuesAt()
+		const AutomationTimeline::ValueVector& values = m_automationTimeline.valuesAt(timeStart);
+
+		// Process recording
+		for (AutomationPattern* p : m_automationTimeline.startedPatterns())
+		{
+			MidiTime relTime = timeStart - p->startPosition();
+			if (p->isRecording() && relTime >= 0 && relTime < p->length())
+			{
+				const AutomatableModel* recordedModel = p->firstObject();
+				p->recordValue(relTime, recordedModel->value<float>());
+
+				recordedModels << recordedModel;
+			}
+		}
+
+		// Apply values
+		for (const AutomationTimeline::Value& v : values)
+		{
+			if (recordedModels.isEmpty() || ! recordedModels.contains(v.model))
+			{
+				v.model->setAutomatedValue(v.value);
+			}
+		}
+		return;
 	}
-		break;
-	default:
+
+	if (m_playMode != Mode_PlayBB)
+	{
 		return;
 	}
 
-	values = container->automatedValuesAt(timeStart, tcoNum);
-	TrackList tracks = container->tracks();
+	Q_ASSERT(tracklist.size() == 1);
+	Q_ASSERT(tracklist.at(0)->type() == Track::BBTrack);
+	auto bbTrack = dynamic_cast<BBTrack*>(tracklist.at(0));
+	auto bbContainer = Engine::getBBTrackContainer();
+
+	AutomatedValueMap values = bbContainer->automatedValuesAt(timeStart, bbTrack->index());
 
 	Track::tcoVector tcos;
-	for (Track* track : tracks)
+	for (Track* track : bbContainer->tracks())
 	{
 		if (track->type() == Track::AutomationTrack) {
 			track->getTCOsInRange(tcos, 0, timeStart);
@@ -0,0 +1,292 @@
+/*
+ * SpectrumAnalysis.cpp - spectra of rendered audio, computed off the
+ *                        rendering threads
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "SpectrumAnalysis.h"
+#include "lmms_constants.h"
+
+
+// Runs the FFTs of all analyses, exists as long as there are analyses
+class SpectrumAnalysisThread : public QThread
+{
+public:
+	// same rate as the main window's periodic update
+	static const int UpdateInterval = 1000 / 60;
+
+	SpectrumAnalysisThread() :
+		QThread()
+	{
+		const int size = SpectrumAnalysis::WindowSize;
+		m_input = (float *) fftwf_malloc( 2 * size * sizeof( float ) );
+		m_output = (fftwf_complex *) fftwf_malloc(
+				SpectrumAnalysis::BinCount * sizeof( fftwf_complex ) );
+		m_plan = fftwf_plan_dft_r2c_1d( 2 * size, m_input, m_output,
+								FFTW_MEASURE );
+		// the second half is zero padding
+		std::fill( m_input, m_input + 2 * size, 0.0f );
+
+		// Blackman-Harris window, normalized so that a sine gets the
+		// same magnitude as without window
+		const float a0 = 0.35875f;
+		const float a1 = 0.48829f;
+		const float a2 = 0.14128f;
+		const float a3 = 0.01168f;
+		float sum = 0;
+		for( int i = 0; i < size; ++i )
+		{
+			const float x = F_2PI * i / ( size - 1 );
+			m_window[i] = a0 - a1 * cosf( x ) + a2 * cosf( 2 * x ) -
+								a3 * cosf( 3 * x );
+			sum += m_window[i];
+		}
+		for( int i = 0; i < size; ++i )
+		{
+			m_window[i] *= size / sum;
+		}
+	}
+
+	virtual ~SpectrumAnalysisThread()
+	{
+		fftwf_destroy_plan( m_plan );
+		fftwf_free( m_output );
+		fftwf_free( m_input );
+	}
+
+	void stop()
+	{
+		m_quit.release();
+		wait();
+	}
+
+	static QMutex s_mutex;
+	static std::vector<SpectrumAnalysis *> s_analyses;
+	static SpectrumAnalysisThread * s_thread;
+
+private:
+	virtual void run()
+	{
+		while( !m_quit.tryAcquire( 1, UpdateInterval ) )
+		{
+			QMutexLocker lock( &s_mutex );
+			for( SpectrumAnalysis * analysis : s_analyses )
+			{
+				analyse( analysis );
+			}
+		}
+	}
+
+	void analyse( SpectrumAnalysis * a );
+
+	float * m_input;
+	fftwf_complex * m_output;
+	fftwf_plan m_plan;
+	float m_window[SpectrumAnalysis::WindowSize];
+	SpectrumAnalysis::Spectrum m_spectrum;
+
+	QSemaphore m_quit;
+
+} ;
+
+
+QMutex SpectrumAnalysisThread::s_mutex;
+std::vector<SpectrumAnalysis *> SpectrumAnalysisThread::s_analyses;
+SpectrumAnalysisThread * SpectrumAnalysisThread::s_thread = NULL;
+
+
+
+
+void SpectrumAnalysisThread::analyse( SpectrumAnalysis * a )
+{
+	const int size = SpectrumAnalysis::WindowSize;
+
+	// before draining, so that frames pushed after clear() are kept
+	const bool cleared = a->m_clear.exchange( false );
+	if( cleared )
+	{
+		memset( a->m_history, 0, sizeof( a->m_history ) );
+	}
+
+	bool newFrames = false;
+	while( SpectrumAnalysis::Block * block = a->m_blocks.beginRead() )
+	{
+		for( fpp_t f = 0; f < block->size; ++f )
+		{
+			a->m_history[a->m_historyPos][0] = block->frames[f][0];
+			a->m_history[a->m_historyPos][1] = block->frames[f][1];
+			a->m_historyPos = ( a->m_historyPos + 1 ) % size;
+		}
+		a->m_blocks.endRead();
+		newFrames = true;
+	}
+
+	if( !cleared && !newFrames )
+	{
+		return;
+	}
+
+	if( !newFrames )
+	{
+		std::fill( m_spectrum.magnitudes, m_spectrum.magnitudes +
+					SpectrumAnalysis::BinCount, 0.0f );
+		m_spectrum.peak = 0;
+		m_spectrum.power = 0;
+	}
+	else
+	{
+		const int mode = a->m_channelMode.load( std::memory_order_relaxed );
+		float peak = 0;
+		float power = 0;
+		for( int i = 0; i < size; ++i )
+		{
+			const sampleFrame & frame =
+				a->m_history[( a->m_historyPos + i ) % size];
+			const float s = mode == SpectrumAnalysis::LeftChannel ? frame[0] :
+					mode == SpectrumAnalysis::RightChannel ? frame[1] :
+						( frame[0] + frame[1] ) * 0.5f;
+			peak = std::max( peak, fabsf( s ) );
+			power += s * s;
+			m_input[i] = s * m_window[i];
+		}
+		fftwf_execute( m_plan );
+		absspec( m_output, m_spectrum.magnitudes, SpectrumAnalysis::BinCount );
+		m_spectrum.peak = peak;
+		m_spectrum.power = power;
+	}
+
+	QMutexLocker lock( &a->m_spectrumMutex );
+	m_spectrum.serial = a->m_spectrum.serial + 1;
+	a->m_spectrum = m_spectrum;
+}
+
+
+
+
+SpectrumAnalysis::SpectrumAnalysis() :
+	m_blocks( QueuedBlocks ),
+	m_open( NULL ),
+	m_active( true ),
+	m_clear( false ),
+	m_channelMode( MergeChannels ),
+	m_historyPos( 0 )
+{
+	memset( m_history, 0, sizeof( m_history ) );
+
+	QMutexLocker lock( &SpectrumAnalysisThread::s_mutex );
+	SpectrumAnalysisThread::s_analyses.push_back( this );
+	if( SpectrumAnalysisThread::s_thread == NULL )
+	{
+		SpectrumAnalysisThread::s_thread = new SpectrumAnalysisThread;
+		SpectrumAnalysisThread::s_thread->start( QThread::LowPriority );
+	}
+}
+
+
+
+
+SpectrumAnalysis::~SpectrumAnalysis()
+{
+	SpectrumAnalysisThread * thread = NULL;
+	{
+		QMutexLocker lock( &SpectrumAnalysisThread::s_mutex );
+		std::vector<SpectrumAnalysis *> & analyses =
+					SpectrumAnalysisThread::s_analyses;
+		analyses.erase( std::find( analyses.begin(), analyses.end(), this ) );
+		if( analyses.empty() )
+		{
+			std::swap( thread, SpectrumAnalysisThread::s_thread );
+		}
+	}
+
+	// outside of the lock, which the thread takes while analysing
+	if( thread )
+	{
+		thread->stop();
+		delete thread;
+	}
+}
+
+
+
+
+void SpectrumAnalysis::push( const sampleFrame * buf, const fpp_t frames )
+{
+	if( !isActive() )
+	{
+		return;
+	}
+
+	fpp_t f = 0;
+	while( f < frames )
+	{
+		// top up the block of the previous periods before taking a new one
+		if( m_open == NULL )
+		{
+			m_open = m_blocks.beginWrite();
+			if( m_open == NULL )
+			{
+				return;
+			}
+			m_open->size = 0;
+		}
+		const fpp_t n = qMin<fpp_t>( frames - f, BlockFrames - m_open->size );
+		memcpy( m_open->frames + m_open->size, buf + f,
+						n * sizeof( sampleFrame ) );
+		m_open->size += n;
+		f += n;
+		if( m_open->size == BlockFrames )
+		{
+			m_blocks.endWrite();
+			m_open = NULL;
+		}
+	}
+}
+
+
+
+
+void SpectrumAnalysis::clear()
+{
+	m_clear.store( true );
+}
+
+
+
+
+bool SpectrumAnalysis::spectrum( Spectrum & s ) const
+{
+	QMutexLocker lock( &m_spectrumMutex );
+	if( m_spectrum.serial == s.serial )
+	{
+		return false;
+	}
+	s = m_spectrum;
+	return true;
+}
@@ -0,0 +1,198 @@
+/*
+ * StemExporter.cpp - writes outputs of tracks and FX channels to files
+ *                    while the project is rendered once
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QFile>
+
+#include "StemExporter.h"
+#include "AudioFileDevice.h"
+#include "AudioPort.h"
+#include "Engine.h"
+#include "FxMixer.h"
+#include "Mixer.h"
+#include "ValueBuffer.h"
+
+
+StemExporter::Stem::Stem( AudioPort * port, FxChannel * channel,
+						AudioFileDevice * device ) :
+	m_port( port ),
+	m_channel( channel ),
+	m_device( device ),
+	m_periods( QueuedPeriods ),
+	m_freePeriods( QueuedPeriods )
+{
+}
+
+
+
+
+StemExporter::Stem::~Stem()
+{
+	delete m_device;
+}
+
+
+
+
+StemExporter::StemExporter() :
+	QThread()
+{
+}
+
+
+
+
+StemExporter::~StemExporter()
+{
+	finish();
+}
+
+
+
+
+void StemExporter::addPortStem( AudioPort * port, AudioFileDevice * device )
+{
+	m_outputFiles << device->outputFile();
+	m_stems.emplace_back( new Stem( port, NULL, device ) );
+}
+
+
+
+
+void StemExporter::addChannelStem( FxChannel * channel, AudioFileDevice * device )
+{
+	m_outputFiles << device->outputFile();
+	m_stems.emplace_back( new Stem( NULL, channel, device ) );
+}
+
+
+
+
+void StemExporter::tapPeriod()
+{
+	const fpp_t fpp = Engine::mixer()->framesPerPeriod();
+	const float masterGain = Engine::mixer()->masterGain();
+
+	for( const std::unique_ptr<Stem> & stem : m_stems )
+	{
+		// only blocks if the encoder is QueuedPeriods behind
+		stem->m_freePeriods.acquire();
+		Period * period = stem->m_periods.beginWrite();
+
+		if( period->capacity < fpp )
+		{
+			period->frames.reset( new surroundSampleFrame[fpp] );
+			period->capacity = fpp;
+		}
+		period->size = fpp;
+		period->masterGain = masterGain;
+		surroundSampleFrame * dst = period->frames.get();
+
+		// ports hold their output until they get processed in the next
+		// period, FX channels until the master mix clears them
+		const sampleFrame * src;
+		float gain = 1.0f;
+		ValueBuffer * gainBuf = NULL;
+		if( stem->m_port )
+		{
+			src = stem->m_port->buffer();
+		}
+		else
+		{
+			src = stem->m_channel->m_buffer;
+			gainBuf = stem->m_channel->m_volumeModel.valueBuffer();
+			gain = stem->m_channel->m_volumeModel.value();
+		}
+
+		for( fpp_t f = 0; f < fpp; ++f )
+		{
+			const float v = gainBuf ? gainBuf->values()[f] : gain;
+			for( ch_cnt_t ch = 0; ch < SURROUND_CHANNELS; ++ch )
+			{
+				dst[f][ch] = src[f][ch % DEFAULT_CHANNELS] * v;
+			}
+		}
+
+		stem->m_periods.endWrite();
+		m_queuedPeriods.release();
+	}
+}
+
+
+
+
+void StemExporter::finish()
+{
+	if( isRunning() )
+	{
+		// one more than queued, so the encoder notices there's nothing
+		// left to do
+		m_queuedPeriods.release();
+		wait();
+	}
+
+	// closing the devices completes the files
+	m_stems.clear();
+}
+
+
+
+
+void StemExporter::removeOutputFiles()
+{
+	for( const QString & file : m_outputFiles )
+	{
+		QFile( file ).remove();
+	}
+}
+
+
+
+
+void StemExporter::run()
+{
+	size_t next = 0;
+	while( true )
+	{
+		m_queuedPeriods.acquire();
+
+		// visit the stems in turns, so all files grow at the same pace
+		Period * period = NULL;
+		Stem * stem = NULL;
+		for( size_t i = 0; i < m_stems.size() && period == NULL; ++i )
+		{
+			stem = m_stems[next].get();
+			period = stem->m_periods.beginRead();
+			next = ( next + 1 ) % m_stems.size();
+		}
+		if( period == NULL )
+		{
+			return;
+		}
+
+		stem->m_device->processBuffer( period->frames.get(),
+						period->size, period->masterGain );
+
+		stem->m_periods.endRead();
+		stem->m_freePeriods.release();
+	}
+}
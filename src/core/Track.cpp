@@ -38,6 +38,7 @@
 #include "Track.h"
 
 #include <assert.h>
+#include <limits>
 
 #include <QLayout>
 #include <QMenu>
@@ -47,6 +48,7 @@
 
 
 #include "AutomationPattern.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "AutomationEditor.h"
 #include "BBEditor.h"
@@ -144,6 +146,11 @@ void TrackContentObject::movePosition( const MidiTime & pos )
 	{
 		Engine::mixer()->requestChangeInModel();
 		m_startPosition = pos;
+		AutomationTimeline::invalidate();
+		if( getTrack() )
+		{
+			getTrack()->invalidateTCOIndex();
+		}
 		Engine::mixer()->doneChangeInModel();
 		Engine::getSong()->updateLength();
 		emit positionChanged();
@@ -163,6 +170,10 @@ void TrackContentObject::movePosition( const MidiTime & pos )
 void TrackContentObject::changeLength( const MidiTime & length )
 {
 	m_length = length;
+	if( getTrack() )
+	{
+		getTrack()->invalidateTCOIndex();
+	}
 	Engine::getSong()->updateLength();
 	emit lengthChanged();
 }
@@ -1989,7 +2000,8 @@ Track::Track( TrackTypes type, TrackContainer * tc ) :
 	m_soloModel( false, this, tr( "Solo" ) ),
 					/*!< For controlling track soloing */
 	m_simpleSerializingMode( false ),
-	m_trackContentObjects()         /*!< The track content objects (segments) */
+	m_trackContentObjects(),        /*!< The track content objects (segments) */
+	m_tcoIndexDirty( true )
 {
 	m_trackContainer->addTrack( this );
 	m_height = -1;
@@ -2244,6 +2256,8 @@ void Track::loadSettings( const QDomElement & element )
 TrackContentObject * Track::addTCO( TrackContentObject * tco )
 {
 	m_trackContentObjects.push_back( tco );
+	AutomationTimeline::invalidate();
+	invalidateTCOIndex();
 
 	emit trackContentObjectAdded( tco );
 
@@ -2265,6 +2279,8 @@ void Track::removeTCO( TrackContentObject * tco )
 	if( it != m_trackContentObjects.end() )
 	{
 		m_trackContentObjects.erase( it );
+		AutomationTimeline::invalidate();
+		invalidateTCOIndex();
 		if( Engine::getSong() )
 		{
 			Engine::getSong()->updateLength();
@@ -2363,11 +2379,25 @@ int Track::getTCONum( const TrackContentObject * tco )
 void Track::getTCOsInRange( tcoVector & tcoV, const MidiTime & start,
 							const MidiTime & end )
 {
-	for( TrackContentObject* tco : m_trackContentObjects )
+	QMutexLocker indexLock( &m_tcoIndexMutex );
+	if( m_tcoIndexDirty.exchange( false ) )
 	{
-		int s = tco->startPosition();
-		int e = tco->endPosition();
-		if( ( s <= end ) && ( e >= start ) )
+		rebuildTCOIndex();
+	}
+
+	// skip all TCOs which end before start, none of the ones before the
+	// first running maximum reaching start does
+	int i = std::lower_bound( m_tcoIndexMaxEnd.begin(),
+				m_tcoIndexMaxEnd.end(), (int) start ) -
+						m_tcoIndexMaxEnd.begin();
+	for( ; i < m_tcoIndex.size(); ++i )
+	{
+		TrackContentObject* tco = m_tcoIndex[i];
+		if( tco->startPosition() > end )
+		{
+			break;
+		}
+		if( tco->endPosition() >= start )
 		{
 			// TCO is within given range
 			// Insert sorted by TCO's position
@@ -2380,6 +2410,25 @@ void Track::getTCOsInRange( tcoVector & tcoV, const MidiTime & start,
 
 
 
+void Track::rebuildTCOIndex()
+{
+	m_tcoIndex = m_trackContentObjects;
+	// stable, so TCOs starting at the same position keep their order
+	std::stable_sort( m_tcoIndex.begin(), m_tcoIndex.end(),
+					TrackContentObject::comparePosition );
+
+	m_tcoIndexMaxEnd.resize( m_tcoIndex.size() );
+	int maxEnd = std::numeric_limits<int>::min();
+	for( int i = 0; i < m_tcoIndex.size(); ++i )
+	{
+		maxEnd = qMax<int>( maxEnd, m_tcoIndex[i]->endPosition() );
+		m_tcoIndexMaxEnd[i] = maxEnd;
+	}
+}
+
+
+
+
 /*! \brief Swap the position of two trackContentObjects.
  *
  *  First, we arrange to swap the positions of the two TCOs in the
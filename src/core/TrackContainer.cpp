@@ -30,6 +30,7 @@
 #include <QWriteLocker>
 
 #include "AutomationPattern.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "BBTrack.h"
 #include "BBTrackContainer.h"
@@ -178,6 +179,7 @@ void TrackContainer::addTrack( Track * _track )
 		_track->lock();
 		m_tracksMutex.lockForWrite();
 		m_tracks.push_back( _track );
+		AutomationTimeline::invalidate();
 		m_tracksMutex.unlock();
 		_track->unlock();
 		emit trackAdded( _track );
@@ -201,6 +203,7 @@ void TrackContainer::removeTrack( Track * _track )
 			_track->setSolo(false);
 		}
 		m_tracks.remove( index );
+		AutomationTimeline::invalidate();
 		lockTracksAccess.unlock();
 
 		if( Engine::getSong() )
@@ -78,6 +78,29 @@ void AudioDevice::processNextBuffer()
 
 
 
+void AudioDevice::processBuffer( const surroundSampleFrame * _ab,
+						const fpp_t _frames,
+						const float _master_gain )
+{
+	if( mixer()->processingSampleRate() == m_sampleRate )
+	{
+		writeBuffer( _ab, _frames, _master_gain );
+		return;
+	}
+
+	lock();
+	resample( _ab, _frames, m_buffer, mixer()->processingSampleRate(),
+								m_sampleRate );
+	const fpp_t frames = _frames * m_sampleRate /
+					mixer()->processingSampleRate();
+	unlock();
+
+	writeBuffer( m_buffer, frames, _master_gain );
+}
+
+
+
+
 fpp_t AudioDevice::getNextBuffer( surroundSampleFrame * _ab )
 {
 	fpp_t frames = mixer()->framesPerPeriod();
@@ -106,11 +129,6 @@ fpp_t AudioDevice::getNextBuffer( surroundSampleFrame * _ab )
 	// release lock
 	unlock();
 
-	if( mixer()->hasFifoWriter() )
-	{
-		delete[] b;
-	}
-
 	return frames;
 }
 
@@ -40,7 +40,8 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 {
 	setSampleRate( outputSettings.getSampleRate() );
 
-	if( m_outputFile.open( QFile::WriteOnly | QFile::Truncate ) == false )
+	if( _file.isEmpty() == false &&
+		m_outputFile.open( QFile::WriteOnly | QFile::Truncate ) == false )
 	{
 		QString title, message;
 		title = ExportProjectDialog::tr( "Could not open file" );
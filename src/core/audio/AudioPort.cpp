@@ -39,8 +39,10 @@ AudioPort::AudioPort( const QString & _name, bool _has_effect_chain,
 	m_portBuffer( BufferManager::acquire() ),
 	m_extOutputEnabled( false ),
 	m_nextFxChannel( 0 ),
+	m_pendingFxChannel( NULL ),
 	m_name( "unnamed port" ),
 	m_effects( _has_effect_chain ? new EffectChain( NULL ) : NULL ),
+	m_playHandles( PlayHandle::AudioPortSlot ),
 	m_volumeModel( volumeModel ),
 	m_panningModel( panningModel ),
 	m_mutedModel( mutedModel )
@@ -105,6 +107,12 @@ void AudioPort::doProcessing()
 {
 	if( m_mutedModel && m_mutedModel->value() )
 	{
+		// don't leave stale output for readers of buffer()
+		BufferManager::clear( m_portBuffer, Engine::mixer()->framesPerPeriod() );
+		if( m_pendingFxChannel )
+		{
+			m_pendingFxChannel->resolveDependency();
+		}
 		return;
 	}
 
@@ -114,6 +122,8 @@ void AudioPort::doProcessing()
 	BufferManager::clear( m_portBuffer, fpp );
 
 	//qDebug( "Playhandles: %d", m_playHandles.size() );
+	m_playHandleLock.lock();
+	m_playHandles.compact();
 	for( PlayHandle * ph : m_playHandles ) // now we mix all playhandle buffers into the audioport buffer
 	{
 		if( ph->buffer() )
@@ -127,6 +137,7 @@ void AudioPort::doProcessing()
 									// pointer to null, so if it doesn't get re-acquired we know to skip it next time
 		}
 	}
+	m_playHandleLock.unlock();
 
 	if( m_bufferUsage )
 	{
@@ -220,10 +231,20 @@ void AudioPort::doProcessing()
 	const bool me = processEffects();
 	if( me || m_bufferUsage )
 	{
-		Engine::fxMixer()->mixToChannel( m_portBuffer, m_nextFxChannel ); 	// send output to fx mixer
-																			// TODO: improve the flow here - convert to pull model
+		// send output to the FX channel we were scheduled for, which stays
+		// the same for the whole period even if m_nextFxChannel changes
+		if( m_pendingFxChannel )
+		{
+			Engine::fxMixer()->mixToChannel( m_portBuffer, m_pendingFxChannel->m_channelIndex );
+		}
 		m_bufferUsage = false;
 	}
+
+	// let the FX channel know that our output is complete
+	if( m_pendingFxChannel )
+	{
+		m_pendingFxChannel->resolveDependency();
+	}
 }
 
 
@@ -238,10 +259,6 @@ void AudioPort::addPlayHandle( PlayHandle * handle )
 void AudioPort::removePlayHandle( PlayHandle * handle )
 {
 	m_playHandleLock.lock();
-		PlayHandleList::Iterator it =	std::find( m_playHandles.begin(), m_playHandles.end(), handle );
-		if( it != m_playHandles.end() )
-		{
-			m_playHandles.erase( it );
-		}
+		m_playHandles.remove( handle );
 	m_playHandleLock.unlock();
 }
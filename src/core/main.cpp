@@ -162,6 +162,8 @@ void printHelp()
 		"  dump <in>                             Dump XML of compressed file <in>\n"
 		"  render <project> [options...]         Render given project file\n"
 		"  rendertracks <project> [options...]   Render each track to a different file\n"
+		"  renderstems <project> [options...]    Render the output of each track to a\n"
+		"                                        different file in a single pass\n"
 		"  upgrade <in> [out]                    Upgrade file <in> and save as <out>\n"
 		"                                        Standard out is used if no output file\n"
 		"                                        is specifed\n"
@@ -177,10 +179,12 @@ void printHelp()
 		"          geometry is <xsizexysize+xoffset+yoffsety>.\n"
 		"      --import <in> [-e]         Import MIDI or Hydrogen file <in>.\n"
 		"          If -e is specified lmms exits after importing the file.\n"
-		"\nOptions for \"render\" and \"rendertracks\":\n"
+		"\nOptions for \"render\", \"rendertracks\" and \"renderstems\":\n"
 		"  -a, --float                    Use 32bit float bit depth\n"
 		"  -b, --bitrate <bitrate>        Specify output bitrate in KBit/s\n"
 		"          Default: 160.\n"
+		"      --fxchannels               For \"renderstems\", also render each FX\n"
+		"          channel and the master channel to a different file\n"
 		"  -f, --format <format>         Specify format of render-output where\n"
 		"          Format is either 'wav', 'flac', 'ogg' or 'mp3'.\n"
 		"  -i, --interpolation <method>   Specify interpolation method\n"
@@ -198,12 +202,14 @@ void printHelp()
 		"          Default: j\n"
 		"  -o, --output <path>            Render into <path>\n"
 		"          For \"render\", provide a file path\n"
-		"          For \"rendertracks\", provide a directory path\n"
+		"          For \"rendertracks\" and \"renderstems\", provide a directory path\n"
 		"          If not specified, render will overwrite the input file\n"
-		"          For \"rendertracks\", this might be required\n"
+		"          For \"rendertracks\" and \"renderstems\", this might be required\n"
 		"  -p, --profile <out>            Dump profiling information to file <out>\n"
 		"  -s, --samplerate <samplerate>  Specify output samplerate in Hz\n"
 		"          Range: 44100 (default) to 192000\n"
+		"  -t, --trace <out>              Dump a trace of all processing jobs to\n"
+		"          file <out>, which can be viewed in chrome://tracing or Perfetto\n"
 		"  -x, --oversampling <value>     Specify oversampling\n"
 		"          Possible values: 1, 2, 4, 8\n"
 		"          Default: 2\n\n",
@@ -299,7 +305,9 @@ int main( int argc, char * * argv )
 	bool allowRoot = false;
 	bool renderLoop = false;
 	bool renderTracks = false;
-	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, configFile;
+	bool renderStems = false;
+	bool renderFxChannels = false;
+	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, traceOutputFile, configFile;
 
 	// first of two command-line parsing stages
 	for( int i = 1; i < argc; ++i )
@@ -317,6 +325,11 @@ int main( int argc, char * * argv )
 			coreOnly = true;
 			renderTracks = true;
 		}
+		else if( arg == "renderstems" || arg == "--renderstems" )
+		{
+			coreOnly = true;
+			renderStems = true;
+		}
 		else if( arg == "--allowroot" )
 		{
 			allowRoot = true;
@@ -421,7 +434,8 @@ int main( int argc, char * * argv )
 			return EXIT_SUCCESS;
 		}
 		else if( arg == "render" || arg == "--render" || arg == "-r" ||
-			arg == "rendertracks" || arg == "--rendertracks" )
+			arg == "rendertracks" || arg == "--rendertracks" ||
+			arg == "renderstems" || arg == "--renderstems" )
 		{
 			++i;
 
@@ -438,6 +452,10 @@ int main( int argc, char * * argv )
 		{
 			renderLoop = true;
 		}
+		else if( arg == "--fxchannels" )
+		{
+			renderFxChannels = true;
+		}
 		else if( arg == "--output" || arg == "-o" )
 		{
 			++i;
@@ -655,6 +673,18 @@ int main( int argc, char * * argv )
 
 			profilerOutputFile = QString::fromLocal8Bit( argv[i] );
 		}
+		else if( arg == "--trace" || arg == "-t" )
+		{
+			++i;
+
+			if( i == argc )
+			{
+				return usageError( "No trace file specified" );
+			}
+
+
+			traceOutputFile = QString::fromLocal8Bit( argv[i] );
+		}
 		else if( arg == "--config" || arg == "-c" )
 		{
 			++i;
@@ -767,7 +797,7 @@ int main( int argc, char * * argv )
 
 		// when rendering multiple tracks, renderOut is a directory
 		// otherwise, it is a file, so we need to append the file extension
-		if ( !renderTracks )
+		if ( !renderTracks && !renderStems )
 		{
 			renderOut = baseName( renderOut ) +
 				ProjectRenderer::getFileExtensionFromFormat(eff);
@@ -788,12 +818,20 @@ int main( int argc, char * * argv )
 		{
 			Engine::mixer()->profiler().setOutputFile( profilerOutputFile );
 		}
+		if( traceOutputFile.isEmpty() == false )
+		{
+			Engine::mixer()->profiler().setTraceFile( traceOutputFile );
+		}
 
 		// start now!
 		if ( renderTracks )
 		{
 			r->renderTracks();
 		}
+		else if ( renderStems )
+		{
+			r->renderStems( renderFxChannels );
+		}
 		else
 		{
 			r->renderProject();
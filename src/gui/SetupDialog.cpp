@@ -102,6 +102,8 @@ SetupDialog::SetupDialog( ConfigTabs _tab_to_open ) :
 							"openlastproject" ).toInt() ),
 	m_hqAudioDev( ConfigManager::inst()->value( "mixer",
 							"hqaudio" ).toInt() ),
+	m_lowLatency( ConfigManager::inst()->value( "mixer",
+							"lowlatency" ).toInt() ),
 	m_lang( ConfigManager::inst()->value( "app",
 							"language" ) ),
 	m_workingDir( QDir::toNativeSeparators( ConfigManager::inst()->workingDir() ) ),
@@ -168,7 +170,7 @@ SetupDialog::SetupDialog( ConfigTabs _tab_to_open ) :
 #endif
 	ws->setFixedSize( 360, wsHeight );
 	QWidget * general = new QWidget( ws );
-	general->setFixedSize( 360, 290 );
+	general->setFixedSize( 360, 308 );
 	QVBoxLayout * gen_layout = new QVBoxLayout( general );
 	gen_layout->setSpacing( 0 );
 	gen_layout->setMargin( 0 );
@@ -230,6 +232,8 @@ SetupDialog::SetupDialog( ConfigTabs _tab_to_open ) :
 		SLOT(toggleOneInstrumentTrackWindow(bool)));
 	addLedCheckBox("HQ-mode for output audio-device",
 		m_hqAudioDev, SLOT(toggleHQAudioDev(bool)));
+	addLedCheckBox("Render audio in the device callback",
+		m_lowLatency, SLOT(toggleLowLatency(bool)));
 	addLedCheckBox("Compact track buttons",
 		m_compactTrackButtons, SLOT(toggleCompactTrackButtons(bool)));
 	addLedCheckBox("Sync VST plugins to host playback",
@@ -817,6 +821,13 @@ void SetupDialog::accept()
 					QString::number( m_openLastProject ) );
 	ConfigManager::inst()->setValue( "mixer", "hqaudio",
 					QString::number( m_hqAudioDev ) );
+	ConfigManager::inst()->setValue( "mixer", "lowlatency",
+					QString::number( m_lowLatency ) );
+	// takes effect right away, unlike the other mixer settings
+	Engine::mixer()->setPipelineMode( m_lowLatency ?
+					Mixer::Pipeline_LowLatency :
+					Mixer::Pipeline_LookAhead,
+					Engine::mixer()->lookAhead() );
 	ConfigManager::inst()->setValue( "ui", "smoothscroll",
 					QString::number( m_smoothScroll ) );
 	ConfigManager::inst()->setValue( "ui", "enableautosave",
@@ -974,6 +985,14 @@ void SetupDialog::toggleHQAudioDev( bool _enabled )
 
 
 
+void SetupDialog::toggleLowLatency( bool _enabled )
+{
+	m_lowLatency = _enabled;
+}
+
+
+
+
 void SetupDialog::toggleSmoothScroll( bool _enabled )
 {
 	m_smoothScroll = _enabled;
@@ -32,6 +32,7 @@
 #include <QWheelEvent>
 
 #include "TrackContainer.h"
+#include "AutomationTimeline.h"
 #include "BBTrack.h"
 #include "MainWindow.h"
 #include "Mixer.h"
@@ -173,6 +174,7 @@ void TrackContainerView::moveTrackView( TrackView * trackView, int indexTo )
 
 	m_tc->m_tracks.remove( indexFrom );
 	m_tc->m_tracks.insert( indexTo, track );
+	AutomationTimeline::invalidate();
 	m_trackViews.move( indexFrom, indexTo );
 
 	realignTracks();
@@ -657,23 +657,10 @@ bool InstrumentTrack::play( const MidiTime & _start, const fpp_t _frames,
 			cur_start -= p->startPosition();
 		}
 
-		// get all notes from the given pattern...
+		// get all notes from the given pattern, starting at the first
+		// one not before cur_start
 		const NoteVector & notes = p->notes();
-		// ...and set our index to zero
-		NoteVector::ConstIterator nit = notes.begin();
-
-		// very effective algorithm for playing notes that are
-		// posated within the current sample-frame
-
-
-		if( cur_start > 0 )
-		{
-			// skip notes which are posated before start-tact
-			while( nit != notes.end() && ( *nit )->pos() < cur_start )
-			{
-				++nit;
-			}
-		}
+		NoteVector::ConstIterator nit = p->seekPlayCursor( cur_start );
 
 		Note * cur_note;
 		while( nit != notes.end() &&
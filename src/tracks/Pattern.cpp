@@ -56,7 +56,8 @@ Pattern::Pattern( InstrumentTrack * _instrument_track ) :
 	TrackContentObject( _instrument_track ),
 	m_instrumentTrack( _instrument_track ),
 	m_patternType( BeatPattern ),
-	m_steps( MidiTime::stepsPerTact() )
+	m_steps( MidiTime::stepsPerTact() ),
+	m_playCursor( -1 )
 {
 	setName( _instrument_track->name() );
 	if( _instrument_track->trackContainer()
@@ -75,7 +76,8 @@ Pattern::Pattern( const Pattern& other ) :
 	TrackContentObject( other.m_instrumentTrack ),
 	m_instrumentTrack( other.m_instrumentTrack ),
 	m_patternType( other.m_patternType ),
-	m_steps( other.m_steps )
+	m_steps( other.m_steps ),
+	m_playCursor( -1 )
 {
 	for( NoteVector::ConstIterator it = other.m_notes.begin(); it != other.m_notes.end(); ++it )
 	{
@@ -216,6 +218,7 @@ Note * Pattern::addNote( const Note & _new_note, const bool _quant_pos )
 
 	instrumentTrack()->lock();
 	m_notes.insert(std::upper_bound(m_notes.begin(), m_notes.end(), new_note, Note::lessThan), new_note);
+	resetPlayCursor();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -243,6 +246,7 @@ void Pattern::removeNote( Note * _note_to_del )
 		}
 		++it;
 	}
+	resetPlayCursor();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -273,11 +277,41 @@ Note * Pattern::noteAtStep( int _step )
 void Pattern::rearrangeAllNotes()
 {
 	// sort notes by start time
+	instrumentTrack()->lock();
 	std::sort(m_notes.begin(), m_notes.end(), Note::lessThan);
+	resetPlayCursor();
+	instrumentTrack()->unlock();
+}
+
+
+
+NoteVector::ConstIterator Pattern::seekPlayCursor( const MidiTime & pos )
+{
+	if( m_playCursor < 0 || pos < m_playCursorPos ||
+					m_playCursor > m_notes.size() )
+	{
+		// notes changed, or we got relocated or looped back
+		m_playCursor = std::lower_bound( m_notes.begin(), m_notes.end(), pos,
+			[]( const Note * note, const MidiTime & p )
+			{
+				return note->pos() < p;
+			} ) - m_notes.begin();
+	}
+	else
+	{
+		while( m_playCursor < m_notes.size() &&
+					m_notes[m_playCursor]->pos() < pos )
+		{
+			++m_playCursor;
+		}
+	}
+	m_playCursorPos = pos;
+	return m_notes.begin() + m_playCursor;
 }
 
 
 
+
 void Pattern::clearNotes()
 {
 	instrumentTrack()->lock();
@@ -287,6 +321,7 @@ void Pattern::clearNotes()
 		delete *it;
 	}
 	m_notes.clear();
+	resetPlayCursor();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -401,6 +436,7 @@ void Pattern::loadSettings( const QDomElement & _this )
 
 	clearNotes();
 
+	instrumentTrack()->lock();
 	QDomNode node = _this.firstChild();
 	while( !node.isNull() )
 	{
@@ -413,6 +449,8 @@ void Pattern::loadSettings( const QDomElement & _this )
 		}
 		node = node.nextSibling();
         }
+	resetPlayCursor();
+	instrumentTrack()->unlock();
 
 	m_steps = _this.attribute( "steps" ).toInt();
 	if( m_steps == 0 )
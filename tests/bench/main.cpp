@@ -0,0 +1,652 @@
+/*
+ * main.cpp - lmms-bench, headless render benchmark
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// Renders projects through ProjectRenderer into a device which discards its
+// output and reports throughput as JSON. The mixer's period size and thread
+// count are fixed once the engine is up, so every configuration is rendered
+// by a child process of its own. --check-note-on checks that instruments
+// which keep their notes in a VoiceArena start them without allocating.
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+
+#include "AudioFileDevice.h"
+#include "BufferManager.h"
+#include "ConfigManager.h"
+#include "DataFile.h"
+#include "Engine.h"
+#include "Instrument.h"
+#include "InstrumentTrack.h"
+#include "MemoryManager.h"
+#include "Mixer.h"
+#include "MixerProfiler.h"
+#include "NotePlayHandle.h"
+#include "ProjectRenderer.h"
+#include "SampleCache.h"
+#include "Song.h"
+
+
+// count all allocations done through operator new while rendering, the ones
+// through MemoryManager are counted by MemoryManager itself
+static std::atomic<long long> s_allocations( 0 );
+
+void * operator new( std::size_t size )
+{
+	s_allocations.fetch_add( 1, std::memory_order_relaxed );
+	if( void * p = std::malloc( size ? size : 1 ) )
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void * operator new[]( std::size_t size )
+{
+	return operator new( size );
+}
+
+void operator delete( void * p ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete[]( void * p ) noexcept
+{
+	std::free( p );
+}
+
+
+
+
+static const char * ResultPrefix = "lmms-bench-result: ";
+static const char * SyntheticProject = "synthetic";
+
+
+struct SyntheticSettings
+{
+	int tracks = 8;
+	int polyphony = 4;
+	int effects = 1;
+	int sendDepth = 1;
+	int bars = 16;
+} ;
+
+
+
+
+// discards everything but counts the frames it got
+class NullFileDevice : public AudioFileDevice
+{
+public:
+	NullFileDevice( const OutputSettings & outputSettings, Mixer * mixer ) :
+		AudioFileDevice( outputSettings, DEFAULT_CHANNELS, QString(), mixer ),
+		m_frames( 0 )
+	{
+	}
+
+	f_cnt_t frames() const
+	{
+		return m_frames;
+	}
+
+protected:
+	virtual void writeBuffer( const surroundSampleFrame *, const fpp_t frames,
+								const float )
+	{
+		m_frames += frames;
+	}
+
+private:
+	f_cnt_t m_frames;
+
+} ;
+
+
+
+
+// Every track plays chords of the given polyphony on every beat into its
+// own chain of FX channels, each of which runs the given number of effects.
+static void writeSyntheticProject( const SyntheticSettings & s, const QString & fileName )
+{
+	DataFile dataFile( DataFile::SongProject );
+	QDomDocument & doc = dataFile;
+
+	dataFile.head().setAttribute( "bpm", 140 );
+	dataFile.head().setAttribute( "mastervol", 100 );
+	dataFile.head().setAttribute( "timesig_numerator", 4 );
+	dataFile.head().setAttribute( "timesig_denominator", 4 );
+
+	QDomElement tracks = doc.createElement( "trackcontainer" );
+	tracks.setAttribute( "type", "song" );
+	dataFile.content().appendChild( tracks );
+
+	QDomElement fxMixer = doc.createElement( "fxmixer" );
+	dataFile.content().appendChild( fxMixer );
+
+	QDomElement master = doc.createElement( "fxchannel" );
+	master.setAttribute( "num", 0 );
+	master.setAttribute( "name", "Master" );
+	master.setAttribute( "volume", 1 );
+	fxMixer.appendChild( master );
+
+	const int ticksPerBar = 192;
+	const int beat = ticksPerBar / 4;
+	for( int t = 0; t < s.tracks; ++t )
+	{
+		const int firstChannel = t * s.sendDepth + 1;
+		for( int d = 0; d < s.sendDepth; ++d )
+		{
+			const int num = firstChannel + d;
+			QDomElement channel = doc.createElement( "fxchannel" );
+			channel.setAttribute( "num", num );
+			channel.setAttribute( "name", QString( "FX %1" ).arg( num ) );
+			channel.setAttribute( "volume", 1 );
+
+			QDomElement chain = doc.createElement( "fxchain" );
+			chain.setAttribute( "enabled", s.effects > 0 ? 1 : 0 );
+			chain.setAttribute( "numofeffects", s.effects );
+			for( int e = 0; e < s.effects; ++e )
+			{
+				QDomElement effect = doc.createElement( "effect" );
+				effect.setAttribute( "name", "amplifier" );
+				effect.setAttribute( "on", 1 );
+				effect.setAttribute( "wet", 1 );
+				effect.setAttribute( "gate", 0 );
+				effect.setAttribute( "autoquit", 1 );
+				chain.appendChild( effect );
+			}
+			channel.appendChild( chain );
+
+			QDomElement send = doc.createElement( "send" );
+			send.setAttribute( "channel", d + 1 < s.sendDepth ? num + 1 : 0 );
+			send.setAttribute( "amount", 1 );
+			channel.appendChild( send );
+
+			fxMixer.appendChild( channel );
+		}
+
+		QDomElement track = doc.createElement( "track" );
+		track.setAttribute( "type", 0 );
+		track.setAttribute( "name", QString( "Track %1" ).arg( t + 1 ) );
+		track.setAttribute( "muted", 0 );
+
+		QDomElement instrumentTrack = doc.createElement( "instrumenttrack" );
+		instrumentTrack.setAttribute( "vol", 100 );
+		instrumentTrack.setAttribute( "pan", 0 );
+		instrumentTrack.setAttribute( "pitch", 0 );
+		instrumentTrack.setAttribute( "basenote", 57 );
+		instrumentTrack.setAttribute( "fxch", s.sendDepth > 0 ? firstChannel : 0 );
+		QDomElement instrument = doc.createElement( "instrument" );
+		instrument.setAttribute( "name", "tripleoscillator" );
+		instrumentTrack.appendChild( instrument );
+		track.appendChild( instrumentTrack );
+
+		QDomElement pattern = doc.createElement( "pattern" );
+		pattern.setAttribute( "type", 1 );
+		pattern.setAttribute( "pos", 0 );
+		pattern.setAttribute( "len", s.bars * ticksPerBar );
+		pattern.setAttribute( "muted", 0 );
+		pattern.setAttribute( "name", "" );
+		for( int pos = 0; pos < s.bars * ticksPerBar; pos += beat )
+		{
+			for( int v = 0; v < s.polyphony; ++v )
+			{
+				QDomElement note = doc.createElement( "note" );
+				note.setAttribute( "pos", pos );
+				note.setAttribute( "len", beat );
+				note.setAttribute( "key", 45 + ( t * 5 + v * 4 ) % 36 );
+				note.setAttribute( "vol", 100 );
+				note.setAttribute( "pan", 0 );
+				pattern.appendChild( note );
+			}
+		}
+		track.appendChild( pattern );
+
+		tracks.appendChild( track );
+	}
+
+	dataFile.writeFile( fileName );
+}
+
+
+
+
+static QJsonObject stageStats( const MixerProfiler::PeriodStats & total, int periods )
+{
+	static const char * names[MixerProfiler::StageCount] =
+	{
+		"valueBuffers", "playHandles", "fxChannels", "masterMix"
+	} ;
+	QJsonObject stages;
+	for( int s = 0; s < MixerProfiler::StageCount; ++s )
+	{
+		QJsonObject stage;
+		stage["totalMs"] = total.stageUsecs[s] / 1000.0;
+		stage["perPeriodUs"] = periods ? double( total.stageUsecs[s] ) / periods : 0.0;
+		stages[names[s]] = stage;
+	}
+	return stages;
+}
+
+
+
+
+// renders one configuration, runs in a child process
+static int renderProject( const QString & project, const SyntheticSettings & synthetic,
+							int frames, int threads )
+{
+	ConfigManager::inst()->setValue( "mixer", "renderframes", QString::number( frames ) );
+	ConfigManager::inst()->setValue( "mixer", "threads", QString::number( threads ) );
+
+	MemoryManager::setCountingAllocations( true );
+	NotePlayHandleManager::init();
+	Engine::init( true );
+
+	QTemporaryFile syntheticFile( QDir::tempPath() + "/lmms-bench-XXXXXX.mmp" );
+	QString fileName = project;
+	if( project == SyntheticProject )
+	{
+		if( !syntheticFile.open() )
+		{
+			fprintf( stderr, "Could not create synthetic project\n" );
+			return EXIT_FAILURE;
+		}
+		fileName = syntheticFile.fileName();
+		syntheticFile.close();
+		writeSyntheticProject( synthetic, fileName );
+	}
+	Engine::getSong()->loadProject( fileName );
+
+	const Mixer::qualitySettings qs( Mixer::qualitySettings::Mode_Draft );
+	const OutputSettings os( 44100, OutputSettings::BitRateSettings( 160, false ),
+						OutputSettings::Depth_32Bit );
+	NullFileDevice * device = new NullFileDevice( os, Engine::mixer() );
+
+	MixerProfiler & profiler = Engine::mixer()->profiler();
+	profiler.setJobProfilingEnabled( true );
+
+	MixerProfiler::PeriodStats period;
+	MixerProfiler::PeriodStats total;
+	total.periodUsecs = 0;
+	std::fill( total.stageUsecs, total.stageUsecs + MixerProfiler::StageCount, 0 );
+	std::map<QString, double> categoryUsecs;
+	int periods = 0;
+	auto collect = [&]()
+	{
+		while( profiler.takePeriodStats( period ) )
+		{
+			++periods;
+			total.periodUsecs += period.periodUsecs;
+			for( int s = 0; s < MixerProfiler::StageCount; ++s )
+			{
+				total.stageUsecs[s] += period.stageUsecs[s];
+			}
+			for( const MixerProfiler::JobStats & job : period.jobs )
+			{
+				categoryUsecs[job.category] += job.usecs;
+			}
+		}
+	};
+
+	ProjectRenderer renderer( qs, device );
+
+	QElapsedTimer timer;
+	s_allocations = 0;
+	const long long mmAllocationsBefore = MemoryManager::allocationCount();
+	timer.start();
+	renderer.startProcessing();
+	while( !renderer.wait( 1 ) )
+	{
+		collect();
+	}
+	const double wallSeconds = timer.nsecsElapsed() / 1e9;
+	const long long mmAllocations = MemoryManager::allocationCount() -
+							mmAllocationsBefore;
+	const long long allocations = s_allocations + mmAllocations;
+	collect();
+
+	const double audioSeconds = double( device->frames() ) /
+					Engine::mixer()->processingSampleRate();
+
+	QJsonObject jobs;
+	for( const auto & category : categoryUsecs )
+	{
+		jobs[category.first] = category.second / 1000.0;
+	}
+
+	QJsonObject result;
+	result["project"] = project;
+	result["framesPerPeriod"] = Engine::mixer()->framesPerPeriod();
+	result["threads"] = threads;
+	result["audioSeconds"] = audioSeconds;
+	result["wallSeconds"] = wallSeconds;
+	result["realtimeFactor"] = wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0;
+	// stats of periods the profiler could hand over, it drops periods
+	// while its ring is full
+	result["profiledPeriods"] = periods;
+	result["stages"] = stageStats( total, periods );
+	result["jobsMs"] = jobs;
+	result["allocations"] = allocations;
+	result["memoryManagerAllocations"] = mmAllocations;
+	const double renderedPeriods = double( device->frames() ) /
+					Engine::mixer()->framesPerPeriod();
+	result["allocationsPerPeriod"] = renderedPeriods > 0 ? allocations / renderedPeriods : 0.0;
+
+	const NotePlayHandleManager::Stats nphStats = NotePlayHandleManager::stats();
+	QJsonObject notePlayHandles;
+	notePlayHandles["hits"] = double( nphStats.hits );
+	notePlayHandles["misses"] = double( nphStats.misses );
+	notePlayHandles["highWaterMark"] = nphStats.highWaterMark;
+	result["notePlayHandles"] = notePlayHandles;
+
+	// decoded audio files of the project, which are still loaded
+	QJsonObject sampleCache;
+	sampleCache["entries"] = SampleCache::entryCount();
+	sampleCache["residentBytes"] = double( SampleCache::residentBytes() );
+	sampleCache["mappedBytes"] = double( SampleCache::mappedBytes() );
+	result["sampleCache"] = sampleCache;
+
+	printf( "%s%s\n", ResultPrefix,
+		QJsonDocument( result ).toJson( QJsonDocument::Compact ).constData() );
+	fflush( stdout );
+	return EXIT_SUCCESS;
+}
+
+
+
+
+// starts notes on every instrument using a VoiceArena and fails if that
+// allocated through the MemoryManager
+static int checkNoteOn()
+{
+	static const char * instruments[] =
+	{
+		"tripleoscillator", "organic", "kicker", "sfxr", "vibedstrings"
+	} ;
+	// fewer than the smallest arena has slots, on keys whose strings fit
+	// into vibed's pool
+	static const int Notes = 16;
+
+	MemoryManager::setCountingAllocations( true );
+	NotePlayHandleManager::init();
+	Engine::init( true );
+
+	const fpp_t frames = Engine::mixer()->framesPerPeriod();
+	sampleFrame * buf = BufferManager::acquire();
+	NotePlayHandle * notes[Notes];
+
+	QJsonArray results;
+	bool allocated = false;
+	for( const char * name : instruments )
+	{
+		InstrumentTrack * track = dynamic_cast<InstrumentTrack *>(
+			Track::create( Track::InstrumentTrack, Engine::getSong() ) );
+		if( track->loadInstrument( name )->nodeName() != name )
+		{
+			fprintf( stderr, "Could not load %s\n", name );
+			return EXIT_FAILURE;
+		}
+
+		long long mmAllocations = 0;
+		long long allocations = 0;
+		// the first pass lets shared state like wavetables get set up
+		for( int pass = 0; pass < 2; ++pass )
+		{
+			for( int n = 0; n < Notes; ++n )
+			{
+				notes[n] = NotePlayHandleManager::acquire( track, 0,
+						4 * frames, Note( MidiTime( 0 ),
+						MidiTime( 0 ), 36 + 3 * n ) );
+				s_allocations = 0;
+				const long long before = MemoryManager::allocationCount();
+				notes[n]->play( buf );
+				if( pass > 0 )
+				{
+					mmAllocations += MemoryManager::allocationCount() -
+										before;
+					allocations += s_allocations;
+				}
+			}
+			for( NotePlayHandle * n : notes )
+			{
+				NotePlayHandleManager::release( n );
+			}
+		}
+
+		fprintf( stderr, "%s: %lld MemoryManager allocations for %d notes\n",
+						name, mmAllocations, Notes );
+		allocated = allocated || mmAllocations > 0;
+
+		QJsonObject result;
+		result["instrument"] = name;
+		result["notes"] = Notes;
+		result["memoryManagerAllocations"] = mmAllocations;
+		// just for information, this includes what the track does with
+		// the audio of the notes
+		result["allocations"] = allocations;
+		results.append( result );
+	}
+	BufferManager::release( buf );
+
+	QJsonObject report;
+	report["noteOn"] = results;
+	const QByteArray json = QJsonDocument( report ).toJson();
+	fwrite( json.constData(), 1, json.size(), stdout );
+	return allocated ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+
+
+static QList<int> intList( const QString & arg )
+{
+	QList<int> values;
+	for( const QString & v : arg.split( ',', QString::SkipEmptyParts ) )
+	{
+		values << v.toInt();
+	}
+	return values;
+}
+
+
+
+
+static void printUsage()
+{
+	printf( "Usage: lmms-bench [options] [<project>...]\n\n"
+		"Renders the given projects, or a synthetic one if none are given,\n"
+		"with every combination of period size and thread count and\n"
+		"writes the results as JSON.\n\n"
+		"  --frames <list>     Comma separated period sizes, default: 64,128,256\n"
+		"  --threads <list>    Comma separated thread counts, default: 1,<ideal>\n"
+		"  --synthetic         Render the synthetic project besides the given ones\n"
+		"  --check-note-on     Fail if starting notes allocates through the\n"
+		"                      MemoryManager in instruments using a VoiceArena\n"
+		"  --tracks <n>        Instrument tracks of the synthetic project (8)\n"
+		"  --polyphony <n>     Notes played at once per track (4)\n"
+		"  --effects <n>       Effects per FX channel (1)\n"
+		"  --send-depth <n>    FX channels chained behind each track (1)\n"
+		"  --bars <n>          Length of the synthetic project (16)\n"
+		"  -o, --output <file> Write the report to <file> instead of stdout\n"
+		"  -h, --help          Show this usage information\n" );
+}
+
+
+
+
+int main( int argc, char * argv[] )
+{
+	QCoreApplication app( argc, argv );
+
+	QStringList projects;
+	QList<int> frameSizes = { 64, 128, 256 };
+	QList<int> threadCounts = { 1, QThread::idealThreadCount() };
+	SyntheticSettings synthetic;
+	bool addSynthetic = false;
+	QString output;
+	// set in child processes
+	QString renderOne;
+	int frames = DEFAULT_BUFFER_SIZE;
+	int threads = 1;
+
+	const QStringList args = app.arguments();
+	for( int i = 1; i < args.size(); ++i )
+	{
+		const QString & arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+		if( arg == "-h" || arg == "--help" )
+		{
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+		else if( arg == "--synthetic" )
+		{
+			addSynthetic = true;
+		}
+		else if( arg == "--check-note-on" )
+		{
+			return checkNoteOn();
+		}
+		else if( !arg.startsWith( '-' ) )
+		{
+			projects << arg;
+		}
+		else if( !hasValue )
+		{
+			fprintf( stderr, "Missing value for %s\n", qPrintable( arg ) );
+			return EXIT_FAILURE;
+		}
+		else if( arg == "--frames" ) { frameSizes = intList( args[++i] ); }
+		else if( arg == "--threads" ) { threadCounts = intList( args[++i] ); }
+		else if( arg == "--tracks" ) { synthetic.tracks = args[++i].toInt(); }
+		else if( arg == "--polyphony" ) { synthetic.polyphony = args[++i].toInt(); }
+		else if( arg == "--effects" ) { synthetic.effects = args[++i].toInt(); }
+		else if( arg == "--send-depth" ) { synthetic.sendDepth = args[++i].toInt(); }
+		else if( arg == "--bars" ) { synthetic.bars = args[++i].toInt(); }
+		else if( arg == "-o" || arg == "--output" ) { output = args[++i]; }
+		else if( arg == "--render-one" ) { renderOne = args[++i]; }
+		else if( arg == "--render-frames" ) { frames = args[++i].toInt(); }
+		else if( arg == "--render-threads" ) { threads = args[++i].toInt(); }
+		else
+		{
+			fprintf( stderr, "Unknown option %s\n", qPrintable( arg ) );
+			return EXIT_FAILURE;
+		}
+	}
+
+	if( !renderOne.isEmpty() )
+	{
+		return renderProject( renderOne, synthetic, frames, threads );
+	}
+
+	if( projects.isEmpty() || addSynthetic )
+	{
+		projects << SyntheticProject;
+	}
+
+	QJsonArray results;
+	for( const QString & project : projects )
+	{
+		for( int f : frameSizes )
+		{
+			for( int t : threadCounts )
+			{
+				fprintf( stderr, "Rendering %s with %d frames and %d threads\n",
+						qPrintable( project ), f, t );
+
+				QProcess child;
+				child.setProcessChannelMode( QProcess::ForwardedErrorChannel );
+				child.start( app.applicationFilePath(), QStringList()
+					<< "--render-one" << project
+					<< "--render-frames" << QString::number( f )
+					<< "--render-threads" << QString::number( t )
+					<< "--tracks" << QString::number( synthetic.tracks )
+					<< "--polyphony" << QString::number( synthetic.polyphony )
+					<< "--effects" << QString::number( synthetic.effects )
+					<< "--send-depth" << QString::number( synthetic.sendDepth )
+					<< "--bars" << QString::number( synthetic.bars ) );
+				child.waitForFinished( -1 );
+
+				QJsonObject result;
+				for( const QByteArray & line : child.readAllStandardOutput().split( '\n' ) )
+				{
+					if( line.startsWith( ResultPrefix ) )
+					{
+						result = QJsonDocument::fromJson(
+							line.mid( strlen( ResultPrefix ) ) ).object();
+					}
+				}
+				if( result.isEmpty() )
+				{
+					result["project"] = project;
+					result["framesPerPeriod"] = f;
+					result["threads"] = t;
+					result["error"] = QString( "render failed with exit code %1" ).
+									arg( child.exitCode() );
+				}
+				results.append( result );
+			}
+		}
+	}
+
+	QJsonObject synthSettings;
+	synthSettings["tracks"] = synthetic.tracks;
+	synthSettings["polyphony"] = synthetic.polyphony;
+	synthSettings["effects"] = synthetic.effects;
+	synthSettings["sendDepth"] = synthetic.sendDepth;
+	synthSettings["bars"] = synthetic.bars;
+
+	QJsonObject report;
+	report["synthetic"] = synthSettings;
+	report["results"] = results;
+	const QByteArray json = QJsonDocument( report ).toJson();
+
+	if( output.isEmpty() )
+	{
+		fwrite( json.constData(), 1, json.size(), stdout );
+		return EXIT_SUCCESS;
+	}
+	QFile file( output );
+	if( !file.open( QFile::WriteOnly | QFile::Truncate ) )
+	{
+		fprintf( stderr, "Could not write %s\n", qPrintable( output ) );
+		return EXIT_FAILURE;
+	}
+	file.write( json );
+	return EXIT_SUCCESS;
+}
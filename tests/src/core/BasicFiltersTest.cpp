@@ -0,0 +1,150 @@
+/*
+ * BasicFiltersTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "BasicFilters.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+typedef BasicFilters<DEFAULT_CHANNELS> Filter;
+
+const int Frames = 4096;
+const sample_rate_t SampleRate = 44100;
+
+std::vector<float> noise()
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+	std::vector<float> samples(Frames * DEFAULT_CHANNELS);
+	for (float& s : samples)
+	{
+		s = dist(rng);
+	}
+	return samples;
+}
+
+sampleFrame* frames(std::vector<float>& samples)
+{
+	return reinterpret_cast<sampleFrame*>(samples.data());
+}
+
+bool sameSamples(const std::vector<float>& a, const std::vector<float>& b)
+{
+	return std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+}
+
+class BasicFiltersTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	//! processBuffer() has to give exactly the output of update()
+	void testBlockMatchesUpdate()
+	{
+		for (int type = 0; type < Filter::NumFilters; ++type)
+		{
+			Filter perSample(SampleRate), block(SampleRate);
+			perSample.setFilterType(type);
+			block.setFilterType(type);
+			perSample.calcFilterCoeffs(1000, 0.5f);
+			block.calcFilterCoeffs(1000, 0.5f);
+
+			std::vector<float> expected = noise(), actual = noise();
+			sampleFrame* e = frames(expected);
+			for (int f = 0; f < Frames; ++f)
+			{
+				e[f][0] = perSample.update(e[f][0], 0);
+				e[f][1] = perSample.update(e[f][1], 1);
+			}
+			block.processBuffer(frames(actual), Frames);
+
+			QVERIFY2(sameSamples(actual, expected), qPrintable(QString("filter type %1").arg(type)));
+		}
+	}
+
+	//! Interpolated coefficients have to stay close to coefficients
+	//! calculated for every frame, and not change anything while the
+	//! cutoff stays put
+	void testModulatedCutoff()
+	{
+		// exponential sweep from 200 Hz to 5 kHz
+		std::vector<float> sweep(Frames);
+		for (int f = 0; f < Frames; ++f)
+		{
+			sweep[f] = 200.0f * powf(25.0f, float(f) / Frames);
+		}
+		const std::vector<float> constant(Frames, 1000.0f);
+		const float q = 0.5f;
+
+		for (int type = 0; type < Filter::NumFilters; ++type)
+		{
+			const QString name = QString("filter type %1").arg(type);
+
+			Filter perFrame(SampleRate), interpolated(SampleRate);
+			perFrame.setFilterType(type);
+			interpolated.setFilterType(type);
+			perFrame.calcFilterCoeffs(sweep[0], q);
+			interpolated.calcFilterCoeffs(sweep[0], q);
+
+			std::vector<float> expected = noise(), actual = noise();
+			sampleFrame* e = frames(expected);
+			for (int f = 0; f < Frames; ++f)
+			{
+				perFrame.calcFilterCoeffs(sweep[f], q);
+				e[f][0] = perFrame.update(e[f][0], 0);
+				e[f][1] = perFrame.update(e[f][1], 1);
+			}
+			interpolated.processBuffer(frames(actual), Frames, sweep.data(), 1, &q, 0);
+
+			double error = 0;
+			double power = 0;
+			for (size_t i = 0; i < actual.size(); ++i)
+			{
+				QVERIFY2(std::isfinite(actual[i]), qPrintable(name));
+				error += (actual[i] - expected[i]) * (actual[i] - expected[i]);
+				power += expected[i] * expected[i];
+			}
+			QVERIFY2(10 * log10(error / power) < -60, qPrintable(name));
+
+			Filter fixed(SampleRate), steady(SampleRate);
+			fixed.setFilterType(type);
+			steady.setFilterType(type);
+			fixed.calcFilterCoeffs(1000, q);
+			steady.calcFilterCoeffs(1000, q);
+
+			std::vector<float> fixedOut = noise(), steadyOut = noise();
+			fixed.processBuffer(frames(fixedOut), Frames);
+			steady.processBuffer(frames(steadyOut), Frames, constant.data(), 1, &q, 0);
+			QVERIFY2(sameSamples(steadyOut, fixedOut), qPrintable(name));
+		}
+	}
+} BasicFiltersTests;
+
+#include "BasicFiltersTest.moc"
@@ -0,0 +1,184 @@
+/*
+ * MixHelpersTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "MixHelpers.h"
+#include "PlanarBuffer.h"
+#include "ValueBuffer.h"
+
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+using MixHelpers::InstructionSet;
+
+class MixHelpersTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void testInstructionSetsBitExact()
+	{
+		// not a multiple of any vector size, so the generic tail is used too
+		const int frames = 259;
+
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> dist(-5.0f, 5.0f);
+
+		std::vector<float> src(frames * 2), dst(frames * 2);
+		std::vector<float> left(frames), right(frames);
+		ValueBuffer buf1(frames), buf2(frames);
+		for (int i = 0; i < frames * 2; ++i)
+		{
+			src[i] = dist(rng);
+			dst[i] = dist(rng);
+		}
+		for (int i = 0; i < frames; ++i)
+		{
+			left[i] = dist(rng);
+			right[i] = dist(rng);
+			buf1.values()[i] = dist(rng);
+			buf2.values()[i] = dist(rng);
+		}
+		src[3] = std::numeric_limits<float>::infinity();
+		src[40] = -std::numeric_limits<float>::infinity();
+		src[77] = std::numeric_limits<float>::quiet_NaN();
+		src[frames * 2 - 1] = std::numeric_limits<float>::quiet_NaN();
+
+		std::vector<float> quiet(frames * 2, 0.00000001f);
+		quiet[frames] = -0.001f;
+
+		auto s = [&src]() { return reinterpret_cast<const sampleFrame*>(src.data()); };
+
+		typedef std::function<bool(sampleFrame*)> Op;
+		const Op ops[] = {
+			[&](sampleFrame* d) { return MixHelpers::isSilent(d, frames); },
+			[&](sampleFrame*) { return MixHelpers::isSilent(reinterpret_cast<sampleFrame*>(quiet.data()), frames); },
+			[&](sampleFrame*) { return MixHelpers::isSilent(reinterpret_cast<sampleFrame*>(quiet.data()), frames / 2); },
+			[&](sampleFrame* d) { std::memcpy(d, src.data(), frames * sizeof(sampleFrame)); return MixHelpers::sanitize(d, frames); },
+			[&](sampleFrame* d) { MixHelpers::add(d, s(), frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::addMultiplied(d, s(), 0.3f, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::addMultipliedByBuffer(d, s(), 0.7f, &buf1, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::addMultipliedByBuffers(d, s(), &buf1, &buf2, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::addSanitizedMultiplied(d, s(), 0.3f, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::addSanitizedMultipliedByBuffer(d, s(), 0.7f, &buf1, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::addSanitizedMultipliedByBuffers(d, s(), &buf1, &buf2, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::addMultipliedStereo(d, s(), 0.2f, 0.9f, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::multiplyAndAddMultiplied(d, s(), 0.5f, 1.5f, frames); return false; },
+			[&](sampleFrame* d) { MixHelpers::multiplyAndAddMultipliedJoined(d, left.data(), right.data(), 0.5f, 1.5f, frames); return false; },
+		};
+
+		const InstructionSet previous = MixHelpers::instructionSet();
+		const InstructionSet sets[] = { InstructionSet::SSE2, InstructionSet::AVX2, InstructionSet::AVX512 };
+		for (InstructionSet set : sets)
+		{
+			if (!MixHelpers::isSupported(set))
+			{
+				continue;
+			}
+			for (const Op& op : ops)
+			{
+				std::vector<float> expected(dst), actual(dst);
+
+				QVERIFY(MixHelpers::setInstructionSet(InstructionSet::Generic));
+				const bool expectedResult = op(reinterpret_cast<sampleFrame*>(expected.data()));
+
+				QVERIFY(MixHelpers::setInstructionSet(set));
+				const bool actualResult = op(reinterpret_cast<sampleFrame*>(actual.data()));
+
+				QCOMPARE(actualResult, expectedResult);
+				QVERIFY(std::memcmp(actual.data(), expected.data(), actual.size() * sizeof(float)) == 0);
+			}
+		}
+		MixHelpers::setInstructionSet(previous);
+	}
+
+	void testPlanarMatchesInterleaved()
+	{
+		const int frames = 259;
+
+		std::mt19937 rng(4321);
+		std::uniform_real_distribution<float> dist(-5.0f, 5.0f);
+
+		std::vector<float> src(frames * 2), dst(frames * 2);
+		ValueBuffer buf1(frames), buf2(frames);
+		for (int i = 0; i < frames * 2; ++i)
+		{
+			src[i] = dist(rng);
+			dst[i] = dist(rng);
+		}
+		for (int i = 0; i < frames; ++i)
+		{
+			buf1.values()[i] = dist(rng);
+			buf2.values()[i] = dist(rng);
+		}
+		src[3] = std::numeric_limits<float>::infinity();
+		src[40] = -std::numeric_limits<float>::infinity();
+		src[77] = std::numeric_limits<float>::quiet_NaN();
+
+		std::vector<float> srcLeft(frames), srcRight(frames);
+		const PlanarBuffer planarSrc(srcLeft.data(), srcRight.data(), frames);
+		planarSrc.deinterleave(reinterpret_cast<const sampleFrame*>(src.data()));
+		auto s = [&src]() { return reinterpret_cast<const sampleFrame*>(src.data()); };
+
+		typedef std::function<void(sampleFrame*)> Op;
+		typedef std::function<void(const PlanarBuffer&)> PlanarOp;
+		const std::pair<Op, PlanarOp> ops[] = {
+			{ [&](sampleFrame* d) { MixHelpers::add(d, s(), frames); },
+				[&](const PlanarBuffer& d) { MixHelpers::add(d, planarSrc, frames); } },
+			{ [&](sampleFrame* d) { MixHelpers::addMultiplied(d, s(), 0.3f, frames); },
+				[&](const PlanarBuffer& d) { MixHelpers::addMultiplied(d, planarSrc, 0.3f, frames); } },
+			{ [&](sampleFrame* d) { MixHelpers::addSanitizedMultiplied(d, s(), 0.3f, frames); },
+				[&](const PlanarBuffer& d) { MixHelpers::addSanitizedMultiplied(d, planarSrc, 0.3f, frames); } },
+			{ [&](sampleFrame* d) { MixHelpers::addSanitizedMultipliedByBuffer(d, s(), 0.7f, &buf1, frames); },
+				[&](const PlanarBuffer& d) { MixHelpers::addSanitizedMultipliedByBuffer(d, planarSrc, 0.7f, &buf1, frames); } },
+			{ [&](sampleFrame* d) { MixHelpers::addSanitizedMultipliedByBuffers(d, s(), &buf1, &buf2, frames); },
+				[&](const PlanarBuffer& d) { MixHelpers::addSanitizedMultipliedByBuffers(d, planarSrc, &buf1, &buf2, frames); } },
+		};
+
+		const InstructionSet previous = MixHelpers::instructionSet();
+		QVERIFY(MixHelpers::setInstructionSet(InstructionSet::Generic));
+		for (const auto& op : ops)
+		{
+			std::vector<float> expected(dst), actual(dst);
+			op.first(reinterpret_cast<sampleFrame*>(expected.data()));
+
+			std::vector<float> left(frames), right(frames);
+			const PlanarBuffer planarDst(left.data(), right.data(), frames);
+			planarDst.deinterleave(reinterpret_cast<const sampleFrame*>(actual.data()));
+			op.second(planarDst);
+			planarDst.interleave(reinterpret_cast<sampleFrame*>(actual.data()));
+
+			QVERIFY(std::memcmp(actual.data(), expected.data(), actual.size() * sizeof(float)) == 0);
+		}
+		MixHelpers::setInstructionSet(previous);
+
+		std::vector<float> silent(frames, 0.00000001f);
+		QVERIFY(MixHelpers::isSilent(PlanarBuffer(silent.data(), silent.data(), frames), frames));
+		QVERIFY(!MixHelpers::isSilent(planarSrc, frames));
+	}
+} MixHelpersTests;
+
+#include "MixHelpersTest.moc"
@@ -0,0 +1,123 @@
+/*
+ * NotePlayHandlePoolTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "NotePlayHandle.h"
+
+class NotePlayHandlePoolTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void testConcurrentAllocation()
+	{
+		const int Threads = 4;
+		const int Rounds = 2000;
+		const int MaxBatch = 100;
+
+		const NotePlayHandleManager::Stats before = NotePlayHandleManager::stats();
+		std::atomic_int allocations(0);
+		std::atomic_int corrupted(0);
+
+		// batches get released by other threads than the ones which
+		// allocated them, so magazines move between threads
+		std::mutex handOverMutex;
+		std::vector<std::vector<void*>> handOver;
+
+		auto work = [&](int thread)
+		{
+			unsigned int seed = thread + 1;
+			for (int round = 0; round < Rounds; ++round)
+			{
+				seed = seed * 1103515245 + 12345;
+				const int size = 1 + (seed >> 16) % MaxBatch;
+
+				std::vector<void*> batch;
+				for (int i = 0; i < size; ++i)
+				{
+					// another thread getting the same storage
+					// would overwrite the mark
+					int* mark = static_cast<int*>(NotePlayHandleManager::allocate());
+					mark[0] = thread;
+					mark[1] = i;
+					batch.push_back(mark);
+				}
+				allocations += size;
+				for (int i = 0; i < size; ++i)
+				{
+					const int* mark = static_cast<int*>(batch[i]);
+					if (mark[0] != thread || mark[1] != i)
+					{
+						++corrupted;
+					}
+				}
+
+				std::vector<void*> released;
+				{
+					std::lock_guard<std::mutex> lock(handOverMutex);
+					handOver.push_back(std::move(batch));
+					if (handOver.size() > 1)
+					{
+						released = std::move(handOver.front());
+						handOver.erase(handOver.begin());
+					}
+				}
+				for (void* storage : released)
+				{
+					NotePlayHandleManager::deallocate(storage);
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < Threads; ++t)
+		{
+			threads.emplace_back(work, t);
+		}
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		for (const std::vector<void*>& batch : handOver)
+		{
+			for (void* storage : batch)
+			{
+				NotePlayHandleManager::deallocate(storage);
+			}
+		}
+
+		QCOMPARE(corrupted.load(), 0);
+
+		const NotePlayHandleManager::Stats after = NotePlayHandleManager::stats();
+		QCOMPARE(after.inUse, before.inUse);
+		QCOMPARE(int(after.hits + after.misses - before.hits - before.misses),
+							allocations.load());
+		QVERIFY(after.highWaterMark >= MaxBatch / 2);
+	}
+} NotePlayHandlePoolTests;
+
+#include "NotePlayHandlePoolTest.moc"
@@ -0,0 +1,163 @@
+/*
+ * OscillatorTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "AutomatableModel.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "Oscillator.h"
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+class OscillatorTest : QTestSuite
+{
+	Q_OBJECT
+private:
+	// power outside of the harmonics of a signal with the given number of
+	// cycles, relative to its total power, in dB
+	static double aliasing(const std::vector<float>& signal, int cycles)
+	{
+		const int size = signal.size();
+		double aliased = 0.0, total = 0.0;
+		for (int bin = 1; bin < size / 2; ++bin)
+		{
+			double re = 0.0, im = 0.0;
+			for (int i = 0; i < size; ++i)
+			{
+				const double w = D_2PI * bin * i / size;
+				re += signal[i] * std::cos(w);
+				im += signal[i] * std::sin(w);
+			}
+			const double power = re * re + im * im;
+			total += power;
+			if (bin % cycles != 0)
+			{
+				aliased += power;
+			}
+		}
+		return 10.0 * std::log10(aliased / total);
+	}
+
+	// left channel of an oscillator running at the given frequency
+	static std::vector<float> render(Oscillator::WaveShapes shape, float freq,
+		int frames)
+	{
+		const float detuning = 1.0f / Engine::mixer()->processingSampleRate();
+		const float phaseOffset = 0.0f;
+		const float volume = 1.0f;
+
+		IntModel waveShape(shape, 0, Oscillator::NumWaveShapes - 1);
+		IntModel modulationAlgo(0, 0, Oscillator::NumModulationAlgos - 1);
+		Oscillator osc(&waveShape, &modulationAlgo, freq, detuning, phaseOffset, volume);
+
+		std::vector<sampleFrame> buf(frames);
+		osc.update(buf.data(), frames, 0);
+
+		std::vector<float> signal(frames);
+		for (int i = 0; i < frames; ++i)
+		{
+			signal[i] = buf[i][0];
+		}
+		return signal;
+	}
+
+	// improvement is how much less aliasing there has to be than in the
+	// naive waveform, in dB
+	static void compareWithNaive(Oscillator::WaveShapes shape,
+		const std::function<sample_t(float)>& naive, double improvement)
+	{
+		// the harmonics above the Nyquist frequency don't fold back
+		// onto other harmonics
+		const int frames = 4096;
+		const int cycles = 185;
+		const float freq = cycles * Engine::mixer()->processingSampleRate() / frames;
+
+		const std::vector<float> bandLimited = render(shape, freq, frames);
+		std::vector<float> naiveSignal(frames);
+		for (int i = 0; i < frames; ++i)
+		{
+			naiveSignal[i] = naive(static_cast<float>(i) * cycles / frames);
+		}
+
+		const double naiveAliasing = aliasing(naiveSignal, cycles);
+		const double bandLimitedAliasing = aliasing(bandLimited, cycles);
+		QVERIFY(bandLimitedAliasing < -40.0);
+		QVERIFY(bandLimitedAliasing < naiveAliasing - improvement);
+	}
+
+	// at low frequencies, band-limiting only rounds off the edges, so the
+	// waveform has to correlate with the naive one
+	static void compareShapeWithNaive(Oscillator::WaveShapes shape,
+		const std::function<sample_t(float)>& naive)
+	{
+		const int frames = 4096;
+		const int cycles = 10;
+		const float freq = cycles * Engine::mixer()->processingSampleRate() / frames;
+
+		const std::vector<float> bandLimited = render(shape, freq, frames);
+		double product = 0.0, bandLimitedPower = 0.0, naivePower = 0.0;
+		for (int i = 0; i < frames; ++i)
+		{
+			const double n = naive(static_cast<float>(i) * cycles / frames);
+			product += bandLimited[i] * n;
+			bandLimitedPower += bandLimited[i] * bandLimited[i];
+			naivePower += n * n;
+		}
+		QVERIFY(product / std::sqrt(bandLimitedPower * naivePower) > 0.99);
+	}
+
+private slots:
+	void testSawIsBandLimited()
+	{
+		compareWithNaive(Oscillator::SawWave, Oscillator::sawSample, 30.0);
+	}
+
+	void testSquareIsBandLimited()
+	{
+		compareWithNaive(Oscillator::SquareWave, Oscillator::squareSample, 30.0);
+	}
+
+	void testTriangleIsBandLimited()
+	{
+		// the harmonics of a triangle fall off with their square, so
+		// even the naive one aliases little
+		compareWithNaive(Oscillator::TriangleWave, Oscillator::triangleSample, 20.0);
+	}
+
+	void testMoogSawIsBandLimited()
+	{
+		compareWithNaive(Oscillator::MoogSawWave, Oscillator::moogSawSample, 30.0);
+	}
+
+	void testBandLimitedShapes()
+	{
+		compareShapeWithNaive(Oscillator::SawWave, Oscillator::sawSample);
+		compareShapeWithNaive(Oscillator::SquareWave, Oscillator::squareSample);
+		compareShapeWithNaive(Oscillator::TriangleWave, Oscillator::triangleSample);
+		compareShapeWithNaive(Oscillator::MoogSawWave, Oscillator::moogSawSample);
+	}
+} OscillatorTests;
+
+#include "OscillatorTest.moc"
@@ -0,0 +1,138 @@
+/*
+ * ProjectCacheTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "ProjectCache.h"
+
+#include <QDomDocument>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+
+namespace
+{
+
+// compares the trees, attributes in any order
+bool sameNodes(const QDomNode& a, const QDomNode& b)
+{
+	if (a.nodeType() != b.nodeType() || a.nodeName() != b.nodeName() ||
+		a.nodeValue() != b.nodeValue())
+	{
+		return false;
+	}
+
+	const QDomNamedNodeMap attributesA = a.attributes();
+	const QDomNamedNodeMap attributesB = b.attributes();
+	if (attributesA.count() != attributesB.count())
+	{
+		return false;
+	}
+	for (int i = 0; i < attributesA.count(); ++i)
+	{
+		const QDomNode attribute = attributesA.item(i);
+		const QDomNode other = attributesB.namedItem(attribute.nodeName());
+		if (other.isNull() || other.nodeValue() != attribute.nodeValue())
+		{
+			return false;
+		}
+	}
+
+	QDomNode childA = a.firstChild();
+	QDomNode childB = b.firstChild();
+	for (; !childA.isNull() && !childB.isNull();
+		childA = childA.nextSibling(), childB = childB.nextSibling())
+	{
+		if (!sameNodes(childA, childB))
+		{
+			return false;
+		}
+	}
+	return childA.isNull() && childB.isNull();
+}
+
+}
+
+class ProjectCacheTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		// don't touch the user's cache directory
+		QStandardPaths::setTestModeEnabled(true);
+	}
+
+	void cleanupTestCase()
+	{
+		QStandardPaths::setTestModeEnabled(false);
+	}
+
+	void RoundTripTest()
+	{
+		// only projects from 512 KB on get cached
+		QTemporaryFile source;
+		QVERIFY(source.open());
+		QCOMPARE(source.write(QByteArray(1024 * 1024, ' ')), qint64(1024 * 1024));
+		QVERIFY(source.flush());
+
+		QDomDocument doc("lmms-project");
+		doc.appendChild(doc.createProcessingInstruction("xml", "version=\"1.0\""));
+		QDomElement root = doc.createElement("lmms-project");
+		root.setAttribute("version", "1.0");
+		root.setAttribute("type", "song");
+		doc.appendChild(root);
+		QDomElement track = doc.createElement("track");
+		track.setAttribute("name", QString::fromUtf8("Gr\xc3\xbc\xc3\x9f" "e \xe2\x99\xab"));
+		// stored out of line
+		track.setAttribute("data", QString(8192, 'x'));
+		// too large to be inline, but not Latin-1
+		track.setAttribute("text", QString(8192, QChar(0x266b)));
+		track.appendChild(doc.createTextNode("text"));
+		track.appendChild(doc.createCDATASection("<cdata>"));
+		root.appendChild(track);
+		root.appendChild(doc.createComment("comment"));
+		// shares its name with the first one
+		root.appendChild(doc.createElement("track"));
+
+		ProjectCache::store(QFileInfo(source.fileName()), doc, "1.2.0");
+
+		QDomDocument loaded("lmms-project");
+		QString creatorVersion;
+		QVERIFY(ProjectCache::load(QFileInfo(source.fileName()), loaded, creatorVersion));
+		QVERIFY(sameNodes(loaded, doc));
+		QCOMPARE(creatorVersion, QString("1.2.0"));
+
+		// a changed project doesn't use its old copy
+		QCOMPARE(source.write("x"), qint64(1));
+		QVERIFY(source.flush());
+		QDomDocument stale("lmms-project");
+		QVERIFY(!ProjectCache::load(QFileInfo(source.fileName()), stale, creatorVersion));
+
+		ProjectCache::store(QFileInfo(source.fileName()), doc, "1.2.0");
+		ProjectCache::remove(source.fileName());
+		QDomDocument removed("lmms-project");
+		QVERIFY(!ProjectCache::load(QFileInfo(source.fileName()), removed, creatorVersion));
+	}
+} ProjectCacheTests;
+
+#include "ProjectCacheTest.moc"
@@ -0,0 +1,157 @@
+/*
+ * SampleBufferTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "ConfigManager.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "SampleBuffer.h"
+
+#include <QTemporaryDir>
+
+#include <sndfile.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+// more than 1 MB once decoded, the lowest threshold for streaming
+const int Frames = 150000;
+
+// a stereo sweep, so that a reversed or shifted decode can't match
+QString writeSweep(const QTemporaryDir& dir, const QString& name, int sampleRate)
+{
+	std::vector<float> samples(Frames * 2);
+	for (int f = 0; f < Frames; ++f)
+	{
+		const float t = float(f) / sampleRate;
+		samples[f * 2] = 0.5f * sinf(2 * M_PI * (100 + 500 * t) * t);
+		samples[f * 2 + 1] = 0.25f * sinf(2 * M_PI * 300 * t);
+	}
+
+	const QString path = dir.filePath(name);
+	SF_INFO info;
+	std::memset(&info, 0, sizeof(info));
+	info.samplerate = sampleRate;
+	info.channels = 2;
+	info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+	SNDFILE* file = sf_open(path.toLocal8Bit().constData(), SFM_WRITE, &info);
+	if (file == nullptr)
+	{
+		return QString();
+	}
+	sf_writef_float(file, samples.data(), Frames);
+	sf_close(file);
+	return path;
+}
+
+std::vector<float> decode(const QString& path, bool reversed, bool& streamed)
+{
+	SampleBuffer buffer(path);
+	if (reversed)
+	{
+		buffer.setReversed(true);
+	}
+	streamed = buffer.isStreamed();
+	const float* data = buffer.data()[0];
+	return std::vector<float>(data, data + buffer.frames() * 2);
+}
+
+}
+
+class SampleBufferTest : QTestSuite
+{
+	Q_OBJECT
+private:
+	QString m_threshold;
+
+	void setThreshold(int megabytes)
+	{
+		ConfigManager::inst()->setValue("app", "samplestreamthreshold", QString::number(megabytes));
+	}
+
+	//! Decodes the file in memory and streamed, the buffers have to be
+	//! destroyed in between, or the second one would share the frames of
+	//! the first one
+	void compareStreamedWithMemory(const QString& path, bool reversed, float tolerance)
+	{
+		bool streamed = true;
+		setThreshold(1024);
+		const std::vector<float> inMemory = decode(path, reversed, streamed);
+		QVERIFY(!streamed);
+
+		setThreshold(1);
+		const std::vector<float> fromCache = decode(path, reversed, streamed);
+		QVERIFY(streamed);
+
+		// the resamplers of both ways may end a few frames apart, and
+		// in-memory decoding doesn't flush its resampler
+		const size_t margin = tolerance > 0 ? 64 * 2 : 0;
+		const size_t size = std::min(fromCache.size(), inMemory.size());
+		QVERIFY(std::max(fromCache.size(), inMemory.size()) - size <= margin);
+		float maxError = 0;
+		for (size_t i = 0; i < size - margin; ++i)
+		{
+			maxError = std::max(maxError, std::fabs(fromCache[i] - inMemory[i]));
+		}
+		QVERIFY(maxError <= tolerance);
+	}
+
+private slots:
+	void initTestCase()
+	{
+		m_threshold = ConfigManager::inst()->value("app", "samplestreamthreshold");
+	}
+
+	void cleanupTestCase()
+	{
+		ConfigManager::inst()->setValue("app", "samplestreamthreshold", m_threshold);
+	}
+
+	void testStreamedMatchesMemory()
+	{
+		QTemporaryDir dir;
+		const QString path = writeSweep(dir, "sweep.wav", Engine::mixer()->baseSampleRate());
+		QVERIFY(!path.isEmpty());
+
+		compareStreamedWithMemory(path, false, 0);
+		compareStreamedWithMemory(path, true, 0);
+	}
+
+	void testStreamedResampledMatchesMemory()
+	{
+		QTemporaryDir dir;
+		const sample_rate_t rate = Engine::mixer()->baseSampleRate() == 48000 ? 44100 : 48000;
+		const QString path = writeSweep(dir, "sweep.wav", rate);
+		QVERIFY(!path.isEmpty());
+
+		// resampled in chunks instead of at once
+		compareStreamedWithMemory(path, false, 0.001f);
+	}
+} SampleBufferTests;
+
+#include "SampleBufferTest.moc"
@@ -0,0 +1,158 @@
+/*
+ * SampleCacheTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "Engine.h"
+#include "Mixer.h"
+#include "SampleBuffer.h"
+#include "SampleCache.h"
+
+#include <QTemporaryDir>
+
+#include <sndfile.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+// a ramp, so that reversed frames differ from the original ones
+bool writeRamp(const QString& path, int frames)
+{
+	std::vector<float> samples(frames * 2);
+	for (int f = 0; f < frames; ++f)
+	{
+		samples[f * 2] = samples[f * 2 + 1] = float(f) / frames;
+	}
+
+	SF_INFO info;
+	std::memset(&info, 0, sizeof(info));
+	info.samplerate = Engine::mixer()->baseSampleRate();
+	info.channels = 2;
+	info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+	SNDFILE* file = sf_open(path.toLocal8Bit().constData(), SFM_WRITE, &info);
+	if (file == nullptr)
+	{
+		return false;
+	}
+	sf_writef_float(file, samples.data(), frames);
+	sf_close(file);
+	return true;
+}
+
+QString keyOf(const QString& path, bool reversed)
+{
+	return SampleCache::key(path, Engine::mixer()->baseSampleRate(), reversed);
+}
+
+}
+
+class SampleCacheTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void testBuffersShareEntry()
+	{
+		QTemporaryDir dir;
+		const QString path = dir.filePath("ramp.wav");
+		QVERIFY(writeRamp(path, 1000));
+
+		const int entries = SampleCache::entryCount();
+		const qint64 resident = SampleCache::residentBytes();
+		SampleBuffer first(path);
+		SampleBuffer second(path);
+		QCOMPARE(SampleCache::entryCount(), entries + 1);
+		QCOMPARE(second.data(), first.data());
+		QCOMPARE(SampleCache::residentBytes(), resident + qint64(1000 * sizeof(sampleFrame)));
+	}
+
+	void testChangedFileIsDecodedAgain()
+	{
+		QTemporaryDir dir;
+		const QString path = dir.filePath("ramp.wav");
+		QVERIFY(writeRamp(path, 1000));
+		const QString key = keyOf(path, false);
+		SampleBuffer before(path);
+
+		// another size
+		QVERIFY(writeRamp(path, 2000));
+		QVERIFY(keyOf(path, false) != key);
+		SampleBuffer resized(path);
+		QVERIFY(resized.data() != before.data());
+		QCOMPARE(resized.frames(), f_cnt_t(2000));
+
+		// same size, but modified later, file times may only have a
+		// resolution of seconds
+		const QString resizedKey = keyOf(path, false);
+		QTest::qSleep(1100);
+		QVERIFY(writeRamp(path, 2000));
+		QVERIFY(keyOf(path, false) != resizedKey);
+		SampleBuffer modified(path);
+		QVERIFY(modified.data() != resized.data());
+	}
+
+	void testReversedIsOtherEntry()
+	{
+		QTemporaryDir dir;
+		const QString path = dir.filePath("ramp.wav");
+		QVERIFY(writeRamp(path, 1000));
+		QVERIFY(keyOf(path, true) != keyOf(path, false));
+
+		const int entries = SampleCache::entryCount();
+		SampleBuffer forward(path);
+		SampleBuffer reversed(path);
+		reversed.setReversed(true);
+		QCOMPARE(SampleCache::entryCount(), entries + 2);
+		QVERIFY(reversed.data() != forward.data());
+		QCOMPARE(reversed.data()[0][0], forward.data()[999][0]);
+
+		// reversing didn't touch the shared frames
+		SampleBuffer other(path);
+		QCOMPARE(other.data(), forward.data());
+		QCOMPARE(other.data()[0][0], 0.0f);
+	}
+
+	void testEntryExpiresWithLastUser()
+	{
+		QTemporaryDir dir;
+		const QString path = dir.filePath("ramp.wav");
+		QVERIFY(writeRamp(path, 1000));
+
+		const int entries = SampleCache::entryCount();
+		std::unique_ptr<SampleBuffer> first(new SampleBuffer(path));
+		std::unique_ptr<SampleBuffer> second(new SampleBuffer(path));
+		const QString key = keyOf(path, false);
+
+		first.reset();
+		QVERIFY(SampleCache::find(key) != nullptr);
+		QCOMPARE(SampleCache::entryCount(), entries + 1);
+
+		second.reset();
+		QVERIFY(SampleCache::find(key) == nullptr);
+		QCOMPARE(SampleCache::entryCount(), entries);
+	}
+} SampleCacheTests;
+
+#include "SampleCacheTest.moc"
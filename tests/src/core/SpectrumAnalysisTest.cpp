@@ -0,0 +1,143 @@
+/*
+ * SpectrumAnalysisTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "SpectrumAnalysis.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+const int Frames = SpectrumAnalysis::WindowSize;
+
+// a sine falling right onto the given bin, left channel only
+void sine(sampleFrame* frames, int bin)
+{
+	for (int i = 0; i < Frames; ++i)
+	{
+		frames[i][0] = 0.5f * sinf(M_PI * bin * i / SpectrumAnalysis::WindowSize);
+		frames[i][1] = 0;
+	}
+}
+
+int loudestBin(const SpectrumAnalysis::Spectrum& s)
+{
+	const float* m = s.magnitudes;
+	return std::max_element(m, m + SpectrumAnalysis::BinCount) - m;
+}
+
+}
+
+class SpectrumAnalysisTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void testFindsSine()
+	{
+		SpectrumAnalysis analysis;
+		analysis.setChannelMode(SpectrumAnalysis::LeftChannel);
+		sampleFrame frames[Frames];
+		sine(frames, 300);
+		// in periods, as the effects do
+		for (int f = 0; f < Frames; f += 64)
+		{
+			analysis.push(frames + f, 64);
+		}
+
+		// the thread may have analysed part of the frames first
+		SpectrumAnalysis::Spectrum s;
+		auto analysedAll = [&]()
+		{
+			analysis.spectrum(s);
+			return s.serial > 0 && std::fabs(s.peak - 0.5f) < 0.01f &&
+				s.magnitudes[300] > 1000 * s.magnitudes[350];
+		};
+		QTRY_VERIFY(analysedAll());
+		QCOMPARE(loudestBin(s), 300);
+	}
+
+	void testKeepsShortPeriods()
+	{
+		SpectrumAnalysis analysis;
+		analysis.setChannelMode(SpectrumAnalysis::LeftChannel);
+		sampleFrame frames[Frames];
+		sine(frames, 300);
+		// more periods than queued blocks, none of them may get dropped
+		for (int f = 0; f < Frames; f += 8)
+		{
+			analysis.push(frames + f, 8);
+		}
+
+		SpectrumAnalysis::Spectrum s;
+		auto analysedAll = [&]()
+		{
+			analysis.spectrum(s);
+			return s.serial > 0 && std::fabs(s.peak - 0.5f) < 0.01f &&
+				s.magnitudes[300] > 1000 * s.magnitudes[350];
+		};
+		QTRY_VERIFY(analysedAll());
+	}
+
+	void testChannelModeAndClear()
+	{
+		SpectrumAnalysis analysis;
+		analysis.setChannelMode(SpectrumAnalysis::RightChannel);
+		sampleFrame frames[Frames];
+		sine(frames, 300);
+		analysis.push(frames, Frames);
+
+		SpectrumAnalysis::Spectrum s;
+		QTRY_VERIFY(analysis.spectrum(s));
+		QCOMPARE(s.peak, 0.0f);
+
+		analysis.setChannelMode(SpectrumAnalysis::MergeChannels);
+		analysis.push(frames, Frames);
+		QTRY_VERIFY(analysis.spectrum(s) && s.peak > 0);
+
+		analysis.clear();
+		QTRY_VERIFY(analysis.spectrum(s) && s.peak == 0);
+		QCOMPARE(s.magnitudes[300], 0.0f);
+
+		// frames pushed right after clearing are analysed
+		analysis.clear();
+		analysis.push(frames, Frames);
+		QTRY_VERIFY(analysis.spectrum(s) && s.peak > 0);
+	}
+
+	void testIgnoresFramesWhileInactive()
+	{
+		SpectrumAnalysis analysis;
+		analysis.setActive(false);
+		sampleFrame frames[Frames];
+		sine(frames, 300);
+		analysis.push(frames, Frames);
+
+		SpectrumAnalysis::Spectrum s;
+		QTest::qWait(100);
+		QVERIFY(!analysis.spectrum(s));
+	}
+} SpectrumAnalysisTests;
+
+#include "SpectrumAnalysisTest.moc"
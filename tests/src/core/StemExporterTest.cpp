@@ -0,0 +1,119 @@
+/*
+ * StemExporterTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include <vector>
+
+#include "AudioFileDevice.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "OutputSettings.h"
+#include "ProjectRenderer.h"
+#include "SampleBuffer.h"
+#include "SampleTrack.h"
+#include "Song.h"
+#include "StemExporter.h"
+
+namespace
+{
+
+// keeps the left channel of everything written to it
+class CaptureDevice : public AudioFileDevice
+{
+public:
+	CaptureDevice(const OutputSettings& outputSettings, std::vector<float>& frames) :
+		AudioFileDevice(outputSettings, DEFAULT_CHANNELS, QString(), Engine::mixer()),
+		m_frames(frames)
+	{
+	}
+
+protected:
+	void writeBuffer(const surroundSampleFrame* buf, const fpp_t frames, const float) override
+	{
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			m_frames.push_back(buf[f][0]);
+		}
+	}
+
+private:
+	std::vector<float>& m_frames;
+};
+
+int firstLoudFrame(const std::vector<float>& frames)
+{
+	for (size_t f = 0; f < frames.size(); ++f)
+	{
+		if (qAbs(frames[f]) > 0.1f)
+		{
+			return f;
+		}
+	}
+	return -1;
+}
+
+}
+
+class StemExporterTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void testStemsInSyncWithMaster()
+	{
+		// a step in the middle of a period, played from the song's start
+		const int step = Engine::mixer()->framesPerPeriod() * 5 / 2;
+		std::vector<sampleFrame> data(4 * step);
+		for (size_t f = step; f < data.size(); ++f)
+		{
+			data[f][0] = data[f][1] = 0.5f;
+		}
+
+		auto song = Engine::getSong();
+		SampleTrack track(song);
+		SampleTCO tco(&track);
+		tco.setSampleBuffer(new SampleBuffer(data.data(), data.size()));
+		tco.movePosition(0);
+
+		const Mixer::qualitySettings qs(Mixer::qualitySettings::Mode_Draft);
+		const OutputSettings os(44100, OutputSettings::BitRateSettings(160, false),
+						OutputSettings::Depth_32Bit);
+		std::vector<float> master;
+		std::vector<float> stem;
+
+		StemExporter stemExporter;
+		stemExporter.addPortStem(track.audioPort(), new CaptureDevice(os, stem));
+
+		ProjectRenderer renderer(qs, new CaptureDevice(os, master));
+		renderer.setStemExporter(&stemExporter);
+		renderer.startProcessing();
+		renderer.wait();
+		// deletes the master's device
+		Engine::mixer()->restoreAudioDevice();
+
+		QVERIFY(firstLoudFrame(master) > 0);
+		QCOMPARE(firstLoudFrame(stem), firstLoudFrame(master));
+		QCOMPARE(stem.size(), master.size());
+	}
+} StemExporterTest;
+
+#include "StemExporterTest.moc"
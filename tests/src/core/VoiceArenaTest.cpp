@@ -0,0 +1,101 @@
+/*
+ * VoiceArenaTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "QTestSuite.h"
+
+#include "VoiceArena.h"
+
+#include <vector>
+
+namespace
+{
+
+struct TestVoice
+{
+	MM_OPERATORS
+	TestVoice(int value, int& alive) :
+		value(value),
+		alive(alive)
+	{
+		++alive;
+	}
+
+	~TestVoice()
+	{
+		--alive;
+	}
+
+	int value;
+	int& alive;
+};
+
+}
+
+class VoiceArenaTest : QTestSuite
+{
+	Q_OBJECT
+private slots:
+	void testVoicesAreRecycled()
+	{
+		int alive = 0;
+		VoiceArena<TestVoice> arena(32);
+
+		for (int round = 0; round < 4; ++round)
+		{
+			std::vector<TestVoice*> voices;
+			for (int i = 0; i < 32; ++i)
+			{
+				voices.push_back(arena.create(i, alive));
+				QCOMPARE(voices.back()->value, i);
+			}
+			QCOMPARE(alive, 32);
+			for (TestVoice* voice : voices)
+			{
+				arena.destroy(voice);
+			}
+			QCOMPARE(alive, 0);
+		}
+		QCOMPARE(arena.heapAllocations(), 0);
+	}
+
+	void testFallsBackToHeap()
+	{
+		int alive = 0;
+		VoiceArena<TestVoice> arena(32);
+
+		std::vector<TestVoice*> voices;
+		for (int i = 0; i < 40; ++i)
+		{
+			voices.push_back(arena.create(i, alive));
+		}
+		QCOMPARE(arena.heapAllocations(), 8);
+		QCOMPARE(voices.back()->value, 39);
+
+		for (TestVoice* voice : voices)
+		{
+			arena.destroy(voice);
+		}
+		QCOMPARE(alive, 0);
+	}
+} VoiceArenaTests;
+
+#include "VoiceArenaTest.moc"
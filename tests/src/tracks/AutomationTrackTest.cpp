@@ -27,6 +27,7 @@
 #include "QCoreApplication"
 
 #include "AutomationPattern.h"
+#include "AutomationTimeline.h"
 #include "AutomationTrack.h"
 #include "BBTrack.h"
 #include "BBTrackContainer.h"
@@ -36,6 +37,7 @@
 #include "TrackContainer.h"
 
 #include "Engine.h"
+#include "Mixer.h"
 #include "Song.h"
 
 class AutomationTrackTest : QTestSuite
@@ -74,6 +76,32 @@ private slots:
 		QCOMPARE(p.valueAt(150), 1.0f);
 	}
 
+	void testPatternRendering()
+	{
+		AutomationPattern p(nullptr);
+		p.putValue(10, 0.2, false);
+		p.putValue(50, 0.9, false);
+		p.putValue(60, 0.1, false);
+
+		const AutomationPattern::ProgressionTypes types[] = {
+			AutomationPattern::DiscreteProgression,
+			AutomationPattern::LinearProgression,
+			AutomationPattern::CubicHermiteProgression
+		};
+		for (auto type : types)
+		{
+			p.setProgressionType(type);
+
+			// half a tick per value, clamped at tick 70
+			float values[160];
+			p.valuesAt(0.0f, 0.5f, values, 160, 70.0f);
+			for (int i = 0; i < 160; i += 2)
+			{
+				QVERIFY(qAbs(values[i] - p.valueAt(qMin(i / 2, 70))) < 1e-5f);
+			}
+		}
+	}
+
 	void testPatterns()
 	{
 		FloatModel model;
@@ -108,6 +136,144 @@ private slots:
 		QCOMPARE(song->automatedValuesAt(150)[&model], 0.5f);
 	}
 
+	void testTimeline()
+	{
+		FloatModel model;
+
+		auto song = Engine::getSong();
+		AutomationTrack track(song);
+
+		AutomationPattern p1(&track);
+		p1.setProgressionType(AutomationPattern::LinearProgression);
+		p1.putValue(0, 0.0, false);
+		p1.putValue(10, 1.0, false);
+		p1.movePosition(0);
+		p1.addObject(&model);
+
+		AutomationPattern p2(&track);
+		p2.setProgressionType(AutomationPattern::LinearProgression);
+		p2.putValue(0, 0.0, false);
+		p2.putValue(100, 1.0, false);
+		p2.movePosition(100);
+		p2.addObject(&model);
+
+		AutomationTimeline timeline(song, song->globalAutomationTrack());
+		auto compareAt = [&](int time)
+		{
+			AutomatedValueMap values;
+			for (const AutomationTimeline::Value& v : timeline.valuesAt(time))
+			{
+				values[v.model] = v.value;
+			}
+			QCOMPARE(values, song->automatedValuesAt(time));
+		};
+
+		// playing forward, then jumping back
+		for (int time : {0, 5, 10, 50, 100, 150, 200, 5, 120})
+		{
+			compareAt(time);
+		}
+
+		// muted patterns fall back to the previous one
+		p2.setMuted(true);
+		compareAt(150);
+		p2.setMuted(false);
+		compareAt(150);
+
+		// moving patterns recompiles the timeline
+		p2.movePosition(20);
+		compareAt(10);
+		compareAt(30);
+	}
+
+	void testRenderPatternStartingMidPeriod()
+	{
+		FloatModel model(0, 0, 1, 0.00001f);
+		FloatModel lateModel(0, 0, 1, 0.00001f);
+
+		auto song = Engine::getSong();
+		AutomationTrack track(song);
+
+		AutomationPattern p1(&track);
+		p1.setProgressionType(AutomationPattern::LinearProgression);
+		p1.putValue(0, 0.0, false);
+		p1.putValue(200, 1.0, false);
+		p1.movePosition(0);
+		p1.addObject(&model);
+
+		AutomationPattern p2(&track);
+		p2.putValue(0, 0.9, false);
+		p2.movePosition(100);
+		p2.addObject(&model);
+		p2.addObject(&lateModel);
+
+		AutomationTimeline timeline(song, song->globalAutomationTrack());
+
+		// the period's middle is at tick 100, a quarter tick in
+		const int frames = Engine::mixer()->framesPerPeriod();
+		const float ticksPerFrame = 1 / 32.0f;
+		const float start = 100.25f - frames / 64.0f;
+		AutomatableModel::incrementPeriodCounter();
+		timeline.renderValueBuffers(start, ticksPerFrame);
+
+		const ValueBuffer* buffer = model.valueBuffer();
+		QVERIFY(buffer != nullptr);
+		for (int i = 0; i < frames; ++i)
+		{
+			const float position = start + i * ticksPerFrame;
+			const float expected = position < 100 ? position / 200 : 0.9f;
+			QVERIFY(qAbs(buffer->values()[i] - expected) < 1e-4f);
+		}
+
+		// no curve before p2 starts, so it keeps the per-tick values
+		QVERIFY(lateModel.valueBuffer() == nullptr);
+	}
+
+	void testRenderLoopWrap()
+	{
+		FloatModel model(0, 0, 1, 0.00001f);
+		FloatModel lateModel(0, 0, 1, 0.00001f);
+
+		auto song = Engine::getSong();
+		AutomationTrack track(song);
+
+		AutomationPattern p1(&track);
+		p1.setProgressionType(AutomationPattern::LinearProgression);
+		p1.putValue(0, 0.0, false);
+		p1.putValue(100, 1.0, false);
+		p1.movePosition(0);
+		p1.addObject(&model);
+
+		AutomationPattern p2(&track);
+		p2.putValue(0, 0.5, false);
+		p2.movePosition(50);
+		p2.addObject(&lateModel);
+
+		AutomationTimeline timeline(song, song->globalAutomationTrack());
+
+		// loops from tick 100 back to 0 in the middle of the period
+		const int frames = Engine::mixer()->framesPerPeriod();
+		const float ticksPerFrame = 1 / 32.0f;
+		const float start = 100.25f - frames / 64.0f;
+		AutomatableModel::incrementPeriodCounter();
+		timeline.renderValueBuffers(start, ticksPerFrame, 0, 100);
+
+		const ValueBuffer* buffer = model.valueBuffer();
+		QVERIFY(buffer != nullptr);
+		for (int i = 0; i < frames; ++i)
+		{
+			float position = start + i * ticksPerFrame;
+			if (position >= 100)
+			{
+				position -= 100;
+			}
+			QVERIFY(qAbs(buffer->values()[i] - position / 100) < 1e-4f);
+		}
+
+		// p2 didn't start yet after looping back
+		QVERIFY(lateModel.valueBuffer() == nullptr);
+	}
+
 	void testLengthRespected()
 	{
 		FloatModel model;